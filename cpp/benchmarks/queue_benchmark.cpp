@@ -0,0 +1,129 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The `queue_benchmark` utility measures the publish and consume throughput of
+ * the event queues. Run it once with the default single shared queue and once
+ * with `--numa` to compare against one queue per NUMA node:
+ *
+ *   bazel run -c opt //cpp/benchmarks:queue_benchmark -- --producers=16
+ *   bazel run -c opt //cpp/benchmarks:queue_benchmark -- --producers=16 --numa
+ *
+ * Pass `--huge_pages` to back the event queues with transparent huge pages.
+ *
+ * Pass `--batch=N` to consume with `readTraceEvents` in batches of up to N
+ * events instead of one `readTraceEvent` call per event.
+ *
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <inspector/config.hpp>
+#include <inspector/details/queue.hpp>
+#include <inspector/trace.hpp>
+#include <inspector/trace_reader.hpp>
+
+DEFINE_bool(numa, false, "Use one event queue per NUMA node.");
+DEFINE_bool(huge_pages, false,
+            "Back the event queues with transparent huge pages.");
+DEFINE_uint64(producers, 4, "Number of producer threads.");
+DEFINE_uint64(events, 1000000, "Number of events published by each producer.");
+DEFINE_uint64(batch, 0,
+              "Number of events consumed per batch. Events are consumed one "
+              "at a time when set to 0.");
+DEFINE_string(queue, "/inspector-queue-benchmark", "Name of the event queue.");
+
+namespace inspector {
+namespace benchmarks {
+
+int main(int argc, char* argv[]) {
+  FLAGS_logtostderr = 1;
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  Config::setEventQueueName(FLAGS_queue);
+  if (FLAGS_numa) {
+    Config::enableNumaAwareEventQueue();
+  }
+  if (FLAGS_huge_pages) {
+    Config::enableHugePageEventQueue();
+  }
+  LOG(INFO) << "Event queues: " << details::eventQueueCount();
+
+  std::atomic_bool done{false};
+  std::atomic_uint64_t consumed{0};
+  std::thread consumer([&]() {
+    TraceEventBatch batch;
+    while (true) {
+      std::size_t count = 0;
+      if (FLAGS_batch) {
+        count = readTraceEvents(batch, FLAGS_batch, 64 * FLAGS_batch * 1024);
+      } else {
+        count = readTraceEvent().isEmpty() ? 0 : 1;
+      }
+      if (count) {
+        consumed += count;
+      } else if (done) {
+        return;
+      }
+    }
+  });
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (uint64_t i = 0; i < FLAGS_producers; ++i) {
+    producers.emplace_back([]() {
+      for (uint64_t count = 0; count < FLAGS_events; ++count) {
+        syncBegin("queue_benchmark", count);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  const auto publish_end = std::chrono::steady_clock::now();
+  done = true;
+  consumer.join();
+  const auto consume_end = std::chrono::steady_clock::now();
+
+  const auto published = FLAGS_producers * FLAGS_events;
+  const auto publish_s =
+      std::chrono::duration<double>(publish_end - start).count();
+  const auto consume_s =
+      std::chrono::duration<double>(consume_end - start).count();
+  LOG(INFO) << "Published: " << published << " events in " << publish_s
+            << "s (" << published / publish_s << " events/s)";
+  LOG(INFO) << "Consumed: " << consumed << " events in " << consume_s << "s ("
+            << consumed / consume_s << " events/s)";
+  LOG(INFO) << "Dropped: " << published - consumed << " events";
+
+  details::removeEventQueues();
+
+  return 0;
+}
+
+}  // namespace benchmarks
+}  // namespace inspector
+
+int main(int argc, char* argv[]) {
+  return inspector::benchmarks::main(argc, argv);
+}
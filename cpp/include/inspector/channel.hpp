@@ -0,0 +1,60 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <inspector/types.hpp>
+
+namespace inspector {
+
+/**
+ * @brief Enumerated set of channels. Trace events are routed to a channel based
+ * on their type. When multi-channel mode is enabled, each channel is backed by
+ * its own set of separately sized event queues so that a burst of events in one
+ * channel cannot cause events in another channel to be dropped.
+ *
+ */
+enum class Channel : uint8_t {
+  kScope = 0,  //<- Synchronous, asynchronous and flow scope events.
+  kCounter,    //<- Counter metric events.
+};
+
+/**
+ * @brief Number of channels.
+ *
+ */
+constexpr std::size_t kChannelCount = 2;
+
+/**
+ * @brief Get the name of the given channel. The name is used to identify the
+ * event queues and the storage topic of the channel.
+ *
+ * @param channel Channel.
+ * @returns Name of the channel as a c-string.
+ */
+const char* channelName(const Channel channel);
+
+/**
+ * @brief Get the channel to which trace events of the given type are routed.
+ *
+ * @param type Trace event type.
+ * @returns Channel of the trace event.
+ */
+Channel eventChannel(const event_type_t type);
+
+}  // namespace inspector
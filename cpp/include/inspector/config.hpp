@@ -16,11 +16,61 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <inspector/channel.hpp>
 #include <string>
 
 namespace inspector {
 namespace Config {
 
+// ------------------------------------
+// Environment Variables
+// ====================================
+//
+// The default value of every setting below can be overridden at process
+// startup using the following environment variables. Settings applied through
+// the API take precedence over the environment.
+//
+//  INSPECTOR_EVENT_QUEUE_NAME             Name of the event queue.
+//  INSPECTOR_EVENT_QUEUE_BUFFER_SIZE      Buffer size in bytes. Accepts the
+//                                         suffixes K, M and G, e.g. `64M`.
+//  INSPECTOR_EVENT_QUEUE_MAX_PRODUCERS    Maximum number of producers.
+//  INSPECTOR_EVENT_QUEUE_MAX_CONSUMERS    Maximum number of consumers.
+//  INSPECTOR_EVENT_QUEUE_TIMEOUT_NS       Queue timeout in nanoseconds.
+//  INSPECTOR_EVENT_QUEUE_OVERFLOW_POLICY  Either `drop` or `block`.
+//  INSPECTOR_EVENT_QUEUE_WAKEUP_THRESHOLD Fill percentage of the queues at
+//                                         which recorders are woken up.
+//  INSPECTOR_NUMA_AWARE_EVENT_QUEUE       Set to `1` to enable NUMA aware
+//                                         event queues.
+//  INSPECTOR_HUGE_PAGE_EVENT_QUEUE        Set to `1` to back event queues
+//                                         with transparent huge pages.
+//  INSPECTOR_PER_PROCESS_EVENT_QUEUE     Set to `1` to let each process
+//                                         publish to its own event queues.
+//  INSPECTOR_MULTI_CHANNEL                Set to `1` to enable one set of
+//                                         event queues per channel.
+//  INSPECTOR_EVENT_CHANNEL_<NAME>_BUFFER_SIZE
+//                                         Buffer size in bytes of the queues
+//                                         of the channel with the upper case
+//                                         name <NAME>, e.g. `COUNTER`.
+//  INSPECTOR_EVENT_CHANNEL_<NAME>_PRIORITY
+//                                         Drain priority of the channel.
+//  INSPECTOR_TRACE_DISABLED               Set to `1` to disable tracing.
+//
+// Event queue settings take effect when the queues are opened, i.e. on the
+// first trace event published or read by the process.
+
+/**
+ * @brief Enumerated set of actions taken when a trace event is published to a
+ * full event queue.
+ *
+ */
+enum class OverflowPolicy : uint8_t {
+  kDrop = 0,  //<- Drop the trace event being published.
+  kBlock,     //<- Retry publishing the trace event until space is available
+              // in the queue or the queue timeout expires.
+};
+
 /**
  * @brief Get the name of the process shared event queue used by the inspector
  * library to publish trace events for consumption by the trace reader.
@@ -37,6 +87,112 @@ std::string eventQueueName();
  */
 void setEventQueueName(const std::string& name);
 
+/**
+ * @brief Get the size in bytes of the buffer backing each event queue.
+ *
+ * @returns Buffer size in bytes. Default set to 8MB.
+ */
+std::size_t eventQueueBufferSize();
+
+/**
+ * @brief Set the size in bytes of the buffer backing each event queue.
+ *
+ * @param size Buffer size in bytes.
+ */
+void setEventQueueBufferSize(const std::size_t size);
+
+/**
+ * @brief Get the maximum number of producers that can concurrently publish to
+ * an event queue.
+ *
+ * @returns Maximum number of producers. Default set to 1024.
+ */
+std::size_t eventQueueMaxProducers();
+
+/**
+ * @brief Set the maximum number of producers that can concurrently publish to
+ * an event queue.
+ *
+ * @param count Maximum number of producers.
+ */
+void setEventQueueMaxProducers(const std::size_t count);
+
+/**
+ * @brief Get the maximum number of consumers that can concurrently read from
+ * an event queue.
+ *
+ * @returns Maximum number of consumers. Default set to 1024.
+ */
+std::size_t eventQueueMaxConsumers();
+
+/**
+ * @brief Set the maximum number of consumers that can concurrently read from
+ * an event queue.
+ *
+ * @param count Maximum number of consumers.
+ */
+void setEventQueueMaxConsumers(const std::size_t count);
+
+/**
+ * @brief Get the event queue timeout in nanoseconds. The timeout bounds how
+ * long a stalled producer or consumer can hold a slot in the queue. It also
+ * bounds how long a publish can block under `OverflowPolicy::kBlock`.
+ *
+ * @returns Timeout in nanoseconds. Default set to 30s.
+ */
+uint64_t eventQueueTimeoutNs();
+
+/**
+ * @brief Set the event queue timeout in nanoseconds.
+ *
+ * @param timeout_ns Timeout in nanoseconds.
+ */
+void setEventQueueTimeoutNs(const uint64_t timeout_ns);
+
+/**
+ * @brief Get the action taken when publishing to a full event queue.
+ *
+ * @returns Overflow policy. Default set to `OverflowPolicy::kDrop`.
+ */
+OverflowPolicy eventQueueOverflowPolicy();
+
+/**
+ * @brief Set the action taken when publishing to a full event queue.
+ *
+ * @param policy Overflow policy.
+ */
+void setEventQueueOverflowPolicy(const OverflowPolicy policy);
+
+/**
+ * @brief Get the fill threshold, as a percentage of the event queue buffer
+ * size, at which producers wake up a recorder blocked waiting for trace
+ * events. Recorders otherwise wake up on their idle timeout.
+ *
+ * @returns Threshold in percent. Default set to 25.
+ */
+std::size_t eventQueueWakeupThreshold();
+
+/**
+ * @brief Set the fill threshold, as a percentage of the event queue buffer
+ * size, at which producers wake up a recorder blocked waiting for trace
+ * events. Values above 100 are capped to 100.
+ *
+ * @param percent Threshold in percent.
+ */
+void setEventQueueWakeupThreshold(const std::size_t percent);
+
+/**
+ * @brief Verify that the geometry of the event queues, i.e. buffer size,
+ * producer and consumer limits, timeout and number of queues, matches the
+ * geometry with which the queues were created by the first process opening
+ * them. Recorders should call this method to check that they agree with the
+ * traced processes.
+ *
+ * @throws `std::runtime_error` describing the mismatch if the geometries do
+ * not match.
+ */
+void verifyEventQueueGeometry();
+
 /**
  * @brief Check if tracing is disabled.
  *
@@ -56,5 +212,151 @@ void disableTrace();
  */
 void enableTrace();
 
+/**
+ * @brief Check if NUMA aware event queues are enabled.
+ *
+ * @returns `true` if enabled else `false`.
+ */
+bool isNumaAwareEventQueueEnabled();
+
+/**
+ * @brief Enable NUMA aware event queues. When enabled, one event queue is
+ * created per NUMA node and trace events are published to the queue local to
+ * the node on which the publishing thread runs. Trace readers drain all the
+ * queues.
+ *
+ * @note The setting must be applied before the first trace event is published
+ * or read, and must match between the traced processes and the recorder.
+ *
+ */
+void enableNumaAwareEventQueue();
+
+/**
+ * @brief Disable NUMA aware event queues. A single event queue is then shared
+ * by all producers. This is the default.
+ *
+ */
+void disableNumaAwareEventQueue();
+
+/**
+ * @brief Check if huge page backed event queues are enabled.
+ *
+ * @returns `true` if enabled else `false`.
+ */
+bool isHugePageEventQueueEnabled();
+
+/**
+ * @brief Enable huge page backed event queues. When enabled, the kernel is
+ * advised to back the shared memory of each opened event queue with
+ * transparent huge pages, which reduces TLB misses on large queues. Queues
+ * fall back to regular pages with a warning when the kernel does not back
+ * shared memory with huge pages on advice, i.e. when
+ * `/sys/kernel/mm/transparent_hugepage/shmem_enabled` is `never` or `deny`.
+ *
+ * @note The setting must be applied before the first trace event is published
+ * or read.
+ *
+ */
+void enableHugePageEventQueue();
+
+/**
+ * @brief Disable huge page backed event queues. This is the default.
+ *
+ */
+void disableHugePageEventQueue();
+
+/**
+ * @brief Check if per process event queues are enabled.
+ *
+ * @returns `true` if enabled else `false`.
+ */
+bool isPerProcessEventQueueEnabled();
+
+/**
+ * @brief Enable per process event queues. When enabled, each traced process
+ * publishes to its own event queues, named after the event queue name and the
+ * process identifier, and registers them in a process shared directory.
+ * Recorders discover the registered processes and drain their queues
+ * independently, so that unrelated processes do not contend for the same
+ * queues or share the producer limit.
+ *
+ * @note The setting must be applied before the first trace event is published
+ * or read, and must match between the traced processes and the recorder.
+ *
+ */
+void enablePerProcessEventQueue();
+
+/**
+ * @brief Disable per process event queues. All the processes then share the
+ * same event queues. This is the default.
+ *
+ */
+void disablePerProcessEventQueue();
+
+/**
+ * @brief Check if multi-channel event queues are enabled.
+ *
+ * @returns `true` if enabled else `false`.
+ */
+bool isMultiChannelEnabled();
+
+/**
+ * @brief Enable multi-channel event queues. When enabled, each channel gets
+ * its own set of event queues sized using `eventChannelBufferSize`. Trace
+ * events are published to the queues of the channel they are routed to, so
+ * that a flood of events in one channel does not evict events of another.
+ *
+ * @note The setting must be applied before the first trace event is published
+ * or read, and must match between the traced processes and the recorder.
+ *
+ */
+void enableMultiChannel();
+
+/**
+ * @brief Disable multi-channel event queues. All the channels then share the
+ * same event queues. This is the default.
+ *
+ */
+void disableMultiChannel();
+
+/**
+ * @brief Get the size in bytes of the buffer backing each event queue of the
+ * given channel. Only used when multi-channel event queues are enabled.
+ *
+ * @param channel Channel.
+ * @returns Buffer size in bytes. Defaults to `eventQueueBufferSize()`.
+ */
+std::size_t eventChannelBufferSize(const Channel channel);
+
+/**
+ * @brief Set the size in bytes of the buffer backing each event queue of the
+ * given channel. Setting the size to 0 falls back to `eventQueueBufferSize()`.
+ *
+ * @param channel Channel.
+ * @param size Buffer size in bytes.
+ */
+void setEventChannelBufferSize(const Channel channel, const std::size_t size);
+
+/**
+ * @brief Get the drain priority of the given channel. Recorders read batches
+ * of trace events proportional in size to `priority` from a channel before
+ * moving on to the next one, so channels with higher priority get a
+ * proportionally larger share of the reads when all channels are busy.
+ *
+ * @param channel Channel.
+ * @returns Drain priority. Default set to 4 for the scope channel and 1 for
+ * the counter channel.
+ */
+uint32_t eventChannelPriority(const Channel channel);
+
+/**
+ * @brief Set the drain priority of the given channel. Priorities smaller than
+ * 1 are treated as 1.
+ *
+ * @param channel Channel.
+ * @param priority Drain priority.
+ */
+void setEventChannelPriority(const Channel channel, const uint32_t priority);
+
 }  // namespace Config
 }  // namespace inspector
\ No newline at end of file
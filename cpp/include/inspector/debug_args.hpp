@@ -18,6 +18,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace inspector {
 
@@ -64,6 +71,17 @@ class DebugArg {
   template <class T>
   T value() const;
 
+  /**
+   * @brief Get the value of the debug argument without checking its type. The
+   * caller must have already validated the type, e.g. by switching on `type()`
+   * or by using `visit`.
+   *
+   * @tparam T Data type of the argument.
+   * @returns Value of the argument.
+   */
+  template <class T>
+  T valueUnchecked() const;
+
   /**
    * @brief Get the storage location of the debug argument.
    *
@@ -89,6 +107,7 @@ class DebugArg {
  */
 class KeywordArg final : public DebugArg {
   friend class DebugArg;
+  friend class DebugArgs;
 
  public:
   /**
@@ -109,12 +128,88 @@ class KeywordArg final : public DebugArg {
   const char* name_;
 };
 
+// ---
+// `DebugArg` Unchecked Access
+// ---
+
+template <class T>
+T DebugArg::valueUnchecked() const {
+  static_assert(std::is_arithmetic<T>::value,
+                "Unsupported type of debug argument value.");
+  T value;
+  std::memcpy(&value, static_cast<const uint8_t*>(address_) + sizeof(uint8_t),
+              sizeof(T));
+  return value;
+}
+
+template <>
+inline const char* DebugArg::valueUnchecked<const char*>() const {
+  return static_cast<const char*>(static_cast<const void*>(
+      static_cast<const uint8_t*>(address_) + sizeof(uint8_t)));
+}
+
+template <>
+inline KeywordArg DebugArg::valueUnchecked<KeywordArg>() const {
+  return KeywordArg(static_cast<const void*>(
+      static_cast<const uint8_t*>(address_) + sizeof(uint8_t)));
+}
+
+/**
+ * @brief Invoke the given callable with the typed value of the debug argument.
+ * The type of the argument is dispatched once and the callable receives the
+ * value without any further type checks. String arguments are passed as
+ * c-strings and keyword arguments as `KeywordArg` objects.
+ *
+ * @tparam F Type of the callable. It should accept values of all the supported
+ * debug argument types and return the same type for all of them.
+ * @param arg Constant reference to the debug argument.
+ * @param f Callable object.
+ * @returns Value returned by the callable.
+ * @throws `std::runtime_error` if the type of the argument is invalid.
+ */
+template <class F>
+auto visit(const DebugArg& arg, F&& f) -> std::invoke_result_t<F, int16_t> {
+  switch (arg.type()) {
+    case DebugArg::Type::TYPE_INT16:
+      return std::forward<F>(f)(arg.valueUnchecked<int16_t>());
+    case DebugArg::Type::TYPE_INT32:
+      return std::forward<F>(f)(arg.valueUnchecked<int32_t>());
+    case DebugArg::Type::TYPE_INT64:
+      return std::forward<F>(f)(arg.valueUnchecked<int64_t>());
+    case DebugArg::Type::TYPE_UINT8:
+      return std::forward<F>(f)(arg.valueUnchecked<uint8_t>());
+    case DebugArg::Type::TYPE_UINT16:
+      return std::forward<F>(f)(arg.valueUnchecked<uint16_t>());
+    case DebugArg::Type::TYPE_UINT32:
+      return std::forward<F>(f)(arg.valueUnchecked<uint32_t>());
+    case DebugArg::Type::TYPE_UINT64:
+      return std::forward<F>(f)(arg.valueUnchecked<uint64_t>());
+    case DebugArg::Type::TYPE_FLOAT:
+      return std::forward<F>(f)(arg.valueUnchecked<float>());
+    case DebugArg::Type::TYPE_DOUBLE:
+      return std::forward<F>(f)(arg.valueUnchecked<double>());
+    case DebugArg::Type::TYPE_CHAR:
+      return std::forward<F>(f)(arg.valueUnchecked<char>());
+    case DebugArg::Type::TYPE_STRING:
+      return std::forward<F>(f)(arg.valueUnchecked<const char*>());
+    case DebugArg::Type::TYPE_KWARG:
+      return std::forward<F>(f)(arg.valueUnchecked<KeywordArg>());
+  }
+
+  throw std::runtime_error("Invalid debug argument type '" +
+                           std::to_string(static_cast<int>(arg.type())) +
+                           "'.");
+}
+
 /**
- * @brief Collection of debug arguments present in a trace event.
+ * @brief Collection of debug arguments present in a trace event. The arguments
+ * are decoded once on construction into a table of offsets so that accessing
+ * an argument by index or a keyword argument by name does not walk the
+ * preceding arguments.
  *
  */
 class DebugArgs {
-  friend class TraceEvent;
+  friend class TraceEventView;
 
  public:
   /**
@@ -134,10 +229,12 @@ class DebugArgs {
     bool operator!=(const Iterator& other) const;
 
    private:
-    Iterator(const void* const address, const size_t count);
+    Iterator(const void* const address, const size_t count,
+             const size_t storage_size);
 
     DebugArg debug_arg_;
     size_t count_;
+    size_t storage_size_;
   };
 
   /**
@@ -153,6 +250,23 @@ class DebugArgs {
    */
   size_t size() const;
 
+  /**
+   * @brief Get the debug argument at the given index. The index is not bounds
+   * checked.
+   *
+   * @param index Index of the argument.
+   * @returns Object of type `DebugArg`.
+   */
+  DebugArg operator[](const size_t index) const;
+
+  /**
+   * @brief Find the keyword argument with the given name.
+   *
+   * @param name Name of the keyword argument.
+   * @returns Keyword argument if found else an empty optional.
+   */
+  std::optional<KeywordArg> kwarg(const char* const name) const;
+
   /**
    * @brief Get iterator to the starting debug argument.
    *
@@ -169,7 +283,16 @@ class DebugArgs {
 
  private:
   /**
-   * @brief Construct a new DebugArgs object
+   * @brief Number of argument offsets stored inline before spilling over to
+   * the heap. Trace events seldom carry more arguments than this.
+   *
+   */
+  static constexpr size_t kInlineOffsets = 8;
+
+  /**
+   * @brief Construct a new DebugArgs object decoding the offsets of the given
+   * number of arguments in a single pass. Decoding stops early if an argument
+   * runs past the storage size.
    *
    * @param address Starting address of the arguments.
    * @param storage_size Number of bytes used to store the arguments.
@@ -178,9 +301,18 @@ class DebugArgs {
   DebugArgs(const void* const address, const size_t storage_size,
             const size_t count);
 
+  /**
+   * @brief Get the offset in bytes of the argument at the given index from the
+   * starting address.
+   *
+   */
+  uint32_t offset(const size_t index) const;
+
   const void* address_;
   size_t storage_size_;
   size_t count_;
+  uint32_t inline_offsets_[kInlineOffsets];
+  std::vector<uint32_t> offsets_;
 };
 
-}  // namespace inspector
\ No newline at end of file
+}  // namespace inspector
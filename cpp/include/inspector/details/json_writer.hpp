@@ -0,0 +1,137 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace inspector {
+namespace details {
+
+/**
+ * @brief Append the given string to the buffer escaped as per the JSON spec,
+ * excluding the surrounding quotes. Runs of characters not needing escaping
+ * are found using SIMD instructions where available.
+ *
+ * @param data Pointer to the string.
+ * @param size Size of the string in bytes.
+ * @param buffer Reference to the buffer to append to.
+ */
+void escapeJsonString(const char *data, const std::size_t size,
+                      std::string &buffer);
+
+/**
+ * @brief The class `JsonWriter` is a streaming JSON writer appending to a
+ * caller provided buffer. The buffer can be reused across documents to avoid
+ * allocations. Separators between members and elements are inserted
+ * automatically. Numbers are formatted using `std::to_chars`.
+ *
+ * @note Nesting is limited to 64 levels of objects and arrays.
+ *
+ */
+class JsonWriter final {
+ public:
+  /**
+   * @brief Construct a new JsonWriter object.
+   *
+   * @param buffer Reference to the buffer to append to.
+   */
+  explicit JsonWriter(std::string &buffer);
+
+  JsonWriter &beginObject();
+  JsonWriter &endObject();
+  JsonWriter &beginArray();
+  JsonWriter &endArray();
+
+  /**
+   * @brief Write the key of the next object member.
+   *
+   * @param name Null terminated name of the member. Escaped as needed.
+   */
+  JsonWriter &key(const char *name);
+
+  /**
+   * @brief Write a string value. Escaped as needed. A null pointer is written
+   * as `null`.
+   *
+   */
+  JsonWriter &value(const char *str);
+
+  /**
+   * @brief Write a string value of the given size. Escaped as needed.
+   *
+   */
+  JsonWriter &value(const char *str, const std::size_t size);
+
+  /**
+   * @brief Write a floating point value. Non-finite values are written as
+   * `null`.
+   *
+   */
+  JsonWriter &value(const double number);
+
+  /**
+   * @brief Write a single precision floating point value using the shortest
+   * representation of the float. Non-finite values are written as `null`.
+   *
+   */
+  JsonWriter &value(const float number);
+
+  /**
+   * @brief Write an integer value.
+   *
+   */
+  template <class T>
+  std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                   JsonWriter &>
+  value(const T number);
+
+  /**
+   * @brief Write a `null` value.
+   *
+   */
+  JsonWriter &null();
+
+ private:
+  void separate();
+
+  std::string &buffer_;
+  uint64_t has_items_;  //<- One bit per nesting level.
+  uint32_t depth_;
+  bool after_key_;
+};
+
+// --------------------------------------------------------------
+// Implementation
+// --------------------------------------------------------------
+
+template <class T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                 JsonWriter &>
+JsonWriter::value(const T number) {
+  separate();
+  char chars[24];
+  const auto result = std::to_chars(chars, chars + sizeof(chars), number);
+  buffer_.append(chars, result.ptr);
+  return *this;
+}
+
+}  // namespace details
+}  // namespace inspector
@@ -17,16 +17,221 @@
 #pragma once
 
 #include <bigcat/circular_queue_a.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <inspector/channel.hpp>
+#include <inspector/details/queue_signal.hpp>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace inspector {
 namespace details {
 
+struct EventQueueSlot;
+
+/**
+ * @brief The class `EventQueueSet` owns the event queues sharing the same base
+ * name, i.e. one queue per channel and NUMA node as configured. The calling
+ * process publishes to its local set, while recorders open the sets of other
+ * processes when per process event queues are enabled.
+ *
+ */
+class EventQueueSet final {
+ public:
+  /**
+   * @brief Construct a new EventQueueSet object. The queues are opened, or
+   * created if they do not exist, as part of the CTOR.
+   *
+   * @param name Constant reference to the base name of the queues.
+   */
+  explicit EventQueueSet(const std::string& name);
+
+  ~EventQueueSet();
+
+  /**
+   * @brief Get the base name of the queues.
+   *
+   */
+  const std::string& name() const;
+
+  /**
+   * @brief Get the number of queues in the set.
+   *
+   */
+  std::size_t count() const;
+
+  /**
+   * @brief Get the queue at the given index.
+   *
+   * @param index Index of the queue in the range `[0, count())`.
+   */
+  bigcat::CircularQueueA& queue(const std::size_t index);
+
+  /**
+   * @brief Get the number of queues storing trace events of the given channel.
+   * Every channel has the same number of queues, so the count does not depend
+   * on the channel.
+   *
+   */
+  std::size_t count(const Channel channel) const;
+
+  /**
+   * @brief Get the queue storing trace events of the given channel at the
+   * given index.
+   *
+   * @param channel Channel of the trace events.
+   * @param index Index of the queue in the range `[0, count(channel))`.
+   */
+  bigcat::CircularQueueA& queue(const Channel channel, const std::size_t index);
+
+  /**
+   * @brief Get the system unique name of the queue at the given index.
+   *
+   */
+  std::string queueName(const std::size_t index) const;
+
+  /**
+   * @brief Get the signal used by producers to wake up consumers of the set.
+   *
+   */
+  QueueSignal &signal();
+
+  /**
+   * @brief Mark all the queues in the set and their signal for removal by the
+   * OS.
+   *
+   */
+  void remove() const;
+
+ private:
+  std::string name_;
+  std::vector<std::unique_ptr<EventQueueSlot>> slots_;
+  QueueSignal signal_;
+};
+
 /**
- * @brief Get the event queue to store trace events.
+ * @brief Get the base name of the event queues of the process with the given
+ * identifier when per process event queues are enabled.
  *
+ * @param pid OS unique identifier of the process.
+ * @returns Base name of the event queues.
+ */
+std::string eventQueueSetName(const int32_t pid);
+
+/**
+ * @brief Get the event queues published to by the calling process. The queues
+ * are opened once on first use, and once more in a child created by `fork()`.
+ *
+ * @returns Reference to the set of event queues.
+ */
+EventQueueSet& localEventQueues();
+
+/**
+ * @brief Get the event queue to store trace events of the given channel. When
+ * NUMA aware event queues are enabled, the queue local to the NUMA node of the
+ * calling thread is returned.
+ *
+ * @param channel Channel of the trace events.
  * @returns Reference to the event queue.
  */
-bigcat::CircularQueueA& eventQueue();
+bigcat::CircularQueueA& eventQueue(const Channel channel);
+
+/**
+ * @brief Get the number of event queues used to store trace events. Trace
+ * readers should drain all the queues.
+ *
+ * @returns Number of event queues.
+ */
+std::size_t eventQueueCount();
+
+/**
+ * @brief Get the event queue at the given index.
+ *
+ * @param index Index of the queue in the range `[0, eventQueueCount())`.
+ * @returns Reference to the event queue.
+ */
+bigcat::CircularQueueA& eventQueue(const std::size_t index);
+
+/**
+ * @brief Get the number of event queues storing trace events of the given
+ * channel. When multi-channel event queues are disabled, all the queues are
+ * shared by all the channels.
+ *
+ * @param channel Channel of the trace events.
+ * @returns Number of event queues.
+ */
+std::size_t eventQueueCount(const Channel channel);
+
+/**
+ * @brief Get the event queue storing trace events of the given channel at the
+ * given index.
+ *
+ * @param channel Channel of the trace events.
+ * @param index Index of the queue in the range `[0, eventQueueCount(channel))`.
+ * @returns Reference to the event queue.
+ */
+bigcat::CircularQueueA& eventQueue(const Channel channel,
+                                   const std::size_t index);
+
+/**
+ * @brief Get the system unique name of the event queue at the given index.
+ *
+ * @param index Index of the queue in the range `[0, eventQueueCount())`.
+ * @returns Name of the event queue.
+ */
+std::string eventQueueName(const std::size_t index);
+
+/**
+ * @brief Publish a serialized trace event to the event queue of the calling
+ * thread for the given channel. A full queue is handled according to the
+ * configured overflow policy.
+ *
+ * @param channel Channel of the trace event.
+ * @param buffer Constant reference to the buffer containing the trace event.
+ */
+void publishTraceEvent(const Channel channel,
+                       const std::vector<uint8_t>& buffer);
+
+/**
+ * @brief Register the event queues of the calling process in the process
+ * shared registry, so that recorders can discover them. Only used when per
+ * process event queues are enabled.
+ *
+ * @returns `true` if registered else `false`.
+ */
+bool registerEventQueues();
+
+/**
+ * @brief Get the identifiers of the processes whose event queues are
+ * registered in the process shared registry.
+ *
+ * @returns List of process identifiers.
+ */
+std::vector<int32_t> registeredEventQueues();
+
+/**
+ * @brief Remove the event queues of the process with the given identifier from
+ * the process shared registry.
+ *
+ * @param pid OS unique identifier of the process.
+ */
+void unregisterEventQueues(const int32_t pid);
+
+/**
+ * @brief Compare the configured event queue geometry against the geometry
+ * with which the queues were created by the first process opening them.
+ *
+ * @returns Description of the mismatch or empty string if they match.
+ */
+std::string eventQueueGeometryMismatch();
+
+/**
+ * @brief Mark all the event queues of the calling process and their geometry
+ * descriptor for removal by the OS. The process is removed from the registry.
+ *
+ */
+void removeEventQueues();
 
 }  // namespace details
 }  // namespace inspector
\ No newline at end of file
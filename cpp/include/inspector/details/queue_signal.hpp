@@ -0,0 +1,139 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace inspector {
+namespace details {
+
+/**
+ * @brief The class `QueueSignal` lets producers wake up a consumer blocked on a
+ * set of event queues. Its state lives in process shared memory next to the
+ * queues. Producers report the bytes they publish, and once the bytes pending
+ * since the consumer last drained the queues cross the configured fill
+ * threshold, any blocked consumer is woken up. In the other direction,
+ * producers blocked on full queues are woken up once a consumer reports that it
+ * consumed trace events. On Linux both sides block on a futex, elsewhere they
+ * sleep for the timeout.
+ *
+ */
+class QueueSignal final {
+ public:
+  /**
+   * @brief Construct a new QueueSignal object. The shared state is opened, or
+   * created if it does not exist, as part of the CTOR.
+   *
+   * @param name Constant reference to the system unique name of the signal.
+   * @param threshold Number of pending bytes above which consumers are woken.
+   */
+  QueueSignal(const std::string &name, const std::size_t threshold);
+
+  ~QueueSignal();
+
+  QueueSignal(const QueueSignal &) = delete;
+  QueueSignal &operator=(const QueueSignal &) = delete;
+
+  /**
+   * @brief Report bytes published to the queues. Wakes blocked consumers once
+   * the pending bytes cross the fill threshold.
+   *
+   * @param bytes Number of bytes published.
+   */
+  void notify(const std::size_t bytes);
+
+  /**
+   * @brief Wake blocked consumers irrespective of the pending bytes.
+   *
+   */
+  void wake();
+
+  /**
+   * @brief Reset the pending bytes ahead of draining the queues.
+   *
+   * @returns Token to pass to `wait` once the queues have been drained.
+   */
+  uint32_t prepare();
+
+  /**
+   * @brief Block until a producer signals or the timeout expires. Returns
+   * immediately if a producer signalled since the token was obtained.
+   *
+   * @param token Token returned by `prepare`.
+   * @param timeout Maximum time to block.
+   * @returns `true` if woken by a producer else `false`.
+   */
+  bool wait(const uint32_t token, const std::chrono::microseconds timeout);
+
+  /**
+   * @brief Register the calling producer as waiting for space in the queues.
+   * Every call must be paired with a call to `endSpaceWait`.
+   *
+   */
+  void beginSpaceWait();
+
+  /**
+   * @brief Unregister the calling producer as waiting for space in the queues.
+   *
+   */
+  void endSpaceWait();
+
+  /**
+   * @brief Get a token to pass to `waitForSpace`. The token must be obtained
+   * before the attempt to publish to the full queue.
+   *
+   * @returns Token identifying the last report of consumed trace events.
+   */
+  uint32_t spaceToken() const;
+
+  /**
+   * @brief Block until a consumer reports consumed trace events or the timeout
+   * expires. Returns immediately if a consumer reported since the token was
+   * obtained.
+   *
+   * @param token Token returned by `spaceToken`.
+   * @param timeout Maximum time to block.
+   */
+  void waitForSpace(const uint32_t token,
+                    const std::chrono::microseconds timeout);
+
+  /**
+   * @brief Report trace events consumed from the queues. Wakes producers
+   * blocked on full queues, if any.
+   *
+   */
+  void notifySpace();
+
+  /**
+   * @brief Mark the shared state for removal by the OS.
+   *
+   */
+  void remove() const;
+
+ private:
+  struct State;
+
+  std::string name_;
+  std::size_t threshold_;
+  State *state_;
+};
+
+}  // namespace details
+}  // namespace inspector
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 namespace inspector {
 namespace details {
@@ -33,5 +34,39 @@ int32_t getPID();
  */
 int32_t getTID();
 
+/**
+ * @brief Check if the process with the given identifier is running.
+ *
+ * @param pid OS unique identifier of the process.
+ * @returns `true` if the process is running else `false`.
+ */
+bool isProcessAlive(const int32_t pid);
+
+/**
+ * @brief Get the dense index of the NUMA node on which the thread calling the
+ * method is currently running. The index lies in the range `[0,
+ * getNumaNodeCount())`.
+ *
+ */
+uint32_t getNumaNode();
+
+/**
+ * @brief Get the number of NUMA nodes available in the system. The method
+ * returns 1 on systems without NUMA support.
+ *
+ */
+uint32_t getNumaNodeCount();
+
+/**
+ * @brief Advise the kernel to back the mappings of the POSIX shared memory
+ * object with the given name in the address space of the calling process with
+ * transparent huge pages.
+ *
+ * @param name Name of the shared memory object, e.g. `/inspector-events`.
+ * @returns `true` if at least one mapping was advised and the kernel backs
+ * shared memory with huge pages on advice, else `false`.
+ */
+bool adviseSharedMemoryHugePages(const std::string &name);
+
 }  // namespace details
 }  // namespace inspector
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <inspector/channel.hpp>
 #include <inspector/config.hpp>
 #include <inspector/details/queue.hpp>
 #include <inspector/details/system.hpp>
@@ -62,7 +63,7 @@ void writeTraceEvent(const event_type_t type, const char* name,
   event.setTid(getTID());
   event.appendDebugArgs(name, args...);
 
-  eventQueue().publish(buffer);
+  publishTraceEvent(eventChannel(type), buffer);
 }
 
 }  // namespace details
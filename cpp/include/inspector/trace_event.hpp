@@ -24,7 +24,130 @@
 namespace inspector {
 
 /**
- * @brief Non-mutable view into a recorded trace event.
+ * @brief Non-owning, non-mutable view into a recorded trace event stored in a
+ * memory span, e.g. a record in storage or a slot in a batch. The view does not
+ * copy the trace event and is only valid while the underlying memory is.
+ *
+ */
+class TraceEventView {
+ public:
+  /**
+   * @brief Construct a new TraceEventView object.
+   *
+   * Default CTOR creating an empty view.
+   *
+   */
+  TraceEventView() = default;
+
+  /**
+   * @brief Construct a new TraceEventView object.
+   *
+   * @param data Pointer to the memory containing the trace event.
+   * @param size Size in bytes of the trace event.
+   */
+  TraceEventView(const uint8_t* data, const std::size_t size);
+
+  /**
+   * @brief Construct a new TraceEventView object.
+   *
+   * @param data Pointer to the memory containing the trace event.
+   * @param size Size in bytes of the trace event.
+   */
+  TraceEventView(const void* data, const std::size_t size);
+
+  /**
+   * @brief Check if the trace event is empty.
+   *
+   * @returns `true` if empty else `false`.
+   */
+  bool isEmpty() const;
+
+  /**
+   * @brief Get the type of trace event.
+   *
+   * @returns Trace event type.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  event_type_t type() const;
+
+  /**
+   * @brief Get the trace event counter.
+   *
+   * @returns Counter value of trace event.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  uint64_t counter() const;
+
+  /**
+   * @brief Get the timestamp in nanoseconds of the trace event.
+   *
+   * @returns Timestamp in nanoseconds.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  timestamp_t timestampNs() const;
+
+  /**
+   * @brief Get the process identifier.
+   *
+   * @returns Process identifier.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  int32_t pid() const;
+
+  /**
+   * @brief Get the thread identifier.
+   *
+   * @returns Thread identifier.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  int32_t tid() const;
+
+  /**
+   * @brief Get the name of trace event.
+   *
+   * @returns Name of trace event as a c-string.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  const char* name() const;
+
+  /**
+   * @brief Get the debug arguments which are part of the trace event.
+   *
+   * @returns Object of type `DebugArgs`.
+   * @throws `std::runtime_error` if the event is empty.
+   */
+  DebugArgs debugArgs() const;
+
+  /**
+   * @brief Get JSON string representation of the trace event.
+   *
+   * @returns JSON string representation.
+   */
+  std::string toJson() const;
+
+  /**
+   * @brief Append the JSON string representation of the trace event to the
+   * given buffer. Reusing the buffer across trace events avoids allocations.
+   *
+   * @param buffer Reference to the buffer to append to.
+   */
+  void toJson(std::string& buffer) const;
+
+  /**
+   * @brief Get the span of memory containing the event.
+   *
+   * @returns Pair with the first element being starting address and last being
+   * size in bytes.
+   */
+  std::pair<const uint8_t*, std::size_t> span() const;
+
+ private:
+  const uint8_t* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+/**
+ * @brief Non-mutable recorded trace event owning the memory it is stored in.
  *
  */
 class TraceEvent {
@@ -44,6 +167,27 @@ class TraceEvent {
    */
   explicit TraceEvent(std::vector<uint8_t>&& buffer);
 
+  /**
+   * @brief Construct a new TraceEvent object owning a copy of the trace event
+   * in the given view.
+   *
+   * @param view Constant reference to the view into the trace event.
+   */
+  explicit TraceEvent(const TraceEventView& view);
+
+  TraceEvent(const TraceEvent& other);
+  TraceEvent(TraceEvent&& other) noexcept;
+  TraceEvent& operator=(const TraceEvent& other);
+  TraceEvent& operator=(TraceEvent&& other) noexcept;
+
+  /**
+   * @brief Get a view into the trace event. The view is valid as long as the
+   * trace event is neither destroyed nor moved.
+   *
+   * @returns Object of type `TraceEventView`.
+   */
+  TraceEventView view() const;
+
   /**
    * @brief Check if the trace event is empty.
    *
@@ -100,12 +244,13 @@ class TraceEvent {
   const char* name() const;
 
   /**
-   * @brief Get the debug arguments which are part of the trace event.
+   * @brief Get the debug arguments which are part of the trace event. The
+   * arguments are decoded once when the trace event is constructed.
    *
-   * @returns Object of type `DebugArgs`.
+   * @returns Constant reference to object of type `DebugArgs`.
    * @throws `std::runtime_error` if the event is empty.
    */
-  DebugArgs debugArgs() const;
+  const DebugArgs& debugArgs() const;
 
   /**
    * @brief Get JSON string representation of the trace event.
@@ -114,6 +259,14 @@ class TraceEvent {
    */
   std::string toJson() const;
 
+  /**
+   * @brief Append the JSON string representation of the trace event to the
+   * given buffer. Reusing the buffer across trace events avoids allocations.
+   *
+   * @param buffer Reference to the buffer to append to.
+   */
+  void toJson(std::string& buffer) const;
+
   /**
    * @brief Get the span of memory containing the event.
    *
@@ -123,7 +276,89 @@ class TraceEvent {
   std::pair<const uint8_t*, std::size_t> span() const;
 
  private:
+  /**
+   * @brief Decode the debug arguments stored in the buffer.
+   *
+   */
+  void index();
+
   std::vector<uint8_t> buffer_;
+  DebugArgs debug_args_;
+};
+
+/**
+ * @brief Batch of recorded trace events stored back to back in a reusable
+ * arena. Clearing the batch keeps the arena memory so that filling it again
+ * does not allocate once the arena has grown to its working size. The views
+ * into the batch are invalidated when the batch is cleared or appended to.
+ *
+ */
+class TraceEventBatch {
+ public:
+  /**
+   * @brief Forward iterator over the trace events in the batch.
+   *
+   */
+  class Iterator {
+   public:
+    Iterator(const TraceEventBatch& batch, const std::size_t index);
+    Iterator& operator++();
+    bool operator==(const Iterator& other) const;
+    bool operator!=(const Iterator& other) const;
+    TraceEventView operator*() const;
+
+   private:
+    const TraceEventBatch* batch_;
+    std::size_t index_;
+  };
+
+  /**
+   * @brief Get the number of trace events in the batch.
+   *
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Check if the batch is empty.
+   *
+   */
+  bool empty() const;
+
+  /**
+   * @brief Get the number of bytes of trace events stored in the batch.
+   *
+   */
+  std::size_t bytes() const;
+
+  /**
+   * @brief Get a view into the trace event at the given index.
+   *
+   * @param index Index of the trace event in the range `[0, size())`.
+   * @returns Object of type `TraceEventView`.
+   */
+  TraceEventView operator[](const std::size_t index) const;
+
+  /**
+   * @brief Append a copy of the given serialized trace event to the batch.
+   *
+   * @param data Pointer to the memory containing the trace event.
+   * @param size Size in bytes of the trace event.
+   */
+  void append(const uint8_t* data, const std::size_t size);
+
+  /**
+   * @brief Remove all the trace events from the batch while keeping the arena
+   * memory for reuse.
+   *
+   */
+  void clear();
+
+  Iterator begin() const;
+  Iterator end() const;
+
+ private:
+  std::vector<uint8_t> arena_;
+  std::vector<std::size_t> offsets_;
 };
 
 }  // namespace inspector
\ No newline at end of file
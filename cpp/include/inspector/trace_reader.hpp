@@ -17,14 +17,22 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
+#include <inspector/channel.hpp>
 #include <inspector/trace_event.hpp>
 
 namespace inspector {
+namespace details {
+class EventQueueSet;
+}  // namespace details
 
 /**
  * @brief Read a stored trace event from the process shared queue. The method
- * blocks until a trace event is read.
+ * blocks until a trace event is read. When NUMA aware event queues are enabled,
+ * the per node queues are read in round robin order.
  *
  * @param max_attempt Number of attempts to make for reading a trace event.
  * Default set to 32.
@@ -32,4 +40,185 @@ namespace inspector {
  */
 TraceEvent readTraceEvent(const size_t max_attempt = 32);
 
+/**
+ * @brief Read a stored trace event of the given channel from the process
+ * shared queues. When multi-channel event queues are disabled, the channels
+ * share the same queues and trace events of any channel can be returned.
+ *
+ * @param channel Channel to read from.
+ * @param max_attempt Number of attempts to make for reading a trace event.
+ * Default set to 32.
+ * @returns An object of type `TraceEvent`.
+ */
+TraceEvent readTraceEvent(const Channel channel,
+                          const size_t max_attempt = 32);
+
+/**
+ * @brief Read a batch of stored trace events from the process shared queues in
+ * one pass. The trace events are copied into the reusable arena of the batch,
+ * avoiding per event allocations. Reading stops once either limit is reached
+ * or all the queues are empty.
+ *
+ * @param batch Reference to the batch to fill. The batch is cleared first.
+ * @param max_events Maximum number of trace events to read.
+ * @param max_bytes Maximum number of bytes to read. The limit can be exceeded
+ * by the size of the last trace event read.
+ * @param max_attempt Number of attempts to make for reading each trace event.
+ * Default set to 32.
+ * @returns Number of trace events read.
+ */
+std::size_t readTraceEvents(TraceEventBatch& batch,
+                            const std::size_t max_events,
+                            const std::size_t max_bytes,
+                            const size_t max_attempt = 32);
+
+/**
+ * @brief Read a batch of stored trace events of the given channel from the
+ * process shared queues in one pass.
+ *
+ * @param batch Reference to the batch to fill. The batch is cleared first.
+ * @param channel Channel to read from.
+ * @param max_events Maximum number of trace events to read.
+ * @param max_bytes Maximum number of bytes to read. The limit can be exceeded
+ * by the size of the last trace event read.
+ * @param max_attempt Number of attempts to make for reading each trace event.
+ * Default set to 32.
+ * @returns Number of trace events read.
+ */
+std::size_t readTraceEvents(TraceEventBatch& batch, const Channel channel,
+                            const std::size_t max_events,
+                            const std::size_t max_bytes,
+                            const size_t max_attempt = 32);
+
+/**
+ * @brief Prepare to wait for trace events published to the process shared
+ * queues. Should be called before draining the queues, so that trace events
+ * published while draining wake up the subsequent wait.
+ *
+ * @returns Token to pass to `waitForTraceEvents`.
+ */
+uint32_t prepareWaitForTraceEvents();
+
+/**
+ * @brief Block until the producers have filled the process shared queues up to
+ * the configured wakeup threshold, see `Config::eventQueueWakeupThreshold`, or
+ * the timeout expires.
+ *
+ * @param token Token returned by `prepareWaitForTraceEvents`.
+ * @param timeout Maximum time to block, i.e. the idle timeout.
+ * @returns `true` if woken by a producer else `false`.
+ */
+bool waitForTraceEvents(const uint32_t token,
+                        const std::chrono::microseconds timeout);
+
+/**
+ * @brief Get the identifiers of the traced processes publishing to their own
+ * event queues. Only used when per process event queues are enabled.
+ *
+ * @returns List of process identifiers.
+ */
+std::vector<int32_t> listTracedProcesses();
+
+/**
+ * @brief The class `ProcessTraceReader` reads stored trace events from the
+ * event queues of a single traced process when per process event queues are
+ * enabled. Readers of different processes can be used concurrently.
+ *
+ */
+class ProcessTraceReader final {
+ public:
+  /**
+   * @brief Construct a new ProcessTraceReader object. The event queues of the
+   * process are opened as part of the CTOR.
+   *
+   * @param pid OS unique identifier of the traced process.
+   */
+  explicit ProcessTraceReader(const int32_t pid);
+
+  ~ProcessTraceReader();
+
+  /**
+   * @brief Get the identifier of the traced process.
+   *
+   */
+  int32_t pid() const;
+
+  /**
+   * @brief Check if the traced process is still running.
+   *
+   */
+  bool isProcessAlive() const;
+
+  /**
+   * @brief Read a stored trace event from the event queues of the process.
+   *
+   * @param max_attempt Number of attempts to make for reading a trace event.
+   * Default set to 32.
+   * @returns An object of type `TraceEvent`.
+   */
+  TraceEvent read(const size_t max_attempt = 32);
+
+  /**
+   * @brief Read a stored trace event of the given channel from the event
+   * queues of the process.
+   *
+   * @param channel Channel to read from.
+   * @param max_attempt Number of attempts to make for reading a trace event.
+   * Default set to 32.
+   * @returns An object of type `TraceEvent`.
+   */
+  TraceEvent read(const Channel channel, const size_t max_attempt = 32);
+
+  /**
+   * @brief Read a batch of stored trace events from the event queues of the
+   * process in one pass. See `readTraceEvents` for details.
+   *
+   * @returns Number of trace events read.
+   */
+  std::size_t read(TraceEventBatch& batch, const std::size_t max_events,
+                   const std::size_t max_bytes, const size_t max_attempt = 32);
+
+  /**
+   * @brief Read a batch of stored trace events of the given channel from the
+   * event queues of the process in one pass. See `readTraceEvents` for
+   * details.
+   *
+   * @returns Number of trace events read.
+   */
+  std::size_t read(TraceEventBatch& batch, const Channel channel,
+                   const std::size_t max_events, const std::size_t max_bytes,
+                   const size_t max_attempt = 32);
+
+  /**
+   * @brief Prepare to wait for trace events published to the event queues of
+   * the process. See `prepareWaitForTraceEvents` for details.
+   *
+   * @returns Token to pass to `wait`.
+   */
+  uint32_t prepareWait();
+
+  /**
+   * @brief Block until the process has filled its event queues up to the
+   * configured wakeup threshold or the timeout expires. See
+   * `waitForTraceEvents` for details.
+   *
+   * @returns `true` if woken by the process else `false`.
+   */
+  bool wait(const uint32_t token, const std::chrono::microseconds timeout);
+
+  /**
+   * @brief Mark the event queues of the process for removal by the OS and
+   * remove the process from the registry. Should be called once the process
+   * has exited and its queues have been drained.
+   *
+   */
+  void release();
+
+ private:
+  int32_t pid_;
+  std::unique_ptr<details::EventQueueSet> queues_;
+  std::size_t next_queue_;
+  std::size_t next_channel_queue_[kChannelCount];
+};
+
 }  // namespace inspector
\ No newline at end of file
@@ -0,0 +1,39 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inspector/channel.hpp>
+#include <inspector/trace.hpp>
+
+namespace inspector {
+
+const char *channelName(const Channel channel) {
+  switch (channel) {
+    case Channel::kScope:
+      return "scope";
+    case Channel::kCounter:
+      return "counter";
+  }
+
+  return "unknown";
+}
+
+Channel eventChannel(const event_type_t type) {
+  return static_cast<EventType>(type) == EventType::kCounterTag
+             ? Channel::kCounter
+             : Channel::kScope;
+}
+
+}  // namespace inspector
@@ -16,38 +16,326 @@
 
 #include <inspector/config.hpp>
 
-#include <bigcat/circular_queue_a.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <inspector/details/logging.hpp>
+#include <inspector/details/queue.hpp>
 
 namespace inspector {
 namespace Config {
 namespace {
 
+/**
+ * @brief Get the value of an environment variable.
+ *
+ * @param name Name of the environment variable.
+ * @returns Value of the variable or empty string if not set.
+ */
+std::string getEnv(const char *name) {
+  const char *value = std::getenv(name);
+  return value ? value : "";
+}
+
+/**
+ * @brief Parse an unsigned integer from an environment variable. The value can
+ * end with one of the suffixes K, M or G to denote multiples of 1024.
+ *
+ * @param name Name of the environment variable.
+ * @param default_value Value returned when the variable is not set or invalid.
+ * @returns Parsed value.
+ */
+uint64_t getEnvUnsigned(const char *name, const uint64_t default_value) {
+  const auto value = getEnv(name);
+  if (value.empty()) {
+    return default_value;
+  }
+  try {
+    std::size_t pos = 0;
+    const uint64_t result = std::stoull(value, &pos);
+    const auto suffix = value.substr(pos);
+    unsigned shift = 0;
+    if (suffix == "K" || suffix == "k") {
+      shift = 10;
+    } else if (suffix == "M" || suffix == "m") {
+      shift = 20;
+    } else if (suffix == "G" || suffix == "g") {
+      shift = 30;
+    } else if (!suffix.empty()) {
+      throw std::invalid_argument(suffix);
+    }
+    if (result > (UINT64_MAX >> shift)) {
+      throw std::out_of_range(value);
+    }
+    return result << shift;
+  } catch (const std::exception &) {
+    LOG_WARN << "Ignoring invalid value '" << value
+             << "' for environment variable " << name << ".";
+  }
+  return default_value;
+}
+
+/**
+ * @brief Parse a boolean flag from an environment variable.
+ *
+ * @param name Name of the environment variable.
+ * @param default_value Value returned when the variable is not set.
+ * @returns Parsed value.
+ */
+bool getEnvFlag(const char *name, const bool default_value) {
+  const auto value = getEnv(name);
+  if (value.empty()) {
+    return default_value;
+  }
+  return value == "1" || value == "true" || value == "TRUE";
+}
+
 /**
  * @brief Flag to turn on and off capturing of trace events.
  *
  * @returns Reference to the flag.
  */
 bool &traceFlag() {
-  static bool value = true;
+  static bool value = !getEnvFlag("INSPECTOR_TRACE_DISABLED", false);
   return value;
 }
 
+/**
+ * @brief Flag to turn on and off NUMA aware event queues.
+ *
+ * @returns Reference to the flag.
+ */
+bool &numaFlag() {
+  static bool value = getEnvFlag("INSPECTOR_NUMA_AWARE_EVENT_QUEUE", false);
+  return value;
+}
+
+/**
+ * @brief Flag to turn on and off huge page backed event queues.
+ *
+ * @returns Reference to the flag.
+ */
+bool &hugePageFlag() {
+  static bool value = getEnvFlag("INSPECTOR_HUGE_PAGE_EVENT_QUEUE", false);
+  return value;
+}
+
+/**
+ * @brief Flag to turn on and off per process event queues.
+ *
+ * @returns Reference to the flag.
+ */
+bool &perProcessFlag() {
+  static bool value = getEnvFlag("INSPECTOR_PER_PROCESS_EVENT_QUEUE", false);
+  return value;
+}
+
+/**
+ * @brief Flag to turn on and off multi-channel event queues.
+ *
+ * @returns Reference to the flag.
+ */
+bool &multiChannelFlag() {
+  static bool value = getEnvFlag("INSPECTOR_MULTI_CHANNEL", false);
+  return value;
+}
+
+/**
+ * @brief Get the name of a per channel environment variable.
+ *
+ * @param channel Channel.
+ * @param setting Name of the setting, e.g. `PRIORITY`.
+ * @returns Name of the environment variable.
+ */
+std::string channelEnvName(const Channel channel, const char *setting) {
+  std::string name = channelName(channel);
+  for (auto &c : name) {
+    c = static_cast<char>(std::toupper(c));
+  }
+  return "INSPECTOR_EVENT_CHANNEL_" + name + "_" + setting;
+}
+
+std::array<std::size_t, kChannelCount> &channelBufferSizes() {
+  static std::array<std::size_t, kChannelCount> sizes = [] {
+    std::array<std::size_t, kChannelCount> values;
+    for (std::size_t i = 0; i < kChannelCount; ++i) {
+      values[i] = getEnvUnsigned(
+          channelEnvName(static_cast<Channel>(i), "BUFFER_SIZE").c_str(), 0);
+    }
+    return values;
+  }();
+  return sizes;
+}
+
+std::array<uint32_t, kChannelCount> &channelPriorities() {
+  static std::array<uint32_t, kChannelCount> priorities = [] {
+    std::array<uint32_t, kChannelCount> values;
+    for (std::size_t i = 0; i < kChannelCount; ++i) {
+      const auto channel = static_cast<Channel>(i);
+      values[i] = getEnvUnsigned(channelEnvName(channel, "PRIORITY").c_str(),
+                                 channel == Channel::kScope ? 4 : 1);
+    }
+    return values;
+  }();
+  return priorities;
+}
+
 std::string &queueName() {
-  static std::string name = "/inspector-56027e94-events";
+  static std::string name = [] {
+    const auto value = getEnv("INSPECTOR_EVENT_QUEUE_NAME");
+    return value.empty() ? "/inspector-56027e94-events" : value;
+  }();
   return name;
 }
 
+std::size_t &queueBufferSize() {
+  static std::size_t size = getEnvUnsigned("INSPECTOR_EVENT_QUEUE_BUFFER_SIZE",
+                                           8 * 1024 * 1024);  // 8MB
+  return size;
+}
+
+std::size_t &queueMaxProducers() {
+  static std::size_t count =
+      getEnvUnsigned("INSPECTOR_EVENT_QUEUE_MAX_PRODUCERS", 1024);
+  return count;
+}
+
+std::size_t &queueMaxConsumers() {
+  static std::size_t count =
+      getEnvUnsigned("INSPECTOR_EVENT_QUEUE_MAX_CONSUMERS", 1024);
+  return count;
+}
+
+uint64_t &queueTimeoutNs() {
+  static uint64_t timeout_ns =
+      getEnvUnsigned("INSPECTOR_EVENT_QUEUE_TIMEOUT_NS", 30000000000);  // 30s
+  return timeout_ns;
+}
+
+OverflowPolicy &queueOverflowPolicy() {
+  static OverflowPolicy policy = [] {
+    const auto value = getEnv("INSPECTOR_EVENT_QUEUE_OVERFLOW_POLICY");
+    if (value == "block") {
+      return OverflowPolicy::kBlock;
+    }
+    if (!value.empty() && value != "drop") {
+      LOG_WARN << "Ignoring invalid value '" << value
+               << "' for environment variable "
+                  "INSPECTOR_EVENT_QUEUE_OVERFLOW_POLICY.";
+    }
+    return OverflowPolicy::kDrop;
+  }();
+  return policy;
+}
+
+std::size_t &queueWakeupThreshold() {
+  static std::size_t percent =
+      getEnvUnsigned("INSPECTOR_EVENT_QUEUE_WAKEUP_THRESHOLD", 25);
+  return percent;
+}
+
 }  // namespace
 
 std::string eventQueueName() { return queueName(); }
 
 void setEventQueueName(const std::string &name) { queueName() = name; }
 
+std::size_t eventQueueBufferSize() { return queueBufferSize(); }
+
+void setEventQueueBufferSize(const std::size_t size) {
+  queueBufferSize() = size;
+}
+
+std::size_t eventQueueMaxProducers() { return queueMaxProducers(); }
+
+void setEventQueueMaxProducers(const std::size_t count) {
+  queueMaxProducers() = count;
+}
+
+std::size_t eventQueueMaxConsumers() { return queueMaxConsumers(); }
+
+void setEventQueueMaxConsumers(const std::size_t count) {
+  queueMaxConsumers() = count;
+}
+
+uint64_t eventQueueTimeoutNs() { return queueTimeoutNs(); }
+
+void setEventQueueTimeoutNs(const uint64_t timeout_ns) {
+  queueTimeoutNs() = timeout_ns;
+}
+
+OverflowPolicy eventQueueOverflowPolicy() { return queueOverflowPolicy(); }
+
+void setEventQueueOverflowPolicy(const OverflowPolicy policy) {
+  queueOverflowPolicy() = policy;
+}
+
+std::size_t eventQueueWakeupThreshold() {
+  return std::min<std::size_t>(queueWakeupThreshold(), 100);
+}
+
+void setEventQueueWakeupThreshold(const std::size_t percent) {
+  queueWakeupThreshold() = percent;
+}
+
+void verifyEventQueueGeometry() {
+  const auto mismatch = details::eventQueueGeometryMismatch();
+  if (!mismatch.empty()) {
+    throw std::runtime_error("Event queue geometry mismatch: " + mismatch);
+  }
+}
+
 bool isTraceDisabled() { return !traceFlag(); }
 
 void disableTrace() { traceFlag() = false; }
 
 void enableTrace() { traceFlag() = true; }
 
+bool isNumaAwareEventQueueEnabled() { return numaFlag(); }
+
+void enableNumaAwareEventQueue() { numaFlag() = true; }
+
+void disableNumaAwareEventQueue() { numaFlag() = false; }
+
+bool isHugePageEventQueueEnabled() { return hugePageFlag(); }
+
+void enableHugePageEventQueue() { hugePageFlag() = true; }
+
+void disableHugePageEventQueue() { hugePageFlag() = false; }
+
+bool isPerProcessEventQueueEnabled() { return perProcessFlag(); }
+
+void enablePerProcessEventQueue() { perProcessFlag() = true; }
+
+void disablePerProcessEventQueue() { perProcessFlag() = false; }
+
+bool isMultiChannelEnabled() { return multiChannelFlag(); }
+
+void enableMultiChannel() { multiChannelFlag() = true; }
+
+void disableMultiChannel() { multiChannelFlag() = false; }
+
+std::size_t eventChannelBufferSize(const Channel channel) {
+  const auto size = channelBufferSizes()[static_cast<std::size_t>(channel)];
+  return size ? size : eventQueueBufferSize();
+}
+
+void setEventChannelBufferSize(const Channel channel, const std::size_t size) {
+  channelBufferSizes()[static_cast<std::size_t>(channel)] = size;
+}
+
+uint32_t eventChannelPriority(const Channel channel) {
+  const auto priority = channelPriorities()[static_cast<std::size_t>(channel)];
+  return priority ? priority : 1;
+}
+
+void setEventChannelPriority(const Channel channel, const uint32_t priority) {
+  channelPriorities()[static_cast<std::size_t>(channel)] = priority;
+}
+
 }  // namespace Config
-}  // namespace inspector
\ No newline at end of file
+}  // namespace inspector
@@ -14,9 +14,11 @@
  * limitations under the License.
  */
 
+#include <cstdint>
 #include <cstring>
 #include <inspector/debug_args.hpp>
 #include <inspector/details/debug_args.hpp>
+#include <memory>
 #include <stdexcept>
 #include <string>
 
@@ -40,8 +42,7 @@ T DebugArg::value() const {
     throw std::runtime_error("Invalid type specified for argument of type '" +
                              std::to_string(static_cast<int>(type())) + "'.");
   }
-  return *static_cast<const T *>(static_cast<const void *>(
-      static_cast<const uint8_t *>(address_) + sizeof(uint8_t)));
+  return valueUnchecked<T>();
 }
 
 // Instantiating for different supported data types
@@ -63,8 +64,7 @@ const char *DebugArg::value<const char *>() const {
     throw std::runtime_error("Invalid type specified for argument of type '" +
                              std::to_string(static_cast<int>(type())) + "'.");
   }
-  return static_cast<const char *>(static_cast<const void *>(
-      static_cast<const uint8_t *>(address_) + sizeof(uint8_t)));
+  return valueUnchecked<const char *>();
 }
 
 // Template specialization for std::string
@@ -80,8 +80,7 @@ KeywordArg DebugArg::value<KeywordArg>() const {
     throw std::runtime_error("Invalid type specified for argument of type '" +
                              std::to_string(static_cast<int>(type())) + "'.");
   }
-  return KeywordArg(static_cast<const void *>(
-      static_cast<const uint8_t *>(address_) + sizeof(uint8_t)));
+  return valueUnchecked<KeywordArg>();
 }
 
 const void *DebugArg::address() const { return address_; }
@@ -106,59 +105,107 @@ const char *KeywordArg::name() const { return name_; }
 namespace {
 
 /**
- * @brief Get the storage size in bytes occupied by the given debug argument.
+ * @brief Get the size in bytes of the null terminated string stored at the
+ * given address, including the terminator.
  *
+ * @returns Size in bytes or 0 if no terminator is found within the limit.
  */
-size_t storageSize(const DebugArg &debug_arg) {
-  switch (debug_arg.type()) {
+size_t stringStorageSize(const uint8_t *const address, const size_t limit) {
+  const void *end = std::memchr(address, '\0', limit);
+  if (end == nullptr) {
+    return 0;
+  }
+  return static_cast<size_t>(static_cast<const uint8_t *>(end) - address) +
+         sizeof(char);
+}
+
+/**
+ * @brief Get the storage size in bytes occupied by the debug argument stored
+ * at the given address. The size is decoded directly from the type marker
+ * without going through the type checked value accessors.
+ *
+ * @param address Address of the debug argument.
+ * @param limit Maximum number of bytes the argument can occupy.
+ * @returns Size in bytes or 0 if the argument is malformed.
+ */
+size_t storageSize(const uint8_t *const address, const size_t limit) {
+  if (limit < sizeof(uint8_t)) {
+    return 0;
+  }
+  size_t size = 0;
+  switch (static_cast<DebugArg::Type>(*address)) {
     case DebugArg::Type::TYPE_INT16: {
-      return details::debugArgStorageSize(debug_arg.value<int16_t>());
+      size = details::debugArgStorageSize(int16_t{});
+      break;
     }
     case DebugArg::Type::TYPE_INT32: {
-      return details::debugArgStorageSize(debug_arg.value<int32_t>());
+      size = details::debugArgStorageSize(int32_t{});
+      break;
     }
     case DebugArg::Type::TYPE_INT64: {
-      return details::debugArgStorageSize(debug_arg.value<int64_t>());
+      size = details::debugArgStorageSize(int64_t{});
+      break;
     }
     case DebugArg::Type::TYPE_UINT8: {
-      return details::debugArgStorageSize(debug_arg.value<uint8_t>());
+      size = details::debugArgStorageSize(uint8_t{});
+      break;
     }
     case DebugArg::Type::TYPE_UINT16: {
-      return details::debugArgStorageSize(debug_arg.value<uint16_t>());
+      size = details::debugArgStorageSize(uint16_t{});
+      break;
     }
     case DebugArg::Type::TYPE_UINT32: {
-      return details::debugArgStorageSize(debug_arg.value<uint32_t>());
+      size = details::debugArgStorageSize(uint32_t{});
+      break;
     }
     case DebugArg::Type::TYPE_UINT64: {
-      return details::debugArgStorageSize(debug_arg.value<uint64_t>());
+      size = details::debugArgStorageSize(uint64_t{});
+      break;
     }
     case DebugArg::Type::TYPE_FLOAT: {
-      return details::debugArgStorageSize(debug_arg.value<float>());
+      size = details::debugArgStorageSize(float{});
+      break;
     }
     case DebugArg::Type::TYPE_DOUBLE: {
-      return details::debugArgStorageSize(debug_arg.value<double>());
+      size = details::debugArgStorageSize(double{});
+      break;
     }
     case DebugArg::Type::TYPE_CHAR: {
-      return details::debugArgStorageSize(debug_arg.value<char>());
+      size = details::debugArgStorageSize(char{});
+      break;
     }
     case DebugArg::Type::TYPE_STRING: {
-      return details::debugArgStorageSize(debug_arg.value<const char *>());
+      const auto chars = stringStorageSize(address + sizeof(uint8_t),
+                                           limit - sizeof(uint8_t));
+      size = chars ? sizeof(uint8_t) + chars : 0;
+      break;
     }
     case DebugArg::Type::TYPE_KWARG: {
-      const auto arg = debug_arg.value<KeywordArg>();
-      return details::debugArgStorageSize(arg.name()) + storageSize(arg);
+      // The type marker of a keyword argument is followed by its name and then
+      // by the value stored as a regular debug argument.
+      const auto name = stringStorageSize(address + sizeof(uint8_t),
+                                          limit - sizeof(uint8_t));
+      if (name == 0) {
+        return 0;
+      }
+      const auto prefix = sizeof(uint8_t) + name;
+      const auto value = storageSize(address + prefix, limit - prefix);
+      size = value ? prefix + value : 0;
+      break;
     }
   }
 
-  return 0;
+  return size <= limit ? size : 0;
 }
 
 }  // namespace
 
-DebugArgs::Iterator::Iterator() : debug_arg_(nullptr), count_(0) {}
+DebugArgs::Iterator::Iterator()
+    : debug_arg_(nullptr), count_(0), storage_size_(0) {}
 
-DebugArgs::Iterator::Iterator(const void *const address, const size_t count)
-    : debug_arg_(address), count_(count) {}
+DebugArgs::Iterator::Iterator(const void *const address, const size_t count,
+                              const size_t storage_size)
+    : debug_arg_(address), count_(count), storage_size_(storage_size) {}
 
 const DebugArg &DebugArgs::Iterator::operator*() const { return debug_arg_; }
 
@@ -170,9 +217,11 @@ DebugArgs::Iterator &DebugArgs::Iterator::operator++() {
   if (count_ == 0) {
     return *this;
   }
+  const auto size = storageSize(
+      static_cast<const uint8_t *>(debug_arg_.address()), storage_size_);
   debug_arg_ = DebugArg(static_cast<const void *>(
-      static_cast<const uint8_t *>(debug_arg_.address()) +
-      storageSize(debug_arg_)));
+      static_cast<const uint8_t *>(debug_arg_.address()) + size));
+  storage_size_ -= size;
   --count_;
   return *this;
 }
@@ -190,22 +239,71 @@ bool DebugArgs::Iterator::operator!=(const Iterator &other) const {
 // `DebugArgs` Implementation
 // ---
 
-DebugArgs::DebugArgs() : address_(nullptr), storage_size_(0), count_(0) {}
+DebugArgs::DebugArgs()
+    : address_(nullptr), storage_size_(0), count_(0), inline_offsets_() {}
 
 DebugArgs::DebugArgs(const void *const address, const size_t storage_size,
                      const size_t count)
-    : address_(address), storage_size_(storage_size), count_(count) {}
+    : address_(address),
+      storage_size_(storage_size),
+      count_(0),
+      inline_offsets_() {
+  if (count > kInlineOffsets) {
+    offsets_.reserve(count);
+  }
+  const auto *const start = static_cast<const uint8_t *>(address_);
+  size_t offset = 0;
+  while (count_ < count) {
+    const auto size = storageSize(start + offset, storage_size_ - offset);
+    if (size == 0) {
+      break;
+    }
+    if (count > kInlineOffsets) {
+      offsets_.push_back(static_cast<uint32_t>(offset));
+    } else {
+      inline_offsets_[count_] = static_cast<uint32_t>(offset);
+    }
+    offset += size;
+    ++count_;
+  }
+  storage_size_ = offset;
+}
+
+uint32_t DebugArgs::offset(const size_t index) const {
+  return offsets_.empty() ? inline_offsets_[index] : offsets_[index];
+}
 
 size_t DebugArgs::size() const { return count_; }
 
+DebugArg DebugArgs::operator[](const size_t index) const {
+  return DebugArg(static_cast<const void *>(
+      static_cast<const uint8_t *>(address_) + offset(index)));
+}
+
+std::optional<KeywordArg> DebugArgs::kwarg(const char *const name) const {
+  const auto *const start = static_cast<const uint8_t *>(address_);
+  for (size_t index = 0; index < count_; ++index) {
+    const auto *const arg = start + offset(index);
+    if (static_cast<DebugArg::Type>(*arg) != DebugArg::Type::TYPE_KWARG) {
+      continue;
+    }
+    const auto *const arg_name =
+        reinterpret_cast<const char *>(arg + sizeof(uint8_t));
+    if (arg_name[0] == name[0] && std::strcmp(arg_name, name) == 0) {
+      return KeywordArg(static_cast<const void *>(arg + sizeof(uint8_t)));
+    }
+  }
+  return std::nullopt;
+}
+
 DebugArgs::Iterator DebugArgs::begin() const {
-  return Iterator(address_, count_);
+  return Iterator(address_, count_, storage_size_);
 }
 
 DebugArgs::Iterator DebugArgs::end() const {
   return Iterator(static_cast<const void *>(
                       static_cast<const uint8_t *>(address_) + storage_size_),
-                  0);
+                  0, 0);
 }
 
-}  // namespace inspector
\ No newline at end of file
+}  // namespace inspector
@@ -0,0 +1,259 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inspector/details/json_writer.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace inspector {
+namespace details {
+namespace {
+
+/**
+ * @brief Hexadecimal digits used to escape control characters.
+ *
+ */
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+/**
+ * @brief Check if the given character needs to be escaped.
+ *
+ */
+inline bool needsEscape(const unsigned char c) {
+  return c < 0x20 || c == '"' || c == '\\';
+}
+
+/**
+ * @brief Get the number of leading characters in the given string which do not
+ * need to be escaped.
+ *
+ */
+std::size_t cleanPrefixSize(const char *data, const std::size_t size) {
+  std::size_t index = 0;
+#if defined(__SSE2__)
+  const auto quote = _mm_set1_epi8('"');
+  const auto backslash = _mm_set1_epi8('\\');
+  const auto max_control = _mm_set1_epi8(0x1f);
+  for (; index + 16 <= size; index += 16) {
+    const auto chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + index));
+    // Unsigned `c <= 0x1f` is computed as `min(c, 0x1f) == c`.
+    const auto special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk));
+    const auto mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return index + __builtin_ctz(mask);
+    }
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  const auto quote = vdupq_n_u8('"');
+  const auto backslash = vdupq_n_u8('\\');
+  const auto space = vdupq_n_u8(0x20);
+  for (; index + 16 <= size; index += 16) {
+    const auto chunk =
+        vld1q_u8(reinterpret_cast<const uint8_t *>(data + index));
+    const auto special =
+        vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)),
+                 vcltq_u8(chunk, space));
+    if (vmaxvq_u8(special) != 0) {
+      break;
+    }
+  }
+#endif
+  while (index < size &&
+         !needsEscape(static_cast<unsigned char>(data[index]))) {
+    ++index;
+  }
+  return index;
+}
+
+/**
+ * @brief Append the escape sequence of the given character to the buffer.
+ *
+ */
+void appendEscaped(const unsigned char c, std::string &buffer) {
+  switch (c) {
+    case '"':
+      buffer.append("\\\"", 2);
+      break;
+    case '\\':
+      buffer.append("\\\\", 2);
+      break;
+    case '\b':
+      buffer.append("\\b", 2);
+      break;
+    case '\f':
+      buffer.append("\\f", 2);
+      break;
+    case '\n':
+      buffer.append("\\n", 2);
+      break;
+    case '\r':
+      buffer.append("\\r", 2);
+      break;
+    case '\t':
+      buffer.append("\\t", 2);
+      break;
+    default: {
+      const char chars[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                            kHexDigits[c & 0xf]};
+      buffer.append(chars, sizeof(chars));
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+void escapeJsonString(const char *data, const std::size_t size,
+                      std::string &buffer) {
+  std::size_t index = 0;
+  while (index < size) {
+    const auto clean = cleanPrefixSize(data + index, size - index);
+    buffer.append(data + index, clean);
+    index += clean;
+    if (index < size) {
+      appendEscaped(static_cast<unsigned char>(data[index]), buffer);
+      ++index;
+    }
+  }
+}
+
+// ------------------------------------------------
+// JsonWriter
+// ------------------------------------------------
+
+JsonWriter::JsonWriter(std::string &buffer)
+    : buffer_(buffer), has_items_(0), depth_(0), after_key_(false) {}
+
+JsonWriter &JsonWriter::beginObject() {
+  separate();
+  buffer_.push_back('{');
+  ++depth_;
+  assert(depth_ < 64);
+  has_items_ &= ~(uint64_t{1} << depth_);
+  return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+  --depth_;
+  buffer_.push_back('}');
+  return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+  separate();
+  buffer_.push_back('[');
+  ++depth_;
+  assert(depth_ < 64);
+  has_items_ &= ~(uint64_t{1} << depth_);
+  return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+  --depth_;
+  buffer_.push_back(']');
+  return *this;
+}
+
+JsonWriter &JsonWriter::key(const char *name) {
+  separate();
+  buffer_.push_back('"');
+  escapeJsonString(name, std::strlen(name), buffer_);
+  buffer_.append("\":", 2);
+  after_key_ = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *str) {
+  if (str == nullptr) {
+    return null();
+  }
+  return value(str, std::strlen(str));
+}
+
+JsonWriter &JsonWriter::value(const char *str, const std::size_t size) {
+  separate();
+  buffer_.push_back('"');
+  escapeJsonString(str, size, buffer_);
+  buffer_.push_back('"');
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const double number) {
+  if (!std::isfinite(number)) {
+    return null();
+  }
+  separate();
+  char chars[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const auto result = std::to_chars(chars, chars + sizeof(chars), number);
+  buffer_.append(chars, result.ptr);
+#else
+  const auto size = std::snprintf(chars, sizeof(chars), "%.17g", number);
+  buffer_.append(chars, size);
+#endif
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const float number) {
+  if (!std::isfinite(number)) {
+    return null();
+  }
+  separate();
+  char chars[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const auto result = std::to_chars(chars, chars + sizeof(chars), number);
+  buffer_.append(chars, result.ptr);
+#else
+  const auto size = std::snprintf(chars, sizeof(chars), "%.9g", number);
+  buffer_.append(chars, size);
+#endif
+  return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+  separate();
+  buffer_.append("null", 4);
+  return *this;
+}
+
+// private
+void JsonWriter::separate() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  const auto bit = uint64_t{1} << depth_;
+  if (has_items_ & bit) {
+    buffer_.push_back(',');
+  }
+  has_items_ |= bit;
+}
+
+}  // namespace details
+}  // namespace inspector
@@ -16,36 +16,582 @@
 
 #include <inspector/details/queue.hpp>
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include <inspector/config.hpp>
 #include <inspector/details/logging.hpp>
+#include <inspector/details/system.hpp>
 
 namespace inspector {
 namespace details {
 namespace {
 
 /**
- * @brief Get the circular queue configuration.
+ * @brief Get the number of channels with their own event queues.
+ *
+ */
+std::size_t channelQueueCount() {
+  return Config::isMultiChannelEnabled() ? kChannelCount : 1;
+}
+
+/**
+ * @brief Get the number of event queues opened per channel.
+ *
+ */
+std::size_t nodeQueueCount() {
+  return Config::isNumaAwareEventQueueEnabled() ? getNumaNodeCount() : 1;
+}
+
+/**
+ * @brief Get the number of event queues to open.
+ *
+ */
+std::size_t queueCount() { return channelQueueCount() * nodeQueueCount(); }
+
+/**
+ * @brief Get the index of the first event queue of the given channel.
+ *
+ */
+std::size_t channelQueueOffset(const Channel channel) {
+  return Config::isMultiChannelEnabled()
+             ? static_cast<std::size_t>(channel) * nodeQueueCount()
+             : 0;
+}
+
+/**
+ * @brief Get the buffer size of the event queues of the given channel.
  *
  */
-bigcat::CircularQueueA::Config queueConfig() {
+std::size_t queueBufferSize(const Channel channel) {
+  return Config::isMultiChannelEnabled()
+             ? Config::eventChannelBufferSize(channel)
+             : Config::eventQueueBufferSize();
+}
+
+/**
+ * @brief Get the circular queue configuration for the given channel.
+ *
+ */
+bigcat::CircularQueueA::Config queueConfig(const Channel channel) {
   bigcat::CircularQueueA::Config config;
-  config.buffer_size = 8 * 1024 * 1024;  // 8MB
-  config.max_producers = 1024;
-  config.max_consumers = 1024;
-  config.timeout_ns = 30000000000;  // 30s
+  config.buffer_size = queueBufferSize(channel);
+  config.max_producers = Config::eventQueueMaxProducers();
+  config.max_consumers = Config::eventQueueMaxConsumers();
+  config.timeout_ns = Config::eventQueueTimeoutNs();
   config.start_marker = 811347036;  // "\\,\\0"
   return config;
 }
 
+/**
+ * @brief Get the number of pending bytes above which producers wake up the
+ * consumers of the event queues, computed from the smallest queue.
+ *
+ */
+std::size_t wakeupThreshold() {
+  auto size = queueBufferSize(Channel::kScope);
+  for (std::size_t i = 1; i < channelQueueCount(); ++i) {
+    size = std::min(size, queueBufferSize(static_cast<Channel>(i)));
+  }
+  return size / 100 * Config::eventQueueWakeupThreshold();
+}
+
+/**
+ * @brief Number of bytes published by a thread before it reports them to the
+ * queue signal. Batching the reports keeps the shared counter off the publish
+ * path of every trace event.
+ *
+ */
+constexpr std::size_t kSignalBatchBytes = 4096;
+
+/**
+ * @brief Maximum time a producer blocked on a full queue sleeps before it
+ * retries. Bounds the wait on platforms without futexes and when a consumer
+ * does not report consumed trace events.
+ *
+ */
+constexpr std::chrono::microseconds kSpaceWaitSlice{100};
+
+/**
+ * @brief Marker value stored in the geometry descriptor once it has been fully
+ * written by its creator.
+ *
+ */
+constexpr uint32_t kGeometryReadyMarker = 0x47454f4d;  // "GEOM"
+
+/**
+ * @brief Maximum time to wait for a geometry descriptor being written by
+ * another process.
+ *
+ */
+constexpr std::chrono::seconds kGeometryWaitTimeout{1};
+
+/**
+ * @brief The data structure `QueueGeometry` describes the geometry with which
+ * the event queues were created. It is stored in process shared memory next to
+ * the queues so that producers and consumers can check that they agree.
+ *
+ */
+struct QueueGeometry {
+  std::atomic<uint32_t> ready;
+  uint32_t queue_count;
+  uint32_t channel_count;
+  uint64_t buffer_size[kChannelCount];
+  uint64_t max_producers;
+  uint64_t max_consumers;
+  uint64_t timeout_ns;
+};
+
+/**
+ * @brief Get the system unique name of the geometry descriptor.
+ *
+ */
+std::string geometryName() { return Config::eventQueueName() + "-geometry"; }
+
+/**
+ * @brief Create the geometry descriptor from the current configuration, or
+ * compare the current configuration against an existing descriptor.
+ *
+ * @returns Description of the mismatch or empty string if they match.
+ */
+std::string createOrCompareGeometry() {
+  const auto name = geometryName();
+  bool created = true;
+  int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR,
+                      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd < 0 && errno == EEXIST) {
+    created = false;
+    fd = ::shm_open(name.c_str(), O_RDWR, 0);
+  }
+  if (fd < 0) {
+    LOG_WARN << "Unable to open event queue geometry descriptor '" << name
+             << "'.";
+    return "";
+  }
+  // A process losing the race to create the descriptor may open it before its
+  // creator extended it, in which case reading it would fault. Extending is
+  // done by either process as it only grows the descriptor, which stays zero
+  // filled and thus not ready until written by its creator.
+  struct stat buffer;
+  if (::fstat(fd, &buffer) == -1 ||
+      (static_cast<std::size_t>(buffer.st_size) < sizeof(QueueGeometry) &&
+       ::ftruncate(fd, sizeof(QueueGeometry)) == -1)) {
+    ::close(fd);
+    return "";
+  }
+  void *address = ::mmap(nullptr, sizeof(QueueGeometry),
+                         PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED) {
+    return "";
+  }
+  auto *geometry = static_cast<QueueGeometry *>(address);
+
+  std::stringstream mismatch;
+  if (created) {
+    geometry->queue_count = queueCount();
+    geometry->channel_count = channelQueueCount();
+    for (std::size_t i = 0; i < kChannelCount; ++i) {
+      geometry->buffer_size[i] = queueBufferSize(static_cast<Channel>(i));
+    }
+    geometry->max_producers = Config::eventQueueMaxProducers();
+    geometry->max_consumers = Config::eventQueueMaxConsumers();
+    geometry->timeout_ns = Config::eventQueueTimeoutNs();
+    geometry->ready.store(kGeometryReadyMarker, std::memory_order_release);
+  } else {
+    const auto deadline =
+        std::chrono::steady_clock::now() + kGeometryWaitTimeout;
+    while (geometry->ready.load(std::memory_order_acquire) !=
+               kGeometryReadyMarker &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (geometry->ready.load(std::memory_order_acquire) ==
+        kGeometryReadyMarker) {
+      const auto compare = [&mismatch](const char *field, const uint64_t actual,
+                                       const uint64_t expected) {
+        if (actual != expected) {
+          mismatch << (mismatch.tellp() ? ", " : "") << field << " is "
+                   << actual << " but configured as " << expected;
+        }
+      };
+      compare("queue count", geometry->queue_count, queueCount());
+      compare("channel count", geometry->channel_count, channelQueueCount());
+      for (std::size_t i = 0; i < kChannelCount; ++i) {
+        const auto channel = static_cast<Channel>(i);
+        const auto field = std::string(channelName(channel)) + " buffer size";
+        compare(field.c_str(), geometry->buffer_size[i],
+                queueBufferSize(channel));
+      }
+      compare("max producers", geometry->max_producers,
+              Config::eventQueueMaxProducers());
+      compare("max consumers", geometry->max_consumers,
+              Config::eventQueueMaxConsumers());
+      compare("timeout", geometry->timeout_ns, Config::eventQueueTimeoutNs());
+    }
+  }
+  ::munmap(address, sizeof(QueueGeometry));
+
+  return mismatch.str();
+}
+
+/**
+ * @brief Maximum number of processes that can register their own event queues
+ * in the registry.
+ *
+ */
+constexpr std::size_t kMaxRegisteredProcesses = 4096;
+
+/**
+ * @brief The data structure `QueueRegistry` lists the processes which publish
+ * to their own event queues. It is stored in process shared memory so that
+ * recorders can discover the queues. Free entries are set to 0.
+ *
+ */
+struct QueueRegistry {
+  std::atomic<int32_t> pids[kMaxRegisteredProcesses];
+};
+
+/**
+ * @brief Get the system unique name of the registry.
+ *
+ */
+std::string registryName() { return Config::eventQueueName() + "-registry"; }
+
+/**
+ * @brief Get the registry of per process event queues. The registry is created
+ * on first use if it does not exist.
+ *
+ * @returns Pointer to the registry or `nullptr` if it could not be opened.
+ */
+QueueRegistry *registry() {
+  static QueueRegistry *registry = []() -> QueueRegistry * {
+    const auto name = registryName();
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR,
+                              S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+    if (fd < 0) {
+      LOG_WARN << "Unable to open event queue registry '" << name << "'.";
+      return nullptr;
+    }
+    // Extending the shared memory zero fills it, so that a registry created
+    // concurrently by multiple processes starts out with only free entries.
+    struct stat buffer;
+    if (::fstat(fd, &buffer) == -1 ||
+        (static_cast<std::size_t>(buffer.st_size) < sizeof(QueueRegistry) &&
+         ::ftruncate(fd, sizeof(QueueRegistry)) == -1)) {
+      ::close(fd);
+      return nullptr;
+    }
+    void *address = ::mmap(nullptr, sizeof(QueueRegistry),
+                           PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    return address == MAP_FAILED ? nullptr
+                                 : static_cast<QueueRegistry *>(address);
+  }();
+  return registry;
+}
+
+/**
+ * @brief Get the base name of the event queues published to by the calling
+ * process.
+ *
+ */
+std::string localEventQueueSetName() {
+  return Config::isPerProcessEventQueueEnabled() ? eventQueueSetName(getPID())
+                                                 : Config::eventQueueName();
+}
+
+/**
+ * @brief The data structure `LocalEventQueueState` holds the event queues
+ * published to by the calling process and whether the process attempted to
+ * register them.
+ *
+ */
+struct LocalEventQueueState {
+  std::mutex mutex;  //<- Guards the opening of the queues.
+  std::unique_ptr<EventQueueSet> owner;
+  std::atomic<EventQueueSet *> queues{nullptr};
+  std::atomic_bool registered{false};
+};
+
+/**
+ * @brief Get the state of the event queues of the calling process. A child
+ * created by `fork()` inherits the queues and the registration of its parent,
+ * so the state is reset in the child and the queues are opened and registered
+ * again on first use, under the identifier of the child.
+ *
+ */
+LocalEventQueueState &localEventQueueState() {
+  static LocalEventQueueState state;
+  static const int handlers = ::pthread_atfork(
+      [] { localEventQueueState().mutex.lock(); },
+      [] { localEventQueueState().mutex.unlock(); },
+      [] {
+        auto &state = localEventQueueState();
+        // The mappings of the parent are left alone as the child can still
+        // hold references into them.
+        static_cast<void>(state.owner.release());
+        state.queues.store(nullptr, std::memory_order_relaxed);
+        state.registered.store(false, std::memory_order_relaxed);
+        state.mutex.unlock();
+      });
+  static_cast<void>(handlers);
+  return state;
+}
+
 }  // namespace
 
-bigcat::CircularQueueA &eventQueue() {
-  static bigcat::CircularQueueA queue =
-      bigcat::CircularQueueA::open(Config::eventQueueName(), queueConfig());
-  return queue;
+/**
+ * @brief The data structure `EventQueueSlot` owns an opened event queue.
+ *
+ */
+struct EventQueueSlot {
+  EventQueueSlot(const std::string &name,
+                 const bigcat::CircularQueueA::Config &config)
+      : queue(bigcat::CircularQueueA::open(name, config)) {
+    if (Config::isHugePageEventQueueEnabled() &&
+        !adviseSharedMemoryHugePages(name)) {
+      LOG_WARN << "Unable to back event queue '" << name
+               << "' with huge pages. Using regular pages.";
+    }
+  }
+
+  bigcat::CircularQueueA queue;
+};
+
+// ------------------------------------------------
+// EventQueueSet
+// ------------------------------------------------
+
+EventQueueSet::EventQueueSet(const std::string &name)
+    : name_(name), signal_(name + "-signal", wakeupThreshold()) {
+  const auto count = queueCount();
+  for (std::size_t index = 0; index < count; ++index) {
+    const auto channel = static_cast<Channel>(index / nodeQueueCount());
+    slots_.emplace_back(std::make_unique<EventQueueSlot>(
+        queueName(index), queueConfig(channel)));
+  }
+}
+
+EventQueueSet::~EventQueueSet() = default;
+
+const std::string &EventQueueSet::name() const { return name_; }
+
+std::size_t EventQueueSet::count() const { return slots_.size(); }
+
+bigcat::CircularQueueA &EventQueueSet::queue(const std::size_t index) {
+  return slots_[index]->queue;
+}
+
+std::size_t EventQueueSet::count(const Channel /*channel*/) const {
+  // Every channel spans the same number of queues.
+  return slots_.size() / channelQueueCount();
+}
+
+bigcat::CircularQueueA &EventQueueSet::queue(const Channel channel,
+                                             const std::size_t index) {
+  return queue(channelQueueOffset(channel) + index);
+}
+
+std::string EventQueueSet::queueName(const std::size_t index) const {
+  auto name = name_;
+  const auto node_count = nodeQueueCount();
+  if (Config::isMultiChannelEnabled()) {
+    name += "-";
+    name += channelName(static_cast<Channel>(index / node_count));
+  }
+  if (Config::isNumaAwareEventQueueEnabled()) {
+    name += "-node" + std::to_string(index % node_count);
+  }
+  return name;
+}
+
+QueueSignal &EventQueueSet::signal() { return signal_; }
+
+void EventQueueSet::remove() const {
+  for (std::size_t index = 0; index < count(); ++index) {
+    bigcat::CircularQueueA::remove(queueName(index));
+  }
+  signal_.remove();
+}
+
+// ------------------------------------------------
+
+std::string eventQueueSetName(const int32_t pid) {
+  return Config::eventQueueName() + "-" + std::to_string(pid);
+}
+
+EventQueueSet &localEventQueues() {
+  auto &state = localEventQueueState();
+  auto *queues = state.queues.load(std::memory_order_acquire);
+  if (queues) {
+    return *queues;
+  }
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.owner) {
+    const auto mismatch = createOrCompareGeometry();
+    if (!mismatch.empty()) {
+      LOG_WARN << "Event queue geometry mismatch: " << mismatch;
+    }
+    state.owner = std::make_unique<EventQueueSet>(localEventQueueSetName());
+    state.queues.store(state.owner.get(), std::memory_order_release);
+  }
+  return *state.owner;
+}
+
+bigcat::CircularQueueA &eventQueue(const Channel channel) {
+  const auto count = eventQueueCount(channel);
+  if (count == 1) {
+    return eventQueue(channel, 0);
+  }
+  return eventQueue(channel, getNumaNode() % count);
+}
+
+std::size_t eventQueueCount() { return localEventQueues().count(); }
+
+bigcat::CircularQueueA &eventQueue(const std::size_t index) {
+  return localEventQueues().queue(index);
+}
+
+std::size_t eventQueueCount(const Channel channel) {
+  return localEventQueues().count(channel);
+}
+
+bigcat::CircularQueueA &eventQueue(const Channel channel,
+                                   const std::size_t index) {
+  return localEventQueues().queue(channel, index);
+}
+
+std::string eventQueueName(const std::size_t index) {
+  return localEventQueues().queueName(index);
+}
+
+void publishTraceEvent(const Channel channel,
+                       const std::vector<uint8_t> &buffer) {
+  // Processes publishing to their own queues register them on first publish
+  // so that recorders can discover them.
+  auto &state = localEventQueueState();
+  if (!state.registered.load(std::memory_order_acquire) &&
+      !state.registered.exchange(true, std::memory_order_acq_rel) &&
+      Config::isPerProcessEventQueueEnabled()) {
+    registerEventQueues();
+  }
+
+  auto &queue = eventQueue(channel);
+  auto status = queue.publish(buffer);
+  if (status != bigcat::CircularQueueA::Status::OK &&
+      Config::eventQueueOverflowPolicy() == Config::OverflowPolicy::kBlock) {
+    const auto deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::nanoseconds(Config::eventQueueTimeoutNs());
+    // Wake up the recorder right away as it is the only way out of a full
+    // queue, then sleep until it reports consumed trace events.
+    auto &signal = localEventQueues().signal();
+    signal.wake();
+    signal.beginSpaceWait();
+    while (true) {
+      const auto token = signal.spaceToken();
+      status = queue.publish(buffer);
+      const auto now = std::chrono::steady_clock::now();
+      if (status == bigcat::CircularQueueA::Status::OK || now >= deadline) {
+        break;
+      }
+      signal.waitForSpace(
+          token, std::min(kSpaceWaitSlice,
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                              deadline - now)));
+    }
+    signal.endSpaceWait();
+  }
+  if (status != bigcat::CircularQueueA::Status::OK) {
+    return;
+  }
+
+  thread_local std::size_t pending_bytes = 0;
+  pending_bytes += buffer.size();
+  if (pending_bytes >= kSignalBatchBytes) {
+    localEventQueues().signal().notify(pending_bytes);
+    pending_bytes = 0;
+  }
+}
+
+bool registerEventQueues() {
+  auto *entries = registry();
+  if (entries == nullptr) {
+    return false;
+  }
+  const auto pid = getPID();
+  for (auto &entry : entries->pids) {
+    if (entry.load(std::memory_order_acquire) == pid) {
+      return true;
+    }
+  }
+  for (auto &entry : entries->pids) {
+    int32_t expected = 0;
+    if (entry.compare_exchange_strong(expected, pid,
+                                      std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  LOG_WARN << "Event queue registry is full. Trace events of process " << pid
+           << " will not be discovered by recorders.";
+  return false;
+}
+
+std::vector<int32_t> registeredEventQueues() {
+  std::vector<int32_t> pids;
+  auto *entries = registry();
+  if (entries == nullptr) {
+    return pids;
+  }
+  for (auto &entry : entries->pids) {
+    const auto pid = entry.load(std::memory_order_acquire);
+    if (pid != 0) {
+      pids.push_back(pid);
+    }
+  }
+  return pids;
+}
+
+void unregisterEventQueues(const int32_t pid) {
+  auto *entries = registry();
+  if (entries == nullptr) {
+    return;
+  }
+  for (auto &entry : entries->pids) {
+    int32_t expected = pid;
+    entry.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+  }
+}
+
+std::string eventQueueGeometryMismatch() {
+  localEventQueues();
+  return createOrCompareGeometry();
+}
+
+void removeEventQueues() {
+  localEventQueues().remove();
+  ::shm_unlink(geometryName().c_str());
+  if (Config::isPerProcessEventQueueEnabled()) {
+    unregisterEventQueues(getPID());
+    if (registeredEventQueues().empty()) {
+      ::shm_unlink(registryName().c_str());
+    }
+  }
 }
 
 }  // namespace details
-}  // namespace inspector
\ No newline at end of file
+}  // namespace inspector
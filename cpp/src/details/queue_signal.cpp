@@ -0,0 +1,219 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inspector/details/queue_signal.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <atomic>
+#include <climits>
+#include <thread>
+
+#include <inspector/details/logging.hpp>
+
+namespace inspector {
+namespace details {
+
+/**
+ * @brief The data structure `State` is the state of a signal stored in process
+ * shared memory. Zero initialized memory is a valid initial state.
+ *
+ */
+struct QueueSignal::State {
+  std::atomic<uint32_t> sequence;  //<- Futex word bumped on every wakeup.
+  std::atomic<uint32_t> waiters;
+  std::atomic<uint64_t> pending_bytes;
+  std::atomic<uint32_t> space_sequence;  //<- Futex word bumped when consumed.
+  std::atomic<uint32_t> space_waiters;
+};
+
+namespace {
+
+#ifdef __linux__
+/**
+ * @brief Block on the given futex word while it holds the expected value.
+ *
+ */
+void futexWait(std::atomic<uint32_t> *word, const uint32_t expected,
+               const std::chrono::microseconds timeout) {
+  const auto seconds =
+      std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  struct timespec spec;
+  spec.tv_sec = seconds.count();
+  spec.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     timeout - seconds)
+                     .count();
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected,
+            &spec, nullptr, 0);
+}
+
+/**
+ * @brief Wake all the waiters blocked on the given futex word.
+ *
+ */
+void futexWakeAll(std::atomic<uint32_t> *word) {
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+#endif
+
+}  // namespace
+
+QueueSignal::QueueSignal(const std::string &name, const std::size_t threshold)
+    : name_(name), threshold_(threshold), state_(nullptr) {
+  const int fd = ::shm_open(name_.c_str(), O_CREAT | O_RDWR,
+                            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd < 0) {
+    LOG_WARN << "Unable to open event queue signal '" << name_ << "'.";
+    return;
+  }
+  struct stat buffer;
+  if (::fstat(fd, &buffer) == -1 ||
+      (static_cast<std::size_t>(buffer.st_size) < sizeof(State) &&
+       ::ftruncate(fd, sizeof(State)) == -1)) {
+    ::close(fd);
+    return;
+  }
+  void *address = ::mmap(nullptr, sizeof(State), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address != MAP_FAILED) {
+    state_ = static_cast<State *>(address);
+  }
+}
+
+QueueSignal::~QueueSignal() {
+  if (state_) {
+    ::munmap(state_, sizeof(State));
+  }
+}
+
+void QueueSignal::notify(const std::size_t bytes) {
+  if (state_ == nullptr) {
+    return;
+  }
+  const auto pending =
+      state_->pending_bytes.fetch_add(bytes, std::memory_order_relaxed) +
+      bytes;
+  if (pending < threshold_ ||
+      state_->waiters.load(std::memory_order_acquire) == 0) {
+    return;
+  }
+  // Only the producer resetting the pending bytes wakes the consumers.
+  if (state_->pending_bytes.exchange(0, std::memory_order_acq_rel) <
+      threshold_) {
+    return;
+  }
+  wake();
+}
+
+void QueueSignal::wake() {
+  if (state_ == nullptr) {
+    return;
+  }
+  state_->sequence.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+  if (state_->waiters.load(std::memory_order_acquire) > 0) {
+    futexWakeAll(&state_->sequence);
+  }
+#endif
+}
+
+uint32_t QueueSignal::prepare() {
+  if (state_ == nullptr) {
+    return 0;
+  }
+  state_->pending_bytes.store(0, std::memory_order_relaxed);
+  return state_->sequence.load(std::memory_order_acquire);
+}
+
+bool QueueSignal::wait(const uint32_t token,
+                       const std::chrono::microseconds timeout) {
+  if (state_ == nullptr) {
+    std::this_thread::sleep_for(timeout);
+    return false;
+  }
+  state_->waiters.fetch_add(1, std::memory_order_acq_rel);
+  // Producers crossing the threshold before the waiter was registered did not
+  // signal, so the pending bytes are checked once more before blocking.
+  if (state_->pending_bytes.load(std::memory_order_acquire) >= threshold_) {
+    state_->waiters.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+  }
+#ifdef __linux__
+  futexWait(&state_->sequence, token, timeout);
+#else
+  std::this_thread::sleep_for(timeout);
+#endif
+  state_->waiters.fetch_sub(1, std::memory_order_acq_rel);
+  return state_->sequence.load(std::memory_order_acquire) != token;
+}
+
+void QueueSignal::beginSpaceWait() {
+  if (state_) {
+    state_->space_waiters.fetch_add(1);
+  }
+}
+
+void QueueSignal::endSpaceWait() {
+  if (state_) {
+    state_->space_waiters.fetch_sub(1);
+  }
+}
+
+uint32_t QueueSignal::spaceToken() const {
+  return state_ ? state_->space_sequence.load() : 0;
+}
+
+void QueueSignal::waitForSpace(const uint32_t token,
+                               const std::chrono::microseconds timeout) {
+#ifdef __linux__
+  if (state_) {
+    futexWait(&state_->space_sequence, token, timeout);
+    return;
+  }
+#endif
+  std::this_thread::sleep_for(timeout);
+}
+
+void QueueSignal::notifySpace() {
+  if (state_ == nullptr) {
+    return;
+  }
+  // Orders the consumption of the trace events before the load of the waiters.
+  // Producers register before they attempt to publish, so either they see the
+  // space or the consumer sees them.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (state_->space_waiters.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  state_->space_sequence.fetch_add(1);
+#ifdef __linux__
+  futexWakeAll(&state_->space_sequence);
+#endif
+}
+
+void QueueSignal::remove() const { ::shm_unlink(name_.c_str()); }
+
+}  // namespace details
+}  // namespace inspector
@@ -16,13 +16,152 @@
 
 #include <inspector/details/system.hpp>
 
+#include <signal.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #ifdef __APPLE__
 #include <sys/syscall.h>
+#else
+#include <dirent.h>
+#include <sched.h>
 #endif
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
 namespace inspector {
 namespace details {
+namespace {
+
+/**
+ * @brief The data structure `NumaTopology` maps each CPU in the system to the
+ * dense index of the NUMA node it belongs to.
+ *
+ */
+struct NumaTopology {
+  uint32_t node_count = 1;
+  std::vector<uint32_t> cpu_nodes;
+};
+
+#ifndef __APPLE__
+
+/**
+ * @brief Sysfs directory listing the NUMA nodes of the system.
+ *
+ */
+constexpr auto kNumaNodeSysfsPath = "/sys/devices/system/node";
+
+/**
+ * @brief Parse a CPU list of the form `0-3,8,10-11` as found in sysfs.
+ *
+ * @param list Constant reference to the CPU list.
+ * @returns Vector of CPU identifiers.
+ */
+std::vector<uint32_t> parseCpuList(const std::string &list) {
+  std::vector<uint32_t> cpus;
+  std::size_t start = 0;
+  while (start < list.size()) {
+    auto end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    const auto range = list.substr(start, end - start);
+    const auto dash = range.find('-');
+    try {
+      const uint32_t first = std::stoul(range.substr(0, dash));
+      const uint32_t last = dash == std::string::npos
+                                ? first
+                                : std::stoul(range.substr(dash + 1));
+      for (auto cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception &) {
+      // Ignoring malformed ranges
+    }
+    start = end + 1;
+  }
+  return cpus;
+}
+
+/**
+ * @brief Load the NUMA topology of the system from sysfs.
+ *
+ */
+NumaTopology loadNumaTopology() {
+  NumaTopology topology;
+
+  std::vector<uint32_t> node_ids;
+  if (auto *dir = ::opendir(kNumaNodeSysfsPath)) {
+    while (auto *entry = ::readdir(dir)) {
+      const std::string name = entry->d_name;
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+          std::all_of(name.begin() + 4, name.end(), [](const char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+          })) {
+        node_ids.push_back(std::stoul(name.substr(4)));
+      }
+    }
+    ::closedir(dir);
+  }
+  if (node_ids.empty()) {
+    return topology;
+  }
+  std::sort(node_ids.begin(), node_ids.end());
+
+  topology.node_count = node_ids.size();
+  for (uint32_t index = 0; index < node_ids.size(); ++index) {
+    std::ifstream file(std::string(kNumaNodeSysfsPath) + "/node" +
+                       std::to_string(node_ids[index]) + "/cpulist");
+    std::string list;
+    std::getline(file, list);
+    for (const auto cpu : parseCpuList(list)) {
+      if (cpu >= topology.cpu_nodes.size()) {
+        topology.cpu_nodes.resize(cpu + 1, 0);
+      }
+      topology.cpu_nodes[cpu] = index;
+    }
+  }
+
+  return topology;
+}
+
+#else
+
+NumaTopology loadNumaTopology() { return {}; }
+
+#endif
+
+/**
+ * @brief Get the NUMA topology of the system. The topology is loaded once.
+ *
+ */
+const NumaTopology &numaTopology() {
+  static const NumaTopology topology = loadNumaTopology();
+  return topology;
+}
+
+/**
+ * @brief Check if the kernel backs shared memory mappings with transparent
+ * huge pages when advised to. Mappings advised under the `never` and `deny`
+ * policies silently keep regular pages.
+ *
+ */
+bool isSharedMemoryHugePageAdvisable() {
+  std::ifstream file("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+  std::string policies;
+  if (!std::getline(file, policies)) {
+    return false;
+  }
+  return policies.find("[never]") == std::string::npos &&
+         policies.find("[deny]") == std::string::npos;
+}
+
+}  // namespace
 
 /**
  * @brief Get the OS unique identifier of the process calling the method.
@@ -42,5 +181,61 @@ int32_t getTID() {
 #endif
 }
 
+bool isProcessAlive(const int32_t pid) {
+  // Signal 0 performs the permission and existence checks without sending a
+  // signal. EPERM implies the process exists but belongs to another user.
+  return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+uint32_t getNumaNode() {
+#ifdef __APPLE__
+  return 0;
+#else
+  const auto &topology = numaTopology();
+  if (topology.node_count == 1) {
+    return 0;
+  }
+  const auto cpu = ::sched_getcpu();
+  if (cpu < 0 || static_cast<std::size_t>(cpu) >= topology.cpu_nodes.size()) {
+    return 0;
+  }
+  return topology.cpu_nodes[cpu];
+#endif
+}
+
+uint32_t getNumaNodeCount() { return numaTopology().node_count; }
+
+bool adviseSharedMemoryHugePages(const std::string &name) {
+#if defined(__APPLE__) || !defined(MADV_HUGEPAGE)
+  return false;
+#else
+  if (!isSharedMemoryHugePageAdvisable()) {
+    return false;
+  }
+  // Shared memory objects live on the tmpfs mounted at `/dev/shm`. Each line
+  // of the maps file reads `begin-end perms offset dev inode path`.
+  const auto path = "/dev/shm" + name;
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  bool advised = false;
+  while (std::getline(maps, line)) {
+    const auto start = line.find('/');
+    if (start == std::string::npos ||
+        line.compare(start, std::string::npos, path) != 0) {
+      continue;
+    }
+    std::istringstream stream(line);
+    uintptr_t begin = 0, end = 0;
+    char dash = 0;
+    if (!(stream >> std::hex >> begin >> dash >> end) || end <= begin) {
+      continue;
+    }
+    advised |= ::madvise(reinterpret_cast<void *>(begin), end - begin,
+                         MADV_HUGEPAGE) == 0;
+  }
+  return advised;
+#endif
+}
+
 }  // namespace details
 }  // namespace inspector
\ No newline at end of file
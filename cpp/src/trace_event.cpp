@@ -14,15 +14,18 @@
  * limitations under the License.
  */
 
+#include <cstring>
+#include <inspector/details/json_writer.hpp>
 #include <inspector/trace.hpp>
 #include <inspector/trace_event.hpp>
-#include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include "cpp/src/details/trace_event_header.hpp"
 
-#define THROW_IF_EMPTY(buffer) \
-  if (buffer.empty()) throw std::runtime_error("Empty trace event.");
+#define THROW_IF_EMPTY(size) \
+  if (size == 0) throw std::runtime_error("Empty trace event.");
 
 namespace inspector {
 namespace {
@@ -31,12 +34,12 @@ namespace {
  * @brief Method to get pointer to trace event header from a memory buffer
  * containing the trace event.
  *
- * @param buffer Constant reference to the buffer.
+ * @param data Pointer to the buffer.
  * @returns Pointer to constant trace event header.
  */
-const details::TraceEventHeader *header(const std::vector<uint8_t> &buffer) {
+const details::TraceEventHeader *header(const uint8_t *data) {
   return static_cast<const details::TraceEventHeader *>(
-      static_cast<const void *>(buffer.data()));
+      static_cast<const void *>(data));
 }
 
 /**
@@ -45,7 +48,7 @@ const details::TraceEventHeader *header(const std::vector<uint8_t> &buffer) {
  * @param type Type of event.
  * @returns String representation of event type.
  */
-std::string eventTypeToString(event_type_t type) {
+const char *eventTypeToString(event_type_t type) {
   switch (static_cast<EventType>(type)) {
     case EventType::kSyncBeginTag:
       return "SyncBegin";
@@ -73,139 +76,260 @@ std::string eventTypeToString(event_type_t type) {
 }
 
 /**
- * @brief Method to get string representation of a debug argument.
+ * @brief Method to write the JSON representation of a debug argument.
  *
  * @param arg Constant reference to a debug argument.
- * @returns String representation of debug argument.
+ * @param writer Reference to the JSON writer.
  */
-std::string debugArgToString(const DebugArg &arg) {
-  switch (arg.type()) {
-    case DebugArg::Type::TYPE_STRING:
-    case DebugArg::Type::TYPE_CHAR:
-      return "\"" + arg.value<std::string>() + "\"";
-    case DebugArg::Type::TYPE_INT16:
-      return std::to_string(arg.value<int16_t>());
-    case DebugArg::Type::TYPE_INT32:
-      return std::to_string(arg.value<int32_t>());
-    case DebugArg::Type::TYPE_INT64:
-      return std::to_string(arg.value<int64_t>());
-    case DebugArg::Type::TYPE_UINT8:
-      return std::to_string(arg.value<uint8_t>());
-    case DebugArg::Type::TYPE_UINT16:
-      return std::to_string(arg.value<uint16_t>());
-    case DebugArg::Type::TYPE_UINT32:
-      return std::to_string(arg.value<uint32_t>());
-    case DebugArg::Type::TYPE_UINT64:
-      return std::to_string(arg.value<uint64_t>());
-    case DebugArg::Type::TYPE_FLOAT:
-      return std::to_string(arg.value<float>());
-    case DebugArg::Type::TYPE_DOUBLE:
-      return std::to_string(arg.value<double>());
-    case DebugArg::Type::TYPE_KWARG: {
-      const auto kwarg = arg.value<KeywordArg>();
-      return "{\"" + std::string{kwarg.name()} +
-             "\":" + debugArgToString(kwarg) + "}";
+void writeDebugArg(const DebugArg &arg, details::JsonWriter &writer) {
+  visit(arg, [&writer](const auto value) {
+    using T = std::decay_t<decltype(value)>;
+    if constexpr (std::is_same<T, char>::value) {
+      writer.value(&value, 1);
+    } else if constexpr (std::is_same<T, KeywordArg>::value) {
+      writer.beginObject().key(value.name());
+      writeDebugArg(value, writer);
+      writer.endObject();
+    } else {
+      writer.value(value);
     }
-    default:
-      break;
-  }
-
-  return "UNKNOWN";
+  });
 }
 
 }  // namespace
 
-TraceEvent::TraceEvent(std::vector<uint8_t> &&buffer)
-    : buffer_(std::move(buffer)) {}
+// ------------------------------------------------
+// TraceEventView
+// ------------------------------------------------
 
-bool TraceEvent::isEmpty() const { return buffer_.empty(); }
+TraceEventView::TraceEventView(const uint8_t *data, const std::size_t size)
+    : data_(data), size_(size) {}
+
+TraceEventView::TraceEventView(const void *data, const std::size_t size)
+    : TraceEventView(static_cast<const uint8_t *>(data), size) {}
 
-event_type_t TraceEvent::type() const {
-  THROW_IF_EMPTY(buffer_);
-  return header(buffer_)->type;
+bool TraceEventView::isEmpty() const { return size_ == 0; }
+
+event_type_t TraceEventView::type() const {
+  THROW_IF_EMPTY(size_);
+  return header(data_)->type;
 }
 
-uint64_t TraceEvent::counter() const {
-  THROW_IF_EMPTY(buffer_);
-  return header(buffer_)->counter;
+uint64_t TraceEventView::counter() const {
+  THROW_IF_EMPTY(size_);
+  return header(data_)->counter;
 }
 
-timestamp_t TraceEvent::timestampNs() const {
-  THROW_IF_EMPTY(buffer_);
-  return header(buffer_)->timestamp;
+timestamp_t TraceEventView::timestampNs() const {
+  THROW_IF_EMPTY(size_);
+  return header(data_)->timestamp;
 }
 
-int32_t TraceEvent::pid() const {
-  THROW_IF_EMPTY(buffer_);
-  return header(buffer_)->pid;
+int32_t TraceEventView::pid() const {
+  THROW_IF_EMPTY(size_);
+  return header(data_)->pid;
 }
 
-int32_t TraceEvent::tid() const {
-  THROW_IF_EMPTY(buffer_);
-  return header(buffer_)->tid;
+int32_t TraceEventView::tid() const {
+  THROW_IF_EMPTY(size_);
+  return header(data_)->tid;
 }
 
-const char *TraceEvent::name() const {
-  THROW_IF_EMPTY(buffer_);
-  const void *address = static_cast<const void *>(
-      buffer_.data() + sizeof(details::TraceEventHeader));
-  const size_t storage_size =
-      buffer_.size() - sizeof(details::TraceEventHeader);
-  auto debug_args =
-      DebugArgs(address, storage_size, header(buffer_)->args_count);
-  auto it = debug_args.begin();
-  if (it == debug_args.end()) {
+const char *TraceEventView::name() const {
+  THROW_IF_EMPTY(size_);
+  if (header(data_)->args_count == 0) {
     return nullptr;
   }
-  return it->value<const char *>();
-}
-
-DebugArgs TraceEvent::debugArgs() const {
-  THROW_IF_EMPTY(buffer_);
-  const void *address = static_cast<const void *>(
-      buffer_.data() + sizeof(details::TraceEventHeader));
-  const size_t storage_size =
-      buffer_.size() - sizeof(details::TraceEventHeader);
-  auto debug_args =
-      DebugArgs(address, storage_size, header(buffer_)->args_count);
-  auto it = debug_args.begin();
-  if (it == debug_args.end()) {
+  // The name is stored as the first debug argument of the event and is
+  // located right after the header.
+  const auto *const address = data_ + sizeof(details::TraceEventHeader);
+  if (static_cast<DebugArg::Type>(*address) != DebugArg::Type::TYPE_STRING) {
+    throw std::runtime_error("Invalid type of trace event name.");
+  }
+  return reinterpret_cast<const char *>(address + sizeof(uint8_t));
+}
+
+DebugArgs TraceEventView::debugArgs() const {
+  const auto *const event_name = name();
+  if (event_name == nullptr) {
     return DebugArgs{};
   }
-  ++it;
-  const size_t new_storage_size =
-      buffer_.size() -
-      static_cast<size_t>(static_cast<const uint8_t *>(it->address()) -
-                          buffer_.data());
-  return DebugArgs(it->address(), new_storage_size,
-                   header(buffer_)->args_count - 1);
-}
-
-std::string TraceEvent::toJson() const {
-  std::stringstream out;
-
-  out << "{\"seq_num\":" << counter() << ",\"timestamp\":" << timestampNs()
-      << ",\"pid\":" << pid() << ",\"tid\":" << tid() << ",\"type\":\""
-      << eventTypeToString(type()) << "\",\"name\":\"" << name() << "\"";
-  if (debugArgs().size()) {
-    out << ",\"args\":[";
-    auto debug_args = debugArgs();
-    auto it = debug_args.begin();
-    out << debugArgToString(*it);
-    while (++it != debug_args.end()) {
-      out << "," << debugArgToString(*it);
+  const auto *const address =
+      reinterpret_cast<const uint8_t *>(event_name) + std::strlen(event_name) +
+      sizeof(char);
+  const size_t storage_size = size_ - static_cast<size_t>(address - data_);
+  return DebugArgs(static_cast<const void *>(address), storage_size,
+                   header(data_)->args_count - 1);
+}
+
+std::string TraceEventView::toJson() const {
+  std::string buffer;
+  toJson(buffer);
+  return buffer;
+}
+
+void TraceEventView::toJson(std::string &buffer) const {
+  details::JsonWriter writer(buffer);
+  writer.beginObject()
+      .key("seq_num")
+      .value(counter())
+      .key("timestamp")
+      .value(timestampNs())
+      .key("pid")
+      .value(pid())
+      .key("tid")
+      .value(tid())
+      .key("type")
+      .value(eventTypeToString(type()))
+      .key("name")
+      .value(name());
+  const auto debug_args = debugArgs();
+  if (debug_args.size()) {
+    writer.key("args").beginArray();
+    for (const auto &arg : debug_args) {
+      writeDebugArg(arg, writer);
     }
-    out << "]";
+    writer.endArray();
   }
-  out << "}";
+  writer.endObject();
+}
 
-  return out.str();
+std::pair<const uint8_t *, std::size_t> TraceEventView::span() const {
+  return {data_, size_};
 }
 
+// ------------------------------------------------
+// TraceEvent
+// ------------------------------------------------
+
+TraceEvent::TraceEvent(std::vector<uint8_t> &&buffer)
+    : buffer_(std::move(buffer)) {
+  index();
+}
+
+TraceEvent::TraceEvent(const TraceEventView &view)
+    : buffer_(view.span().first, view.span().first + view.span().second) {
+  index();
+}
+
+TraceEvent::TraceEvent(const TraceEvent &other) : buffer_(other.buffer_) {
+  index();
+}
+
+TraceEvent::TraceEvent(TraceEvent &&other) noexcept
+    : buffer_(std::move(other.buffer_)),
+      debug_args_(std::exchange(other.debug_args_, DebugArgs{})) {
+  other.buffer_.clear();
+}
+
+TraceEvent &TraceEvent::operator=(const TraceEvent &other) {
+  if (this != &other) {
+    buffer_ = other.buffer_;
+    index();
+  }
+  return *this;
+}
+
+TraceEvent &TraceEvent::operator=(TraceEvent &&other) noexcept {
+  if (this != &other) {
+    buffer_ = std::move(other.buffer_);
+    debug_args_ = std::exchange(other.debug_args_, DebugArgs{});
+    other.buffer_.clear();
+  }
+  return *this;
+}
+
+void TraceEvent::index() {
+  debug_args_ = buffer_.empty() ? DebugArgs{} : view().debugArgs();
+}
+
+TraceEventView TraceEvent::view() const {
+  return {buffer_.data(), buffer_.size()};
+}
+
+bool TraceEvent::isEmpty() const { return buffer_.empty(); }
+
+event_type_t TraceEvent::type() const { return view().type(); }
+
+uint64_t TraceEvent::counter() const { return view().counter(); }
+
+timestamp_t TraceEvent::timestampNs() const { return view().timestampNs(); }
+
+int32_t TraceEvent::pid() const { return view().pid(); }
+
+int32_t TraceEvent::tid() const { return view().tid(); }
+
+const char *TraceEvent::name() const { return view().name(); }
+
+const DebugArgs &TraceEvent::debugArgs() const {
+  THROW_IF_EMPTY(buffer_.size());
+  return debug_args_;
+}
+
+std::string TraceEvent::toJson() const { return view().toJson(); }
+
+void TraceEvent::toJson(std::string &buffer) const { view().toJson(buffer); }
+
 std::pair<const uint8_t *, std::size_t> TraceEvent::span() const {
   return {buffer_.data(), buffer_.size()};
 }
 
+// ------------------------------------------------
+// TraceEventBatch
+// ------------------------------------------------
+
+TraceEventBatch::Iterator::Iterator(const TraceEventBatch &batch,
+                                    const std::size_t index)
+    : batch_(&batch), index_(index) {}
+
+TraceEventBatch::Iterator &TraceEventBatch::Iterator::operator++() {
+  ++index_;
+  return *this;
+}
+
+bool TraceEventBatch::Iterator::operator==(const Iterator &other) const {
+  return batch_ == other.batch_ && index_ == other.index_;
+}
+
+bool TraceEventBatch::Iterator::operator!=(const Iterator &other) const {
+  return !(*this == other);
+}
+
+TraceEventView TraceEventBatch::Iterator::operator*() const {
+  return (*batch_)[index_];
+}
+
+std::size_t TraceEventBatch::size() const { return offsets_.size(); }
+
+bool TraceEventBatch::empty() const { return offsets_.empty(); }
+
+std::size_t TraceEventBatch::bytes() const { return arena_.size(); }
+
+TraceEventView TraceEventBatch::operator[](const std::size_t index) const {
+  const auto offset = offsets_[index];
+  const auto end =
+      index + 1 < offsets_.size() ? offsets_[index + 1] : arena_.size();
+  return {arena_.data() + offset, end - offset};
+}
+
+void TraceEventBatch::append(const uint8_t *data, const std::size_t size) {
+  offsets_.push_back(arena_.size());
+  arena_.insert(arena_.end(), data, data + size);
+}
+
+void TraceEventBatch::clear() {
+  arena_.clear();
+  offsets_.clear();
+}
+
+TraceEventBatch::Iterator TraceEventBatch::begin() const {
+  return Iterator{*this, 0};
+}
+
+TraceEventBatch::Iterator TraceEventBatch::end() const {
+  return Iterator{*this, size()};
+}
+
 }  // namespace inspector
 
 #undef THROW_IF_EMPTY
\ No newline at end of file
@@ -19,13 +19,213 @@
 #include <vector>
 
 #include <inspector/details/queue.hpp>
+#include <inspector/details/system.hpp>
 
 namespace inspector {
+namespace {
 
-TraceEvent readTraceEvent(const size_t max_attempt) {
+/**
+ * @brief The class `QueueSelection` selects the event queues to read from in a
+ * set of event queues, i.e. either all the queues or the queues of a channel.
+ *
+ */
+class QueueSelection {
+ public:
+  explicit QueueSelection(details::EventQueueSet &queues)
+      : queues_(queues), all_(true), channel_(Channel::kScope) {}
+
+  QueueSelection(details::EventQueueSet &queues, const Channel channel)
+      : queues_(queues), all_(false), channel_(channel) {}
+
+  std::size_t count() const {
+    return all_ ? queues_.count() : queues_.count(channel_);
+  }
+
+  bigcat::CircularQueueA &queue(const std::size_t index) {
+    return all_ ? queues_.queue(index) : queues_.queue(channel_, index);
+  }
+
+  details::QueueSignal &signal() { return queues_.signal(); }
+
+ private:
+  details::EventQueueSet &queues_;
+  const bool all_;
+  const Channel channel_;
+};
+
+/**
+ * @brief Read a trace event from the selected event queues, visiting the
+ * queues round robin starting at the given position.
+ *
+ * @param queues Selected event queues.
+ * @param next Reference to the position of the next queue to visit.
+ * @param max_attempt Number of attempts to make for reading a trace event.
+ * @returns An object of type `TraceEvent`.
+ */
+TraceEvent readFromQueues(QueueSelection queues, std::size_t &next,
+                          const size_t max_attempt) {
   std::vector<uint8_t> event;
-  details::eventQueue().consume(event, max_attempt);
+  const auto count = queues.count();
+  for (std::size_t i = 0; i < count && event.empty(); ++i) {
+    queues.queue(next++ % count).consume(event, max_attempt);
+  }
+  if (!event.empty()) {
+    queues.signal().notifySpace();
+  }
   return TraceEvent(std::move(event));
 }
 
+/**
+ * @brief Read a batch of trace events from the selected event queues, visiting
+ * the queues round robin starting at the given position. Reading stops once
+ * the batch limits are reached or all the queues are empty.
+ *
+ * @param queues Selected event queues.
+ * @param next Reference to the position of the next queue to visit.
+ * @param batch Reference to the batch to fill. The batch is cleared first.
+ * @param max_events Maximum number of trace events to read.
+ * @param max_bytes Maximum number of bytes to read. The limit can be exceeded
+ * by the size of the last trace event read.
+ * @param max_attempt Number of attempts to make for reading each trace event.
+ * @returns Number of trace events read.
+ */
+std::size_t readFromQueues(QueueSelection queues, std::size_t &next,
+                           TraceEventBatch &batch, const std::size_t max_events,
+                           const std::size_t max_bytes,
+                           const size_t max_attempt) {
+  // Events are consumed into a thread local buffer whose capacity is reused
+  // across calls, and then appended to the arena of the batch.
+  thread_local std::vector<uint8_t> event;
+
+  batch.clear();
+  const auto count = queues.count();
+  std::size_t empty_count = 0;
+  while (batch.size() < max_events && batch.bytes() < max_bytes &&
+         empty_count < count) {
+    event.clear();
+    queues.queue(next++ % count).consume(event, max_attempt);
+    if (event.empty()) {
+      ++empty_count;
+      continue;
+    }
+    empty_count = 0;
+    batch.append(event.data(), event.size());
+  }
+  if (batch.size()) {
+    queues.signal().notifySpace();
+  }
+  return batch.size();
+}
+
+}  // namespace
+
+TraceEvent readTraceEvent(const size_t max_attempt) {
+  // Queues are visited round robin across calls so that a busy queue does not
+  // starve the others.
+  thread_local std::size_t next_queue = 0;
+  return readFromQueues(QueueSelection{details::localEventQueues()},
+                        next_queue, max_attempt);
+}
+
+TraceEvent readTraceEvent(const Channel channel, const size_t max_attempt) {
+  thread_local std::size_t next_queue[kChannelCount] = {};
+  return readFromQueues(QueueSelection{details::localEventQueues(), channel},
+                        next_queue[static_cast<std::size_t>(channel)],
+                        max_attempt);
+}
+
+std::size_t readTraceEvents(TraceEventBatch &batch,
+                            const std::size_t max_events,
+                            const std::size_t max_bytes,
+                            const size_t max_attempt) {
+  thread_local std::size_t next_queue = 0;
+  return readFromQueues(QueueSelection{details::localEventQueues()},
+                        next_queue, batch, max_events, max_bytes, max_attempt);
+}
+
+std::size_t readTraceEvents(TraceEventBatch &batch, const Channel channel,
+                            const std::size_t max_events,
+                            const std::size_t max_bytes,
+                            const size_t max_attempt) {
+  thread_local std::size_t next_queue[kChannelCount] = {};
+  return readFromQueues(QueueSelection{details::localEventQueues(), channel},
+                        next_queue[static_cast<std::size_t>(channel)], batch,
+                        max_events, max_bytes, max_attempt);
+}
+
+uint32_t prepareWaitForTraceEvents() {
+  return details::localEventQueues().signal().prepare();
+}
+
+bool waitForTraceEvents(const uint32_t token,
+                        const std::chrono::microseconds timeout) {
+  return details::localEventQueues().signal().wait(token, timeout);
+}
+
+std::vector<int32_t> listTracedProcesses() {
+  return details::registeredEventQueues();
+}
+
+// ------------------------------------------------
+// ProcessTraceReader
+// ------------------------------------------------
+
+ProcessTraceReader::ProcessTraceReader(const int32_t pid)
+    : pid_(pid),
+      queues_(std::make_unique<details::EventQueueSet>(
+          details::eventQueueSetName(pid))),
+      next_queue_(0),
+      next_channel_queue_() {}
+
+ProcessTraceReader::~ProcessTraceReader() = default;
+
+int32_t ProcessTraceReader::pid() const { return pid_; }
+
+bool ProcessTraceReader::isProcessAlive() const {
+  return details::isProcessAlive(pid_);
+}
+
+TraceEvent ProcessTraceReader::read(const size_t max_attempt) {
+  return readFromQueues(QueueSelection{*queues_}, next_queue_, max_attempt);
+}
+
+TraceEvent ProcessTraceReader::read(const Channel channel,
+                                    const size_t max_attempt) {
+  return readFromQueues(QueueSelection{*queues_, channel},
+                        next_channel_queue_[static_cast<std::size_t>(channel)],
+                        max_attempt);
+}
+
+std::size_t ProcessTraceReader::read(TraceEventBatch &batch,
+                                     const std::size_t max_events,
+                                     const std::size_t max_bytes,
+                                     const size_t max_attempt) {
+  return readFromQueues(QueueSelection{*queues_}, next_queue_, batch,
+                        max_events, max_bytes, max_attempt);
+}
+
+std::size_t ProcessTraceReader::read(TraceEventBatch &batch,
+                                     const Channel channel,
+                                     const std::size_t max_events,
+                                     const std::size_t max_bytes,
+                                     const size_t max_attempt) {
+  return readFromQueues(QueueSelection{*queues_, channel},
+                        next_channel_queue_[static_cast<std::size_t>(channel)],
+                        batch, max_events, max_bytes, max_attempt);
+}
+
+uint32_t ProcessTraceReader::prepareWait() {
+  return queues_->signal().prepare();
+}
+
+bool ProcessTraceReader::wait(const uint32_t token,
+                              const std::chrono::microseconds timeout) {
+  return queues_->signal().wait(token, timeout);
+}
+
+void ProcessTraceReader::release() {
+  queues_->remove();
+  details::unregisterEventQueues(pid_);
+}
+
 }  // namespace inspector
\ No newline at end of file
@@ -0,0 +1,96 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <inspector/channel.hpp>
+#include <inspector/config.hpp>
+#include <inspector/details/queue.hpp>
+#include <inspector/trace.hpp>
+#include <inspector/trace_reader.hpp>
+
+#include "cpp/tests/testing.hpp"
+
+using namespace inspector;
+
+namespace {
+static constexpr auto kEventQueueName = "inspector-channel-test";
+static constexpr auto kCounterBufferSize = 4 * 1024;
+}  // namespace
+
+class ChannelTestFixture : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    Config::setEventQueueName(kEventQueueName);
+    Config::enableMultiChannel();
+    Config::setEventChannelBufferSize(Channel::kCounter, kCounterBufferSize);
+  }
+  static void TearDownTestSuite() { inspector::testing::removeEventQueue(); }
+  void SetUp() override {}
+  void TearDown() override { inspector::testing::emptyEventQueue(); }
+};
+
+TEST_F(ChannelTestFixture, TestEventChannel) {
+  ASSERT_EQ(
+      eventChannel(static_cast<event_type_t>(EventType::kSyncBeginTag)),
+      Channel::kScope);
+  ASSERT_EQ(eventChannel(static_cast<event_type_t>(EventType::kFlowEndTag)),
+            Channel::kScope);
+  ASSERT_EQ(eventChannel(static_cast<event_type_t>(EventType::kCounterTag)),
+            Channel::kCounter);
+  ASSERT_EQ(std::string{channelName(Channel::kScope)}, "scope");
+  ASSERT_EQ(std::string{channelName(Channel::kCounter)}, "counter");
+}
+
+TEST_F(ChannelTestFixture, TestEventQueuePerChannel) {
+  ASSERT_EQ(details::eventQueueCount(),
+            kChannelCount * details::eventQueueCount(Channel::kScope));
+  ASSERT_EQ(details::eventQueueName(0),
+            std::string{kEventQueueName} + "-scope");
+  ASSERT_EQ(details::eventQueueName(details::eventQueueCount() - 1),
+            std::string{kEventQueueName} + "-counter");
+}
+
+TEST_F(ChannelTestFixture, TestReadTraceEventByChannel) {
+  syncBegin("scope");
+  counter("counter", 1);
+
+  auto event = readTraceEvent(Channel::kCounter);
+  ASSERT_EQ(event.type(), static_cast<event_type_t>(EventType::kCounterTag));
+  ASSERT_EQ(std::string{event.name()}, "counter");
+  ASSERT_TRUE(readTraceEvent(Channel::kCounter).isEmpty());
+
+  event = readTraceEvent(Channel::kScope);
+  ASSERT_EQ(event.type(), static_cast<event_type_t>(EventType::kSyncBeginTag));
+  ASSERT_EQ(std::string{event.name()}, "scope");
+  ASSERT_TRUE(readTraceEvent(Channel::kScope).isEmpty());
+}
+
+TEST_F(ChannelTestFixture, TestChannelOverflowIsolation) {
+  syncBegin("scope");
+  // Overflow the small counter channel. Dropped counter events must not evict
+  // events of the scope channel.
+  for (auto i = 0; i < kCounterBufferSize; ++i) {
+    counter("counter", i);
+  }
+
+  auto event = readTraceEvent(Channel::kScope);
+  ASSERT_FALSE(event.isEmpty());
+  ASSERT_EQ(std::string{event.name()}, "scope");
+  ASSERT_FALSE(readTraceEvent(Channel::kCounter).isEmpty());
+}
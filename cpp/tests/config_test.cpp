@@ -31,3 +31,69 @@ TEST(ConfigTestFixture, TestTraceEnableDisable) {
   Config::enableTrace();
   ASSERT_FALSE(Config::isTraceDisabled());
 }
+
+TEST(ConfigTestFixture, TestNumaAwareEventQueueEnableDisable) {
+  ASSERT_FALSE(Config::isNumaAwareEventQueueEnabled());  // Disabled by default
+  Config::enableNumaAwareEventQueue();
+  ASSERT_TRUE(Config::isNumaAwareEventQueueEnabled());
+  Config::disableNumaAwareEventQueue();
+  ASSERT_FALSE(Config::isNumaAwareEventQueueEnabled());
+}
+
+TEST(ConfigTestFixture, TestPerProcessEventQueueEnableDisable) {
+  ASSERT_FALSE(Config::isPerProcessEventQueueEnabled());  // Disabled by default
+  Config::enablePerProcessEventQueue();
+  ASSERT_TRUE(Config::isPerProcessEventQueueEnabled());
+  Config::disablePerProcessEventQueue();
+  ASSERT_FALSE(Config::isPerProcessEventQueueEnabled());
+}
+
+TEST(ConfigTestFixture, TestEventQueueGeometry) {
+  ASSERT_EQ(Config::eventQueueBufferSize(), 8 * 1024 * 1024);
+  ASSERT_EQ(Config::eventQueueMaxProducers(), 1024);
+  ASSERT_EQ(Config::eventQueueMaxConsumers(), 1024);
+  ASSERT_EQ(Config::eventQueueTimeoutNs(), 30000000000);
+  ASSERT_EQ(Config::eventQueueOverflowPolicy(), Config::OverflowPolicy::kDrop);
+
+  Config::setEventQueueBufferSize(64 * 1024 * 1024);
+  Config::setEventQueueMaxProducers(16);
+  Config::setEventQueueMaxConsumers(2);
+  Config::setEventQueueTimeoutNs(1000);
+  Config::setEventQueueOverflowPolicy(Config::OverflowPolicy::kBlock);
+  ASSERT_EQ(Config::eventQueueBufferSize(), 64 * 1024 * 1024);
+  ASSERT_EQ(Config::eventQueueMaxProducers(), 16);
+  ASSERT_EQ(Config::eventQueueMaxConsumers(), 2);
+  ASSERT_EQ(Config::eventQueueTimeoutNs(), 1000);
+  ASSERT_EQ(Config::eventQueueOverflowPolicy(), Config::OverflowPolicy::kBlock);
+}
+
+TEST(ConfigTestFixture, TestEventQueueWakeupThreshold) {
+  ASSERT_EQ(Config::eventQueueWakeupThreshold(), 25);
+  Config::setEventQueueWakeupThreshold(50);
+  ASSERT_EQ(Config::eventQueueWakeupThreshold(), 50);
+  Config::setEventQueueWakeupThreshold(200);
+  ASSERT_EQ(Config::eventQueueWakeupThreshold(), 100);
+  Config::setEventQueueWakeupThreshold(25);
+}
+
+TEST(ConfigTestFixture, TestMultiChannel) {
+  ASSERT_FALSE(Config::isMultiChannelEnabled());  // Disabled by default
+  Config::enableMultiChannel();
+  ASSERT_TRUE(Config::isMultiChannelEnabled());
+  Config::disableMultiChannel();
+  ASSERT_FALSE(Config::isMultiChannelEnabled());
+
+  ASSERT_EQ(Config::eventChannelBufferSize(Channel::kCounter),
+            Config::eventQueueBufferSize());
+  Config::setEventChannelBufferSize(Channel::kCounter, 1024);
+  ASSERT_EQ(Config::eventChannelBufferSize(Channel::kCounter), 1024);
+  ASSERT_EQ(Config::eventChannelBufferSize(Channel::kScope),
+            Config::eventQueueBufferSize());
+
+  ASSERT_EQ(Config::eventChannelPriority(Channel::kScope), 4);
+  ASSERT_EQ(Config::eventChannelPriority(Channel::kCounter), 1);
+  Config::setEventChannelPriority(Channel::kCounter, 8);
+  ASSERT_EQ(Config::eventChannelPriority(Channel::kCounter), 8);
+  Config::setEventChannelPriority(Channel::kCounter, 0);
+  ASSERT_EQ(Config::eventChannelPriority(Channel::kCounter), 1);
+}
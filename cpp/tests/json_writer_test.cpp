@@ -0,0 +1,86 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inspector/details/json_writer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace inspector::details;
+
+TEST(JsonWriterTestFixture, TestEscapeJsonString) {
+  std::string buffer;
+  const std::string input = "plain \"quoted\" back\\slash \x01\t\n";
+  escapeJsonString(input.data(), input.size(), buffer);
+  ASSERT_EQ(buffer,
+            "plain \\\"quoted\\\" back\\\\slash \\u0001\\t\\n");
+
+  // Long strings are scanned in chunks, the escaped characters falling on
+  // either side of the chunk boundaries.
+  std::string long_input(100, 'a');
+  long_input[15] = '"';
+  long_input[16] = '\x1f';
+  long_input[99] = '\\';
+  buffer.clear();
+  escapeJsonString(long_input.data(), long_input.size(), buffer);
+  std::string expected(100, 'a');
+  expected.replace(99, 1, "\\\\");
+  expected.replace(16, 1, "\\u001f");
+  expected.replace(15, 1, "\\\"");
+  ASSERT_EQ(buffer, expected);
+
+  // Non-ASCII characters are left untouched
+  buffer.clear();
+  const std::string utf8 = "caf\xc3\xa9";
+  escapeJsonString(utf8.data(), utf8.size(), buffer);
+  ASSERT_EQ(buffer, utf8);
+}
+
+TEST(JsonWriterTestFixture, TestWriteDocument) {
+  std::string buffer;
+  JsonWriter writer(buffer);
+  writer.beginObject()
+      .key("int")
+      .value(-42)
+      .key("uint64")
+      .value(std::numeric_limits<uint64_t>::max())
+      .key("double")
+      .value(0.1)
+      .key("float")
+      .value(0.1f)
+      .key("nan")
+      .value(std::numeric_limits<double>::quiet_NaN())
+      .key("array")
+      .beginArray()
+      .value("a")
+      .beginObject()
+      .endObject()
+      .beginArray()
+      .endArray()
+      .null()
+      .endArray()
+      .key("string")
+      .value(static_cast<const char *>(nullptr))
+      .endObject();
+
+  ASSERT_EQ(buffer,
+            "{\"int\":-42,\"uint64\":18446744073709551615,\"double\":0.1,"
+            "\"float\":0.1,\"nan\":null,\"array\":[\"a\",{},[],null],"
+            "\"string\":null}");
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include <inspector/config.hpp>
+#include <inspector/details/queue.hpp>
+#include <inspector/details/system.hpp>
+#include <inspector/trace.hpp>
+#include <inspector/trace_reader.hpp>
+
+#include "cpp/tests/testing.hpp"
+
+using namespace inspector;
+
+namespace {
+static constexpr auto kEventQueueName = "inspector-process-reader-test";
+
+bool isTraced(const int32_t pid) {
+  const auto pids = listTracedProcesses();
+  return std::find(pids.begin(), pids.end(), pid) != pids.end();
+}
+}  // namespace
+
+class ProcessTraceReaderTestFixture : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    Config::setEventQueueName(kEventQueueName);
+    Config::enablePerProcessEventQueue();
+  }
+  static void TearDownTestSuite() { inspector::testing::removeEventQueue(); }
+  void SetUp() override {}
+  void TearDown() override { inspector::testing::emptyEventQueue(); }
+};
+
+TEST_F(ProcessTraceReaderTestFixture, TestLocalEventQueueName) {
+  ASSERT_EQ(details::localEventQueues().name(),
+            std::string{kEventQueueName} + "-" +
+                std::to_string(details::getPID()));
+}
+
+TEST_F(ProcessTraceReaderTestFixture, TestRegisterOnPublish) {
+  syncBegin("test");
+  ASSERT_TRUE(isTraced(details::getPID()));
+}
+
+TEST_F(ProcessTraceReaderTestFixture, TestReadProcessTraceEvent) {
+  syncBegin("test");
+
+  ProcessTraceReader reader(details::getPID());
+  ASSERT_EQ(reader.pid(), details::getPID());
+  ASSERT_TRUE(reader.isProcessAlive());
+
+  auto event = reader.read();
+  ASSERT_EQ(event.type(), static_cast<event_type_t>(EventType::kSyncBeginTag));
+  ASSERT_EQ(std::string{event.name()}, "test");
+  ASSERT_TRUE(reader.read().isEmpty());
+}
+
+TEST_F(ProcessTraceReaderTestFixture, TestRelease) {
+  syncBegin("test");
+  ASSERT_TRUE(isTraced(details::getPID()));
+
+  ProcessTraceReader reader(details::getPID());
+  reader.release();
+  ASSERT_FALSE(isTraced(details::getPID()));
+  ASSERT_TRUE(details::registerEventQueues());
+}
+
+TEST_F(ProcessTraceReaderTestFixture, TestRegisterAfterFork) {
+  syncBegin("test");
+  const auto pid = ::fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // The child publishes to and registers its own event queues.
+    syncBegin("test");
+    const auto name = std::string{kEventQueueName} + "-" +
+                      std::to_string(details::getPID());
+    const bool ok = details::localEventQueues().name() == name &&
+                    isTraced(details::getPID());
+    ::_exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+  ASSERT_TRUE(isTraced(pid));
+
+  ProcessTraceReader reader(pid);
+  reader.release();
+  ASSERT_FALSE(isTraced(pid));
+}
@@ -0,0 +1,93 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <inspector/details/queue_signal.hpp>
+
+using namespace inspector;
+
+namespace {
+static constexpr auto kSignalName = "/inspector-queue-signal-test";
+static constexpr auto kThreshold = 1024;
+static constexpr std::chrono::microseconds kTimeout{10'000};  // 10ms
+}  // namespace
+
+class QueueSignalTestFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    signal_ = std::make_unique<details::QueueSignal>(kSignalName, kThreshold);
+  }
+  void TearDown() override {
+    signal_->remove();
+    signal_.reset();
+  }
+
+  std::unique_ptr<details::QueueSignal> signal_;
+};
+
+TEST_F(QueueSignalTestFixture, TestWaitTimeout) {
+  const auto token = signal_->prepare();
+  signal_->notify(kThreshold / 2);
+  ASSERT_FALSE(signal_->wait(token, kTimeout));
+}
+
+TEST_F(QueueSignalTestFixture, TestWaitAfterThresholdCrossed) {
+  const auto token = signal_->prepare();
+  signal_->notify(kThreshold);
+  ASSERT_TRUE(signal_->wait(token, kTimeout));
+  // Pending bytes are reset ahead of the next drain.
+  ASSERT_FALSE(signal_->wait(signal_->prepare(), kTimeout));
+}
+
+TEST_F(QueueSignalTestFixture, TestWakeBlockedWaiter) {
+  const auto token = signal_->prepare();
+  std::thread producer([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    for (auto i = 0; i < 4; ++i) {
+      signal_->notify(kThreshold / 4);
+    }
+  });
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(signal_->wait(token, std::chrono::seconds(10)));
+  ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+  producer.join();
+}
+
+TEST_F(QueueSignalTestFixture, TestWake) {
+  const auto token = signal_->prepare();
+  signal_->wake();
+  ASSERT_TRUE(signal_->wait(token, kTimeout));
+}
+
+TEST_F(QueueSignalTestFixture, TestWakeProducerWaitingForSpace) {
+  signal_->beginSpaceWait();
+  const auto token = signal_->spaceToken();
+  std::thread consumer([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    signal_->notifySpace();
+  });
+  const auto start = std::chrono::steady_clock::now();
+  signal_->waitForSpace(token, std::chrono::seconds(10));
+  ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+  ASSERT_NE(signal_->spaceToken(), token);
+  signal_->endSpaceWait();
+  consumer.join();
+}
@@ -22,4 +22,9 @@ using namespace inspector::details;
 
 TEST(SystemTestFixture, TestGetPID) { ASSERT_NE(getPID(), 0); }
 
-TEST(SystemTestFixture, TestGetTID) { ASSERT_NE(getTID(), 0); }
\ No newline at end of file
+TEST(SystemTestFixture, TestGetTID) { ASSERT_NE(getTID(), 0); }
+
+TEST(SystemTestFixture, TestGetNumaNode) {
+  ASSERT_GE(getNumaNodeCount(), 1);
+  ASSERT_LT(getNumaNode(), getNumaNodeCount());
+}
@@ -23,17 +23,17 @@
 namespace inspector {
 namespace testing {
 
-void removeEventQueue() {
-  bigcat::CircularQueueA::remove(Config::eventQueueName());
-}
+void removeEventQueue() { details::removeEventQueues(); }
 
 void emptyEventQueue() {
-  while (1) {
-    auto result = details::eventQueue().consume(1024);
-    if (result.first == bigcat::CircularQueueA::Status::EMPTY) {
-      return;
-    }
-  };
+  for (std::size_t index = 0; index < details::eventQueueCount(); ++index) {
+    while (1) {
+      auto result = details::eventQueue(index).consume(1024);
+      if (result.first == bigcat::CircularQueueA::Status::EMPTY) {
+        break;
+      }
+    };
+  }
 }
 
 }  // namespace testing
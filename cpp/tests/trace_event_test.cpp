@@ -17,9 +17,12 @@
 #include <gtest/gtest.h>
 
 #include <cstring>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include <inspector/details/trace_event.hpp>
+#include <inspector/trace.hpp>
 #include <inspector/trace_event.hpp>
 
 using namespace inspector;
@@ -170,4 +173,197 @@ TEST(TraceEventTestFixture,
   ASSERT_EQ(it->type(), DebugArg::Type::TYPE_STRING);
   ASSERT_EQ(it->value<std::string>(), kValue);
   ASSERT_THROW(it->value<uint8_t>(), std::runtime_error);
-}
\ No newline at end of file
+}
+
+TEST(TraceEventTestFixture, TestTraceEventView) {
+  constexpr const char *kEventName = "test-event";
+  constexpr auto kType = 1;
+  constexpr auto kCounter = 2;
+  constexpr auto kPid = 1;
+  constexpr auto kTid = 1;
+  constexpr auto kTimestampNs = 1000;
+  constexpr int32_t kValue = 10;
+
+  std::vector<uint8_t> buffer(
+      details::traceEventStorageSize(kEventName, kValue));
+
+  details::MutableTraceEvent mutable_event(buffer.data(), buffer.size());
+  mutable_event.setType(kType);
+  mutable_event.setCounter(kCounter);
+  mutable_event.setPid(kPid);
+  mutable_event.setTid(kTid);
+  mutable_event.setTimestampNs(kTimestampNs);
+  mutable_event.appendDebugArgs(kEventName, kValue);
+
+  TraceEventView view(buffer.data(), buffer.size());
+  ASSERT_FALSE(view.isEmpty());
+  ASSERT_EQ(view.type(), kType);
+  ASSERT_EQ(view.counter(), kCounter);
+  ASSERT_EQ(view.pid(), kPid);
+  ASSERT_EQ(view.tid(), kTid);
+  ASSERT_EQ(view.timestampNs(), kTimestampNs);
+  ASSERT_EQ(std::strcmp(view.name(), kEventName), 0);
+  ASSERT_EQ(view.debugArgs().size(), 1);
+  ASSERT_EQ(view.debugArgs().begin()->value<int32_t>(), kValue);
+  ASSERT_EQ(view.span().first, buffer.data());
+  ASSERT_EQ(view.span().second, buffer.size());
+
+  // The view does not copy the trace event
+  const auto data = buffer.data();
+  TraceEvent event(std::move(buffer));
+  ASSERT_EQ(event.view().span().first, data);
+  ASSERT_EQ(event.view().toJson(), view.toJson());
+
+  ASSERT_TRUE(TraceEventView().isEmpty());
+  ASSERT_THROW(TraceEventView().type(), std::runtime_error);
+}
+
+TEST(TraceEventTestFixture, TestTraceEventBatch) {
+  constexpr const char *kEventName = "test-event";
+  std::vector<uint8_t> buffer(details::traceEventStorageSize(kEventName));
+  details::MutableTraceEvent mutable_event(buffer.data(), buffer.size());
+  mutable_event.appendDebugArgs(kEventName);
+
+  TraceEventBatch batch;
+  ASSERT_TRUE(batch.empty());
+  for (uint8_t type = 0; type < 3; ++type) {
+    mutable_event.setType(type);
+    batch.append(buffer.data(), buffer.size());
+  }
+  ASSERT_EQ(batch.size(), 3);
+  ASSERT_EQ(batch.bytes(), 3 * buffer.size());
+
+  event_type_t type = 0;
+  for (const auto event : batch) {
+    ASSERT_EQ(event.type(), type++);
+    ASSERT_EQ(event.span().second, buffer.size());
+    ASSERT_EQ(std::strcmp(event.name(), kEventName), 0);
+  }
+  ASSERT_EQ(type, 3);
+
+  const TraceEvent event(batch[1]);
+  ASSERT_EQ(event.type(), 1);
+  ASSERT_NE(event.span().first, batch[1].span().first);
+
+  batch.clear();
+  ASSERT_TRUE(batch.empty());
+  ASSERT_EQ(batch.bytes(), 0);
+}
+
+TEST(TraceEventTestFixture, TestTraceEventToJson) {
+  constexpr const char *kEventName = "test \"event\"\n";
+  const auto kKwarg = details::makeKeywordArg("ke\\y", 1.5);
+  constexpr auto kString = "value";
+
+  std::vector<uint8_t> buffer(
+      details::traceEventStorageSize(kEventName, kKwarg, kString, 'c'));
+  details::MutableTraceEvent mutable_event(buffer.data(), buffer.size());
+  mutable_event.setType(static_cast<event_type_t>(EventType::kCounterTag));
+  mutable_event.setCounter(2);
+  mutable_event.setPid(3);
+  mutable_event.setTid(-4);
+  mutable_event.setTimestampNs(1000);
+  mutable_event.appendDebugArgs(kEventName, kKwarg, kString, 'c');
+
+  const TraceEventView event(buffer.data(), buffer.size());
+  const std::string expected =
+      "{\"seq_num\":2,\"timestamp\":1000,\"pid\":3,\"tid\":-4,\"type\":"
+      "\"Counter\",\"name\":\"test \\\"event\\\"\\n\",\"args\":[{\"ke\\\\y\":"
+      "1.5},\"value\",\"c\"]}";
+  ASSERT_EQ(event.toJson(), expected);
+
+  // The JSON is appended to the reused buffer
+  std::string json = "prefix";
+  event.toJson(json);
+  ASSERT_EQ(json, "prefix" + expected);
+}
+
+TEST(TraceEventTestFixture, TestDebugArgsIndexAndKeywordLookup) {
+  constexpr const char *kEventName = "test-event";
+  const auto kFirst = details::makeKeywordArg("first", int32_t{1});
+  const auto kSecond =
+      details::makeKeywordArg("second", static_cast<const char *>("two"));
+
+  // More arguments than stored inline in the offset table
+  std::vector<uint8_t> buffer(details::traceEventStorageSize(
+      kEventName, kFirst, 'a', 2.5, uint8_t{3}, int64_t{-4}, "five", 6.5f,
+      uint16_t{7}, int16_t{-8}, kSecond));
+  details::MutableTraceEvent mutable_event(buffer.data(), buffer.size());
+  mutable_event.appendDebugArgs(kEventName, kFirst, 'a', 2.5, uint8_t{3},
+                                int64_t{-4}, "five", 6.5f, uint16_t{7},
+                                int16_t{-8}, kSecond);
+
+  const TraceEvent event(std::move(buffer));
+  const auto &debug_args = event.debugArgs();
+  ASSERT_EQ(debug_args.size(), 10);
+  ASSERT_EQ(debug_args[1].value<char>(), 'a');
+  ASSERT_EQ(debug_args[4].value<int64_t>(), -4);
+  ASSERT_EQ(debug_args[5].value<std::string>(), "five");
+  ASSERT_EQ(debug_args[8].value<int16_t>(), -8);
+
+  size_t index = 0;
+  for (const auto &arg : debug_args) {
+    ASSERT_EQ(arg.address(), debug_args[index++].address());
+  }
+  ASSERT_EQ(index, debug_args.size());
+
+  const auto first = debug_args.kwarg("first");
+  ASSERT_TRUE(first.has_value());
+  ASSERT_EQ(first->value<int32_t>(), 1);
+  const auto second = debug_args.kwarg("second");
+  ASSERT_TRUE(second.has_value());
+  ASSERT_EQ(second->value<std::string>(), "two");
+  ASSERT_FALSE(debug_args.kwarg("third").has_value());
+
+  // Copies decode the arguments in their own buffer
+  const TraceEvent copy(event);
+  ASSERT_EQ(copy.debugArgs().size(), 10);
+  ASSERT_NE(copy.debugArgs()[9].address(), debug_args[9].address());
+  ASSERT_EQ(copy.debugArgs().kwarg("second")->value<std::string>(), "two");
+
+  ASSERT_THROW(TraceEvent().debugArgs(), std::runtime_error);
+}
+
+TEST(TraceEventTestFixture, TestVisitDebugArgs) {
+  constexpr const char *kEventName = "test-event";
+  const auto kKwarg = details::makeKeywordArg("key", uint16_t{7});
+  constexpr const char *kString = "value";
+
+  std::vector<uint8_t> buffer(details::traceEventStorageSize(
+      kEventName, int32_t{-1}, 2.5, 'c', kString, kKwarg));
+  details::MutableTraceEvent mutable_event(buffer.data(), buffer.size());
+  mutable_event.appendDebugArgs(kEventName, int32_t{-1}, 2.5, 'c', kString,
+                                kKwarg);
+
+  const TraceEventView event(buffer.data(), buffer.size());
+  const auto debug_args = event.debugArgs();
+  std::vector<std::string> visited;
+  for (const auto &arg : debug_args) {
+    visited.push_back(visit(arg, [](const auto value) -> std::string {
+      using T = std::decay_t<decltype(value)>;
+      if constexpr (std::is_same<T, const char *>::value) {
+        return std::string("string:") + value;
+      } else if constexpr (std::is_same<T, char>::value) {
+        return std::string("char:") + value;
+      } else if constexpr (std::is_same<T, KeywordArg>::value) {
+        return std::string("kwarg:") + value.name() + "=" +
+               std::to_string(value.template valueUnchecked<uint16_t>());
+      } else if constexpr (std::is_floating_point<T>::value) {
+        return "float:" + std::to_string(value);
+      } else {
+        return "int:" + std::to_string(value);
+      }
+    }));
+  }
+  const std::vector<std::string> expected = {
+      "int:-1", "float:2.500000", "char:c", "string:value", "kwarg:key=7"};
+  ASSERT_EQ(visited, expected);
+
+  ASSERT_EQ(debug_args[0].valueUnchecked<int32_t>(), -1);
+  ASSERT_EQ(debug_args[1].valueUnchecked<double>(), 2.5);
+  ASSERT_EQ(std::strcmp(debug_args[3].valueUnchecked<const char *>(), kString),
+            0);
+  ASSERT_EQ(std::strcmp(debug_args[4].valueUnchecked<KeywordArg>().name(),
+                        "key"),
+            0);
+}
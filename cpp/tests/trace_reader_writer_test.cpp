@@ -21,6 +21,7 @@
 #include <inspector/config.hpp>
 #include <inspector/details/queue.hpp>
 #include <inspector/details/trace_writer.hpp>
+#include <inspector/trace.hpp>
 #include <inspector/trace_event.hpp>
 #include <inspector/trace_reader.hpp>
 
@@ -49,3 +50,44 @@ TEST_F(TraceReaderWriterTestFixture, TestWriteAndReadTraceEvent) {
   ASSERT_EQ(std::string{event.name()}, test_event);
   ASSERT_EQ(event.debugArgs().size(), 0);
 }
+
+TEST_F(TraceReaderWriterTestFixture, TestReadTraceEvents) {
+  constexpr auto kEventCount = 10;
+  for (auto i = 0; i < kEventCount; ++i) {
+    details::writeTraceEvent(i, "testing");
+  }
+
+  TraceEventBatch batch;
+  ASSERT_EQ(readTraceEvents(batch, 4, 1024 * 1024), 4);
+  ASSERT_EQ(batch.size(), 4);
+  // The byte limit is exceeded by at most the last trace event read
+  ASSERT_EQ(readTraceEvents(batch, kEventCount, 1), 1);
+  ASSERT_EQ(readTraceEvents(batch, kEventCount, 1024 * 1024), 5);
+
+  event_type_t type = 5;
+  for (const auto event : batch) {
+    ASSERT_EQ(event.type(), type++);
+    ASSERT_EQ(std::string{event.name()}, "testing");
+  }
+  ASSERT_EQ(readTraceEvents(batch, kEventCount, 1024 * 1024), 0);
+  ASSERT_TRUE(batch.empty());
+}
+
+TEST_F(TraceReaderWriterTestFixture, TestReadTraceEventFromSharedChannel) {
+  // Channels share the same queues when multi-channel mode is disabled.
+  details::writeTraceEvent(
+      static_cast<event_type_t>(EventType::kCounterTag), "counter", 1);
+  auto event = readTraceEvent(Channel::kScope);
+  ASSERT_EQ(event.type(), static_cast<event_type_t>(EventType::kCounterTag));
+  ASSERT_EQ(std::string{event.name()}, "counter");
+}
+
+TEST_F(TraceReaderWriterTestFixture, TestVerifyEventQueueGeometry) {
+  ASSERT_NO_THROW(Config::verifyEventQueueGeometry());
+
+  const auto buffer_size = Config::eventQueueBufferSize();
+  Config::setEventQueueBufferSize(2 * buffer_size);
+  ASSERT_THROW(Config::verifyEventQueueGeometry(), std::runtime_error);
+  Config::setEventQueueBufferSize(buffer_size);
+  ASSERT_NO_THROW(Config::verifyEventQueueGeometry());
+}
@@ -41,10 +41,113 @@ void bindConfig(py::module &m) {
       "inspector library to publish trace events for consumption by the "
       "trace reader.",
       py::arg("name"));
+  config_m.def("event_queue_buffer_size",
+               &inspector::Config::eventQueueBufferSize,
+               "Get the size in bytes of the buffer backing each event queue.");
+  config_m.def("set_event_queue_buffer_size",
+               &inspector::Config::setEventQueueBufferSize,
+               "Set the size in bytes of the buffer backing each event queue.",
+               py::arg("size"));
+  config_m.def("event_queue_max_producers",
+               &inspector::Config::eventQueueMaxProducers,
+               "Get the maximum number of producers of an event queue.");
+  config_m.def("set_event_queue_max_producers",
+               &inspector::Config::setEventQueueMaxProducers,
+               "Set the maximum number of producers of an event queue.",
+               py::arg("count"));
+  config_m.def("event_queue_max_consumers",
+               &inspector::Config::eventQueueMaxConsumers,
+               "Get the maximum number of consumers of an event queue.");
+  config_m.def("set_event_queue_max_consumers",
+               &inspector::Config::setEventQueueMaxConsumers,
+               "Set the maximum number of consumers of an event queue.",
+               py::arg("count"));
+  config_m.def("event_queue_timeout_ns",
+               &inspector::Config::eventQueueTimeoutNs,
+               "Get the event queue timeout in nanoseconds.");
+  config_m.def("set_event_queue_timeout_ns",
+               &inspector::Config::setEventQueueTimeoutNs,
+               "Set the event queue timeout in nanoseconds.",
+               py::arg("timeout_ns"));
+
+  py::enum_<inspector::Config::OverflowPolicy>(config_m, "OverflowPolicy")
+      .value("kDrop", inspector::Config::OverflowPolicy::kDrop)
+      .value("kBlock", inspector::Config::OverflowPolicy::kBlock);
+
+  config_m.def("event_queue_overflow_policy",
+               &inspector::Config::eventQueueOverflowPolicy,
+               "Get the action taken when publishing to a full event queue.");
+  config_m.def("set_event_queue_overflow_policy",
+               &inspector::Config::setEventQueueOverflowPolicy,
+               "Set the action taken when publishing to a full event queue.",
+               py::arg("policy"));
+  config_m.def("event_queue_wakeup_threshold",
+               &inspector::Config::eventQueueWakeupThreshold,
+               "Get the fill threshold, as a percentage of the event queue "
+               "buffer size, at which recorders are woken up.");
+  config_m.def("set_event_queue_wakeup_threshold",
+               &inspector::Config::setEventQueueWakeupThreshold,
+               "Set the fill threshold, as a percentage of the event queue "
+               "buffer size, at which recorders are woken up.",
+               py::arg("percent"));
+  config_m.def("verify_event_queue_geometry",
+               &inspector::Config::verifyEventQueueGeometry,
+               "Verify that the configured event queue geometry matches the "
+               "geometry with which the queues were created.");
   config_m.def("is_trace_disabled", &inspector::Config::isTraceDisabled,
                "Check if tracing is disabled.");
   config_m.def("disable_trace", &inspector::Config::disableTrace,
                "Disable capturing of all trace events.");
   config_m.def("enable_trace", &inspector::Config::enableTrace,
                "Enable capturing of all trace events.");
+  config_m.def("is_numa_aware_event_queue_enabled",
+               &inspector::Config::isNumaAwareEventQueueEnabled,
+               "Check if NUMA aware event queues are enabled.");
+  config_m.def("enable_numa_aware_event_queue",
+               &inspector::Config::enableNumaAwareEventQueue,
+               "Enable one event queue per NUMA node.");
+  config_m.def("disable_numa_aware_event_queue",
+               &inspector::Config::disableNumaAwareEventQueue,
+               "Disable NUMA aware event queues.");
+  config_m.def("is_huge_page_event_queue_enabled",
+               &inspector::Config::isHugePageEventQueueEnabled,
+               "Check if huge page backed event queues are enabled.");
+  config_m.def("enable_huge_page_event_queue",
+               &inspector::Config::enableHugePageEventQueue,
+               "Back event queues with transparent huge pages.");
+  config_m.def("disable_huge_page_event_queue",
+               &inspector::Config::disableHugePageEventQueue,
+               "Disable huge page backed event queues.");
+  config_m.def("is_per_process_event_queue_enabled",
+               &inspector::Config::isPerProcessEventQueueEnabled,
+               "Check if per process event queues are enabled.");
+  config_m.def("enable_per_process_event_queue",
+               &inspector::Config::enablePerProcessEventQueue,
+               "Enable event queues owned by each traced process.");
+  config_m.def("disable_per_process_event_queue",
+               &inspector::Config::disablePerProcessEventQueue,
+               "Disable per process event queues.");
+  config_m.def("is_multi_channel_enabled",
+               &inspector::Config::isMultiChannelEnabled,
+               "Check if multi-channel event queues are enabled.");
+  config_m.def("enable_multi_channel", &inspector::Config::enableMultiChannel,
+               "Enable one set of event queues per channel.");
+  config_m.def("disable_multi_channel",
+               &inspector::Config::disableMultiChannel,
+               "Disable multi-channel event queues.");
+  config_m.def("event_channel_buffer_size",
+               &inspector::Config::eventChannelBufferSize,
+               "Get the buffer size in bytes of the event queues of a channel.",
+               py::arg("channel"));
+  config_m.def("set_event_channel_buffer_size",
+               &inspector::Config::setEventChannelBufferSize,
+               "Set the buffer size in bytes of the event queues of a channel.",
+               py::arg("channel"), py::arg("size"));
+  config_m.def("event_channel_priority",
+               &inspector::Config::eventChannelPriority,
+               "Get the drain priority of a channel.", py::arg("channel"));
+  config_m.def("set_event_channel_priority",
+               &inspector::Config::setEventChannelPriority,
+               "Set the drain priority of a channel.", py::arg("channel"),
+               py::arg("priority"));
 }
\ No newline at end of file
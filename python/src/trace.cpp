@@ -17,6 +17,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <inspector/channel.hpp>
 #include <inspector/trace.hpp>
 
 namespace py = pybind11;
@@ -108,7 +109,9 @@ void pythonTraceEvent(const std::string &name, const py::args &args,
   }
 
   // Publishing created trace event
-  inspector::details::eventQueue().publish(buffer);
+  inspector::details::publishTraceEvent(
+      inspector::eventChannel(static_cast<const inspector::event_type_t>(T)),
+      buffer);
 }
 
 void pythonCounterEvent(const std::string &name, const py::object &arg) {
@@ -135,6 +138,18 @@ void bindTrace(py::module &m) {
       .value("kFlowEndTag", inspector::EventType::kFlowEndTag)
       .value("kCounterTag", inspector::EventType::kCounterTag);
 
+  py::enum_<inspector::Channel>(m, "Channel")
+      .value("kScope", inspector::Channel::kScope)
+      .value("kCounter", inspector::Channel::kCounter);
+  m.def(
+      "event_channel",
+      [](const inspector::EventType type) {
+        return inspector::eventChannel(
+            static_cast<inspector::event_type_t>(type));
+      },
+      "Get the channel to which trace events of the given type are routed.",
+      py::arg("type"));
+
   m.def("sync_begin", &pythonTraceEvent<inspector::EventType::kSyncBeginTag>);
   m.def("sync_end",
         [](const std::string &name) { inspector::syncEnd(name.c_str()); });
@@ -17,6 +17,9 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <string>
+#include <type_traits>
+
 #include <inspector/trace_event.hpp>
 #include <inspector/trace_reader.hpp>
 
@@ -24,52 +27,27 @@ namespace py = pybind11;
 
 namespace {
 
+/**
+ * @brief Default maximum number of bytes read per batch of trace events.
+ *
+ */
+constexpr size_t kReadBatchBytes = 1024 * 1024;  // 1MB
+
 /**
  * @brief Utility method to get python compatible value from a debug argument
  * object.
  */
 py::object pyDebugArgValue(const inspector::DebugArg &self) {
-  switch (self.type()) {
-    case inspector::DebugArg::Type::TYPE_INT16: {
-      return py::cast(self.value<int16_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_INT32: {
-      return py::cast(self.value<int32_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_INT64: {
-      return py::cast(self.value<int64_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_UINT8: {
-      return py::cast(self.value<uint8_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_UINT16: {
-      return py::cast(self.value<uint16_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_UINT32: {
-      return py::cast(self.value<uint32_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_UINT64: {
-      return py::cast(self.value<uint64_t>());
-    }
-    case inspector::DebugArg::Type::TYPE_FLOAT: {
-      return py::cast(self.value<float>());
-    }
-    case inspector::DebugArg::Type::TYPE_DOUBLE: {
-      return py::cast(self.value<double>());
-    }
-    case inspector::DebugArg::Type::TYPE_CHAR: {
-      return py::cast(self.value<char>());
-    }
-    case inspector::DebugArg::Type::TYPE_STRING: {
-      return py::cast(self.value<std::string>());
+  return inspector::visit(self, [](const auto value) -> py::object {
+    using T = std::decay_t<decltype(value)>;
+    if constexpr (std::is_same<T, const char *>::value) {
+      return py::str(value);
+    } else if constexpr (std::is_same<T, inspector::KeywordArg>::value) {
+      return py::make_tuple(std::string{value.name()}, pyDebugArgValue(value));
+    } else {
+      return py::cast(value);
     }
-    case inspector::DebugArg::Type::TYPE_KWARG: {
-      const auto kwarg = self.value<inspector::KeywordArg>();
-      return py::make_tuple(std::string{kwarg.name()}, pyDebugArgValue(kwarg));
-    }
-  }
-
-  throw std::runtime_error("Invalid debug argument type observed.");
+  });
 }
 
 }  // namespace
@@ -109,6 +87,27 @@ void bindTraceEvent(py::module &m) {
       .def("size", &inspector::DebugArgs::size,
            "Get the number of debug arguments.")
       .def("__len__", &inspector::DebugArgs::size)
+      .def(
+          "__getitem__",
+          [](const inspector::DebugArgs &self, const size_t index) {
+            if (index >= self.size()) {
+              throw py::index_error("Debug argument index out of range.");
+            }
+            return self[index];
+          },
+          "Get the debug argument at the given index.")
+      .def(
+          "kwarg",
+          [](const inspector::DebugArgs &self,
+             const std::string &name) -> py::object {
+            const auto kwarg = self.kwarg(name.c_str());
+            if (!kwarg) {
+              return py::none();
+            }
+            return pyDebugArgValue(*kwarg);
+          },
+          "Get the value of the keyword argument with the given name or None "
+          "if not found.")
       .def(
           "__iter__",
           [](const inspector::DebugArgs &self) {
@@ -132,14 +131,53 @@ void bindTraceEvent(py::module &m) {
           "Get the name of trace event.")
       .def("debug_args", &inspector::TraceEvent::debugArgs,
            "Get the debug arguments which are part of the trace event.")
-      .def("to_json", &inspector::TraceEvent::toJson,
-           "Get JSON representation of the trace event.");
+      .def(
+          "to_json",
+          [](const inspector::TraceEvent &self) {
+            // The JSON is formatted into a reusable buffer and copied once
+            // into the Python string.
+            thread_local std::string buffer;
+            buffer.clear();
+            self.toJson(buffer);
+            return py::str(buffer.data(), buffer.size());
+          },
+          "Get JSON representation of the trace event.");
 
   m.def(
       "read_trace_event",
       [](const size_t max_attempt) {
-        return inspector::readTraceEvent(max_attempt);
+        thread_local inspector::TraceEventBatch batch;
+        if (inspector::readTraceEvents(batch, 1, kReadBatchBytes,
+                                       max_attempt) == 0) {
+          return inspector::TraceEvent{};
+        }
+        return inspector::TraceEvent(batch[0]);
       },
       "Read a stored trace event from the process shared queue.",
       py::arg("max_attempt") = 32);
+  m.def(
+      "read_trace_events",
+      [](const size_t max_events, const size_t max_bytes,
+         const size_t max_attempt) {
+        thread_local inspector::TraceEventBatch batch;
+        inspector::readTraceEvents(batch, max_events, max_bytes, max_attempt);
+        std::vector<inspector::TraceEvent> events;
+        events.reserve(batch.size());
+        for (const auto event : batch) {
+          events.emplace_back(event);
+        }
+        return events;
+      },
+      "Read a batch of stored trace events from the process shared queues in "
+      "one pass.",
+      py::arg("max_events") = 1024, py::arg("max_bytes") = kReadBatchBytes,
+      py::arg("max_attempt") = 32);
+  m.def(
+      "read_trace_event",
+      [](const inspector::Channel channel, const size_t max_attempt) {
+        return inspector::readTraceEvent(channel, max_attempt);
+      },
+      "Read a stored trace event of the given channel from the process shared "
+      "queues.",
+      py::arg("channel"), py::arg("max_attempt") = 32);
 }
\ No newline at end of file
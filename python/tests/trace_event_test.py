@@ -40,3 +40,5 @@ def test_trace_event():
         assert arg.type() == expected[idx][0]
         assert arg.value() == expected[idx][1]
         idx += 1
+    assert debug_args[2].value() == "test-data"
+    assert debug_args.kwarg("test") is None
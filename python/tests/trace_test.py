@@ -170,3 +170,20 @@ def test_scope():
     event = inspector.read_trace_event()
     assert event.type() == inspector.EventType.kSyncEndTag.value
     assert event.name() == "test-scope"
+
+
+def test_read_trace_events():
+    for i in range(10):
+        inspector.counter("test-counter", i)
+
+    events = inspector.read_trace_events(max_events=4)
+    assert len(events) == 4
+    events += inspector.read_trace_events()
+    assert len(events) == 10
+    for i, event in enumerate(events):
+        assert event.type() == inspector.EventType.kCounterTag.value
+        assert event.name() == "test-counter"
+        args, _ = extract_debug_args(event)
+        assert args == [i]
+
+    assert inspector.read_trace_events() == []
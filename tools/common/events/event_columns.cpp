@@ -0,0 +1,273 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/events/event_columns.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace inspector {
+namespace tools {
+namespace {
+
+/**
+ * @brief Maximum number of values of a set predicate which are compared
+ * linearly against each event. Larger sets are binary searched.
+ *
+ */
+constexpr std::size_t kMaxScanValues = 16;
+
+/**
+ * @brief Narrow down the selection to the events whose value in the given
+ * column is one of the given values.
+ *
+ * @param column Constant reference to the column.
+ * @param values Constant reference to the sorted values to match.
+ * @param selection Reference to the selection.
+ */
+template <class T>
+void selectIn(const std::vector<T>& column, const std::vector<T>& values,
+              std::vector<uint32_t>& selection) {
+  std::size_t selected = 0;
+  if (values.size() <= kMaxScanValues) {
+    for (const auto index : selection) {
+      const auto value = column[index];
+      bool keep = false;
+      for (const auto candidate : values) {
+        keep |= value == candidate;
+      }
+      selection[selected] = index;
+      selected += keep;
+    }
+  } else {
+    for (const auto index : selection) {
+      selection[selected] = index;
+      selected +=
+          std::binary_search(values.begin(), values.end(), column[index]);
+    }
+  }
+  selection.resize(selected);
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------
+// EventColumns
+// ----------------------------------------------------------------
+
+std::size_t EventColumns::size() const { return data_.size(); }
+
+bool EventColumns::empty() const { return data_.empty(); }
+
+void EventColumns::clear() {
+  data_.clear();
+  sizes_.clear();
+  timestamps_.clear();
+  types_.clear();
+  pids_.clear();
+  tids_.clear();
+  name_ids_.clear();
+  args_offsets_.clear();
+}
+
+void EventColumns::append(const void* data, const std::size_t size) {
+  if (size == 0) {
+    return;
+  }
+  const TraceEventView event(data, size);
+  const auto* const bytes = static_cast<const uint8_t*>(data);
+  const auto* const name = event.name();
+  uint32_t name_id = kNoName;
+  std::size_t args_offset = size;
+  if (name != nullptr) {
+    name_id = intern(name);
+    args_offset = static_cast<std::size_t>(
+                      reinterpret_cast<const uint8_t*>(name) - bytes) +
+                  std::strlen(name) + sizeof(char);
+  }
+  data_.push_back(bytes);
+  sizes_.push_back(static_cast<uint32_t>(size));
+  timestamps_.push_back(event.timestampNs());
+  types_.push_back(event.type());
+  pids_.push_back(event.pid());
+  tids_.push_back(event.tid());
+  name_ids_.push_back(name_id);
+  args_offsets_.push_back(static_cast<uint32_t>(args_offset));
+}
+
+void EventColumns::decode(const storage::BlockReader& block) {
+  for (const auto& record : block) {
+    append(record.src, record.size);
+  }
+}
+
+void EventColumns::decode(const TraceEventBatch& batch) {
+  for (const auto event : batch) {
+    const auto span = event.span();
+    append(span.first, span.second);
+  }
+}
+
+TraceEventView EventColumns::event(const std::size_t index) const {
+  return {data_[index], sizes_[index]};
+}
+
+uint32_t EventColumns::nameId(const std::string& name) const {
+  const auto it = name_index_.find(name);
+  return it == name_index_.end() ? kNoName : it->second;
+}
+
+std::size_t EventColumns::nameCount() const { return names_.size(); }
+
+const std::vector<timestamp_t>& EventColumns::timestamps() const {
+  return timestamps_;
+}
+
+const std::vector<event_type_t>& EventColumns::types() const { return types_; }
+
+const std::vector<int32_t>& EventColumns::pids() const { return pids_; }
+
+const std::vector<int32_t>& EventColumns::tids() const { return tids_; }
+
+const std::vector<uint32_t>& EventColumns::nameIds() const { return name_ids_; }
+
+const std::vector<uint32_t>& EventColumns::argsOffsets() const {
+  return args_offsets_;
+}
+
+// private
+uint32_t EventColumns::intern(const char* name) {
+  const auto it = name_index_.find(name);
+  if (it != name_index_.end()) {
+    return it->second;
+  }
+  const auto id = static_cast<uint32_t>(names_.size());
+  names_.emplace_back(name);
+  name_index_.emplace(names_.back(), id);
+  return id;
+}
+
+// ----------------------------------------------------------------
+// EventFilter
+// ----------------------------------------------------------------
+
+EventFilter& EventFilter::setTimeRange(const timestamp_t min,
+                                       const timestamp_t max) {
+  min_timestamp_ = min;
+  max_timestamp_ = max;
+  return *this;
+}
+
+EventFilter& EventFilter::setTypes(const std::vector<event_type_t>& types) {
+  types_.reset();
+  for (const auto type : types) {
+    types_.set(type);
+  }
+  filter_types_ = !types.empty();
+  return *this;
+}
+
+EventFilter& EventFilter::setPids(const std::vector<int32_t>& pids) {
+  pids_ = pids;
+  std::sort(pids_.begin(), pids_.end());
+  return *this;
+}
+
+EventFilter& EventFilter::setTids(const std::vector<int32_t>& tids) {
+  tids_ = tids;
+  std::sort(tids_.begin(), tids_.end());
+  return *this;
+}
+
+EventFilter& EventFilter::setNames(const std::vector<std::string>& names) {
+  names_ = names;
+  return *this;
+}
+
+bool EventFilter::empty() const {
+  return min_timestamp_ == std::numeric_limits<timestamp_t>::min() &&
+         max_timestamp_ == std::numeric_limits<timestamp_t>::max() &&
+         !filter_types_ && pids_.empty() && tids_.empty() && names_.empty();
+}
+
+timestamp_t EventFilter::minTimestamp() const { return min_timestamp_; }
+
+timestamp_t EventFilter::maxTimestamp() const { return max_timestamp_; }
+
+void EventFilter::apply(const EventColumns& columns,
+                        std::vector<uint32_t>& selection) const {
+  // The time range is checked over all the events, while the rest of the
+  // predicates only scan the events selected so far.
+  const auto& timestamps = columns.timestamps();
+  const auto count = static_cast<uint32_t>(columns.size());
+  selection.resize(count);
+  std::size_t selected = 0;
+  for (uint32_t index = 0; index < count; ++index) {
+    const auto timestamp = timestamps[index];
+    selection[selected] = index;
+    selected += (timestamp >= min_timestamp_) & (timestamp <= max_timestamp_);
+  }
+  selection.resize(selected);
+
+  if (filter_types_) {
+    const auto& types = columns.types();
+    selected = 0;
+    for (const auto index : selection) {
+      selection[selected] = index;
+      selected += types_[types[index]];
+    }
+    selection.resize(selected);
+  }
+  if (!pids_.empty()) {
+    selectIn(columns.pids(), pids_, selection);
+  }
+  if (!tids_.empty()) {
+    selectIn(columns.tids(), tids_, selection);
+  }
+  if (!names_.empty()) {
+    // Names are matched by their interned identifiers.
+    std::vector<uint8_t> wanted(columns.nameCount(), 0);
+    for (const auto& name : names_) {
+      const auto id = columns.nameId(name);
+      if (id != EventColumns::kNoName) {
+        wanted[id] = 1;
+      }
+    }
+    const auto& name_ids = columns.nameIds();
+    selected = 0;
+    for (const auto index : selection) {
+      const auto id = name_ids[index];
+      selection[selected] = index;
+      selected += id < wanted.size() ? wanted[id] : 0;
+    }
+    selection.resize(selected);
+  }
+}
+
+// ----------------------------------------------------------------
+// Record Tags
+// ----------------------------------------------------------------
+
+storage::RecordTags eventTags(const storage::Record& record) {
+  if (record.size == 0) {
+    return {};
+  }
+  const TraceEventView event(record.src, record.size);
+  return {event.type(), event.pid(), event.tid()};
+}
+
+}  // namespace tools
+}  // namespace inspector
@@ -0,0 +1,242 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <inspector/trace_event.hpp>
+#include <inspector/types.hpp>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tools/common/storage/block.hpp"
+
+namespace inspector {
+namespace tools {
+
+/**
+ * @brief The class `EventColumns` holds the header fields of a set of trace
+ * events decoded into column vectors, i.e. one vector per field with one entry
+ * per event. Filters can then scan the columns without decoding the events one
+ * at a time. Event names are interned into integer identifiers which stay
+ * stable for the lifetime of the object.
+ *
+ * The columns do not copy the trace events and are only valid while the memory
+ * containing the events is, e.g. the block reader or batch they were decoded
+ * from.
+ *
+ */
+class EventColumns {
+ public:
+  /**
+   * @brief Name identifier of events without a name.
+   *
+   */
+  static constexpr uint32_t kNoName = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * @brief Get the number of decoded events.
+   *
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Check if no events are decoded.
+   *
+   */
+  bool empty() const;
+
+  /**
+   * @brief Remove all the decoded events. The memory of the columns and the
+   * interned names are kept for reuse.
+   *
+   */
+  void clear();
+
+  /**
+   * @brief Decode the trace event stored in the given memory and append it to
+   * the columns. Empty events are skipped.
+   *
+   * @param data Pointer to the memory containing the trace event.
+   * @param size Size in bytes of the trace event.
+   */
+  void append(const void* data, const std::size_t size);
+
+  /**
+   * @brief Decode all the trace events stored in the given block and append
+   * them to the columns.
+   *
+   * @param block Constant reference to the block reader.
+   */
+  void decode(const storage::BlockReader& block);
+
+  /**
+   * @brief Decode all the trace events in the given batch and append them to
+   * the columns.
+   *
+   * @param batch Constant reference to the batch of trace events.
+   */
+  void decode(const TraceEventBatch& batch);
+
+  /**
+   * @brief Get a view into the decoded event at the given index.
+   *
+   * @param index Index of the event in the range `[0, size())`.
+   * @returns Object of type `TraceEventView`.
+   */
+  TraceEventView event(const std::size_t index) const;
+
+  /**
+   * @brief Get the identifier of the given event name.
+   *
+   * @param name Constant reference to the name.
+   * @returns Identifier of the name or `kNoName` if no decoded event had the
+   * name.
+   */
+  uint32_t nameId(const std::string& name) const;
+
+  /**
+   * @brief Get the number of interned event names.
+   *
+   */
+  std::size_t nameCount() const;
+
+  const std::vector<timestamp_t>& timestamps() const;
+  const std::vector<event_type_t>& types() const;
+  const std::vector<int32_t>& pids() const;
+  const std::vector<int32_t>& tids() const;
+  const std::vector<uint32_t>& nameIds() const;
+
+  /**
+   * @brief Get the offsets in bytes of the debug arguments, excluding the
+   * name, from the start of each event.
+   *
+   */
+  const std::vector<uint32_t>& argsOffsets() const;
+
+ private:
+  uint32_t intern(const char* name);
+
+  std::vector<const uint8_t*> data_;
+  std::vector<uint32_t> sizes_;
+  std::vector<timestamp_t> timestamps_;
+  std::vector<event_type_t> types_;
+  std::vector<int32_t> pids_;
+  std::vector<int32_t> tids_;
+  std::vector<uint32_t> name_ids_;
+  std::vector<uint32_t> args_offsets_;
+  std::deque<std::string> names_;
+  std::unordered_map<std::string_view, uint32_t> name_index_;
+};
+
+/**
+ * @brief The class `EventFilter` selects decoded events matching a set of
+ * predicates. Each predicate runs as a branch free scan over a single column,
+ * narrowing down the selection of the previous one. Predicates which are not
+ * set match all the events.
+ *
+ */
+class EventFilter {
+ public:
+  /**
+   * @brief Select events with timestamps in the closed range `[min, max]`.
+   *
+   */
+  EventFilter& setTimeRange(const timestamp_t min, const timestamp_t max);
+
+  /**
+   * @brief Select events of the given types. An empty list selects events of
+   * all types.
+   *
+   */
+  EventFilter& setTypes(const std::vector<event_type_t>& types);
+
+  /**
+   * @brief Select events of the given process identifiers. An empty list
+   * selects events of all processes.
+   *
+   */
+  EventFilter& setPids(const std::vector<int32_t>& pids);
+
+  /**
+   * @brief Select events of the given thread identifiers. An empty list
+   * selects events of all threads.
+   *
+   */
+  EventFilter& setTids(const std::vector<int32_t>& tids);
+
+  /**
+   * @brief Select events with the given names. An empty list selects events
+   * with any name.
+   *
+   */
+  EventFilter& setNames(const std::vector<std::string>& names);
+
+  /**
+   * @brief Check if no predicate is set, in which case all events match.
+   *
+   */
+  bool empty() const;
+
+  /**
+   * @brief Get the lower bound of the selected time range.
+   *
+   */
+  timestamp_t minTimestamp() const;
+
+  /**
+   * @brief Get the upper bound of the selected time range.
+   *
+   */
+  timestamp_t maxTimestamp() const;
+
+  /**
+   * @brief Select the decoded events matching the filter.
+   *
+   * @param columns Constant reference to the decoded events.
+   * @param selection Reference to the vector receiving the indices of the
+   * selected events in increasing order.
+   */
+  void apply(const EventColumns& columns,
+             std::vector<uint32_t>& selection) const;
+
+ private:
+  timestamp_t min_timestamp_ = std::numeric_limits<timestamp_t>::min();
+  timestamp_t max_timestamp_ = std::numeric_limits<timestamp_t>::max();
+  bool filter_types_ = false;
+  std::bitset<std::numeric_limits<event_type_t>::max() + 1> types_;
+  std::vector<int32_t> pids_;
+  std::vector<int32_t> tids_;
+  std::vector<std::string> names_;
+};
+
+/**
+ * @brief Tag a record containing a trace event with the type, process and
+ * thread of the event. Used as the classifier of block summaries, so that
+ * reads filtered by event fields can skip whole blocks.
+ *
+ * @param record Constant reference to the record.
+ * @returns Tags of the record, all 0 for empty records.
+ */
+storage::RecordTags eventTags(const storage::Record& record);
+
+}  // namespace tools
+}  // namespace inspector
@@ -0,0 +1,161 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/events/event_columns.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <inspector/details/trace_event.hpp>
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/testing.hpp"
+
+using namespace inspector;
+using namespace inspector::tools;
+
+namespace {
+
+constexpr auto kBlockSize = 4096;
+
+/**
+ * @brief Create a serialized trace event with the given header fields and
+ * name, followed by a single integer debug argument.
+ *
+ */
+std::vector<uint8_t> createEvent(const event_type_t type, const int32_t pid,
+                                 const int32_t tid,
+                                 const timestamp_t timestamp,
+                                 const char* name) {
+  constexpr int32_t kArg = 42;
+  std::vector<uint8_t> buffer(details::traceEventStorageSize(name, kArg));
+  details::MutableTraceEvent event(buffer.data(), buffer.size());
+  event.setType(type);
+  event.setPid(pid);
+  event.setTid(tid);
+  event.setTimestampNs(timestamp);
+  event.appendDebugArgs(name, kArg);
+  return buffer;
+}
+
+}  // namespace
+
+class EventColumnsTestFixture : public storage::TestHarness,
+                                public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const char* names[] = {"alpha", "beta", "gamma"};
+    for (int32_t i = 0; i < 12; ++i) {
+      events_.push_back(createEvent(static_cast<event_type_t>(i % 4), i % 3,
+                                    100 + i % 2, 1000 + 10 * i, names[i % 3]));
+    }
+    for (const auto& event : events_) {
+      batch_.append(event.data(), event.size());
+    }
+  }
+
+  std::vector<std::vector<uint8_t>> events_;
+  TraceEventBatch batch_;
+};
+
+TEST_F(EventColumnsTestFixture, TestDecodeBatch) {
+  EventColumns columns;
+  columns.decode(batch_);
+
+  ASSERT_EQ(columns.size(), events_.size());
+  ASSERT_EQ(columns.nameCount(), 3);
+  for (std::size_t i = 0; i < columns.size(); ++i) {
+    const TraceEventView event(events_[i].data(), events_[i].size());
+    ASSERT_EQ(columns.timestamps()[i], event.timestampNs());
+    ASSERT_EQ(columns.types()[i], event.type());
+    ASSERT_EQ(columns.pids()[i], event.pid());
+    ASSERT_EQ(columns.tids()[i], event.tid());
+    ASSERT_EQ(columns.nameIds()[i], columns.nameId(event.name()));
+    ASSERT_EQ(columns.event(i).toJson(), event.toJson());
+
+    // The arguments follow the name of the event
+    const auto* const args =
+        columns.event(i).span().first + columns.argsOffsets()[i];
+    ASSERT_EQ(*args, static_cast<uint8_t>(DebugArg::Type::TYPE_INT32));
+  }
+  ASSERT_EQ(columns.nameId("delta"), EventColumns::kNoName);
+
+  // Interned names survive clearing the columns
+  const auto id = columns.nameId("beta");
+  columns.clear();
+  ASSERT_TRUE(columns.empty());
+  ASSERT_EQ(columns.nameId("beta"), id);
+}
+
+TEST_F(EventColumnsTestFixture, TestDecodeBlock) {
+  storage::BlockBuilder builder(kBlockSize);
+  for (const auto& event : events_) {
+    const TraceEventView view(event.data(), event.size());
+    ASSERT_TRUE(builder.add({view.timestampNs(), event.data(), event.size()}));
+  }
+  const storage::File file("block", tempDir().path());
+  builder.flush(file);
+
+  storage::BlockReader block(file);
+  EventColumns columns;
+  columns.decode(block);
+  ASSERT_EQ(columns.size(), events_.size());
+  for (std::size_t i = 0; i < columns.size(); ++i) {
+    ASSERT_EQ(columns.timestamps()[i], 1000 + 10 * i);
+  }
+}
+
+TEST_F(EventColumnsTestFixture, TestEventFilter) {
+  EventColumns columns;
+  columns.decode(batch_);
+  std::vector<uint32_t> selection;
+
+  EventFilter filter;
+  ASSERT_TRUE(filter.empty());
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection.size(), columns.size());
+
+  filter.setTimeRange(1020, 1090);
+  ASSERT_FALSE(filter.empty());
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection, (std::vector<uint32_t>{2, 3, 4, 5, 6, 7, 8, 9}));
+
+  filter.setTypes({1, 2});
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection, (std::vector<uint32_t>{2, 5, 6, 9}));
+
+  filter.setTids({101});
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection, (std::vector<uint32_t>{5, 9}));
+
+  filter.setPids({0, 2});
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection, (std::vector<uint32_t>{5, 9}));
+
+  filter.setNames({"gamma", "delta"});
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection, (std::vector<uint32_t>{5}));
+
+  // Large sets of identifiers are binary searched
+  std::vector<int32_t> pids;
+  for (int32_t pid = 1; pid < 100; ++pid) {
+    pids.push_back(pid);
+  }
+  filter = EventFilter().setPids(pids);
+  filter.apply(columns, selection);
+  ASSERT_EQ(selection, (std::vector<uint32_t>{1, 2, 4, 5, 7, 8, 10, 11}));
+}
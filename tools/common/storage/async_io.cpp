@@ -0,0 +1,566 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/async_io.hpp"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace inspector {
+namespace tools {
+namespace storage {
+namespace {
+
+/**
+ * @brief Maximum number of threads of the thread pool backend.
+ *
+ */
+constexpr std::size_t kMaxThreads = 8;
+
+/**
+ * @brief Truncate a written file to the given size, dropping the stale tail of
+ * a larger file written before, e.g. by a previous recording. Files are
+ * truncated once written rather than before, so that they are never shorter
+ * than the written part of the buffer.
+ *
+ * @returns `true` if the file was truncated else `false`.
+ */
+bool truncateFile(const File& file, const std::size_t size) {
+  if (file.size() <= size) {
+    return false;
+  }
+  file.resize(size);
+  return true;
+}
+
+/**
+ * @brief Write the given span to file starting at the given offset, retrying
+ * short writes, truncate the file to the span and optionally sync the file.
+ *
+ */
+void writeFile(const File& file, const uint8_t* const data,
+               const std::size_t size, std::size_t offset, const bool sync) {
+  while (offset < size) {
+    const auto bytes = file.write(data + offset, size - offset, offset);
+    if (bytes == 0) {
+      throw std::system_error(EIO, std::generic_category(),
+                              "Error writing file '" + file.path() + "': ");
+    }
+    offset += bytes;
+  }
+  truncateFile(file, size);
+  if (sync) {
+    file.sync();
+  }
+}
+
+int ioUringSetup(const unsigned entries, io_uring_params& params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int ioUringEnter(const int fd, const unsigned to_submit,
+                 const unsigned min_complete, const unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------
+// Engine
+// ----------------------------------------------------------------
+
+/**
+ * @brief Interface of the mechanisms performing the writes.
+ *
+ */
+class AsyncWriter::Engine {
+ public:
+  virtual ~Engine() = default;
+
+  virtual void submit(File&& file, BlockBuffer&& buffer, const bool sync,
+                      const std::size_t tag) = 0;
+
+  virtual std::size_t reap(std::vector<Completion>& completions,
+                           const bool wait) = 0;
+};
+
+// ----------------------------------------------------------------
+// IoUringEngine
+// ----------------------------------------------------------------
+
+/**
+ * @brief Engine submitting the writes to an io_uring instance. Each write is
+ * submitted as a vectored write of the buffer, linked to an fsync of the file
+ * when synced, and completes once all its entries have completed. Writes cut
+ * short by the kernel, along with syncs the kernel did not accept, are
+ * finished synchronously while reaping.
+ *
+ */
+class AsyncWriter::IoUringEngine final : public AsyncWriter::Engine {
+ public:
+  explicit IoUringEngine(const std::size_t depth)
+      : slots_(depth),
+        fd_(-1),
+        sq_ring_(MAP_FAILED),
+        sq_ring_size_(0),
+        cq_ring_(MAP_FAILED),
+        cq_ring_size_(0),
+        sqes_(MAP_FAILED),
+        sqes_size_(0) {
+    for (std::size_t index = depth; index > 0; --index) {
+      free_slots_.push_back(index - 1);
+    }
+    try {
+      setup(static_cast<unsigned>(2 * depth));
+    } catch (...) {
+      close();
+      throw;
+    }
+  }
+
+  ~IoUringEngine() override {
+    // Buffers are referenced by the kernel until their writes complete.
+    std::vector<Completion> completions;
+    while (free_slots_.size() < slots_.size()) {
+      try {
+        reap(completions, true);
+      } catch (const std::exception&) {
+        break;
+      }
+    }
+    close();
+  }
+
+  void submit(File&& file, BlockBuffer&& buffer, const bool sync,
+              const std::size_t tag) override {
+    const auto index = free_slots_.back();
+    auto& slot = slots_[index];
+    slot.iov.iov_base = buffer.data();
+    slot.iov.iov_len = buffer.size();
+
+    const unsigned entries = sync ? 2 : 1;
+    const auto tail = *sq_tail_;
+    auto* sqe = pushSqe(tail);
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->flags = sync ? IOSQE_IO_LINK : 0;
+    sqe->fd = descriptor(file);
+    sqe->addr = reinterpret_cast<uint64_t>(&slot.iov);
+    sqe->len = 1;
+    sqe->user_data = index << 1;
+    if (sync) {
+      sqe = pushSqe(tail + 1);
+      sqe->opcode = IORING_OP_FSYNC;
+      sqe->fd = descriptor(file);
+      sqe->user_data = (index << 1) | 1;
+    }
+    __atomic_store_n(sq_tail_, tail + entries, __ATOMIC_RELEASE);
+
+    unsigned submitted = 0;
+    int error = 0;
+    while (submitted < entries) {
+      const auto status = ioUringEnter(fd_, entries - submitted, 0, 0);
+      if (status < 0 && errno == EINTR) {
+        continue;
+      }
+      if (status <= 0) {
+        // Calls consuming no entry without an error are not retried either,
+        // as retrying could spin forever.
+        error = status < 0 ? errno : EAGAIN;
+        break;
+      }
+      submitted += static_cast<unsigned>(status);
+    }
+    if (submitted == 0) {
+      // Nothing was consumed by the kernel, thus the entries are withdrawn
+      // and the buffer is left with the caller.
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      throw std::system_error(error, std::generic_category(),
+                              "Error calling 'io_uring_enter': ");
+    }
+    if (submitted < entries) {
+      // The write was consumed without its linked fsync, which is withdrawn
+      // and performed synchronously once the write completes.
+      __atomic_store_n(sq_tail_, tail + submitted, __ATOMIC_RELEASE);
+    }
+    free_slots_.pop_back();
+    slot.file.emplace(std::move(file));
+    slot.buffer = std::move(buffer);
+    slot.pending = submitted;
+    slot.sync = sync;
+    slot.linked = submitted == 2;
+    slot.tag = tag;
+    slot.error = nullptr;
+  }
+
+  std::size_t reap(std::vector<Completion>& completions,
+                   const bool wait) override {
+    std::size_t count = 0;
+    while (true) {
+      auto head = *cq_head_;
+      const auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        const auto& cqe = cqes_[head & cq_mask_];
+        count += complete(cqe.user_data, cqe.res, completions);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      if (count || !wait || free_slots_.size() == slots_.size()) {
+        return count;
+      }
+      if (ioUringEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+          errno != EINTR) {
+        throw std::system_error(errno, std::generic_category(),
+                                "Error calling 'io_uring_enter': ");
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    std::optional<File> file;
+    BlockBuffer buffer;
+    iovec iov;
+    unsigned pending = 0;
+    bool sync = false;
+    bool linked = false;  //<- Set if the fsync is linked to the write.
+    std::size_t tag = 0;
+    std::exception_ptr error;
+  };
+
+  void setup(const unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = ioUringSetup(entries, params);
+    if (fd_ < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "Error calling 'io_uring_setup': ");
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = map(sqes_size_, IORING_OFF_SQES);
+
+    auto* const sq = static_cast<uint8_t*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    auto* const cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  void* map(const std::size_t size, const off_t offset) const {
+    auto* const address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd_, offset);
+    if (address == MAP_FAILED) {
+      throw std::system_error(errno, std::generic_category(),
+                              "Error calling 'mmap' for io_uring: ");
+    }
+    return address;
+  }
+
+  void close() {
+    if (sqes_ != MAP_FAILED) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      ::munmap(sq_ring_, sq_ring_size_);
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    sqes_ = cq_ring_ = sq_ring_ = MAP_FAILED;
+    fd_ = -1;
+  }
+
+  io_uring_sqe* pushSqe(const unsigned tail) {
+    const auto index = tail & sq_mask_;
+    auto* const sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    return sqe;
+  }
+
+  /**
+   * @brief Handle the completion of an entry, returning the number of writes
+   * completed by it.
+   *
+   */
+  std::size_t complete(const uint64_t user_data, const int result,
+                       std::vector<Completion>& completions) {
+    const auto index = static_cast<std::size_t>(user_data >> 1);
+    auto& slot = slots_[index];
+    if ((user_data & 1) == 0) {
+      if (result < 0) {
+        slot.error = std::make_exception_ptr(std::system_error(
+            -result, std::generic_category(),
+            "Error writing file '" + slot.file->path() + "': "));
+      } else if (static_cast<std::size_t>(result) < slot.buffer.size()) {
+        // The linked fsync is cancelled by the short write.
+        try {
+          writeFile(*slot.file, slot.buffer.data(), slot.buffer.size(),
+                    static_cast<std::size_t>(result), slot.sync);
+        } catch (...) {
+          slot.error = std::current_exception();
+        }
+      } else {
+        // The file is synced here if the kernel did not accept its fsync, or
+        // if it was truncated once written, which the linked fsync does not
+        // cover.
+        try {
+          const auto truncated =
+              truncateFile(*slot.file, slot.buffer.size());
+          if (slot.sync && (truncated || !slot.linked)) {
+            slot.file->sync();
+          }
+        } catch (...) {
+          slot.error = std::current_exception();
+        }
+      }
+    } else if (result < 0 && result != -ECANCELED && !slot.error) {
+      slot.error = std::make_exception_ptr(std::system_error(
+          -result, std::generic_category(),
+          "Error syncing file '" + slot.file->path() + "': "));
+    }
+    if (--slot.pending > 0) {
+      return 0;
+    }
+    completions.push_back({slot.tag, std::move(slot.buffer), slot.error});
+    slot.buffer = {};
+    slot.file.reset();
+    slot.error = nullptr;
+    free_slots_.push_back(index);
+    return 1;
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<std::size_t> free_slots_;
+  int fd_;
+  void* sq_ring_;
+  std::size_t sq_ring_size_;
+  void* cq_ring_;
+  std::size_t cq_ring_size_;
+  void* sqes_;
+  std::size_t sqes_size_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+};
+
+// ----------------------------------------------------------------
+// ThreadPoolEngine
+// ----------------------------------------------------------------
+
+/**
+ * @brief Engine performing the writes with blocking calls on a pool of
+ * threads.
+ *
+ */
+class AsyncWriter::ThreadPoolEngine final : public AsyncWriter::Engine {
+ public:
+  explicit ThreadPoolEngine(const std::size_t threads) : stop_(false) {
+    for (std::size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this]() { run(); });
+    }
+  }
+
+  ~ThreadPoolEngine() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    task_condition_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void submit(File&& file, BlockBuffer&& buffer, const bool sync,
+              const std::size_t tag) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back({std::move(file), std::move(buffer), sync, tag});
+    }
+    task_condition_.notify_one();
+  }
+
+  std::size_t reap(std::vector<Completion>& completions,
+                   const bool wait) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (wait) {
+      done_condition_.wait(lock, [this]() { return !done_.empty(); });
+    }
+    const auto count = done_.size();
+    for (auto& completion : done_) {
+      completions.push_back(std::move(completion));
+    }
+    done_.clear();
+    return count;
+  }
+
+ private:
+  struct Task {
+    File file;
+    BlockBuffer buffer;
+    bool sync;
+    std::size_t tag;
+  };
+
+  void run() {
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // Pending writes are completed before stopping.
+      task_condition_.wait(lock,
+                           [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      auto task = std::move(tasks_.front());
+      tasks_.pop_front();
+      lock.unlock();
+
+      Completion completion;
+      completion.tag = task.tag;
+      try {
+        writeFile(task.file, task.buffer.data(), task.buffer.size(), 0,
+                  task.sync);
+      } catch (...) {
+        completion.error = std::current_exception();
+      }
+      completion.buffer = std::move(task.buffer);
+
+      lock.lock();
+      done_.push_back(std::move(completion));
+      lock.unlock();
+      done_condition_.notify_one();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable task_condition_;
+  std::condition_variable done_condition_;
+  std::deque<Task> tasks_;
+  std::vector<Completion> done_;
+  bool stop_;
+  std::vector<std::thread> threads_;
+};
+
+// ----------------------------------------------------------------
+// AsyncWriter
+// ----------------------------------------------------------------
+
+bool AsyncWriter::isIoUringAvailable() {
+  static const bool available = []() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    const auto fd = ioUringSetup(1, params);
+    if (fd < 0) {
+      return false;
+    }
+    ::close(fd);
+    return true;
+  }();
+  return available;
+}
+
+AsyncWriter::AsyncWriter(const std::size_t depth, const Backend backend)
+    : backend_(backend), depth_(depth), in_flight_(0) {
+  if (depth == 0) {
+    throw std::invalid_argument("Async writer depth must be positive.");
+  }
+  if (backend_ == Backend::kAuto) {
+    backend_ =
+        isIoUringAvailable() ? Backend::kIoUring : Backend::kThreadPool;
+  }
+  if (backend_ == Backend::kIoUring) {
+    engine_ = std::make_unique<IoUringEngine>(depth_);
+  } else {
+    engine_ = std::make_unique<ThreadPoolEngine>(std::min(depth_, kMaxThreads));
+  }
+}
+
+AsyncWriter::~AsyncWriter() {
+  std::vector<Completion> completions;
+  while (in_flight_) {
+    try {
+      in_flight_ -= engine_->reap(completions, true);
+    } catch (const std::exception&) {
+      break;
+    }
+    completions.clear();
+  }
+}
+
+AsyncWriter::Backend AsyncWriter::backend() const { return backend_; }
+
+std::size_t AsyncWriter::depth() const { return depth_; }
+
+std::size_t AsyncWriter::inFlight() const { return in_flight_; }
+
+bool AsyncWriter::full() const { return in_flight_ == depth_; }
+
+void AsyncWriter::submit(File&& file, BlockBuffer&& buffer,
+                         const bool sync, const std::size_t tag) {
+  if (full()) {
+    throw std::length_error("Async writer has maximum writes in flight.");
+  }
+  engine_->submit(std::move(file), std::move(buffer), sync, tag);
+  ++in_flight_;
+}
+
+std::size_t AsyncWriter::reap(std::vector<Completion>& completions,
+                              const bool wait) {
+  const auto count = engine_->reap(completions, wait && in_flight_ > 0);
+  in_flight_ -= count;
+  return count;
+}
+
+// private
+int AsyncWriter::descriptor(const File& file) { return file.fd_; }
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
@@ -0,0 +1,160 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "tools/common/storage/common.hpp"
+#include "tools/common/storage/file_io.hpp"
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+/**
+ * @brief The class `AsyncWriter` writes whole buffers to files and optionally
+ * syncs them to disk asynchronously, keeping multiple writes in flight at once.
+ *
+ * Writes are submitted through an io_uring instance when the kernel provides
+ * one, with each synced write linked to the sync of its file. Otherwise writes
+ * are performed by a pool of threads. Buffers are handed back with the
+ * completion of their write so that the caller can reuse them. Files larger
+ * than their buffer are truncated to it once written.
+ *
+ * @note The class is not thread safe, writes are expected to be submitted and
+ * reaped by a single thread.
+ */
+class AsyncWriter final {
+ public:
+  NO_COPY(AsyncWriter);
+
+  /**
+   * @brief Mechanism used to perform the writes.
+   *
+   */
+  enum class Backend : uint8_t {
+    kAuto,        //<- io_uring if available else a thread pool.
+    kIoUring,     //<- io_uring, throws if not available.
+    kThreadPool,  //<- Pool of threads performing blocking writes.
+  };
+
+  /**
+   * @brief Data structure representing a completed write.
+   *
+   */
+  struct Completion {
+    std::size_t tag = 0;        //<- Tag given when submitting the write.
+    BlockBuffer buffer;         //<- Buffer handed back for reuse.
+    std::exception_ptr error;   //<- Error writing the buffer, if any.
+  };
+
+  /**
+   * @brief Check if io_uring is available to the process.
+   *
+   */
+  static bool isIoUringAvailable();
+
+  /**
+   * @brief Construct a new AsyncWriter object.
+   *
+   * @param depth Maximum number of writes in flight at once. Must be positive.
+   * @param backend Mechanism used to perform the writes.
+   * @throws `std::invalid_argument` if the depth is 0.
+   * @throws `std::system_error` if the io_uring backend is requested but is
+   * not available.
+   */
+  explicit AsyncWriter(const std::size_t depth,
+                       const Backend backend = Backend::kAuto);
+
+  /**
+   * @brief Destroy the AsyncWriter object.
+   *
+   * The DTOR waits for the writes in flight to complete.
+   */
+  ~AsyncWriter();
+
+  /**
+   * @brief Get the mechanism used to perform the writes. Never `kAuto`.
+   *
+   */
+  Backend backend() const;
+
+  /**
+   * @brief Get the maximum number of writes in flight at once.
+   *
+   */
+  std::size_t depth() const;
+
+  /**
+   * @brief Get the number of writes submitted but not yet reaped.
+   *
+   */
+  std::size_t inFlight() const;
+
+  /**
+   * @brief Check if the maximum number of writes are in flight.
+   *
+   */
+  bool full() const;
+
+  /**
+   * @brief Submit writing the given buffer at the start of the given file,
+   * optionally followed by syncing the file.
+   *
+   * @param file Rvalue reference to the file, kept open until the write
+   * completes.
+   * @param buffer Rvalue reference to the buffer to write. The buffer is left
+   * untouched if submitting fails.
+   * @param sync Flag to sync the file to disk once written.
+   * @param tag Tag identifying the write in its completion.
+   * @throws `std::length_error` if the maximum number of writes are in flight.
+   * @throws `std::system_error` if the write could not be submitted.
+   */
+  void submit(File&& file, BlockBuffer&& buffer, const bool sync = true,
+              const std::size_t tag = 0);
+
+  /**
+   * @brief Collect the completed writes.
+   *
+   * @param completions Reference to the list to which completions are
+   * appended.
+   * @param wait Flag to block until at least one write completes if any is in
+   * flight.
+   * @returns Number of completions appended.
+   */
+  std::size_t reap(std::vector<Completion>& completions,
+                   const bool wait = false);
+
+ private:
+  class Engine;
+  class IoUringEngine;
+  class ThreadPoolEngine;
+
+  static int descriptor(const File& file);
+
+  std::unique_ptr<Engine> engine_;
+  Backend backend_;
+  std::size_t depth_;
+  std::size_t in_flight_;
+};
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
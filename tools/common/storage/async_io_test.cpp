@@ -0,0 +1,113 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/async_io.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/testing.hpp"
+
+using namespace inspector::tools::storage;
+
+class AsyncWriterTestFixture : public TestHarness, public ::testing::Test {
+ protected:
+  /**
+   * @brief Write files with the given writer, recycling the buffers of
+   * completed writes, and check their contents.
+   *
+   */
+  void writeFiles(AsyncWriter& writer) {
+    constexpr std::size_t kFileCount = 16;
+    constexpr std::size_t kFileSize = 64 * 1024;
+
+    std::vector<BlockBuffer> buffers(writer.depth());
+    std::vector<AsyncWriter::Completion> completions;
+    std::size_t completed = 0;
+    for (std::size_t index = 0; index < kFileCount; ++index) {
+      while (writer.full()) {
+        completed += writer.reap(completions, true);
+      }
+      for (auto& completion : completions) {
+        ASSERT_FALSE(completion.error);
+        buffers.push_back(std::move(completion.buffer));
+      }
+      completions.clear();
+      auto buffer = std::move(buffers.back());
+      buffers.pop_back();
+      buffer.assign(kFileSize, static_cast<uint8_t>(index));
+      // Every fourth file is left larger by a previous write, whose stale tail
+      // is dropped.
+      if (index % 4 == 0) {
+        const std::string stale(2 * kFileSize, 'x');
+        File{std::to_string(index), tempDir().path()}.write(
+            stale.data(), stale.size(), 0);
+      }
+      // Every other file is synced to disk
+      writer.submit(File{std::to_string(index), tempDir().path()},
+                    std::move(buffer), index % 2 == 0, index);
+      ASSERT_LE(writer.inFlight(), writer.depth());
+    }
+    while (writer.inFlight()) {
+      completed += writer.reap(completions, true);
+    }
+    for (const auto& completion : completions) {
+      ASSERT_FALSE(completion.error);
+      ASSERT_EQ(completion.buffer.size(), kFileSize);
+      ASSERT_EQ(completion.buffer[0], completion.tag);
+    }
+    ASSERT_EQ(completed, kFileCount);
+    ASSERT_EQ(writer.reap(completions), 0);
+
+    for (std::size_t index = 0; index < kFileCount; ++index) {
+      const auto data = tempDir().readFile(std::to_string(index));
+      ASSERT_EQ(data, std::string(kFileSize, static_cast<char>(index)));
+    }
+  }
+};
+
+TEST_F(AsyncWriterTestFixture, TestWriteWithThreadPool) {
+  AsyncWriter writer(4, AsyncWriter::Backend::kThreadPool);
+  ASSERT_EQ(writer.backend(), AsyncWriter::Backend::kThreadPool);
+  writeFiles(writer);
+}
+
+TEST_F(AsyncWriterTestFixture, TestWriteWithIoUring) {
+  if (!AsyncWriter::isIoUringAvailable()) {
+    ASSERT_THROW(AsyncWriter(4, AsyncWriter::Backend::kIoUring),
+                 std::system_error);
+    return;
+  }
+  AsyncWriter writer(4, AsyncWriter::Backend::kAuto);
+  ASSERT_EQ(writer.backend(), AsyncWriter::Backend::kIoUring);
+  writeFiles(writer);
+}
+
+TEST_F(AsyncWriterTestFixture, TestFullAndInvalidDepth) {
+  ASSERT_THROW(AsyncWriter(0), std::invalid_argument);
+
+  AsyncWriter writer(1);
+  writer.submit(File{"file", tempDir().path()}, BlockBuffer(16, 1));
+  ASSERT_TRUE(writer.full());
+  BlockBuffer buffer(16, 2);
+  ASSERT_THROW(writer.submit(File{"other", tempDir().path()},
+                             std::move(buffer)),
+               std::length_error);
+  ASSERT_EQ(buffer.size(), 16);
+}
@@ -16,8 +16,15 @@
 
 #include "tools/common/storage/block.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 #include "tools/common/storage/checksum.hpp"
 
@@ -26,15 +33,107 @@ namespace tools {
 namespace storage {
 namespace {
 
+/**
+ * @brief Number of bytes of the body of a block compressed at once. Frames are
+ * compressed independently so that a block can be streamed without
+ * decompressing all of it.
+ *
+ */
+constexpr std::size_t kFrameSize = 64 * 1024;
+
+/**
+ * @brief Number of bytes reserved after a block for its footer, so that the
+ * footer is appended without reallocating the block.
+ *
+ */
+constexpr std::size_t kFooterReserve = 64 * 1024;
+
+/**
+ * @brief Magic number identifying blocks, stored right after the checksum.
+ *
+ */
+constexpr uint32_t kBlockMagic = 0x4b4c4249;  // "IBLK"
+
+/**
+ * @brief Version of the block format. Bumped whenever the layout of the header
+ * or of the body changes. Version 2 added the frame checksums.
+ *
+ */
+constexpr uint16_t kBlockVersion = 2;
+
 /**
  * @brief Data structure representing a block header. It contains the checksum,
- * number of records, and head (offset in bytes from start of body) to the free
- * space in the block.
+ * the magic number and format version of the block, number of records, head
+ * (offset in bytes from start of body) to the free space in the block, the
+ * codec used to compress the body, the size of the body once decompressed, the
+ * offset in bytes from the start of the block to the footer containing the
+ * summary of the block, and the offset to the frame checksums. The summary
+ * offset is 0 for blocks without a footer.
+ *
+ * The body of a compressed block is compacted before being compressed, i.e. the
+ * records are moved right after the index leaving no free space. It is stored
+ * as a table with the compressed size of each frame of the body, followed by
+ * the frames. Frames which do not compress are stored as is.
+ *
+ * The body is followed by the footer and by the checksum of each frame of the
+ * body as stored, after which the block is padded to whole pages. The checksum
+ * in the header covers the rest of the block, i.e. the header, the frame size
+ * table, the footer, the frame checksums and the padding. Thus readers verify
+ * the metadata of a block up front and each frame as they read it.
  */
 struct PACKED BlockHeader {
   ChecksumType checksum;
+  uint32_t magic;
+  uint16_t version;
   std::size_t count;
   std::size_t fs_head;
+  CodecType codec;
+  std::size_t size;
+  std::size_t summary;
+  std::size_t checksums;
+};
+
+/**
+ * @brief Data structure representing the header of blocks written before the
+ * header had a magic number. Legacy blocks are uncompressed and have no footer.
+ * Their body is laid out as in the current format, but their checksum was
+ * never set, thus they are read without verification.
+ */
+struct PACKED LegacyBlockHeader {
+  ChecksumType checksum;
+  std::size_t count;
+  std::size_t fs_head;
+};
+
+/**
+ * @brief Compressed size of a frame, stored in the frame table of compressed
+ * blocks.
+ *
+ */
+using FrameSize = uint32_t;
+
+/**
+ * @brief Data structure representing the header of a serialized block summary.
+ * It is followed by the number of records of each type, and the process and
+ * thread ids.
+ */
+struct PACKED SummaryHeader {
+  uint64_t count;
+  timestamp_t min_timestamp;
+  timestamp_t max_timestamp;
+  uint8_t tagged;
+  uint16_t types;
+  uint32_t pids;
+  uint32_t tids;
+};
+
+/**
+ * @brief Data structure representing the number of records of a type in a
+ * serialized block summary.
+ */
+struct PACKED TypeCount {
+  uint8_t type;
+  uint64_t count;
 };
 
 /**
@@ -48,22 +147,119 @@ struct PACKED RecordIndex {
   std::size_t size;
 };
 
+}  // namespace
+
+const std::size_t kMinBlockSize = sizeof(BlockHeader) + sizeof(RecordIndex);
+
+namespace {
+
+/**
+ * @brief Get the number of frames of a block body of given size.
+ *
+ */
+std::size_t frameCount(const std::size_t size) {
+  return (size + kFrameSize - 1) / kFrameSize;
+}
+
+/**
+ * @brief Get the size of a frame of a block body of given size once
+ * decompressed.
+ *
+ */
+std::size_t frameSize(const std::size_t size, const std::size_t frame) {
+  return std::min(kFrameSize, size - frame * kFrameSize);
+}
+
+/**
+ * @brief Round the given size of a block up to whole pages.
+ *
+ */
+std::size_t alignBlock(const std::size_t size) {
+  return (size + kBlockAlignment - 1) / kBlockAlignment * kBlockAlignment;
+}
+
+/**
+ * @brief Data structure locating the parts of a block.
+ *
+ */
+struct BlockLayout {
+  std::size_t frames;     //<- Number of frames of the body.
+  std::size_t table_end;  //<- End of the header and of the frame size table.
+  std::size_t tail;       //<- Start of the footer, or of the frame checksums.
+  std::size_t end;        //<- End of the padding after the frame checksums.
+};
+
+/**
+ * @brief Locate the parts of the block with the given header.
+ *
+ * @param header Constant reference to the header of the block.
+ * @param size Number of bytes of the block file.
+ * @param layout Reference to store the layout.
+ * @returns `true` on success or `false` if the header does not describe a
+ * block fitting the file, i.e. the block is truncated or corrupt.
+ */
+bool blockLayout(const BlockHeader& header, const std::size_t size,
+                 BlockLayout& layout) {
+  // The body size is bounded by the file size before sizes are derived from
+  // it, so that corrupt headers do not overflow them.
+  if (header.size / kFrameSize >= size) {
+    return false;
+  }
+  const auto compressed = header.codec != CodecType::kNone;
+  layout.frames = frameCount(header.size);
+  layout.table_end = sizeof(BlockHeader) +
+                     (compressed ? layout.frames * sizeof(FrameSize) : 0);
+  layout.tail = header.summary ? header.summary : header.checksums;
+  const auto body_end =
+      compressed ? layout.table_end : sizeof(BlockHeader) + header.size;
+  if (body_end > layout.tail || layout.tail > header.checksums ||
+      header.checksums > size ||
+      layout.frames > (size - header.checksums) / sizeof(ChecksumType)) {
+    return false;
+  }
+  layout.end =
+      alignBlock(header.checksums + layout.frames * sizeof(ChecksumType));
+  return layout.end <= size;
+}
+
+/**
+ * @brief Compute the checksum of the metadata of the block stored in the given
+ * memory span, i.e. of the parts of the block which are not frames.
+ *
+ */
+ChecksumType metadataChecksum(const uint8_t* const data,
+                              const BlockLayout& layout) {
+  const auto value = checksum(data + sizeof(ChecksumType),
+                              layout.table_end - sizeof(ChecksumType));
+  return checksum(data + layout.tail, layout.end - layout.tail, value);
+}
+
 /**
  * @brief The class exposes a read and write view of a block.
  *
  */
 class BlockView {
  public:
-  explicit BlockView(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+  explicit BlockView(BlockBuffer& buffer) : buffer_(buffer) {}
 
   void reset() {
+    header().checksum = 0;
+    header().magic = kBlockMagic;
+    header().version = kBlockVersion;
     header().count = 0;
     header().fs_head = buffer_.size() - sizeof(BlockHeader);
+    header().codec = CodecType::kNone;
+    header().size = buffer_.size() - sizeof(BlockHeader);
+    header().summary = 0;
+    header().checksums = 0;
   }
 
-  bool isCorrupt() const { return header().checksum != getChecksum(); }
-
-  void setChecksum() { header().checksum = getChecksum(); }
+  void setChecksum() {
+    // Sealed blocks always fit their buffer.
+    BlockLayout layout;
+    blockLayout(header(), buffer_.size(), layout);
+    header().checksum = metadataChecksum(buffer_.data(), layout);
+  }
 
   std::size_t count() const { return header().count; }
 
@@ -77,51 +273,188 @@ class BlockView {
     header().fs_head -= record.size;
     std::memcpy(body() + header().fs_head, record.src, record.size);
 
-    // Find location to insert the record index
-    std::size_t insert_idx = 0, idx = 0, step = 0, count = header().count;
-    while (count > 0) {
-      idx = insert_idx;
-      step = count / 2;
-      idx += step;
-      if (recordIndex(idx).timestamp < record.timestamp) {
-        insert_idx = idx + 1;
-        count -= step + 1;
-      } else {
-        count = step;
-      }
-    }
-
-    // Creating a new index record at the end and then swaping it to the correct
-    // location.
+    // The index is appended in arrival order and only sorted once when the
+    // block is sealed.
     auto& record_index = recordIndex(header().count);
     record_index.timestamp = record.timestamp;
     record_index.size = record.size;
     record_index.offset = header().fs_head;
-    idx = header().count;
-    while (idx > insert_idx) {
-      const auto prev_idx = idx - 1;
-      std::swap(recordIndex(idx), recordIndex(prev_idx));
-      idx = prev_idx;
-    }
     header().count += 1;
 
     return true;
   }
 
+  std::size_t insert(const Record* const records, const std::size_t count) {
+    std::size_t added = 0;
+    while (added < count && insert(records[added])) {
+      ++added;
+    }
+    return added;
+  }
+
+  void sort(std::vector<uint8_t>& scratch) {
+    const auto count = header().count;
+    if (count < 2) {
+      return;
+    }
+    auto* const begin = &recordIndex(0);
+    auto* const end = begin + count;
+
+    // Records mostly arrive in chronological order, e.g. one run per event
+    // queue drained into the block, in which case the sorted runs are merged.
+    // Otherwise the index is radix sorted on timestamps.
+    std::vector<RecordIndex*> runs{begin};
+    for (auto* it = begin + 1; it != end; ++it) {
+      if (it->timestamp < (it - 1)->timestamp) {
+        if (runs.size() > kMaxMergeRuns) {
+          radixSort(scratch);
+          return;
+        }
+        runs.push_back(it);
+      }
+    }
+    runs.push_back(end);
+    const auto compare = [](const RecordIndex& lhs, const RecordIndex& rhs) {
+      return lhs.timestamp < rhs.timestamp;
+    };
+    while (runs.size() > 2) {
+      std::size_t merged = 1;
+      for (std::size_t idx = 2; idx < runs.size(); idx += 2) {
+        std::inplace_merge(runs[idx - 2], runs[idx - 1], runs[idx], compare);
+        runs[merged++] = runs[idx];
+      }
+      if (runs.size() % 2 == 0) {
+        runs[merged++] = runs.back();
+      }
+      runs.resize(merged);
+    }
+  }
+
   Record operator[](const std::size_t index) const {
     auto& record_index = recordIndex(index);
     return Record{record_index.timestamp, body() + record_index.offset,
                   record_index.size};
   }
 
-  void flush(const File& file) {
+  void seal(std::vector<uint8_t>& scratch) {
+    sort(scratch);
     std::memset(body() + header().count * sizeof(RecordIndex), 0, freeSpace());
-    file.write(buffer_.data(), buffer_.size(), 0);
-    file.sync();
-    reset();
+  }
+
+  void appendSummary(const BlockSummary& summary,
+                     std::vector<uint8_t>& scratch) {
+    scratch.clear();
+    summary.serialize(scratch);
+    header().summary = buffer_.size();
+    buffer_.insert(buffer_.end(), scratch.begin(), scratch.end());
+  }
+
+  void appendChecksums() {
+    // Frames are checksummed as stored, i.e. compressed frames once
+    // compressed, so that readers verify them before decompressing them.
+    const auto frames = frameCount(header().size);
+    const auto compressed = header().codec != CodecType::kNone;
+    auto offset =
+        sizeof(BlockHeader) + (compressed ? frames * sizeof(FrameSize) : 0);
+    header().checksums = buffer_.size();
+    buffer_.resize(buffer_.size() + frames * sizeof(ChecksumType));
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+      std::size_t stored = frameSize(header().size, frame);
+      if (compressed) {
+        FrameSize frame_size;
+        std::memcpy(&frame_size,
+                    buffer_.data() + sizeof(BlockHeader) +
+                        frame * sizeof(FrameSize),
+                    sizeof(frame_size));
+        stored = frame_size;
+      }
+      const auto value = checksum(buffer_.data() + offset, stored);
+      std::memcpy(buffer_.data() + header().checksums +
+                      frame * sizeof(ChecksumType),
+                  &value, sizeof(value));
+      offset += stored;
+    }
+    // Blocks are padded to whole pages, which takes no extra space on disk and
+    // lets them be written with direct IO.
+    buffer_.resize(alignBlock(buffer_.size()));
+  }
+
+  std::size_t compact() {
+    const auto index_size = header().count * sizeof(RecordIndex);
+    const auto shift = header().fs_head - index_size;
+    const auto data_size = header().size - header().fs_head;
+    std::memmove(body() + index_size, body() + header().fs_head, data_size);
+    for (std::size_t idx = 0; idx < header().count; ++idx) {
+      recordIndex(idx).offset -= shift;
+    }
+    header().fs_head = index_size;
+    header().size = index_size + data_size;
+    return header().size;
   }
 
  private:
+  /**
+   * @brief Maximum number of sorted runs in the index which are merged. Blocks
+   * with more runs are radix sorted instead.
+   *
+   */
+  static constexpr std::size_t kMaxMergeRuns = 64;
+
+  /**
+   * @brief Stable LSD radix sort of the index on timestamps relative to the
+   * smallest timestamp. Only the bytes which vary across the index are sorted
+   * on, e.g. 4 passes for records spanning a few seconds.
+   *
+   */
+  void radixSort(std::vector<uint8_t>& scratch) {
+    constexpr std::size_t kRadix = 256;
+    const auto count = header().count;
+    auto* src = &recordIndex(0);
+    scratch.resize(count * sizeof(RecordIndex));
+    auto* dst = reinterpret_cast<RecordIndex*>(scratch.data());
+
+    auto min = src[0].timestamp, max = src[0].timestamp;
+    for (std::size_t idx = 1; idx < count; ++idx) {
+      min = std::min(min, src[idx].timestamp);
+      max = std::max(max, src[idx].timestamp);
+    }
+    const auto range =
+        static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+    std::size_t passes = 0;
+    while (passes < sizeof(uint64_t) && (range >> (8 * passes)) != 0) {
+      ++passes;
+    }
+
+    std::size_t offsets[kRadix];
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+      const auto shift = 8 * pass;
+      const auto digit = [min, shift](const RecordIndex& index) {
+        return ((static_cast<uint64_t>(index.timestamp) -
+                 static_cast<uint64_t>(min)) >>
+                shift) &
+               (kRadix - 1);
+      };
+      std::fill(offsets, offsets + kRadix, 0);
+      for (std::size_t idx = 0; idx < count; ++idx) {
+        ++offsets[digit(src[idx])];
+      }
+      std::size_t sum = 0;
+      for (auto& offset : offsets) {
+        const auto bucket = offset;
+        offset = sum;
+        sum += bucket;
+      }
+      for (std::size_t idx = 0; idx < count; ++idx) {
+        std::memcpy(&dst[offsets[digit(src[idx])]++], &src[idx],
+                    sizeof(RecordIndex));
+      }
+      std::swap(src, dst);
+    }
+    if (src != &recordIndex(0)) {
+      std::memcpy(&recordIndex(0), src, count * sizeof(RecordIndex));
+    }
+  }
+
   BlockHeader& header() {
     return *reinterpret_cast<BlockHeader*>(buffer_.data());
   }
@@ -144,18 +477,13 @@ class BlockView {
                                                  sizeof(RecordIndex) * index);
   }
 
-  ChecksumType getChecksum() const {
-    return checksum(buffer_.data() + sizeof(ChecksumType),
-                    buffer_.size() - sizeof(ChecksumType));
-  }
-
   std::size_t freeSpace() const {
     const std::size_t index_head = header().count * sizeof(RecordIndex);
     assert(header().fs_head >= index_head);
     return header().fs_head - index_head;
   }
 
-  std::vector<uint8_t>& buffer_;
+  BlockBuffer& buffer_;
 };
 
 /**
@@ -164,12 +492,53 @@ class BlockView {
  */
 class ConstBlockView {
  public:
-  explicit ConstBlockView(const std::vector<uint8_t>& buffer)
-      : buffer_(buffer) {}
+  ConstBlockView(const uint8_t* const data, const std::size_t size)
+      : data_(data), size_(size) {}
 
-  bool isCorrupt() const { return header().checksum != getChecksum(); }
+  bool isCorrupt() const {
+    BlockLayout layout;
+    if (size_ < sizeof(BlockHeader) || header().magic != kBlockMagic ||
+        !blockLayout(header(), size_, layout) ||
+        header().checksum != metadataChecksum(data_, layout)) {
+      return true;
+    }
+    const auto compressed = header().codec != CodecType::kNone;
+    auto offset = layout.table_end;
+    for (std::size_t frame = 0; frame < layout.frames; ++frame) {
+      std::size_t stored = frameSize(header().size, frame);
+      if (compressed) {
+        FrameSize frame_size;
+        std::memcpy(&frame_size,
+                    data_ + sizeof(BlockHeader) + frame * sizeof(FrameSize),
+                    sizeof(frame_size));
+        stored = frame_size;
+      }
+      ChecksumType value;
+      std::memcpy(&value,
+                  data_ + header().checksums + frame * sizeof(ChecksumType),
+                  sizeof(value));
+      if (stored > layout.tail - offset ||
+          checksum(data_ + offset, stored) != value) {
+        return true;
+      }
+      offset += stored;
+    }
+    return false;
+  }
 
-  std::size_t count() const { return header().count; }
+  std::size_t count() const {
+    // Truncated blocks are treated as empty, while the count is capped to the
+    // number of indices fitting in the block.
+    if (size_ < sizeof(BlockHeader)) {
+      return 0;
+    }
+    return std::min(header().count,
+                    (size_ - sizeof(BlockHeader)) / sizeof(RecordIndex));
+  }
+
+  std::size_t indexSize() const {
+    return sizeof(BlockHeader) + count() * sizeof(RecordIndex);
+  }
 
   Record operator[](const std::size_t index) const {
     auto& record_index = recordIndex(index);
@@ -179,43 +548,483 @@ class ConstBlockView {
 
  private:
   const BlockHeader& header() const {
-    return *reinterpret_cast<const BlockHeader*>(buffer_.data());
+    return *reinterpret_cast<const BlockHeader*>(data_);
   }
 
-  const uint8_t* body() const { return buffer_.data() + sizeof(BlockHeader); }
+  const uint8_t* body() const { return data_ + sizeof(BlockHeader); }
 
   const RecordIndex& recordIndex(const std::size_t index) const {
     return *reinterpret_cast<const RecordIndex*>(body() +
                                                  sizeof(RecordIndex) * index);
   }
 
-  ChecksumType getChecksum() const {
-    return checksum(buffer_.data() + sizeof(ChecksumType),
-                    buffer_.size() - sizeof(ChecksumType));
+  const uint8_t* data_;
+  std::size_t size_;
+};
+
+/**
+ * @brief Number of leading bytes of a block needed to tell its format.
+ *
+ */
+constexpr std::size_t kFormatPrefixSize =
+    std::max(sizeof(BlockHeader),
+             sizeof(LegacyBlockHeader) + sizeof(RecordIndex));
+
+/**
+ * @brief Check that the block at the given path, starting with the given
+ * bytes, is not in another version of the format. Blocks which are neither in
+ * the current format nor in the legacy one are corrupt, which is detected by
+ * their checksum.
+ *
+ * @param data Pointer to the first bytes of the block.
+ * @param size Number of bytes of the block file.
+ * @param path Constant reference to the path of the block file.
+ * @throws `std::runtime_error` if the block is in another version of the
+ * format.
+ */
+void checkFormat(const uint8_t* const data, const std::size_t size,
+                 const std::string& path) {
+  BlockHeader header;
+  if (size < sizeof(header)) {
+    return;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic == kBlockMagic && header.version != kBlockVersion) {
+    throw std::runtime_error(
+        "Block '" + path + "' has format version " +
+        std::to_string(header.version) + " but only version " +
+        std::to_string(kBlockVersion) + " is supported.");
+  }
+}
+
+/**
+ * @brief Check if the block starting with the given bytes is in the legacy
+ * format. Legacy writers left the checksum unset and wrote the block whole,
+ * with the index before the free space head and the records after it. An
+ * empty legacy block is all free space, so that zero filled blocks, among
+ * other corrupt ones, are not mistaken for legacy blocks.
+ *
+ * @param data Pointer to the first bytes of the block.
+ * @param available Number of bytes available at the pointer, which must cover
+ * the legacy header and the first record index when the block has them.
+ * @param size Number of bytes of the block file.
+ * @returns `true` if the block is in the legacy format else `false`.
+ */
+bool isLegacyBlock(const uint8_t* const data, const std::size_t available,
+                   const std::size_t size) {
+  LegacyBlockHeader legacy;
+  if (available < sizeof(legacy)) {
+    return false;
   }
+  std::memcpy(&legacy, data, sizeof(legacy));
+  const auto body_size = size - sizeof(legacy);
+  if (legacy.checksum != 0 || legacy.fs_head > body_size ||
+      legacy.count > legacy.fs_head / sizeof(RecordIndex)) {
+    return false;
+  }
+  if (legacy.count == 0) {
+    return legacy.fs_head == body_size;
+  }
+  if (available < sizeof(legacy) + sizeof(RecordIndex)) {
+    return false;
+  }
+  RecordIndex first;
+  std::memcpy(&first, data + sizeof(legacy), sizeof(first));
+  return first.offset >= legacy.fs_head && first.offset <= body_size &&
+         first.size <= body_size - first.offset;
+}
 
-  const std::vector<uint8_t>& buffer_;
-};
+/**
+ * @brief Convert the legacy block stored in the given memory span into a block
+ * in the current format.
+ *
+ */
+void decodeLegacyBlock(const uint8_t* const data, const std::size_t size,
+                       BlockBuffer& decoded) {
+  LegacyBlockHeader legacy;
+  std::memcpy(&legacy, data, sizeof(legacy));
+  const auto body_size = size - sizeof(legacy);
+  decoded.resize(sizeof(BlockHeader) + body_size);
+  auto* const header = reinterpret_cast<BlockHeader*>(decoded.data());
+  header->checksum = 0;
+  header->magic = kBlockMagic;
+  header->version = kBlockVersion;
+  header->count = legacy.count;
+  header->fs_head = legacy.fs_head;
+  header->codec = CodecType::kNone;
+  header->size = body_size;
+  header->summary = 0;
+  header->checksums = 0;
+  std::memcpy(decoded.data() + sizeof(BlockHeader), data + sizeof(legacy),
+              body_size);
+}
+
+/**
+ * @brief Decompress a frame of a compressed block.
+ *
+ * @throws `std::runtime_error` if the frame is corrupt.
+ */
+void decodeFrame(const Codec& codec, const uint8_t* const src,
+                 const std::size_t size, uint8_t* const dest,
+                 const std::size_t dest_size) {
+  if (size == dest_size) {
+    std::memcpy(dest, src, size);
+  } else {
+    codec.decompress(src, size, dest, dest_size);
+  }
+}
+
+/**
+ * @brief Decompress the compressed block stored in the given memory span into
+ * an uncompressed block with no free space.
+ *
+ * @returns `true` on success or `false` if the block is truncated or corrupt.
+ */
+bool decodeBlock(const uint8_t* const data, const std::size_t size,
+                 BlockBuffer& decoded) {
+  BlockHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  const auto frames = frameCount(header.size);
+  auto offset = sizeof(BlockHeader) + frames * sizeof(FrameSize);
+  if (offset > size) {
+    return false;
+  }
+  try {
+    const auto& codec = Codec::get(header.codec);
+    decoded.resize(sizeof(BlockHeader) + header.size);
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+      FrameSize frame_size;
+      std::memcpy(&frame_size,
+                  data + sizeof(BlockHeader) + frame * sizeof(FrameSize),
+                  sizeof(frame_size));
+      const auto begin = frame * kFrameSize;
+      const auto end = std::min(begin + kFrameSize, header.size);
+      if (frame_size > size - offset || frame_size > end - begin) {
+        return false;
+      }
+      decodeFrame(codec, data + offset, frame_size,
+                  decoded.data() + sizeof(BlockHeader) + begin, end - begin);
+      offset += frame_size;
+    }
+  } catch (const std::exception&) {
+    decoded.clear();
+    return false;
+  }
+  header.codec = CodecType::kNone;
+  std::memcpy(decoded.data(), &header, sizeof(header));
+  return true;
+}
 
 }  // namespace
 
+// ----------------------------------------------------------------
+// BlockSummary
+// ----------------------------------------------------------------
+
+BlockSummary BlockSummary::unknown() {
+  BlockSummary summary;
+  summary.min_timestamp = std::numeric_limits<timestamp_t>::min();
+  summary.max_timestamp = std::numeric_limits<timestamp_t>::max();
+  return summary;
+}
+
+bool BlockSummary::overlaps(const timestamp_t begin,
+                            const timestamp_t end) const {
+  return min_timestamp <= end && max_timestamp >= begin;
+}
+
+void BlockSummary::merge(const BlockSummary& other) {
+  // Summaries of no records, unlike unknown ones, leave the other as is.
+  if (other.min_timestamp > other.max_timestamp) {
+    return;
+  }
+  if (min_timestamp > max_timestamp) {
+    *this = other;
+    return;
+  }
+  count += other.count;
+  min_timestamp = std::min(min_timestamp, other.min_timestamp);
+  max_timestamp = std::max(max_timestamp, other.max_timestamp);
+  tagged = tagged && other.tagged;
+  if (!tagged) {
+    type_counts.clear();
+    pids.clear();
+    tids.clear();
+    return;
+  }
+  for (const auto& type_count : other.type_counts) {
+    type_counts[type_count.first] += type_count.second;
+  }
+  const auto unite = [](std::vector<int32_t>& ids,
+                        const std::vector<int32_t>& other_ids) {
+    std::vector<int32_t> united;
+    united.reserve(ids.size() + other_ids.size());
+    std::set_union(ids.begin(), ids.end(), other_ids.begin(), other_ids.end(),
+                   std::back_inserter(united));
+    ids = std::move(united);
+  };
+  unite(pids, other.pids);
+  unite(tids, other.tids);
+}
+
+void BlockSummary::serialize(std::vector<uint8_t>& buffer) const {
+  SummaryHeader header;
+  header.count = count;
+  header.min_timestamp = min_timestamp;
+  header.max_timestamp = max_timestamp;
+  header.tagged = tagged;
+  header.types = static_cast<uint16_t>(type_counts.size());
+  header.pids = static_cast<uint32_t>(pids.size());
+  header.tids = static_cast<uint32_t>(tids.size());
+  const auto append = [&buffer](const void* const data,
+                                const std::size_t size) {
+    const auto* const bytes = static_cast<const uint8_t*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+  };
+  append(&header, sizeof(header));
+  for (const auto& type_count : type_counts) {
+    const TypeCount entry{type_count.first, type_count.second};
+    append(&entry, sizeof(entry));
+  }
+  append(pids.data(), pids.size() * sizeof(int32_t));
+  append(tids.data(), tids.size() * sizeof(int32_t));
+}
+
+std::size_t BlockSummary::deserialize(const uint8_t* const data,
+                                      const std::size_t size) {
+  SummaryHeader header;
+  if (size < sizeof(header)) {
+    return 0;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  const auto total = sizeof(header) + header.types * sizeof(TypeCount) +
+                     (std::size_t{header.pids} + header.tids) * sizeof(int32_t);
+  if (size < total) {
+    return 0;
+  }
+  count = header.count;
+  min_timestamp = header.min_timestamp;
+  max_timestamp = header.max_timestamp;
+  tagged = header.tagged;
+  type_counts.clear();
+  const auto* src = data + sizeof(header);
+  for (std::size_t idx = 0; idx < header.types; ++idx) {
+    TypeCount entry;
+    std::memcpy(&entry, src, sizeof(entry));
+    type_counts[entry.type] = entry.count;
+    src += sizeof(entry);
+  }
+  pids.resize(header.pids);
+  std::memcpy(pids.data(), src, pids.size() * sizeof(int32_t));
+  src += pids.size() * sizeof(int32_t);
+  tids.resize(header.tids);
+  std::memcpy(tids.data(), src, tids.size() * sizeof(int32_t));
+  return total;
+}
+
 // ----------------------------------------------------------------
 // BlockBuilder
 // ----------------------------------------------------------------
 
-BlockBuilder::BlockBuilder(const std::size_t block_size) : buffer_(block_size) {
-  BlockView(buffer_).reset();
+BlockBuilder::BlockBuilder(const std::size_t block_size, const CodecType codec,
+                           const RecordClassifier classifier)
+    : block_size_(block_size),
+      codec_(codec),
+      classifier_(classifier),
+      type_counts_(classifier ? std::numeric_limits<uint8_t>::max() + 1 : 0) {
+  if (block_size_ < kMinBlockSize) {
+    throw std::invalid_argument("Block size " + std::to_string(block_size_) +
+                                " is less than the minimum of " +
+                                std::to_string(kMinBlockSize) + " bytes.");
+  }
+  buffer_.reserve(block_size_ + kFooterReserve);
+  reset();
 }
 
 std::size_t BlockBuilder::count() const {
-  return ConstBlockView(buffer_).count();
+  return ConstBlockView(buffer_.data(), buffer_.size()).count();
+}
+
+BlockSummary BlockBuilder::summary() const {
+  BlockSummary summary;
+  summary.count = count();
+  summary.min_timestamp = min_timestamp_;
+  summary.max_timestamp = max_timestamp_;
+  if (classifier_) {
+    summary.tagged = true;
+    for (std::size_t type = 0; type < type_counts_.size(); ++type) {
+      if (type_counts_[type]) {
+        summary.type_counts[static_cast<uint8_t>(type)] = type_counts_[type];
+      }
+    }
+    summary.pids.assign(pids_.begin(), pids_.end());
+    std::sort(summary.pids.begin(), summary.pids.end());
+    summary.tids.assign(tids_.begin(), tids_.end());
+    std::sort(summary.tids.begin(), summary.tids.end());
+  }
+  return summary;
 }
 
 bool BlockBuilder::add(const Record& record) {
-  return BlockView(buffer_).insert(record);
+  if (!BlockView(buffer_).insert(record)) {
+    return false;
+  }
+  tally(&record, 1);
+  return true;
+}
+
+std::size_t BlockBuilder::add(const Record* const records,
+                              const std::size_t count) {
+  const auto added = BlockView(buffer_).insert(records, count);
+  tally(records, added);
+  return added;
 }
 
-void BlockBuilder::flush(const File& file) { BlockView(buffer_).flush(file); }
+BlockInfo BlockBuilder::flush(const File& file, const bool sync) {
+  seal();
+  auto* block = &buffer_;
+  if (codec_ != CodecType::kNone) {
+    encodeBlock(buffer_, codec_, encoded_);
+    block = &encoded_;
+  }
+  writeBlock(*block, file, sync);
+  const auto info = blockInfo(*block);
+  reset();
+  return info;
+}
+
+void BlockBuilder::seal(BlockBuffer& buffer) {
+  seal();
+  buffer.reserve(buffer_.capacity());
+  std::swap(buffer_, buffer);
+  reset();
+}
+
+// private
+void BlockBuilder::tally(const Record* const records, const std::size_t count) {
+  for (std::size_t idx = 0; idx < count; ++idx) {
+    min_timestamp_ = std::min(min_timestamp_, records[idx].timestamp);
+    max_timestamp_ = std::max(max_timestamp_, records[idx].timestamp);
+  }
+  if (!classifier_) {
+    return;
+  }
+  for (std::size_t idx = 0; idx < count; ++idx) {
+    const auto tags = classifier_(records[idx]);
+    ++type_counts_[tags.type];
+    pids_.insert(tags.pid);
+    tids_.insert(tags.tid);
+  }
+}
+
+// private
+void BlockBuilder::seal() {
+  BlockView view(buffer_);
+  view.seal(scratch_);
+  view.appendSummary(summary(), scratch_);
+  view.appendChecksums();
+  view.setChecksum();
+}
+
+// private
+void BlockBuilder::reset() {
+  buffer_.resize(block_size_);
+  BlockView(buffer_).reset();
+  min_timestamp_ = std::numeric_limits<timestamp_t>::max();
+  max_timestamp_ = std::numeric_limits<timestamp_t>::min();
+  std::fill(type_counts_.begin(), type_counts_.end(), 0);
+  pids_.clear();
+  tids_.clear();
+}
+
+// ----------------------------------------------------------------
+
+void encodeBlock(BlockBuffer& block, const CodecType type,
+                 BlockBuffer& encoded) {
+  const auto& codec = Codec::get(type);
+  const auto* const sealed = reinterpret_cast<const BlockHeader*>(block.data());
+  const auto summary = sealed->summary;
+  const auto footer_size = summary ? sealed->checksums - summary : 0;
+  const auto size = BlockView(block).compact();
+  const auto frames = frameCount(size);
+  encoded.resize(sizeof(BlockHeader) + frames * sizeof(FrameSize) +
+                 frames * codec.bound(kFrameSize) + footer_size +
+                 frames * sizeof(ChecksumType) + kBlockAlignment);
+  std::memcpy(encoded.data(), block.data(), sizeof(BlockHeader));
+  auto* const header = reinterpret_cast<BlockHeader*>(encoded.data());
+  header->codec = type;
+
+  const auto* const body = block.data() + sizeof(BlockHeader);
+  auto offset = sizeof(BlockHeader) + frames * sizeof(FrameSize);
+  for (std::size_t frame = 0; frame < frames; ++frame) {
+    const auto begin = frame * kFrameSize;
+    const auto frame_size = frameSize(size, frame);
+    auto compressed = codec.compress(body + begin, frame_size,
+                                     encoded.data() + offset,
+                                     encoded.size() - offset);
+    if (compressed >= frame_size) {
+      std::memcpy(encoded.data() + offset, body + begin, frame_size);
+      compressed = frame_size;
+    }
+    const auto stored = static_cast<FrameSize>(compressed);
+    std::memcpy(encoded.data() + sizeof(BlockHeader) + frame * sizeof(stored),
+                &stored, sizeof(stored));
+    offset += compressed;
+  }
+  if (footer_size) {
+    header->summary = offset;
+    std::memcpy(encoded.data() + offset, block.data() + summary, footer_size);
+    offset += footer_size;
+  }
+  encoded.resize(offset);
+  BlockView view(encoded);
+  view.appendChecksums();
+  view.setChecksum();
+}
+
+BlockInfo blockInfo(const BlockBuffer& block) {
+  BlockInfo info;
+  info.size = block.size();
+  if (block.size() >= sizeof(BlockHeader)) {
+    const auto* const header =
+        reinterpret_cast<const BlockHeader*>(block.data());
+    info.codec = header->codec;
+    info.checksum = header->checksum;
+  }
+  return info;
+}
+
+void writeBlock(const BlockBuffer& block, const File& file,
+                const bool sync) {
+  // Files of a previous recording may be larger than the block. They are
+  // truncated once the block is written, so that the file is never shorter
+  // than the written part of the block. A stale tail left by a crash before
+  // the truncation is not covered by the checksums.
+  file.write(block.data(), block.size(), 0);
+  file.resize(block.size());
+  if (sync) {
+    file.sync();
+  }
+}
+
+bool readSummary(const File& file, BlockSummary& summary) {
+  BlockHeader header;
+  const auto size = file.size();
+  if (size < sizeof(header) ||
+      file.read(&header, sizeof(header), 0) != sizeof(header) ||
+      header.magic != kBlockMagic || header.version != kBlockVersion ||
+      header.summary < sizeof(header) || header.summary >= header.checksums ||
+      header.checksums > size) {
+    return false;
+  }
+  std::vector<uint8_t> footer(header.checksums - header.summary);
+  return file.read(footer.data(), footer.size(), header.summary) ==
+             footer.size() &&
+         summary.deserialize(footer.data(), footer.size()) != 0;
+}
 
 // ----------------------------------------------------------------
 // BlockReader
@@ -229,7 +1038,9 @@ void BlockReader::Iterator::next() {
     return;
   }
   ++index_;
-  record_ = ConstBlockView(reader_->buffer_)[index_];
+  record_ = index_ < reader_->count()
+                ? ConstBlockView(reader_->data_, reader_->size_)[index_]
+                : Record{};
 }
 
 // private
@@ -237,7 +1048,7 @@ BlockReader::Iterator::Iterator(const BlockReader& reader,
                                 const std::size_t index)
     : reader_(std::addressof(reader)), index_(index) {
   if (index_ < reader_->count()) {
-    record_ = ConstBlockView(reader_->buffer_)[index_];
+    record_ = ConstBlockView(reader_->data_, reader_->size_)[index_];
   }
 }
 
@@ -262,20 +1073,308 @@ const Record* BlockReader::Iterator::operator->() const {
 const Record& BlockReader::Iterator::operator*() const { return record_; }
 
 BlockReader::BlockReader(const File& file)
-    : path_(file.path()), buffer_(file.size()) {
-  file.read(buffer_.data(), buffer_.size(), 0);
+    : path_(file.path()),
+      mapping_(file),
+      data_(mapping_.data()),
+      size_(mapping_.size()),
+      corrupt_(false) {
+  mapping_.advise(MappedFile::Advice::kSequential, 0, size_);
+  if (isLegacyBlock(data_, size_, size_)) {
+    decodeLegacyBlock(data_, size_, decoded_);
+    data_ = decoded_.data();
+    size_ = decoded_.size();
+    return;
+  }
+  checkFormat(data_, size_, path_);
+  if (ConstBlockView(data_, size_).isCorrupt()) {
+    corrupt_ = true;
+    data_ = nullptr;
+    size_ = 0;
+    return;
+  }
+  BlockHeader header;
+  if (size_ >= sizeof(header)) {
+    std::memcpy(&header, data_, sizeof(header));
+    if (header.codec != CodecType::kNone) {
+      // Compressed blocks are decompressed up front, truncated or corrupt ones
+      // are treated as empty.
+      if (!decodeBlock(data_, size_, decoded_)) {
+        decoded_.clear();
+      }
+      data_ = decoded_.data();
+      size_ = decoded_.size();
+      return;
+    }
+  }
+  // The index at the start of the block is scanned front to back. Records are
+  // stored from the end of the block backwards and are left to the default
+  // read ahead.
+  const auto index_size = ConstBlockView(data_, size_).indexSize();
+  mapping_.advise(MappedFile::Advice::kSequential, 0, index_size);
+  mapping_.advise(MappedFile::Advice::kWillNeed, 0, index_size);
 }
 
 std::size_t BlockReader::count() const {
-  return ConstBlockView(buffer_).count();
+  return ConstBlockView(data_, size_).count();
 }
 
+bool BlockReader::isCorrupt() const { return corrupt_; }
+
 BlockReader::Iterator BlockReader::begin() const { return Iterator(*this, 0); }
 
 BlockReader::Iterator BlockReader::end() const {
   return Iterator(*this, count());
 }
 
+// ----------------------------------------------------------------
+// BlockCursor
+// ----------------------------------------------------------------
+
+BlockCursor::BlockCursor(File&& file, const std::size_t chunk_size,
+                         const timestamp_t begin)
+    : file_(std::move(file)),
+      chunk_size_(chunk_size),
+      count_(0),
+      position_(0),
+      index_count_(0),
+      index_position_(0),
+      payload_offset_(0),
+      body_offset_(sizeof(BlockHeader)),
+      valid_(false),
+      corrupt_(false),
+      codec_(nullptr),
+      body_size_(0),
+      frame_index_(0) {
+  uint8_t prefix[kFormatPrefixSize];
+  const auto size = file_.size();
+  const auto available = file_.read(prefix, std::min(size, sizeof(prefix)), 0);
+  if (isLegacyBlock(prefix, available, size)) {
+    // Legacy blocks have a shorter header and no frames, and are not verified.
+    LegacyBlockHeader legacy_header;
+    std::memcpy(&legacy_header, prefix, sizeof(legacy_header));
+    body_offset_ = sizeof(legacy_header);
+    count_ = legacy_header.count;
+  } else if (available >= sizeof(BlockHeader)) {
+    checkFormat(prefix, size, file_.path());
+    corrupt_ = !openFrames(prefix, size);
+  }
+  if (begin != std::numeric_limits<timestamp_t>::min()) {
+    seek(begin);
+  }
+  next();
+}
+
+bool BlockCursor::valid() const { return valid_; }
+
+bool BlockCursor::isCorrupt() const { return corrupt_; }
+
+const Record& BlockCursor::record() const { return record_; }
+
+void BlockCursor::next() {
+  if (index_position_ == index_count_ && !load()) {
+    record_ = {};
+    valid_ = false;
+    return;
+  }
+  valid_ = true;
+  const auto& record_index = reinterpret_cast<const RecordIndex*>(
+      index_.data())[index_position_++];
+  record_ = Record{record_index.timestamp,
+                   payload_.data() + (record_index.offset - payload_offset_),
+                   record_index.size};
+}
+
+std::size_t BlockCursor::count() const { return count_; }
+
+// private
+bool BlockCursor::load() {
+  // Half of the chunk is used for the index and the rest for the payloads of
+  // the indexed records. Records are mostly stored in arrival order, thus the
+  // payloads of a chunk of the sorted index are mostly adjacent. Otherwise the
+  // chunk of the index is shrunk until its payloads fit.
+  if (position_ == count_) {
+    return false;
+  }
+  auto count = std::min(
+      count_ - position_,
+      std::max<std::size_t>(1, chunk_size_ / 2 / sizeof(RecordIndex)));
+  index_.resize(count * sizeof(RecordIndex));
+  if (readBody(index_.data(), index_.size(),
+               position_ * sizeof(RecordIndex)) != index_.size()) {
+    position_ = count_;
+    return false;
+  }
+  const auto* const indices =
+      reinterpret_cast<const RecordIndex*>(index_.data());
+  std::size_t begin = 0, end = 0;
+  while (true) {
+    begin = indices[0].offset;
+    end = indices[0].offset + indices[0].size;
+    for (std::size_t idx = 1; idx < count; ++idx) {
+      begin = std::min(begin, indices[idx].offset);
+      end = std::max(end, indices[idx].offset + indices[idx].size);
+    }
+    if (count == 1 || end - begin <= chunk_size_) {
+      break;
+    }
+    count /= 2;
+  }
+  payload_.resize(end - begin);
+  payload_offset_ = begin;
+  if (readBody(payload_.data(), payload_.size(), begin) != payload_.size()) {
+    position_ = count_;
+    return false;
+  }
+  position_ += count;
+  index_count_ = count;
+  index_position_ = 0;
+  return true;
+}
+
+// private
+void BlockCursor::seek(const timestamp_t begin) {
+  std::size_t low = 0, high = count_;
+  while (low < high) {
+    const auto mid = low + (high - low) / 2;
+    RecordIndex record_index;
+    if (readBody(reinterpret_cast<uint8_t*>(&record_index),
+                 sizeof(record_index),
+                 mid * sizeof(RecordIndex)) != sizeof(record_index)) {
+      position_ = count_;
+      return;
+    }
+    if (record_index.timestamp < begin) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  position_ = low;
+}
+
+// private
+bool BlockCursor::openFrames(const uint8_t* const prefix,
+                             const std::size_t file_size) {
+  // The metadata of the block is verified up front, while the frames are
+  // verified as they are read.
+  BlockHeader header;
+  std::memcpy(&header, prefix, sizeof(header));
+  BlockLayout layout;
+  if (header.magic != kBlockMagic || !blockLayout(header, file_size, layout)) {
+    return false;
+  }
+  if (header.codec != CodecType::kNone) {
+    try {
+      codec_ = &Codec::get(header.codec);
+    } catch (const std::invalid_argument&) {
+      return false;
+    }
+  }
+  std::vector<uint8_t> table(layout.table_end - sizeof(BlockHeader));
+  std::vector<uint8_t> tail(layout.end - layout.tail);
+  if (file_.read(table.data(), table.size(), sizeof(BlockHeader)) !=
+          table.size() ||
+      file_.read(tail.data(), tail.size(), layout.tail) != tail.size()) {
+    return false;
+  }
+  auto value = checksum(prefix + sizeof(ChecksumType),
+                        sizeof(BlockHeader) - sizeof(ChecksumType));
+  value = checksum(table.data(), table.size(), value);
+  if (checksum(tail.data(), tail.size(), value) != header.checksum) {
+    return false;
+  }
+
+  body_size_ = header.size;
+  checksums_.resize(layout.frames);
+  std::memcpy(checksums_.data(), tail.data() + header.checksums - layout.tail,
+              layout.frames * sizeof(ChecksumType));
+  frames_.resize(layout.frames + 1);
+  frames_[0] = layout.table_end;
+  for (std::size_t frame = 0; frame < layout.frames; ++frame) {
+    std::size_t stored = frameSize(body_size_, frame);
+    if (codec_) {
+      FrameSize frame_size;
+      std::memcpy(&frame_size, table.data() + frame * sizeof(FrameSize),
+                  sizeof(frame_size));
+      stored = frame_size;
+    }
+    frames_[frame + 1] = frames_[frame] + stored;
+  }
+  if (frames_.back() > layout.tail) {
+    return false;
+  }
+  frame_index_ = layout.frames;
+  count_ = std::min(header.count, body_size_ / sizeof(RecordIndex));
+  return true;
+}
+
+// private
+bool BlockCursor::readFrame(const std::size_t frame, uint8_t* const dest) {
+  // Uncompressed frames are read and verified in place. Frames failing to read
+  // or verify mark the block corrupt.
+  const auto stored = frames_[frame + 1] - frames_[frame];
+  const auto frame_size = frameSize(body_size_, frame);
+  auto* src = dest;
+  if (codec_) {
+    encoded_.resize(stored);
+    src = encoded_.data();
+  }
+  if (stored > frame_size ||
+      file_.read(src, stored, frames_[frame]) != stored ||
+      checksum(src, stored) != checksums_[frame]) {
+    corrupt_ = true;
+    return false;
+  }
+  if (codec_) {
+    try {
+      decodeFrame(*codec_, src, stored, dest, frame_size);
+    } catch (const std::runtime_error&) {
+      corrupt_ = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+// private
+std::size_t BlockCursor::readBody(uint8_t* dest, const std::size_t size,
+                                  std::size_t offset) {
+  if (frames_.empty()) {
+    return file_.read(dest, size, body_offset_ + offset);
+  }
+  // Frames covering the requested bytes are read one at a time. Whole frames
+  // of uncompressed blocks are read straight into the destination, while the
+  // others are kept as the index and payloads are mostly read from adjacent
+  // frames.
+  std::size_t read = 0;
+  while (read < size && offset < body_size_) {
+    const auto frame = offset / kFrameSize;
+    const auto frame_size = frameSize(body_size_, frame);
+    const auto begin = offset - frame * kFrameSize;
+    const auto count = std::min(size - read, frame_size - begin);
+    if (frame != frame_index_) {
+      if (!codec_ && count == frame_size) {
+        if (!readFrame(frame, dest + read)) {
+          return read;
+        }
+        read += count;
+        offset += count;
+        continue;
+      }
+      frame_.resize(frame_size);
+      if (!readFrame(frame, frame_.data())) {
+        frame_index_ = frames_.size();
+        return read;
+      }
+      frame_index_ = frame;
+    }
+    std::memcpy(dest + read, frame_.data() + begin, count);
+    read += count;
+    offset += count;
+  }
+  return read;
+}
+
 }  // namespace storage
 }  // namespace tools
 }  // namespace inspector
\ No newline at end of file
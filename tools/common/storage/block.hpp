@@ -16,9 +16,14 @@
 
 #pragma once
 
+#include <limits>
+#include <map>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "tools/common/storage/checksum.hpp"
+#include "tools/common/storage/codec.hpp"
 #include "tools/common/storage/common.hpp"
 #include "tools/common/storage/file_io.hpp"
 
@@ -26,9 +31,106 @@ namespace inspector {
 namespace tools {
 namespace storage {
 
+/**
+ * @brief Minimum size in bytes of a block, fitting the block header and the
+ * index of a record.
+ *
+ */
+extern const std::size_t kMinBlockSize;
+
+/**
+ * @brief Data structure with the attributes of a record blocks are summarized
+ * on, e.g. the type, process and thread of a trace event.
+ *
+ */
+struct RecordTags {
+  uint8_t type = 0;
+  int32_t pid = 0;
+  int32_t tid = 0;
+};
+
+/**
+ * @brief Function getting the tags of a record. Records are opaque to storage,
+ * thus the tags are provided by its users.
+ *
+ */
+using RecordClassifier = RecordTags (*)(const Record& record);
+
+/**
+ * @brief Data structure summarizing the records of one or more blocks. Blocks
+ * can be skipped by reads which do not need their records, e.g. reads of a
+ * time range, without opening them.
+ *
+ */
+struct BlockSummary {
+  std::size_t count = 0;  //<- Number of records.
+  timestamp_t min_timestamp = std::numeric_limits<timestamp_t>::max();
+  timestamp_t max_timestamp = std::numeric_limits<timestamp_t>::min();
+  bool tagged = false;  //<- Set if the following fields are known.
+  std::map<uint8_t, std::size_t> type_counts;  //<- Number of records per type.
+  std::vector<int32_t> pids;                   //<- Sorted process ids.
+  std::vector<int32_t> tids;                   //<- Sorted thread ids.
+
+  /**
+   * @brief Get a summary of unknown records, which no read can skip. Used for
+   * blocks whose summary can not be read.
+   *
+   */
+  static BlockSummary unknown();
+
+  /**
+   * @brief Check if any summarized record is in the given time range.
+   *
+   * @param begin Start timestamp of the range.
+   * @param end End timestamp of the range, inclusive.
+   * @returns `true` if records may be in the range else `false`.
+   */
+  bool overlaps(const timestamp_t begin, const timestamp_t end) const;
+
+  /**
+   * @brief Add the given summary to this one.
+   *
+   * @param other Constant reference to the summary to add.
+   */
+  void merge(const BlockSummary& other);
+
+  /**
+   * @brief Append the binary representation of the summary to the given
+   * buffer.
+   *
+   * @param buffer Reference to the buffer.
+   */
+  void serialize(std::vector<uint8_t>& buffer) const;
+
+  /**
+   * @brief Read the summary from its binary representation.
+   *
+   * @param data Pointer to the binary representation.
+   * @param size Number of bytes available.
+   * @returns Number of bytes read, or 0 if the representation is truncated.
+   */
+  std::size_t deserialize(const uint8_t* const data, const std::size_t size);
+};
+
+/**
+ * @brief Data structure describing a sealed block as written to file.
+ *
+ */
+struct BlockInfo {
+  std::size_t size = 0;                //<- Size in bytes of the block.
+  CodecType codec = CodecType::kNone;  //<- Codec compressing the block.
+  ChecksumType checksum = 0;           //<- Checksum stored in the header.
+};
+
 /**
  * @brief The class `BlockBuilder` exposes API to create a block of
- * chronologically sorted records.
+ * chronologically sorted records. Records are appended in arrival order and the
+ * block is sorted once when it is flushed or sealed. Flushed blocks are
+ * compressed with the codec of the builder.
+ *
+ * Records are summarized as they are added, with the records tagged by the
+ * given classifier if any. The summary is stored in a footer following the
+ * records when the block is sealed.
  *
  */
 class BlockBuilder {
@@ -37,8 +139,15 @@ class BlockBuilder {
    * @brief Construct a new BlockBuilder object.
    *
    * @param block_size Size in bytes of the block.
+   * @param codec Codec used to compress the block when flushed.
+   * @param classifier Function tagging the records for the summary of the
+   * block. Records are not tagged if null.
+   * @throws `std::invalid_argument` if the block size is less than
+   * `kMinBlockSize`.
    */
-  explicit BlockBuilder(const std::size_t block_size);
+  explicit BlockBuilder(const std::size_t block_size,
+                        const CodecType codec = CodecType::kNone,
+                        const RecordClassifier classifier = nullptr);
 
   /**
    * @brief Get the number of records in the block.
@@ -47,6 +156,12 @@ class BlockBuilder {
    */
   std::size_t count() const;
 
+  /**
+   * @brief Get the summary of the records in the block.
+   *
+   */
+  BlockSummary summary() const;
+
   /**
    * @brief Add the given record in the block.
    *
@@ -56,20 +171,107 @@ class BlockBuilder {
    */
   bool add(const Record& record);
 
+  /**
+   * @brief Add the given records in the block in one pass. Records are added
+   * in order until the block runs out of space.
+   *
+   * @param records Pointer to the first record to add.
+   * @param count Number of records to add.
+   * @returns Number of records added.
+   */
+  std::size_t add(const Record* const records, const std::size_t count);
+
   /**
    * @brief Flush the contents in the block to the given file and reset the
    * block.
    *
+   * @param file Constant reference to the file.
+   * @param sync Flag to sync the file to disk once written.
+   * @returns Description of the written block.
    */
-  void flush(const File& file);
+  BlockInfo flush(const File& file, const bool sync = true);
+
+  /**
+   * @brief Seal the contents in the block and hand them over to the given
+   * buffer, resetting the block. The previous contents of the buffer are
+   * reused as the memory of the block. The sealed block can then be written
+   * to file using `writeBlock`, e.g. by a separate writer thread. The sealed
+   * block is not compressed, which is left to `encodeBlock`.
+   *
+   * @param buffer Reference to the buffer receiving the sealed block.
+   */
+  void seal(BlockBuffer& buffer);
 
  private:
-  std::vector<uint8_t> buffer_;
+  void tally(const Record* const records, const std::size_t count);
+  void seal();
+  void reset();
+
+  std::size_t block_size_;
+  BlockBuffer buffer_;
+  CodecType codec_;
+  RecordClassifier classifier_;
+  timestamp_t min_timestamp_;
+  timestamp_t max_timestamp_;
+  std::vector<std::size_t> type_counts_;
+  std::unordered_set<int32_t> pids_;
+  std::unordered_set<int32_t> tids_;
+  BlockBuffer encoded_;
+  std::vector<uint8_t> scratch_;
 };
 
+/**
+ * @brief Compress a block sealed by a `BlockBuilder`. The codec is recorded in
+ * the header of the compressed block, from which readers pick it up. The sealed
+ * block is compacted in place and can not be read after.
+ *
+ * @param block Reference to the sealed block.
+ * @param codec Codec used to compress the block.
+ * @param encoded Reference to the buffer receiving the compressed block.
+ */
+void encodeBlock(BlockBuffer& block, const CodecType codec,
+                 BlockBuffer& encoded);
+
+/**
+ * @brief Describe a block sealed by a `BlockBuilder`, compressed or not.
+ *
+ * @param block Constant reference to the sealed block.
+ * @returns Description of the block.
+ */
+BlockInfo blockInfo(const BlockBuffer& block);
+
+/**
+ * @brief Write a block sealed by a `BlockBuilder` to the given file. The file
+ * is truncated to the block once written.
+ *
+ * @param block Constant reference to the sealed block.
+ * @param file Constant reference to the file.
+ * @param sync Flag to sync the file to disk once written.
+ */
+void writeBlock(const BlockBuffer& block, const File& file,
+                const bool sync = true);
+
+/**
+ * @brief Read the summary stored in the footer of a block, without reading the
+ * records of the block.
+ *
+ * @param file Constant reference to the file containing the block.
+ * @param summary Reference to store the summary.
+ * @returns `true` on success or `false` if the block has no readable summary.
+ */
+bool readSummary(const File& file, BlockSummary& summary);
+
 /**
  * @brief The class `BlockReader` exposes API to read records stored in a block.
- * Reading of records is performed using iterators.
+ * Reading of records is performed using iterators. The block is memory mapped
+ * and records point directly into the mapping, thus they are only valid while
+ * the reader is. Compressed blocks are decompressed in memory when opened.
+ *
+ * The checksums of the block, i.e. of its metadata and of each of its frames,
+ * are verified when opened. Corrupt blocks, along with truncated ones, are read
+ * as empty. Blocks written in other versions of the block format are rejected,
+ * except for legacy blocks written before the format was versioned, which are
+ * read without verification.
  *
  */
 class BlockReader {
@@ -104,6 +306,8 @@ class BlockReader {
    * @brief Construct a block reader.
    *
    * @param file File containing block.
+   * @throws `std::runtime_error` if the block is in an unsupported version of
+   * the format.
    */
   explicit BlockReader(const File& file);
 
@@ -114,6 +318,12 @@ class BlockReader {
    */
   std::size_t count() const;
 
+  /**
+   * @brief Check if the block failed checksum verification.
+   *
+   */
+  bool isCorrupt() const;
+
   /**
    * @brief Get iterator to the first record.
    *
@@ -128,7 +338,109 @@ class BlockReader {
 
  private:
   std::string path_;
-  std::vector<uint8_t> buffer_;
+  MappedFile mapping_;
+  BlockBuffer decoded_;
+  const uint8_t* data_;
+  std::size_t size_;
+  bool corrupt_;
+};
+
+/**
+ * @brief The class `BlockCursor` streams the records of a block in
+ * chronological order. The index and the payloads of the records are read in
+ * chunks bounded by the given size, so the memory used by the cursor does not
+ * depend on the size of the block. The current record points into the chunk
+ * and is only valid until the cursor is advanced. The block is read a frame
+ * of up to 64KB at a time, with compressed frames decompressed once read.
+ *
+ * The metadata of the block, i.e. its header, index of frames and footer, is
+ * verified when opened, while each frame is verified against its checksum as
+ * it is read. Blocks with corrupt metadata, along with truncated ones, are read
+ * as empty. A corrupt frame ends the block early, after the records read from
+ * the preceding frames. Blocks written in other versions of the block format
+ * are rejected, except for legacy blocks written before the format was
+ * versioned, which are read without verification.
+ *
+ */
+class BlockCursor {
+ public:
+  /**
+   * @brief Construct a new BlockCursor object positioned at the first record
+   * of the block.
+   *
+   * @param file Rvalue reference to the file containing the block.
+   * @param chunk_size Maximum number of bytes of the block to hold in memory.
+   * A single record larger than the chunk size is still read.
+   * @param begin Timestamp of the first record to read. Earlier records are
+   * skipped by binary searching the index.
+   * @throws `std::runtime_error` if the block is in an unsupported version of
+   * the format.
+   */
+  BlockCursor(File&& file, const std::size_t chunk_size,
+              const timestamp_t begin =
+                  std::numeric_limits<timestamp_t>::min());
+
+  /**
+   * @brief Check if the cursor points to a record.
+   *
+   * @returns `true` if a record is available else `false` once all the records
+   * have been read.
+   */
+  bool valid() const;
+
+  /**
+   * @brief Get the current record.
+   *
+   */
+  const Record& record() const;
+
+  /**
+   * @brief Advance the cursor to the next record.
+   *
+   */
+  void next();
+
+  /**
+   * @brief Get the number of records in the block.
+   *
+   */
+  std::size_t count() const;
+
+  /**
+   * @brief Check if the block failed checksum verification, either when opened
+   * or when one of its frames was read.
+   *
+   */
+  bool isCorrupt() const;
+
+ private:
+  bool load();
+  void seek(const timestamp_t begin);
+  bool openFrames(const uint8_t* const prefix, const std::size_t file_size);
+  bool readFrame(const std::size_t frame, uint8_t* const dest);
+  std::size_t readBody(uint8_t* dest, const std::size_t size,
+                       std::size_t offset);
+
+  File file_;
+  std::size_t chunk_size_;
+  std::size_t count_;
+  std::size_t position_;
+  std::vector<uint8_t> index_;
+  std::size_t index_count_;
+  std::size_t index_position_;
+  std::vector<uint8_t> payload_;
+  std::size_t payload_offset_;
+  std::size_t body_offset_;
+  bool valid_;
+  bool corrupt_;
+  Record record_;
+  const Codec* codec_;
+  std::size_t body_size_;
+  std::vector<std::size_t> frames_;
+  std::vector<ChecksumType> checksums_;
+  std::size_t frame_index_;
+  std::vector<uint8_t> encoded_;
+  std::vector<uint8_t> frame_;
 };
 
 }  // namespace storage
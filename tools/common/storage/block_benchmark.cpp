@@ -0,0 +1,97 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The `block_benchmark` utility measures the throughput of building a block
+ * from records arriving in chronological order and from shuffled records:
+ *
+ *   bazel run -c opt //tools/common/storage:block_benchmark
+ *
+ * Pass `--records=N` to change the number of records added to the block.
+ *
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/block.hpp"
+
+DEFINE_uint64(records, 1000000, "Number of records added to the block.");
+DEFINE_uint64(record_size, 32, "Size in bytes of each record.");
+DEFINE_uint64(block_size, 100 * 1024 * 1024, "Size in bytes of the block.");
+
+namespace inspector {
+namespace tools {
+namespace {
+
+/**
+ * @brief Add the records with the given timestamps to a block and seal it,
+ * logging the throughput of both steps.
+ *
+ */
+void run(const std::string& name,
+         const std::vector<storage::timestamp_t>& timestamps) {
+  const std::vector<uint8_t> data(FLAGS_record_size, 0);
+  storage::BlockBuilder builder(FLAGS_block_size);
+  storage::BlockBuffer sealed;
+
+  const auto start = std::chrono::steady_clock::now();
+  std::size_t added = 0;
+  for (const auto timestamp : timestamps) {
+    if (!builder.add({timestamp, data.data(), data.size()})) {
+      break;
+    }
+    ++added;
+  }
+  const auto add_end = std::chrono::steady_clock::now();
+  builder.seal(sealed);
+  const auto seal_end = std::chrono::steady_clock::now();
+
+  const auto add_s = std::chrono::duration<double>(add_end - start).count();
+  const auto total_s = std::chrono::duration<double>(seal_end - start).count();
+  LOG(INFO) << name << ": added " << added << " records in " << add_s << "s, "
+            << "sealed in " << total_s - add_s << "s (" << added / total_s
+            << " records/s)";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  FLAGS_logtostderr = 1;
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::vector<storage::timestamp_t> timestamps(FLAGS_records);
+  for (std::size_t i = 0; i < timestamps.size(); ++i) {
+    timestamps[i] = static_cast<storage::timestamp_t>(1000 * i);
+  }
+  run("Sorted", timestamps);
+  std::shuffle(timestamps.begin(), timestamps.end(), std::mt19937_64(0));
+  run("Shuffled", timestamps);
+
+  return 0;
+}
+
+}  // namespace tools
+}  // namespace inspector
+
+int main(int argc, char* argv[]) { return inspector::tools::main(argc, argv); }
@@ -18,9 +18,15 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstring>
+#include <map>
 #include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "tools/common/storage/testing.hpp"
@@ -30,6 +36,16 @@ using namespace inspector::tools::storage;
 
 namespace {
 constexpr auto kBlockSize = 1024;
+
+// Records of the summary tests store their tags as text "type:pid:tid".
+RecordTags parseTags(const Record& record) {
+  const std::string data(static_cast<const char*>(record.src), record.size);
+  const auto first = data.find(':');
+  const auto second = data.find(':', first + 1);
+  return {static_cast<uint8_t>(std::stoi(data.substr(0, first))),
+          std::stoi(data.substr(first + 1, second - first - 1)),
+          std::stoi(data.substr(second + 1))};
+}
 }
 
 class BlockTestFixture : public TestHarness, public ::testing::Test {
@@ -50,6 +66,9 @@ TEST_F(BlockTestFixture, TestBlockBuilderCtor) {
   BlockBuilder builder(kBlockSize);
 
   ASSERT_EQ(builder.count(), 0);
+  ASSERT_THROW(BlockBuilder{0}, std::invalid_argument);
+  ASSERT_THROW(BlockBuilder{kMinBlockSize - 1}, std::invalid_argument);
+  ASSERT_NO_THROW(BlockBuilder{kMinBlockSize});
 }
 
 TEST_F(BlockTestFixture, TestBlockBuilderFlush) {
@@ -62,8 +81,11 @@ TEST_F(BlockTestFixture, TestBlockBuilderFlush) {
 
   builder.flush(File{"block", tempDir().path()});
 
+  // The block is followed by its footer, padded to whole pages.
   ASSERT_TRUE(tempDir().fileExists("block"));
-  ASSERT_EQ(tempDir().readFile("block").size(), kBlockSize);
+  const auto size = tempDir().readFile("block").size();
+  ASSERT_GT(size, kBlockSize);
+  ASSERT_EQ(size % kBlockAlignment, 0);
 }
 
 TEST_F(BlockTestFixture, TestBlockBuilderAndReader) {
@@ -99,4 +121,456 @@ TEST_F(BlockTestFixture, TestBlockBuilderAndReader) {
     queue.pop();
     ASSERT_TRUE(isOneOf(entry, records_map[entry.timestamp]));
   }
-}
\ No newline at end of file
+}
+
+TEST_F(BlockTestFixture, TestBlockBuilderAddBatch) {
+  utils::RandomNumberGenerator<timestamp_t> rand(100, 1000);
+  std::vector<std::string> data;
+  std::vector<Record> records;
+  for (std::size_t i = 0; i < 64; ++i) {
+    data.emplace_back("test-data-" + std::to_string(i));
+  }
+  for (const auto& item : data) {
+    records.emplace_back(rand(), item.data(), item.size());
+  }
+
+  // The batch is appended in chunks until the block runs out of space, with
+  // the out of order records sorted when the block is flushed.
+  BlockBuilder builder(kBlockSize);
+  std::size_t added = 0, chunk = 0;
+  do {
+    chunk = builder.add(records.data() + added,
+                        std::min<std::size_t>(8, records.size() - added));
+    added += chunk;
+  } while (chunk == 8 && added < records.size());
+  ASSERT_GT(added, 0);
+  ASSERT_LT(added, records.size());
+  ASSERT_EQ(builder.count(), added);
+  builder.flush(File{"block", tempDir().path()});
+
+  std::vector<timestamp_t> timestamps;
+  for (std::size_t i = 0; i < added; ++i) {
+    timestamps.push_back(records[i].timestamp);
+  }
+  std::sort(timestamps.begin(), timestamps.end());
+
+  BlockReader reader(File{"block", tempDir().path()});
+  ASSERT_EQ(reader.count(), added);
+  std::size_t index = 0;
+  for (const auto& entry : reader) {
+    ASSERT_EQ(entry.timestamp, timestamps[index++]);
+    ASSERT_TRUE(isOneOf(entry, data));
+  }
+}
+
+TEST_F(BlockTestFixture, TestBlockBuilderSortsRunsAndShuffledRecords) {
+  constexpr std::size_t kLargeBlockSize = 1024 * 1024;
+  constexpr std::size_t kCount = 10000;
+
+  // Records are identified by their position in the expected order. Few
+  // interleaved sorted runs are merged, while shuffled records spanning
+  // negative and positive timestamps are radix sorted.
+  std::vector<timestamp_t> runs, shuffled;
+  for (std::size_t i = 0; i < kCount; ++i) {
+    runs.push_back(static_cast<timestamp_t>((i % 4) * kCount + i / 4));
+    shuffled.push_back(static_cast<timestamp_t>(i * 1000003) -
+                       static_cast<timestamp_t>(kCount * 500000));
+  }
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+
+  for (const auto& timestamps : {runs, shuffled}) {
+    BlockBuilder builder(kLargeBlockSize);
+    for (const auto& timestamp : timestamps) {
+      ASSERT_TRUE(builder.add({timestamp, &timestamp, sizeof(timestamp)}));
+    }
+    builder.flush(File{"block", tempDir().path()});
+
+    auto expected = timestamps;
+    std::sort(expected.begin(), expected.end());
+    BlockReader reader(File{"block", tempDir().path()});
+    ASSERT_EQ(reader.count(), kCount);
+    std::size_t index = 0;
+    for (const auto& entry : reader) {
+      ASSERT_EQ(entry.timestamp, expected[index++]);
+      ASSERT_EQ(entry.size, sizeof(timestamp_t));
+      ASSERT_EQ(std::memcmp(entry.src, &entry.timestamp, entry.size), 0);
+    }
+  }
+}
+
+TEST_F(BlockTestFixture, TestBlockCursorReadsInChunks) {
+  constexpr std::size_t kLargeBlockSize = 64 * 1024;
+  constexpr std::size_t kChunkSize = 256;
+
+  BlockBuilder builder(kLargeBlockSize);
+  std::vector<std::string> records;
+  for (timestamp_t timestamp = 0;; ++timestamp) {
+    // Every tenth record is larger than the chunk size.
+    std::string record = "test-data-" + std::to_string(timestamp);
+    if (timestamp % 10 == 0) {
+      record.resize(2 * kChunkSize, 'x');
+    }
+    if (!builder.add({timestamp, record.data(), record.size()})) {
+      break;
+    }
+    records.emplace_back(std::move(record));
+  }
+  builder.flush(File{"block", tempDir().path()});
+
+  BlockCursor cursor(File{"block", tempDir().path()}, kChunkSize);
+  ASSERT_EQ(cursor.count(), records.size());
+  timestamp_t timestamp = 0;
+  for (; cursor.valid(); cursor.next()) {
+    const auto& entry = cursor.record();
+    ASSERT_EQ(entry.timestamp, timestamp);
+    ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+              records[timestamp]);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, records.size());
+}
+
+TEST_F(BlockTestFixture, TestCompressedBlock) {
+  constexpr std::size_t kLargeBlockSize = 256 * 1024;
+  constexpr std::size_t kChunkSize = 256;
+
+  for (const auto codec : {CodecType::kLz4, CodecType::kZlib}) {
+    // Pairs of records are added out of order, spanning multiple compressed
+    // frames.
+    BlockBuilder builder(kLargeBlockSize, codec);
+    std::vector<std::pair<timestamp_t, std::string>> records;
+    for (timestamp_t i = 0;; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      if (!builder.add({i ^ 1, record.data(), record.size()})) {
+        break;
+      }
+      records.emplace_back(i ^ 1, std::move(record));
+    }
+    std::sort(records.begin(), records.end());
+    builder.flush(File{"block", tempDir().path()});
+    ASSERT_LT(tempDir().readFile("block").size(), kLargeBlockSize / 2);
+
+    BlockReader reader(File{"block", tempDir().path()});
+    ASSERT_EQ(reader.count(), records.size());
+    std::size_t index = 0;
+    for (const auto& entry : reader) {
+      ASSERT_EQ(entry.timestamp, records[index].first);
+      ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+                records[index].second);
+      ++index;
+    }
+    ASSERT_EQ(index, records.size());
+
+    BlockCursor cursor(File{"block", tempDir().path()}, kChunkSize);
+    ASSERT_EQ(cursor.count(), records.size());
+    index = 0;
+    for (; cursor.valid(); cursor.next()) {
+      const auto& entry = cursor.record();
+      ASSERT_EQ(entry.timestamp, records[index].first);
+      ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+                records[index].second);
+      ++index;
+    }
+    ASSERT_EQ(index, records.size());
+  }
+}
+
+TEST_F(BlockTestFixture, TestCorruptCompressedBlockIsEmpty) {
+  BlockBuilder builder(kBlockSize, CodecType::kLz4);
+  const std::string kData = "data";
+  ASSERT_TRUE(builder.add({10, kData.data(), kData.size()}));
+  builder.flush(File{"block", tempDir().path()});
+  File{"block", tempDir().path()}.resize(40);
+
+  ASSERT_EQ(BlockReader(File{"block", tempDir().path()}).count(), 0);
+  BlockCursor cursor(File{"block", tempDir().path()}, kBlockSize);
+  ASSERT_FALSE(cursor.valid());
+}
+
+TEST_F(BlockTestFixture, TestCorruptBlockFailsChecksum) {
+  const std::string kData = "data";
+  for (const auto codec : {CodecType::kNone, CodecType::kLz4}) {
+    BlockBuilder builder(kBlockSize, codec);
+    ASSERT_TRUE(builder.add({10, kData.data(), kData.size()}));
+    builder.flush(File{"block", tempDir().path()});
+    {
+      BlockReader reader(File{"block", tempDir().path()});
+      ASSERT_FALSE(reader.isCorrupt());
+      ASSERT_EQ(reader.count(), 1);
+      BlockCursor cursor(File{"block", tempDir().path()}, kBlockSize);
+      ASSERT_FALSE(cursor.isCorrupt());
+      ASSERT_TRUE(cursor.valid());
+    }
+
+    // Flip a bit of the record count, which still fits the block. The count
+    // follows the checksum, magic number and version.
+    File file("block", tempDir().path());
+    constexpr auto kCountOffset =
+        sizeof(ChecksumType) + sizeof(uint32_t) + sizeof(uint16_t);
+    uint8_t byte;
+    ASSERT_EQ(file.read(&byte, 1, kCountOffset), 1);
+    byte ^= 2;
+    file.write(&byte, 1, kCountOffset);
+
+    BlockReader reader(File{"block", tempDir().path()});
+    ASSERT_TRUE(reader.isCorrupt());
+    ASSERT_EQ(reader.count(), 0);
+    BlockCursor cursor(File{"block", tempDir().path()}, kBlockSize);
+    ASSERT_TRUE(cursor.isCorrupt());
+    ASSERT_FALSE(cursor.valid());
+  }
+}
+
+TEST_F(BlockTestFixture, TestCorruptFrameEndsBlock) {
+  // Records are stored from the end of the block backwards, thus the payloads
+  // of the first records are read from the last frames of the block.
+  constexpr std::size_t kLargeBlockSize = 256 * 1024;
+  constexpr std::size_t kChunkSize = 4 * 1024;
+  BlockBuilder builder(kLargeBlockSize);
+  const std::string kData(1024, 'x');
+  std::size_t count = 0;
+  while (builder.add(
+      {static_cast<timestamp_t>(count), kData.data(), kData.size()})) {
+    ++count;
+  }
+  builder.flush(File{"block", tempDir().path()});
+
+  // Flip a bit in the middle of the block, in a frame holding payloads.
+  File file("block", tempDir().path());
+  constexpr auto kOffset = kLargeBlockSize / 2;
+  uint8_t byte;
+  ASSERT_EQ(file.read(&byte, 1, kOffset), 1);
+  byte ^= 2;
+  file.write(&byte, 1, kOffset);
+
+  BlockReader reader(File{"block", tempDir().path()});
+  ASSERT_TRUE(reader.isCorrupt());
+  ASSERT_EQ(reader.count(), 0);
+
+  // The cursor reads the records preceding the corrupt frame.
+  BlockCursor cursor(File{"block", tempDir().path()}, kChunkSize);
+  ASSERT_FALSE(cursor.isCorrupt());
+  ASSERT_EQ(cursor.count(), count);
+  std::size_t read = 0;
+  for (; cursor.valid(); cursor.next()) {
+    ASSERT_EQ(cursor.record().timestamp, read);
+    ++read;
+  }
+  ASSERT_GT(read, 0);
+  ASSERT_LT(read, count);
+  ASSERT_TRUE(cursor.isCorrupt());
+}
+
+TEST_F(BlockTestFixture, TestStaleTailIsIgnored) {
+  const std::string kData = "data";
+  const std::string stale(4 * kBlockSize, 'x');
+  File{"block", tempDir().path()}.write(stale.data(), stale.size(), 0);
+
+  // Larger files are truncated to the block once written.
+  BlockBuilder builder(kBlockSize);
+  ASSERT_TRUE(builder.add({10, kData.data(), kData.size()}));
+  const auto info = builder.flush(File{"block", tempDir().path()});
+  ASSERT_EQ(File("block", tempDir().path()).size(), info.size);
+
+  // A crash before the truncation leaves a stale tail after the block.
+  File{"block", tempDir().path()}.write(stale.data(), stale.size(), info.size);
+  BlockReader reader(File{"block", tempDir().path()});
+  ASSERT_FALSE(reader.isCorrupt());
+  ASSERT_EQ(reader.count(), 1);
+  BlockCursor cursor(File{"block", tempDir().path()}, kBlockSize);
+  ASSERT_FALSE(cursor.isCorrupt());
+  ASSERT_TRUE(cursor.valid());
+  ASSERT_TRUE(isOneOf(cursor.record(), {kData}));
+}
+
+TEST_F(BlockTestFixture, TestLegacyBlockIsRead) {
+  // Blocks of the legacy format have a header with an unset checksum, record
+  // count and free space head, followed by the index. Records are stored from
+  // the end of the block backwards.
+  const std::vector<std::string> kData = {"data-1", "data-2"};
+  {
+    std::vector<uint8_t> legacy(kBlockSize, 0);
+    constexpr auto kHeaderSize = sizeof(ChecksumType) + 2 * sizeof(std::size_t);
+    constexpr auto kIndexSize = 3 * sizeof(std::size_t);
+    const std::size_t count = kData.size();
+    std::size_t fs_head = kBlockSize - kHeaderSize;
+    for (std::size_t idx = 0; idx < count; ++idx) {
+      fs_head -= kData[idx].size();
+      std::memcpy(legacy.data() + kHeaderSize + fs_head, kData[idx].data(),
+                  kData[idx].size());
+      const std::size_t index[] = {10 * (idx + 1), fs_head, kData[idx].size()};
+      std::memcpy(legacy.data() + kHeaderSize + idx * kIndexSize, index,
+                  kIndexSize);
+    }
+    std::memcpy(legacy.data() + sizeof(ChecksumType), &count, sizeof(count));
+    std::memcpy(legacy.data() + sizeof(ChecksumType) + sizeof(count),
+                &fs_head, sizeof(fs_head));
+    File file("legacy", tempDir().path());
+    file.write(legacy.data(), legacy.size(), 0);
+  }
+
+  BlockReader reader(File{"legacy", tempDir().path()});
+  ASSERT_FALSE(reader.isCorrupt());
+  ASSERT_EQ(reader.count(), kData.size());
+  std::size_t idx = 0;
+  for (const auto& record : reader) {
+    ASSERT_EQ(record.timestamp, 10 * (idx + 1));
+    ASSERT_TRUE(isOneOf(record, {kData[idx]}));
+    ++idx;
+  }
+
+  BlockCursor cursor(File{"legacy", tempDir().path()}, kBlockSize);
+  ASSERT_FALSE(cursor.isCorrupt());
+  for (idx = 0; cursor.valid(); cursor.next(), ++idx) {
+    ASSERT_EQ(cursor.record().timestamp, 10 * (idx + 1));
+    ASSERT_TRUE(isOneOf(cursor.record(), {kData[idx]}));
+  }
+  ASSERT_EQ(idx, kData.size());
+}
+
+TEST_F(BlockTestFixture, TestZeroFilledBlockIsCorrupt) {
+  {
+    const std::vector<uint8_t> zeros(kBlockSize, 0);
+    File file("block", tempDir().path());
+    file.write(zeros.data(), zeros.size(), 0);
+  }
+
+  BlockReader reader(File{"block", tempDir().path()});
+  ASSERT_TRUE(reader.isCorrupt());
+  ASSERT_EQ(reader.count(), 0);
+  BlockCursor cursor(File{"block", tempDir().path()}, kBlockSize);
+  ASSERT_TRUE(cursor.isCorrupt());
+  ASSERT_FALSE(cursor.valid());
+}
+
+TEST_F(BlockTestFixture, TestOtherBlockFormatVersionsAreRejected) {
+  const std::string kData = "data";
+  BlockBuilder builder(kBlockSize);
+  ASSERT_TRUE(builder.add({10, kData.data(), kData.size()}));
+  builder.flush(File{"block", tempDir().path()});
+  File file("block", tempDir().path());
+  // Blocks of version 1 have no frame checksums.
+  const uint16_t version = 1;
+  constexpr auto kVersionOffset = sizeof(ChecksumType) + sizeof(uint32_t);
+  file.write(&version, sizeof(version), kVersionOffset);
+  ASSERT_THROW(BlockReader(File{"block", tempDir().path()}),
+               std::runtime_error);
+  ASSERT_THROW(BlockCursor(File{"block", tempDir().path()}, kBlockSize),
+               std::runtime_error);
+}
+
+TEST_F(BlockTestFixture, TestBlockSummary) {
+  BlockBuilder builder(kBlockSize, CodecType::kNone, parseTags);
+  const std::vector<std::pair<timestamp_t, std::string>> records = {
+      {30, "1:10:100"}, {10, "2:10:101"}, {20, "1:11:102"}, {40, "1:10:100"}};
+  for (const auto& record : records) {
+    ASSERT_TRUE(builder.add(
+        {record.first, record.second.data(), record.second.size()}));
+  }
+
+  const auto summary = builder.summary();
+  ASSERT_EQ(summary.count, records.size());
+  ASSERT_EQ(summary.min_timestamp, 10);
+  ASSERT_EQ(summary.max_timestamp, 40);
+  ASSERT_TRUE(summary.tagged);
+  ASSERT_EQ(summary.type_counts,
+            (std::map<uint8_t, std::size_t>{{1, 3}, {2, 1}}));
+  ASSERT_EQ(summary.pids, (std::vector<int32_t>{10, 11}));
+  ASSERT_EQ(summary.tids, (std::vector<int32_t>{100, 101, 102}));
+  ASSERT_TRUE(summary.overlaps(40, 50));
+  ASSERT_FALSE(summary.overlaps(41, 50));
+
+  // The summary is read back from the footer of raw and compressed blocks.
+  for (const auto codec : {CodecType::kNone, CodecType::kLz4}) {
+    BlockBuilder codec_builder(kBlockSize, codec, parseTags);
+    for (const auto& record : records) {
+      codec_builder.add(
+          {record.first, record.second.data(), record.second.size()});
+    }
+    codec_builder.flush(File{"block", tempDir().path()});
+    ASSERT_EQ(codec_builder.summary().count, 0);
+
+    BlockSummary footer;
+    ASSERT_TRUE(readSummary(File{"block", tempDir().path()}, footer));
+    ASSERT_EQ(footer.count, summary.count);
+    ASSERT_EQ(footer.min_timestamp, summary.min_timestamp);
+    ASSERT_EQ(footer.max_timestamp, summary.max_timestamp);
+    ASSERT_EQ(footer.type_counts, summary.type_counts);
+    ASSERT_EQ(footer.pids, summary.pids);
+    ASSERT_EQ(footer.tids, summary.tids);
+    ASSERT_EQ(BlockReader(File{"block", tempDir().path()}).count(),
+              records.size());
+  }
+}
+
+TEST_F(BlockTestFixture, TestBlockSummaryMerge) {
+  BlockSummary first;
+  first.count = 2;
+  first.min_timestamp = 10;
+  first.max_timestamp = 20;
+  first.tagged = true;
+  first.type_counts = {{1, 2}};
+  first.pids = {1};
+  first.tids = {1, 3};
+  BlockSummary second = first;
+  second.min_timestamp = 15;
+  second.max_timestamp = 30;
+  second.type_counts = {{1, 1}, {2, 1}};
+  second.pids = {2};
+  second.tids = {2, 3};
+
+  BlockSummary merged;
+  merged.merge(first);
+  merged.merge(BlockSummary{});
+  merged.merge(second);
+  ASSERT_EQ(merged.count, 4);
+  ASSERT_EQ(merged.min_timestamp, 10);
+  ASSERT_EQ(merged.max_timestamp, 30);
+  ASSERT_TRUE(merged.tagged);
+  ASSERT_EQ(merged.type_counts,
+            (std::map<uint8_t, std::size_t>{{1, 3}, {2, 1}}));
+  ASSERT_EQ(merged.pids, (std::vector<int32_t>{1, 2}));
+  ASSERT_EQ(merged.tids, (std::vector<int32_t>{1, 2, 3}));
+
+  // Unknown summaries can not be skipped by any time range.
+  merged.merge(BlockSummary::unknown());
+  ASSERT_FALSE(merged.tagged);
+  ASSERT_TRUE(merged.pids.empty());
+  ASSERT_TRUE(merged.overlaps(100, 200));
+
+  std::vector<uint8_t> data;
+  second.serialize(data);
+  BlockSummary parsed;
+  ASSERT_EQ(parsed.deserialize(data.data(), data.size()), data.size());
+  ASSERT_EQ(parsed.type_counts, second.type_counts);
+  ASSERT_EQ(parsed.tids, second.tids);
+  ASSERT_EQ(parsed.deserialize(data.data(), data.size() - 1), 0);
+}
+
+TEST_F(BlockTestFixture, TestBlockCursorSeek) {
+  constexpr std::size_t kLargeBlockSize = 64 * 1024;
+
+  for (const auto codec : {CodecType::kNone, CodecType::kLz4}) {
+    BlockBuilder builder(kLargeBlockSize, codec);
+    timestamp_t count = 0;
+    for (;; ++count) {
+      const auto record = "test-data-" + std::to_string(count);
+      if (!builder.add({2 * count, record.data(), record.size()})) {
+        break;
+      }
+    }
+    builder.flush(File{"block", tempDir().path()});
+
+    // Reads start at the first record at or after the given timestamp.
+    const std::vector<timestamp_t> begins = {0, count - 1, count, 2 * count};
+    for (const auto begin : begins) {
+      BlockCursor cursor(File{"block", tempDir().path()}, 1024, begin);
+      timestamp_t expected = (begin + 1) / 2;
+      for (; cursor.valid(); cursor.next()) {
+        ASSERT_EQ(cursor.record().timestamp, 2 * expected);
+        ++expected;
+      }
+      ASSERT_EQ(expected, count);
+    }
+  }
+}
@@ -0,0 +1,332 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+/**
+ * @brief Data structure describing the backpressure experienced by the
+ * producer of a bounded queue.
+ *
+ */
+struct BackpressureMetrics {
+  uint64_t items = 0;      //<- Number of items pushed.
+  uint64_t stalls = 0;     //<- Number of pushes finding the queue full.
+  uint64_t stall_ns = 0;   //<- Time spent waiting on a full queue.
+  uint64_t max_depth = 0;  //<- Maximum number of items queued at once.
+};
+
+/**
+ * @brief The class `BoundedQueue` is a lock-free single producer single
+ * consumer queue of fixed capacity. It connects two pipeline stages running in
+ * separate threads, and records the backpressure experienced by the producing
+ * stage when the consuming stage falls behind.
+ *
+ * Stages waiting on a full or an empty queue block on a condition variable
+ * instead of polling, so that idle stages do not wake up. Pushes and pops only
+ * take the lock of the condition variable to signal a stage that is waiting.
+ *
+ * @tparam T Type of queued items. Must be default constructible and movable.
+ */
+template <class T>
+class BoundedQueue final {
+ public:
+  /**
+   * @brief Construct a new BoundedQueue object.
+   *
+   * @param capacity Maximum number of queued items. Must be positive.
+   */
+  explicit BoundedQueue(const std::size_t capacity);
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * @brief Get the maximum number of queued items.
+   *
+   */
+  std::size_t capacity() const;
+
+  /**
+   * @brief Get the number of queued items.
+   *
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Check if the queue is empty.
+   *
+   */
+  bool empty() const;
+
+  /**
+   * @brief Push an item if the queue is not full. Only called by the producer.
+   *
+   * @param item Rvalue reference to the item. The item is left untouched if
+   * the queue is full.
+   * @returns `true` if pushed else `false`.
+   */
+  bool tryPush(T&& item);
+
+  /**
+   * @brief Push an item, waiting for the consumer to make space if the queue
+   * is full. Only called by the producer.
+   *
+   * @param item Rvalue reference to the item.
+   */
+  void push(T&& item);
+
+  /**
+   * @brief Pop the oldest item if the queue is not empty. Only called by the
+   * consumer.
+   *
+   * @param item Reference to store the popped item.
+   * @returns `true` if popped else `false`.
+   */
+  bool tryPop(T& item);
+
+  /**
+   * @brief Pop the oldest item, waiting for the producer to push one if the
+   * queue is empty. Only called by the consumer.
+   *
+   * @param item Reference to store the popped item.
+   * @returns `true` if popped else `false` once the queue is closed and empty.
+   */
+  bool pop(T& item);
+
+  /**
+   * @brief Pop the oldest item, waiting up to the given time for the producer
+   * to push one if the queue is empty. Only called by the consumer.
+   *
+   * @param item Reference to store the popped item.
+   * @param deadline Constant reference to the time until which to wait.
+   * @returns `true` if popped else `false`.
+   */
+  template <class Clock, class Duration>
+  bool popUntil(T& item,
+                const std::chrono::time_point<Clock, Duration>& deadline);
+
+  /**
+   * @brief Close the queue, waking up the consumer waiting on it. Items queued
+   * before closing can still be popped.
+   *
+   */
+  void close();
+
+  /**
+   * @brief Check if the queue is closed.
+   *
+   */
+  bool closed() const;
+
+  /**
+   * @brief Get the backpressure experienced by the producer so far. Only
+   * called by the producer.
+   *
+   */
+  const BackpressureMetrics& metrics() const;
+
+ private:
+  void notify(const std::atomic_bool& waiting);
+
+  template <class Predicate, class Wait>
+  void wait(std::atomic_bool& waiting, Predicate ready, Wait wait);
+
+  std::vector<T> slots_;
+  alignas(64) std::atomic<std::size_t> head_;  //<- Next slot to pop.
+  alignas(64) std::atomic<std::size_t> tail_;  //<- Next slot to push.
+  BackpressureMetrics metrics_;
+  std::atomic_bool closed_;
+  std::atomic_bool producer_waiting_;
+  std::atomic_bool consumer_waiting_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+};
+
+// --------------------------------------------------------------
+// Implementation
+// --------------------------------------------------------------
+
+template <class T>
+BoundedQueue<T>::BoundedQueue(const std::size_t capacity)
+    : slots_(capacity),
+      head_(0),
+      tail_(0),
+      closed_(false),
+      producer_waiting_(false),
+      consumer_waiting_(false) {
+  if (capacity == 0) {
+    throw std::invalid_argument("Bounded queue capacity must be positive.");
+  }
+}
+
+template <class T>
+std::size_t BoundedQueue<T>::capacity() const {
+  return slots_.size();
+}
+
+template <class T>
+std::size_t BoundedQueue<T>::size() const {
+  return tail_.load(std::memory_order_acquire) -
+         head_.load(std::memory_order_acquire);
+}
+
+template <class T>
+bool BoundedQueue<T>::empty() const {
+  return size() == 0;
+}
+
+template <class T>
+bool BoundedQueue<T>::tryPush(T&& item) {
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  const auto depth = tail - head_.load(std::memory_order_acquire);
+  if (depth == slots_.size()) {
+    return false;
+  }
+  slots_[tail % slots_.size()] = std::move(item);
+  tail_.store(tail + 1, std::memory_order_release);
+  notify(consumer_waiting_);
+  ++metrics_.items;
+  if (depth + 1 > metrics_.max_depth) {
+    metrics_.max_depth = depth + 1;
+  }
+  return true;
+}
+
+template <class T>
+void BoundedQueue<T>::push(T&& item) {
+  if (tryPush(std::move(item))) {
+    return;
+  }
+  ++metrics_.stalls;
+  const auto start = std::chrono::steady_clock::now();
+  while (!tryPush(std::move(item))) {
+    wait(
+        producer_waiting_,
+        [this]() {
+          return tail_.load(std::memory_order_relaxed) -
+                     head_.load(std::memory_order_acquire) <
+                 slots_.size();
+        },
+        [this](std::unique_lock<std::mutex>& lock, const auto& ready) {
+          condition_.wait(lock, ready);
+        });
+  }
+  metrics_.stall_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+}
+
+template <class T>
+bool BoundedQueue<T>::tryPop(T& item) {
+  const auto head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  item = std::move(slots_[head % slots_.size()]);
+  head_.store(head + 1, std::memory_order_release);
+  notify(producer_waiting_);
+  return true;
+}
+
+template <class T>
+bool BoundedQueue<T>::pop(T& item) {
+  while (!tryPop(item)) {
+    if (closed() && empty()) {
+      return false;
+    }
+    wait(
+        consumer_waiting_, [this]() { return closed() || !empty(); },
+        [this](std::unique_lock<std::mutex>& lock, const auto& ready) {
+          condition_.wait(lock, ready);
+        });
+  }
+  return true;
+}
+
+template <class T>
+template <class Clock, class Duration>
+bool BoundedQueue<T>::popUntil(
+    T& item, const std::chrono::time_point<Clock, Duration>& deadline) {
+  if (tryPop(item)) {
+    return true;
+  }
+  wait(
+      consumer_waiting_, [this]() { return closed() || !empty(); },
+      [this, &deadline](std::unique_lock<std::mutex>& lock,
+                        const auto& ready) {
+        condition_.wait_until(lock, deadline, ready);
+      });
+  return tryPop(item);
+}
+
+template <class T>
+void BoundedQueue<T>::close() {
+  closed_.store(true, std::memory_order_seq_cst);
+  std::lock_guard<std::mutex> lock(mutex_);
+  condition_.notify_all();
+}
+
+template <class T>
+bool BoundedQueue<T>::closed() const {
+  return closed_.load(std::memory_order_acquire);
+}
+
+template <class T>
+const BackpressureMetrics& BoundedQueue<T>::metrics() const {
+  return metrics_;
+}
+
+// private
+template <class T>
+void BoundedQueue<T>::notify(const std::atomic_bool& waiting) {
+  // Pairs with the fence of a waiting stage, so that either the stage sees the
+  // update of the queue or the waiting flag is seen here.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    condition_.notify_all();
+  }
+}
+
+// private
+template <class T>
+template <class Predicate, class Wait>
+void BoundedQueue<T>::wait(std::atomic_bool& waiting, Predicate ready,
+                           Wait wait) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  waiting.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  wait(lock, ready);
+  waiting.store(false, std::memory_order_relaxed);
+}
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
@@ -0,0 +1,114 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/bounded_queue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace inspector::tools::storage;
+
+TEST(BoundedQueueTestFixture, TestPushPop) {
+  BoundedQueue<int> queue(2);
+  ASSERT_EQ(queue.capacity(), 2);
+  ASSERT_TRUE(queue.empty());
+  ASSERT_TRUE(queue.tryPush(1));
+  ASSERT_TRUE(queue.tryPush(2));
+  ASSERT_FALSE(queue.tryPush(3));
+  ASSERT_EQ(queue.size(), 2);
+
+  int item = 0;
+  ASSERT_TRUE(queue.tryPop(item));
+  ASSERT_EQ(item, 1);
+  ASSERT_TRUE(queue.tryPush(3));
+  ASSERT_TRUE(queue.tryPop(item));
+  ASSERT_EQ(item, 2);
+  ASSERT_TRUE(queue.tryPop(item));
+  ASSERT_EQ(item, 3);
+  ASSERT_FALSE(queue.tryPop(item));
+
+  ASSERT_EQ(queue.metrics().items, 3);
+  ASSERT_EQ(queue.metrics().max_depth, 2);
+  ASSERT_EQ(queue.metrics().stalls, 0);
+}
+
+TEST(BoundedQueueTestFixture, TestInvalidCapacity) {
+  ASSERT_THROW(BoundedQueue<int>(0), std::invalid_argument);
+}
+
+TEST(BoundedQueueTestFixture, TestProducerConsumer) {
+  constexpr auto kItemCount = 100000;
+  BoundedQueue<int> queue(8);
+
+  // The consumer yields while the queue is empty so that the producer runs on
+  // single CPU hosts. Mismatches are checked once joined, as a failed assertion
+  // in the thread would stop consuming and block the producer.
+  int mismatch = -1;
+  std::thread consumer([&queue, &mismatch]() {
+    int expected = 0, item;
+    while (expected < kItemCount) {
+      if (!queue.tryPop(item)) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (item != expected && mismatch < 0) {
+        mismatch = expected;
+      }
+      ++expected;
+    }
+  });
+  for (auto i = 0; i < kItemCount; ++i) {
+    queue.push(std::move(i));
+  }
+  consumer.join();
+
+  ASSERT_EQ(mismatch, -1);
+  ASSERT_TRUE(queue.empty());
+  ASSERT_EQ(queue.metrics().items, kItemCount);
+  ASSERT_LE(queue.metrics().max_depth, queue.capacity());
+}
+
+TEST(BoundedQueueTestFixture, TestBlockingPopAndClose) {
+  BoundedQueue<int> queue(1);
+  int item = 0;
+  ASSERT_FALSE(queue.popUntil(item, std::chrono::steady_clock::now() +
+                                        std::chrono::milliseconds(1)));
+
+  // The consumer blocks until items are pushed, and once the queue is closed
+  // pops the remaining items before stopping.
+  std::vector<int> items;
+  std::thread consumer([&queue, &items]() {
+    int item;
+    while (queue.pop(item)) {
+      items.push_back(item);
+    }
+  });
+  for (auto i = 0; i < 100; ++i) {
+    queue.push(std::move(i));
+  }
+  queue.close();
+  consumer.join();
+
+  ASSERT_TRUE(queue.closed());
+  ASSERT_EQ(items.size(), 100);
+  for (auto i = 0; i < 100; ++i) {
+    ASSERT_EQ(items[i], i);
+  }
+  ASSERT_FALSE(queue.pop(item));
+}
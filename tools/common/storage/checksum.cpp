@@ -16,28 +16,198 @@
 
 #include "tools/common/storage/checksum.hpp"
 
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
 namespace inspector {
 namespace tools {
 namespace storage {
 namespace {
 
-constexpr uint32_t kMod = 65521;
+/**
+ * @brief Reversed CRC32C (Castagnoli) polynomial.
+ *
+ */
+constexpr uint32_t kPolynomial = 0x82f63b78;
 
+/**
+ * @brief Number of bytes of each of the three streams checksummed in parallel
+ * by the hardware implementation. The CRC instruction has a latency of three
+ * cycles but a throughput of one per cycle, thus interleaving independent
+ * streams keeps it busy.
+ *
+ */
+constexpr std::size_t kStreamSize = 4096;
+
+/**
+ * @brief Multiply two polynomials modulo the CRC polynomial, in the reflected
+ * bit order of the CRC.
+ *
+ */
+uint32_t multiplyModulo(uint32_t a, uint32_t b) {
+  uint32_t product = 0;
+  for (uint32_t mask = 1u << 31; mask; mask >>= 1) {
+    if (a & mask) {
+      product ^= b;
+    }
+    b = b & 1 ? (b >> 1) ^ kPolynomial : b >> 1;
+  }
+  return product;
 }
 
-uint32_t checksum(const void* src, const std::size_t size) {
-  uint32_t a = 1, b = 0;
+/**
+ * @brief Compute the polynomial x^(8 * size) modulo the CRC polynomial, used to
+ * shift a CRC past the given number of zero bytes.
+ *
+ */
+uint32_t shiftOperator(const std::size_t size) {
+  uint32_t result = 1u << 31;  // x^0
+  uint32_t square = 1u << 23;  // x^8
+  for (auto bytes = size; bytes; bytes >>= 1) {
+    if (bytes & 1) {
+      result = multiplyModulo(result, square);
+    }
+    square = multiplyModulo(square, square);
+  }
+  return result;
+}
 
-  std::size_t count = 0;
-  auto it = static_cast<const uint8_t*>(src);
-  while (count < size) {
-    a = (a + *it) % kMod;
-    b = (b + a) % kMod;
-    ++count;
-    ++it;
+/**
+ * @brief Tables of the slicing by 8 software implementation.
+ *
+ */
+struct Tables {
+  Tables() {
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+      uint32_t crc = byte;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = crc & 1 ? (crc >> 1) ^ kPolynomial : crc >> 1;
+      }
+      values[0][byte] = crc;
+    }
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+      for (std::size_t slice = 1; slice < values.size(); ++slice) {
+        const auto previous = values[slice - 1][byte];
+        values[slice][byte] = (previous >> 8) ^ values[0][previous & 0xff];
+      }
+    }
   }
 
-  return (b << 16) | a;
+  std::array<std::array<uint32_t, 256>, 8> values;
+};
+
+/**
+ * @brief Update the CRC register with the given bytes using lookup tables.
+ *
+ */
+uint32_t updateSoftware(uint32_t crc, const uint8_t* data, std::size_t size) {
+  static const Tables tables;
+  const auto& table = tables.values;
+  for (; size >= 8; size -= 8, data += 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    word ^= crc;
+    crc = table[7][word & 0xff] ^ table[6][(word >> 8) & 0xff] ^
+          table[5][(word >> 16) & 0xff] ^ table[4][(word >> 24) & 0xff] ^
+          table[3][(word >> 32) & 0xff] ^ table[2][(word >> 40) & 0xff] ^
+          table[1][(word >> 48) & 0xff] ^ table[0][word >> 56];
+  }
+  for (; size; --size, ++data) {
+    crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__) || \
+    (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+
+#if defined(__x86_64__)
+#define CRC_TARGET __attribute__((target("sse4.2")))
+#define CRC_U8(crc, value) _mm_crc32_u8(crc, value)
+#define CRC_U64(crc, value) _mm_crc32_u64(crc, value)
+#else
+#define CRC_TARGET
+#define CRC_U8(crc, value) __crc32cb(crc, value)
+#define CRC_U64(crc, value) __crc32cd(crc, value)
+#endif
+
+/**
+ * @brief Update the CRC register with the given bytes using CRC instructions.
+ * Large spans are checksummed as three interleaved streams whose CRCs are then
+ * combined.
+ *
+ */
+CRC_TARGET uint32_t updateHardware(uint32_t crc, const uint8_t* data,
+                                   std::size_t size) {
+  static const uint32_t kShift1 = shiftOperator(kStreamSize);
+  static const uint32_t kShift2 = shiftOperator(2 * kStreamSize);
+  for (; size >= 3 * kStreamSize; size -= 3 * kStreamSize) {
+    uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+    for (std::size_t offset = 0; offset < kStreamSize; offset += 8) {
+      uint64_t word0, word1, word2;
+      std::memcpy(&word0, data + offset, sizeof(word0));
+      std::memcpy(&word1, data + kStreamSize + offset, sizeof(word1));
+      std::memcpy(&word2, data + 2 * kStreamSize + offset, sizeof(word2));
+      crc0 = CRC_U64(crc0, word0);
+      crc1 = CRC_U64(crc1, word1);
+      crc2 = CRC_U64(crc2, word2);
+    }
+    crc = multiplyModulo(static_cast<uint32_t>(crc0), kShift2) ^
+          multiplyModulo(static_cast<uint32_t>(crc1), kShift1) ^
+          static_cast<uint32_t>(crc2);
+    data += 3 * kStreamSize;
+  }
+  uint64_t crc64 = crc;
+  for (; size >= 8; size -= 8, data += 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc64 = CRC_U64(crc64, word);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; size; --size, ++data) {
+    crc = CRC_U8(crc, *data);
+  }
+  return crc;
+}
+
+#undef CRC_TARGET
+#undef CRC_U8
+#undef CRC_U64
+
+/**
+ * @brief Check if the CPU supports the CRC instructions.
+ *
+ */
+bool hasHardwareCrc() {
+#if defined(__x86_64__)
+  return __builtin_cpu_supports("sse4.2");
+#else
+  return true;
+#endif
+}
+
+#else
+
+uint32_t updateHardware(uint32_t crc, const uint8_t* data, std::size_t size) {
+  return updateSoftware(crc, data, size);
+}
+
+bool hasHardwareCrc() { return false; }
+
+#endif
+
+}  // namespace
+
+ChecksumType checksum(const void* src, const std::size_t size,
+                      const ChecksumType seed) {
+  static const auto update = hasHardwareCrc() ? updateHardware : updateSoftware;
+  return ~update(~seed, static_cast<const uint8_t*>(src), size);
 }
 
 }  // namespace storage
@@ -26,13 +26,20 @@ namespace storage {
 using ChecksumType = uint32_t;
 
 /**
- * @brief Compute checksum for the given memory span.
+ * @brief Compute checksum for the given memory span. The checksum is a CRC32C
+ * computed with the CRC instructions of SSE4.2 or ARMv8 when available, and
+ * with a table driven implementation otherwise.
+ *
+ * A memory span can be checksummed in pieces by passing the checksum of the
+ * previous pieces as seed.
  *
  * @param src Starting address of the memory span to compute checksum.
  * @param size Size in bytes of the memory span.
- * @returns CHecksum value.
+ * @param seed Checksum of the memory preceding the span, if any.
+ * @returns Checksum value.
  */
-ChecksumType checksum(const void* src, const std::size_t size);
+ChecksumType checksum(const void* src, const std::size_t size,
+                      const ChecksumType seed = 0);
 
 }  // namespace storage
 }  // namespace tools
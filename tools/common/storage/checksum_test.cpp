@@ -18,6 +18,7 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
 #include <vector>
 
 using namespace inspector::tools::storage;
@@ -26,12 +27,47 @@ TEST(ChecksumTestFixture, TestChecksumNonNullData) {
   const std::vector<char> data = {'t', 'e', 's', 't', 'i', 'n', 'g', '_',
                                   'c', 'h', 'e', 'c', 'k', 's', 'u', 'm'};
   size_t value = checksum(data.data(), data.size());
-  ASSERT_EQ(value, 956630705);
+  ASSERT_EQ(value, 2784316897);
 }
 
 TEST(ChecksumTestFixture, TestChecksumForNullData) {
   const std::vector<uint8_t> data = {0, 0, 0, 0, 0, 0, 0, 0,
                                      0, 0, 0, 0, 0, 0, 0, 0};
   size_t value = checksum(data.data(), data.size());
-  ASSERT_EQ(value, 1048577);
+  ASSERT_EQ(value, 1114675946);
+}
+
+TEST(ChecksumTestFixture, TestChecksumMatchesBitwiseCrc) {
+  // Reference CRC32C computed one bit at a time.
+  const auto reference = [](const uint8_t* data, const std::size_t size) {
+    uint32_t crc = ~0u;
+    for (std::size_t i = 0; i < size; ++i) {
+      crc ^= data[i];
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = crc & 1 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+      }
+    }
+    return ~crc;
+  };
+
+  std::mt19937 engine(7);
+  std::vector<uint8_t> data(64 * 1024 + 13);
+  for (auto& byte : data) {
+    byte = static_cast<uint8_t>(engine());
+  }
+  ASSERT_EQ(checksum("123456789", 9), 0xe3069283);
+  // Sizes and offsets cover the unaligned heads and tails, and the spans long
+  // enough to be checksummed as interleaved streams.
+  for (const std::size_t offset : {0, 1, 5}) {
+    for (const std::size_t size : {0, 1, 7, 8, 100, 12288, 12289, 40000,
+                                   64 * 1024}) {
+      const auto* const src = data.data() + offset;
+      const auto expected = reference(src, size);
+      ASSERT_EQ(checksum(src, size), expected);
+      // Checksums computed in pieces match the whole.
+      const auto half = size / 2;
+      ASSERT_EQ(checksum(src + half, size - half, checksum(src, half)),
+                expected);
+    }
+  }
 }
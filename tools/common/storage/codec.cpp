@@ -0,0 +1,396 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/codec.hpp"
+
+#include <zlib.h>
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+namespace {
+
+/**
+ * @brief Check that the given capacity can hold the compressed bytes.
+ *
+ */
+void checkCapacity(const Codec& codec, const std::size_t size,
+                   const std::size_t capacity) {
+  if (capacity < codec.bound(size)) {
+    throw std::length_error("Not enough capacity to compress " +
+                            std::to_string(size) + " bytes.");
+  }
+}
+
+/**
+ * @brief Raise error for corrupt compressed data.
+ *
+ */
+[[noreturn]] void throwCorrupt(const char* const codec) {
+  throw std::runtime_error(std::string("Corrupt ") + codec + " data.");
+}
+
+// ------------------------------------------------
+// None
+// ------------------------------------------------
+
+/**
+ * @brief The codec stores the bytes as is.
+ *
+ */
+class NoneCodec final : public Codec {
+ public:
+  CodecType type() const override { return CodecType::kNone; }
+
+  std::size_t bound(const std::size_t size) const override { return size; }
+
+  std::size_t compress(const uint8_t* const src, const std::size_t size,
+                       uint8_t* const dest,
+                       const std::size_t capacity) const override {
+    checkCapacity(*this, size, capacity);
+    std::memcpy(dest, src, size);
+    return size;
+  }
+
+  void decompress(const uint8_t* const src, const std::size_t size,
+                  uint8_t* const dest,
+                  const std::size_t dest_size) const override {
+    if (size < dest_size) {
+      throwCorrupt("raw");
+    }
+    std::memcpy(dest, src, dest_size);
+  }
+};
+
+// ------------------------------------------------
+// LZ4
+// ------------------------------------------------
+
+/**
+ * @brief The codec implements the LZ4 block format: a sequence of literal runs
+ * each followed by a match of at least `kMinMatch` bytes within the last 64KB.
+ * A sequence starts with a token holding the literal and match lengths in its
+ * high and low nibbles, extended with bytes of 255 when they overflow. The last
+ * sequence only has literals. Matches are found greedily using a hash table of
+ * 4 byte sequences, skipping faster over data which does not compress.
+ *
+ */
+class Lz4Codec final : public Codec {
+ public:
+  CodecType type() const override { return CodecType::kLz4; }
+
+  std::size_t bound(const std::size_t size) const override {
+    return size + size / 255 + 16;
+  }
+
+  std::size_t compress(const uint8_t* const src, const std::size_t size,
+                       uint8_t* const dest,
+                       const std::size_t capacity) const override {
+    checkCapacity(*this, size, capacity);
+    if (size > std::numeric_limits<uint32_t>::max()) {
+      throw std::length_error("Can not compress " + std::to_string(size) +
+                              " bytes at once.");
+    }
+    const auto* const end = src + size;
+    const auto* anchor = src;
+    auto* op = dest;
+    if (size > kMatchLimit) {
+      // Matches start at least `kMatchLimit` bytes and end at least
+      // `kLastLiterals` bytes before the end, as in the reference format.
+      const auto* const match_limit = end - kMatchLimit;
+      const auto* const copy_limit = end - kLastLiterals;
+      std::vector<uint32_t> table(std::size_t{1} << kHashLog, 0);
+      const auto* ip = src + 1;
+      while (ip < match_limit) {
+        const auto sequence = read32(ip);
+        auto& entry = table[hash(sequence)];
+        const auto* ref = src + entry;
+        entry = static_cast<uint32_t>(ip - src);
+        if (static_cast<std::size_t>(ip - ref) > kMaxOffset ||
+            read32(ref) != sequence) {
+          ip += 1 + ((ip - anchor) >> kSkipTrigger);
+          continue;
+        }
+        while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+          --ip;
+          --ref;
+        }
+        const auto length =
+            kMinMatch +
+            matchLength(ip + kMinMatch, ref + kMinMatch, copy_limit);
+        op = writeSequence(op, anchor, ip - anchor, ip - ref, length);
+        ip += length;
+        anchor = ip;
+      }
+    }
+    op = writeLiterals(op, anchor, end - anchor);
+    return op - dest;
+  }
+
+  void decompress(const uint8_t* const src, const std::size_t size,
+                  uint8_t* const dest,
+                  const std::size_t dest_size) const override {
+    const auto* ip = src;
+    const auto* const iend = src + size;
+    auto* op = dest;
+    auto* const oend = dest + dest_size;
+    while (true) {
+      if (ip == iend) {
+        throwCorrupt("lz4");
+      }
+      const auto token = *ip++;
+      std::size_t literals = token >> 4;
+      if (literals == kMaxNibble) {
+        literals += readLength(ip, iend);
+      }
+      if (literals > static_cast<std::size_t>(iend - ip) ||
+          literals > static_cast<std::size_t>(oend - op)) {
+        throwCorrupt("lz4");
+      }
+      if (literals <= kWildCopy &&
+          static_cast<std::size_t>(iend - ip) >= kWildCopy &&
+          static_cast<std::size_t>(oend - op) >= kWildCopy) {
+        // Short literal runs are copied with a fixed size which is faster,
+        // overwriting bytes which are decoded next.
+        std::memcpy(op, ip, kWildCopy);
+      } else {
+        std::memcpy(op, ip, literals);
+      }
+      ip += literals;
+      op += literals;
+      if (op == oend) {
+        return;
+      }
+
+      if (iend - ip < 2) {
+        throwCorrupt("lz4");
+      }
+      const std::size_t offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      std::size_t length = token & kMaxNibble;
+      if (length == kMaxNibble) {
+        length += readLength(ip, iend);
+      }
+      length += kMinMatch;
+      if (offset == 0 || offset > static_cast<std::size_t>(op - dest) ||
+          length > static_cast<std::size_t>(oend - op)) {
+        throwCorrupt("lz4");
+      }
+      const auto* match = op - offset;
+      if (offset >= 8 && static_cast<std::size_t>(oend - op) >= length + 8) {
+        // Copying 8 bytes at a time is safe for matches at least 8 bytes back.
+        for (std::size_t idx = 0; idx < length; idx += 8) {
+          std::memcpy(op + idx, match + idx, 8);
+        }
+        op += length;
+      } else if (offset >= length) {
+        std::memcpy(op, match, length);
+        op += length;
+      } else {
+        // Overlapping matches repeat the last `offset` bytes.
+        for (std::size_t idx = 0; idx < length; ++idx) {
+          *op++ = *match++;
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr std::size_t kMinMatch = 4;
+  static constexpr std::size_t kLastLiterals = 5;
+  static constexpr std::size_t kMatchLimit = 12;
+  static constexpr std::size_t kMaxOffset = 65535;
+  static constexpr std::size_t kMaxNibble = 15;
+  static constexpr std::size_t kHashLog = 14;
+  static constexpr std::size_t kSkipTrigger = 6;
+  static constexpr std::size_t kWildCopy = 16;
+
+  static uint32_t read32(const uint8_t* const src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+  }
+
+  static uint32_t hash(const uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - kHashLog);
+  }
+
+  /**
+   * @brief Get the number of bytes matching at the given positions, not going
+   * past the given limit.
+   *
+   */
+  static std::size_t matchLength(const uint8_t* ip, const uint8_t* ref,
+                                 const uint8_t* const limit) {
+    const auto* const start = ip;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (limit - ip >= 8) {
+      uint64_t lhs, rhs;
+      std::memcpy(&lhs, ip, sizeof(lhs));
+      std::memcpy(&rhs, ref, sizeof(rhs));
+      if (lhs != rhs) {
+        return ip - start + (__builtin_ctzll(lhs ^ rhs) >> 3);
+      }
+      ip += 8;
+      ref += 8;
+    }
+#endif
+    while (ip < limit && *ip == *ref) {
+      ++ip;
+      ++ref;
+    }
+    return ip - start;
+  }
+
+  static uint8_t* writeLength(uint8_t* op, std::size_t length) {
+    while (length >= 255) {
+      *op++ = 255;
+      length -= 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+  }
+
+  static std::size_t readLength(const uint8_t*& ip, const uint8_t* const iend) {
+    std::size_t length = 0;
+    uint8_t byte;
+    do {
+      if (ip == iend) {
+        throwCorrupt("lz4");
+      }
+      byte = *ip++;
+      length += byte;
+    } while (byte == 255);
+    return length;
+  }
+
+  static uint8_t* writeLiterals(uint8_t* op, const uint8_t* const literals,
+                                const std::size_t count) {
+    auto* const token = op++;
+    if (count >= kMaxNibble) {
+      *token = kMaxNibble << 4;
+      op = writeLength(op, count - kMaxNibble);
+    } else {
+      *token = static_cast<uint8_t>(count << 4);
+    }
+    std::memcpy(op, literals, count);
+    return op + count;
+  }
+
+  static uint8_t* writeSequence(uint8_t* op, const uint8_t* const literals,
+                                const std::size_t count,
+                                const std::size_t offset,
+                                const std::size_t length) {
+    auto* const token = op;
+    op = writeLiterals(op, literals, count);
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    const auto extra = length - kMinMatch;
+    if (extra >= kMaxNibble) {
+      *token |= kMaxNibble;
+      op = writeLength(op, extra - kMaxNibble);
+    } else {
+      *token |= static_cast<uint8_t>(extra);
+    }
+    return op;
+  }
+};
+
+// ------------------------------------------------
+// Zlib
+// ------------------------------------------------
+
+/**
+ * @brief The codec deflates bytes using zlib.
+ *
+ */
+class ZlibCodec final : public Codec {
+ public:
+  CodecType type() const override { return CodecType::kZlib; }
+
+  std::size_t bound(const std::size_t size) const override {
+    return ::compressBound(size);
+  }
+
+  std::size_t compress(const uint8_t* const src, const std::size_t size,
+                       uint8_t* const dest,
+                       const std::size_t capacity) const override {
+    checkCapacity(*this, size, capacity);
+    uLongf dest_size = capacity;
+    const auto result = ::compress2(dest, &dest_size, src, size, kLevel);
+    if (result != Z_OK) {
+      throw std::runtime_error("Error calling 'compress2': " +
+                               std::to_string(result));
+    }
+    return dest_size;
+  }
+
+  void decompress(const uint8_t* const src, const std::size_t size,
+                  uint8_t* const dest,
+                  const std::size_t dest_size) const override {
+    uLongf decompressed = dest_size;
+    uLong consumed = size;
+    if (::uncompress2(dest, &decompressed, src, &consumed) != Z_OK ||
+        decompressed != dest_size) {
+      throwCorrupt("zlib");
+    }
+  }
+
+ private:
+  static constexpr int kLevel = 6;
+};
+
+}  // namespace
+
+CodecType parseCodec(const std::string& name) {
+  if (name == "none") {
+    return CodecType::kNone;
+  }
+  if (name == "lz4") {
+    return CodecType::kLz4;
+  }
+  if (name == "zlib") {
+    return CodecType::kZlib;
+  }
+  throw std::invalid_argument("Unknown codec '" + name + "'.");
+}
+
+const Codec& Codec::get(const CodecType type) {
+  static const NoneCodec kNone;
+  static const Lz4Codec kLz4;
+  static const ZlibCodec kZlib;
+  switch (type) {
+    case CodecType::kNone:
+      return kNone;
+    case CodecType::kLz4:
+      return kLz4;
+    case CodecType::kZlib:
+      return kZlib;
+  }
+  throw std::invalid_argument(
+      "Unknown codec type " +
+      std::to_string(static_cast<unsigned>(type)) + ".");
+}
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
@@ -0,0 +1,112 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+/**
+ * @brief Types of codecs used to compress blocks. The type is recorded in the
+ * header of each block so that readers pick the codec on their own.
+ *
+ */
+enum class CodecType : uint8_t {
+  kNone = 0,  //<- Stored as is.
+  kLz4 = 1,   //<- LZ4 block format, fast to compress and decompress.
+  kZlib = 2,  //<- Deflate, slower but with a higher compression ratio.
+};
+
+/**
+ * @brief Parse a codec type from its name: one of `none`, `lz4` or `zlib`.
+ *
+ * @param name Constant reference to the name.
+ * @returns Codec type.
+ * @throws `std::invalid_argument` if the name is unknown.
+ */
+CodecType parseCodec(const std::string& name);
+
+/**
+ * @brief The interface `Codec` compresses and decompresses spans of memory.
+ * Codecs are stateless and thus safe to use from multiple threads.
+ *
+ */
+class Codec {
+ public:
+  /**
+   * @brief Get the codec of the given type.
+   *
+   * @param type Codec type.
+   * @returns Constant reference to the codec.
+   * @throws `std::invalid_argument` if the type is unknown, e.g. when read
+   * from a corrupt block.
+   */
+  static const Codec& get(const CodecType type);
+
+  virtual ~Codec() = default;
+
+  /**
+   * @brief Get the type of the codec.
+   *
+   */
+  virtual CodecType type() const = 0;
+
+  /**
+   * @brief Get the maximum number of bytes compressing the given number of
+   * bytes can take.
+   *
+   * @param size Number of bytes to compress.
+   * @returns Upper bound on the compressed size.
+   */
+  virtual std::size_t bound(const std::size_t size) const = 0;
+
+  /**
+   * @brief Compress the given memory span.
+   *
+   * @param src Pointer to the bytes to compress.
+   * @param size Number of bytes to compress.
+   * @param dest Pointer to the memory receiving the compressed bytes.
+   * @param capacity Size in bytes of the destination, at least `bound(size)`.
+   * @returns Number of compressed bytes.
+   * @throws `std::length_error` if the capacity is less than the bound.
+   */
+  virtual std::size_t compress(const uint8_t* const src, const std::size_t size,
+                               uint8_t* const dest,
+                               const std::size_t capacity) const = 0;
+
+  /**
+   * @brief Decompress the given memory span into exactly the given number of
+   * bytes. Bytes following the compressed data in the source are ignored.
+   *
+   * @param src Pointer to the compressed bytes.
+   * @param size Number of bytes available in the source.
+   * @param dest Pointer to the memory receiving the decompressed bytes.
+   * @param dest_size Number of decompressed bytes.
+   * @throws `std::runtime_error` if the compressed data is corrupt.
+   */
+  virtual void decompress(const uint8_t* const src, const std::size_t size,
+                          uint8_t* const dest,
+                          const std::size_t dest_size) const = 0;
+};
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
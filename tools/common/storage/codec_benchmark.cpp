@@ -0,0 +1,221 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The `codec_benchmark` utility measures the compression ratio and throughput
+ * of the block codecs on trace events, either generated or read from a recorded
+ * trace:
+ *
+ *   bazel run -c opt //tools/common/storage:codec_benchmark -- --trace=<path>
+ *
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <inspector/details/trace_event.hpp>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tools/common/storage/block.hpp"
+#include "tools/common/storage/codec.hpp"
+#include "tools/common/storage/storage.hpp"
+#include "utils/tempdir.hpp"
+
+DEFINE_uint64(events, 2000000, "Number of generated trace events.");
+DEFINE_uint64(block_size, 4 * 1024 * 1024, "Size in bytes of each block.");
+DEFINE_string(trace, "", "Path of a recorded trace to read events from.");
+DEFINE_string(dir, "/tmp/codec_benchmark", "Directory to write blocks.");
+
+namespace inspector {
+namespace tools {
+namespace {
+
+using Event = std::vector<uint8_t>;
+
+/**
+ * @brief Generate trace events resembling those of an instrumented service: a
+ * few threads of a few processes entering and leaving named scopes, with
+ * counters and string arguments.
+ *
+ */
+std::vector<std::pair<storage::timestamp_t, Event>> generateEvents(
+    const std::size_t count) {
+  const char* const kNames[] = {
+      "handle_request", "parse_header", "lookup_cache", "query_database",
+      "serialize_response", "compress_payload", "send_response", "gc_pause"};
+  const char* const kValues[] = {"GET /users", "POST /orders", "hit", "miss"};
+  constexpr int32_t kPids = 4;
+  constexpr int32_t kThreads = 8;
+  constexpr event_type_t kTypes = 4;
+
+  std::mt19937_64 engine(42);
+  std::uniform_int_distribution<storage::timestamp_t> delta(50, 5000);
+  std::uniform_int_distribution<std::size_t> pick(0, 1023);
+  std::vector<std::pair<storage::timestamp_t, Event>> events;
+  events.reserve(count);
+  storage::timestamp_t timestamp = 1700000000000000000;
+  for (std::size_t i = 0; i < count; ++i) {
+    timestamp += delta(engine);
+    const auto choice = pick(engine);
+    const auto* const name = kNames[choice % 8];
+    const auto pid = static_cast<int32_t>(1000 + choice % kPids);
+    const auto tid = pid + static_cast<int32_t>(choice / kPids % kThreads);
+    Event event;
+    if (choice % 3 == 0) {
+      const std::string value = kValues[choice % 4];
+      event.resize(details::traceEventStorageSize(name, value));
+      details::MutableTraceEvent(event.data(), event.size())
+          .appendDebugArgs(name, value);
+    } else {
+      const auto counter = static_cast<int64_t>(i);
+      event.resize(details::traceEventStorageSize(name, counter));
+      details::MutableTraceEvent(event.data(), event.size())
+          .appendDebugArgs(name, counter);
+    }
+    details::MutableTraceEvent mutable_event(event.data(), event.size());
+    mutable_event.setType(static_cast<event_type_t>(i % kTypes));
+    mutable_event.setCounter(i);
+    mutable_event.setPid(pid);
+    mutable_event.setTid(tid);
+    mutable_event.setTimestampNs(timestamp);
+    events.emplace_back(timestamp, std::move(event));
+  }
+  return events;
+}
+
+/**
+ * @brief Read the events of the recorded trace at the given path.
+ *
+ */
+std::vector<std::pair<storage::timestamp_t, Event>> readEvents(
+    const std::string& path) {
+  std::vector<std::pair<storage::timestamp_t, Event>> events;
+  for (const auto& record : storage::Reader{path}) {
+    const auto* const data = static_cast<const uint8_t*>(record.src);
+    events.emplace_back(record.timestamp, Event(data, data + record.size));
+  }
+  return events;
+}
+
+/**
+ * @brief Seal the given events into blocks.
+ *
+ */
+std::vector<storage::BlockBuffer> sealBlocks(
+    const std::vector<std::pair<storage::timestamp_t, Event>>& events) {
+  std::vector<storage::BlockBuffer> blocks;
+  storage::BlockBuilder builder(FLAGS_block_size);
+  const auto seal = [&]() {
+    blocks.emplace_back();
+    builder.seal(blocks.back());
+  };
+  for (const auto& event : events) {
+    const storage::Record record{event.first, event.second.data(),
+                                 event.second.size()};
+    if (!builder.add(record)) {
+      seal();
+      builder.add(record);
+    }
+  }
+  if (builder.count()) {
+    seal();
+  }
+  return blocks;
+}
+
+double elapsedSeconds(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief Compress the given blocks with the given codec and stream them back,
+ * logging the compression ratio and the throughputs.
+ *
+ */
+void run(const std::string& name, const storage::CodecType codec,
+         const std::vector<std::pair<storage::timestamp_t, Event>>& events,
+         const std::string& path) {
+  // Blocks are compressed from a fresh copy as compression compacts them.
+  auto blocks = sealBlocks(events);
+  const std::size_t raw_bytes = blocks.size() * FLAGS_block_size;
+  std::vector<storage::BlockBuffer> encoded(blocks.size());
+  auto start = std::chrono::steady_clock::now();
+  if (codec != storage::CodecType::kNone) {
+    for (std::size_t idx = 0; idx < blocks.size(); ++idx) {
+      storage::encodeBlock(blocks[idx], codec, encoded[idx]);
+    }
+  } else {
+    encoded = std::move(blocks);
+  }
+  const auto compress_s = elapsedSeconds(start);
+
+  std::size_t stored_bytes = 0;
+  for (std::size_t idx = 0; idx < encoded.size(); ++idx) {
+    stored_bytes += encoded[idx].size();
+    storage::writeBlock(encoded[idx],
+                        storage::File{std::to_string(idx), path}, false);
+  }
+
+  start = std::chrono::steady_clock::now();
+  std::size_t count = 0;
+  for (std::size_t idx = 0; idx < encoded.size(); ++idx) {
+    storage::BlockCursor cursor(storage::File{std::to_string(idx), path},
+                                storage::Reader::kDefaultMemoryBudget);
+    for (; cursor.valid(); cursor.next()) {
+      ++count;
+    }
+  }
+  const auto read_s = elapsedSeconds(start);
+  CHECK(count == events.size());
+
+  constexpr double kMB = 1024 * 1024;
+  LOG(INFO) << name << ": " << raw_bytes / kMB << "MB stored in "
+            << stored_bytes / kMB << "MB (ratio "
+            << static_cast<double>(raw_bytes) / stored_bytes
+            << "), compressed in " << compress_s << "s ("
+            << raw_bytes / kMB / compress_s << "MB/s), read in " << read_s
+            << "s (" << raw_bytes / kMB / read_s << "MB/s)";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  FLAGS_logtostderr = 1;
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const auto events = FLAGS_trace.empty() ? generateEvents(FLAGS_events)
+                                          : readEvents(FLAGS_trace);
+  LOG(INFO) << "Benchmarking " << events.size() << " events in blocks of "
+            << FLAGS_block_size << " bytes";
+  const utils::TempDir dir(FLAGS_dir);
+  for (const auto& codec : {"none", "lz4", "zlib"}) {
+    const auto path = storage::topicPath(dir.path(), codec);
+    run(codec, storage::parseCodec(codec), events, path);
+  }
+
+  return 0;
+}
+
+}  // namespace tools
+}  // namespace inspector
+
+int main(int argc, char* argv[]) { return inspector::tools::main(argc, argv); }
@@ -0,0 +1,133 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/codec.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utils/random.hpp"
+
+using namespace inspector::tools::storage;
+
+namespace {
+
+/**
+ * @brief Compress and decompress the given data with the codec of given type,
+ * returning the compressed size.
+ *
+ */
+std::size_t roundTrip(const CodecType type, const std::vector<uint8_t>& data) {
+  const auto& codec = Codec::get(type);
+  EXPECT_EQ(codec.type(), type);
+  std::vector<uint8_t> compressed(codec.bound(data.size()));
+  const auto size = codec.compress(data.data(), data.size(), compressed.data(),
+                                   compressed.size());
+  EXPECT_LE(size, compressed.size());
+  // Trailing bytes after the compressed data are ignored.
+  compressed.resize(size + 16);
+  std::vector<uint8_t> decompressed(data.size());
+  codec.decompress(compressed.data(), compressed.size(), decompressed.data(),
+                   decompressed.size());
+  EXPECT_EQ(decompressed, data);
+  return size;
+}
+
+/**
+ * @brief Create data looking like serialized events: a few distinct names and
+ * slowly increasing counters.
+ *
+ */
+std::vector<uint8_t> createEvents(const std::size_t count) {
+  const std::string names[] = {"process", "render-frame", "io-wait"};
+  std::vector<uint8_t> data;
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto event = names[i % 3] + ":" + std::to_string(1000 + i * 7) + ";";
+    data.insert(data.end(), event.begin(), event.end());
+  }
+  return data;
+}
+
+const std::vector<CodecType> kCodecs = {CodecType::kNone, CodecType::kLz4,
+                                        CodecType::kZlib};
+
+}  // namespace
+
+TEST(CodecTestFixture, TestParseCodec) {
+  ASSERT_EQ(parseCodec("none"), CodecType::kNone);
+  ASSERT_EQ(parseCodec("lz4"), CodecType::kLz4);
+  ASSERT_EQ(parseCodec("zlib"), CodecType::kZlib);
+  ASSERT_THROW(parseCodec("zstd"), std::invalid_argument);
+  ASSERT_THROW(Codec::get(static_cast<CodecType>(42)), std::invalid_argument);
+}
+
+TEST(CodecTestFixture, TestRoundTrip) {
+  utils::RandomNumberGenerator<uint32_t> rand(0, 255);
+  std::vector<uint8_t> random(100 * 1024);
+  for (auto& byte : random) {
+    byte = static_cast<uint8_t>(rand());
+  }
+  // Runs of a single byte are encoded as matches overlapping their source.
+  std::vector<uint8_t> runs;
+  for (std::size_t i = 0; i < 64; ++i) {
+    runs.insert(runs.end(), i * 37 % 1000 + 1, static_cast<uint8_t>(i));
+  }
+  const std::vector<std::vector<uint8_t>> inputs = {
+      {}, {1}, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13}, random, runs,
+      createEvents(10000)};
+
+  for (const auto type : kCodecs) {
+    for (const auto& input : inputs) {
+      roundTrip(type, input);
+    }
+  }
+}
+
+TEST(CodecTestFixture, TestCompressionRatio) {
+  const auto events = createEvents(10000);
+
+  ASSERT_EQ(roundTrip(CodecType::kNone, events), events.size());
+  const auto lz4_size = roundTrip(CodecType::kLz4, events);
+  const auto zlib_size = roundTrip(CodecType::kZlib, events);
+  ASSERT_LT(lz4_size, events.size() / 2);
+  ASSERT_LT(zlib_size, lz4_size);
+}
+
+TEST(CodecTestFixture, TestDecompressCorruptData) {
+  const auto events = createEvents(1000);
+  for (const auto type : {CodecType::kLz4, CodecType::kZlib}) {
+    const auto& codec = Codec::get(type);
+    std::vector<uint8_t> compressed(codec.bound(events.size()));
+    compressed.resize(codec.compress(events.data(), events.size(),
+                                     compressed.data(), compressed.size()));
+    std::vector<uint8_t> decompressed(2 * events.size());
+
+    const std::vector<uint8_t> truncated(
+        compressed.begin(), compressed.begin() + compressed.size() / 2);
+    ASSERT_THROW(codec.decompress(truncated.data(), truncated.size(),
+                                  decompressed.data(), events.size()),
+                 std::runtime_error);
+    ASSERT_THROW(codec.decompress(compressed.data(), compressed.size(),
+                                  decompressed.data(), decompressed.size()),
+                 std::runtime_error);
+    ASSERT_THROW(codec.compress(events.data(), events.size(),
+                                compressed.data(), events.size() / 2),
+                 std::length_error);
+  }
+}
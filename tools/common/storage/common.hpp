@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <new>
+#include <vector>
 
 namespace inspector {
 namespace tools {
@@ -74,6 +77,54 @@ struct Record {
   }
 };
 
+/**
+ * @brief Alignment in bytes of the memory and the size of blocks written with
+ * direct IO.
+ *
+ */
+constexpr std::size_t kBlockAlignment = 4096;
+
+/**
+ * @brief Allocator of memory aligned to `kBlockAlignment`.
+ *
+ * @tparam T Type of allocated objects.
+ */
+template <class T>
+struct AlignedAllocator {
+  using value_type = T;
+
+  AlignedAllocator() = default;
+
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U>&) {}
+
+  T* allocate(const std::size_t count) {
+    return static_cast<T*>(::operator new(
+        count * sizeof(T), std::align_val_t{kBlockAlignment}));
+  }
+
+  void deallocate(T* const pointer, const std::size_t) {
+    ::operator delete(pointer, std::align_val_t{kBlockAlignment});
+  }
+
+  template <class U>
+  bool operator==(const AlignedAllocator<U>&) const {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const AlignedAllocator<U>&) const {
+    return false;
+  }
+};
+
+/**
+ * @brief Memory of a block. The memory is aligned so that blocks can be
+ * written with direct IO.
+ *
+ */
+using BlockBuffer = std::vector<uint8_t, AlignedAllocator<uint8_t>>;
+
 }  // namespace storage
 }  // namespace tools
 }  // namespace inspector
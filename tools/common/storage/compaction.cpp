@@ -0,0 +1,163 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tools/common/storage/compaction.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "tools/common/storage/manifest.hpp"
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+namespace {
+
+/**
+ * @brief Number of full blocks of a segment waiting to be written, so that
+ * compressing and writing blocks overlaps with reading the storage.
+ *
+ */
+constexpr std::size_t kMaxPendingBlocks = 4;
+
+/**
+ * @brief Get the time partition of the given timestamp, rounding towards
+ * negative infinity so that partitions have the same duration on both sides
+ * of zero.
+ *
+ */
+timestamp_t partition(const timestamp_t timestamp, const timestamp_t duration) {
+  const auto quotient = timestamp / duration;
+  return timestamp % duration < 0 ? quotient - 1 : quotient;
+}
+
+/**
+ * @brief Create the segment index entry of the segment with given index
+ * written at the given path.
+ *
+ */
+ManifestEntry segmentEntry(const std::string& path, const std::size_t index,
+                           const CodecType codec) {
+  const auto segment_path = segmentPath(path, index);
+  auto directory = readIndex(segment_path);
+  ManifestEntry entry;
+  entry.index = index;
+  entry.name = segment_path.substr(path.size() + 1);
+  entry.codec = codec;
+  for (const auto& block : directory.blocks) {
+    entry.size += block.size;
+  }
+  entry.summary = std::move(directory.summary);
+  return entry;
+}
+
+/**
+ * @brief Get the components of the canonical absolute path of the given path,
+ * which need not exist.
+ *
+ */
+std::vector<std::string> canonicalComponents(const std::string& path) {
+  std::vector<std::string> components;
+  for (const auto& component :
+       boost::filesystem::weakly_canonical(boost::filesystem::absolute(path))) {
+    // Trailing separators are iterated as a "." component.
+    if (component != ".") {
+      components.push_back(component.string());
+    }
+  }
+  return components;
+}
+
+/**
+ * @brief Check if the given path is the given directory or lies under it,
+ * following symbolic links and relative components.
+ *
+ */
+bool isWithin(const std::string& path, const std::string& directory) {
+  const auto components = canonicalComponents(path);
+  const auto parents = canonicalComponents(directory);
+  return parents.size() <= components.size() &&
+         std::equal(parents.begin(), parents.end(), components.begin());
+}
+
+}  // namespace
+
+CompactionStats compact(const std::string& path, const std::string& output,
+                        const CompactionOptions& options) {
+  if (options.segment_duration <= 0) {
+    throw std::invalid_argument("Segment duration must be positive.");
+  }
+  if (isWithin(output, path)) {
+    throw std::invalid_argument("Storage '" + path +
+                                "' cannot be compacted in place or into a "
+                                "directory under it.");
+  }
+
+  // Records are read in almost chronological mode so that none is dropped.
+  // All the blocks are merged, if need be in multiple passes, so the records
+  // are read in order unless a block is not sorted.
+  Reader reader(path, Reader::kDefaultMaxBlocks,
+                Reader::ReadMode::kAlmostChronological, options.memory_budget,
+                options.prefetch_threads);
+  DurabilityPolicy durability;
+  durability.sync = DurabilityPolicy::Sync::kOnClose;
+  ManifestWriter index(output, kSegmentIndexName);
+  CompactionStats stats;
+  std::unique_ptr<Writer> writer;
+  timestamp_t current = 0;
+  timestamp_t last = std::numeric_limits<timestamp_t>::min();
+  const auto close = [&]() {
+    writer->flush();
+    writer.reset();
+    index.append(segmentEntry(output, stats.segments, options.codec), true);
+    ++stats.segments;
+  };
+  for (const auto& record : reader) {
+    if (record.timestamp < last) {
+      throw std::runtime_error("Records of storage '" + path +
+                               "' are not sorted.");
+    }
+    last = record.timestamp;
+    const auto next = partition(record.timestamp, options.segment_duration);
+    if (writer && next != current) {
+      close();
+    }
+    if (!writer) {
+      current = next;
+      writer = std::make_unique<Writer>(
+          segmentPath(output, stats.segments), options.block_size,
+          kMaxPendingBlocks, durability, options.codec, options.classifier);
+    }
+    writer->write(record);
+    ++stats.records;
+  }
+  if (writer) {
+    close();
+  }
+  stats.corrupt_blocks = reader.corruptBlocks();
+  return stats;
+}
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
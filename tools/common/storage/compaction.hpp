@@ -0,0 +1,89 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <string>
+
+#include "tools/common/storage/block.hpp"
+#include "tools/common/storage/codec.hpp"
+#include "tools/common/storage/common.hpp"
+#include "tools/common/storage/storage.hpp"
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+/**
+ * @brief Data structure describing how a storage is compacted.
+ *
+ */
+struct CompactionOptions {
+  static constexpr timestamp_t kDefaultSegmentDuration =
+      60L * 1000L * 1000L * 1000L;  // 1 minute in ns
+  static constexpr std::size_t kDefaultBlockSize =
+      1024UL * 1024UL * 16UL;  // 16MB
+
+  timestamp_t segment_duration = kDefaultSegmentDuration;
+  std::size_t block_size = kDefaultBlockSize;  //<- Block size in bytes.
+  CodecType codec = CodecType::kLz4;           //<- Block codec.
+  RecordClassifier classifier = nullptr;       //<- Tags the block summaries.
+  std::size_t memory_budget = Reader::kDefaultMemoryBudget;
+  std::size_t prefetch_threads = Reader::kDefaultPrefetchThreads;
+};
+
+/**
+ * @brief Data structure describing the outcome of a compaction.
+ *
+ */
+struct CompactionStats {
+  std::size_t records = 0;         //<- Number of records written.
+  std::size_t segments = 0;        //<- Number of segments written.
+  std::size_t corrupt_blocks = 0;  //<- Number of corrupt blocks skipped.
+};
+
+/**
+ * @brief Compact the storage located at the given path into the given output
+ * directory.
+ *
+ * The records of all the shards and topics of the storage are externally
+ * sorted by a `Reader`, which merges in multiple passes through temporary runs
+ * when the storage has more blocks than fit the memory budget, so that no
+ * record is dropped for arriving too far out of order. The sorted records are
+ * partitioned by time into segments of the given duration, with segment
+ * boundaries at multiples of the duration. Each segment is a directory of
+ * blocks written with a manifest, and the segments are listed in the segment
+ * index of the output directory.
+ *
+ * Each segment is synced to disk before being listed in the segment index, so
+ * that an interrupted compaction leaves the segments listed so far readable.
+ *
+ * @param path Path where the storage to compact is located.
+ * @param output Path of the output directory.
+ * @param options Constant reference to the compaction options.
+ * @returns Statistics of the compaction.
+ * @throws `std::invalid_argument` if the segment duration is not positive or
+ * the output directory is the storage itself or lies under it.
+ * @throws `std::runtime_error` if a block of the storage is not sorted, in
+ * which case its records cannot be partitioned.
+ */
+CompactionStats compact(const std::string& path, const std::string& output,
+                        const CompactionOptions& options = {});
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
@@ -0,0 +1,165 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tools/common/storage/compaction.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/storage.hpp"
+#include "tools/common/storage/testing.hpp"
+#include "utils/random.hpp"
+
+using namespace inspector::tools::storage;
+
+namespace {
+constexpr auto kBlockSize = 1024;
+}
+
+class CompactionTestFixture : public TestHarness, public ::testing::Test {
+ protected:
+  std::string storagePath() const { return tempDir().path() + "/storage"; }
+
+  std::string outputPath() const { return tempDir().path() + "/compacted"; }
+
+  /**
+   * @brief Write the given number of records to overlapping shards, with each
+   * record storing its timestamp as text. Records of a shard are written out
+   * of order across blocks.
+   *
+   */
+  void writeStorage(const std::size_t count, const std::size_t shards) const {
+    std::vector<std::unique_ptr<Writer>> writers;
+    for (std::size_t shard = 0; shard < shards; ++shard) {
+      writers.emplace_back(std::make_unique<Writer>(
+          shardPath(storagePath(), shard), kBlockSize));
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      // Records of the second half are written before those of the first.
+      const auto timestamp = (i + count / 2) % count;
+      const auto record = std::to_string(timestamp);
+      writers[i % shards]->write({static_cast<timestamp_t>(timestamp),
+                                  record.data(), record.size()});
+    }
+  }
+
+  static timestamp_t parseTimestamp(const Record& record) {
+    return std::stol(
+        std::string(static_cast<const char*>(record.src), record.size));
+  }
+};
+
+TEST_F(CompactionTestFixture, TestCompactAndRead) {
+  constexpr std::size_t kRecordCount = 5000;
+  constexpr timestamp_t kSegmentDuration = 1000;
+  writeStorage(kRecordCount, 3);
+
+  // The memory budget only allows merging a few blocks at once, so that the
+  // storage is sorted in multiple passes.
+  CompactionOptions options;
+  options.segment_duration = kSegmentDuration;
+  options.block_size = kBlockSize;
+  options.codec = CodecType::kNone;
+  options.memory_budget = 256 * 1024;
+  const auto stats = compact(storagePath(), outputPath(), options);
+  ASSERT_EQ(stats.records, kRecordCount);
+  ASSERT_EQ(stats.segments, kRecordCount / kSegmentDuration);
+  ASSERT_EQ(stats.corrupt_blocks, 0);
+
+  // Segments are time partitions in order, each with sorted blocks not
+  // overlapping in time.
+  std::vector<ManifestEntry> segments;
+  ASSERT_TRUE(readSegments(outputPath(), segments));
+  ASSERT_EQ(segments.size(), stats.segments);
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    const auto& summary = segments[i].summary;
+    ASSERT_EQ(segments[i].index, i);
+    ASSERT_EQ(summary.count, kSegmentDuration);
+    ASSERT_EQ(summary.min_timestamp, i * kSegmentDuration);
+    ASSERT_EQ(summary.max_timestamp, (i + 1) * kSegmentDuration - 1);
+    const auto index = readIndex(outputPath() + "/" + segments[i].name);
+    ASSERT_GT(index.blocks.size(), 1);
+    for (std::size_t block = 1; block < index.blocks.size(); ++block) {
+      ASSERT_GT(index.blocks[block].summary.min_timestamp,
+                index.blocks[block - 1].summary.max_timestamp);
+    }
+  }
+  ASSERT_TRUE(listTopics(outputPath()).empty());
+
+  // All the blocks of the compacted storage are read as a single run, so that
+  // no record is dropped however few blocks are merged at once.
+  Reader reader{outputPath(), 2, Reader::ReadMode::kAlwaysChronological};
+  timestamp_t timestamp = 0;
+  for (const auto& entry : reader) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    ASSERT_EQ(parseTimestamp(entry), timestamp);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+}
+
+TEST_F(CompactionTestFixture, TestReadCompactedWithFilter) {
+  constexpr std::size_t kRecordCount = 4000;
+  writeStorage(kRecordCount, 2);
+  CompactionOptions options;
+  options.segment_duration = 500;
+  options.block_size = kBlockSize;
+  compact(storagePath(), outputPath(), options);
+
+  utils::RandomNumberGenerator<timestamp_t> rand(0, kRecordCount - 1);
+  for (auto i = 0; i < 10; ++i) {
+    ReadFilter filter;
+    filter.begin = rand();
+    filter.end = filter.begin + rand() % 700;
+    timestamp_t timestamp = filter.begin;
+    for (const auto& entry : Reader{outputPath(), Reader::kDefaultMaxBlocks,
+                                    Reader::ReadMode::kAlwaysChronological,
+                                    Reader::kDefaultMemoryBudget,
+                                    Reader::kDefaultPrefetchThreads, filter}) {
+      ASSERT_EQ(entry.timestamp, timestamp);
+      ++timestamp;
+    }
+    ASSERT_EQ(timestamp,
+              std::min<timestamp_t>(filter.end + 1, kRecordCount));
+  }
+}
+
+TEST_F(CompactionTestFixture, TestCompactInvalidOptions) {
+  writeStorage(100, 1);
+  CompactionOptions options;
+  options.segment_duration = 0;
+  ASSERT_THROW(compact(storagePath(), outputPath(), options),
+               std::invalid_argument);
+  ASSERT_THROW(compact(storagePath(), storagePath()), std::invalid_argument);
+  // Paths are compared once resolved, and outputs under the storage are
+  // rejected as well.
+  ASSERT_THROW(compact(storagePath(), storagePath() + "/../storage/"),
+               std::invalid_argument);
+  ASSERT_THROW(compact(storagePath(), storagePath() + "/compacted"),
+               std::invalid_argument);
+
+  // Compacting an empty storage writes no segment.
+  const auto stats = compact(outputPath(), tempDir().path() + "/empty");
+  ASSERT_EQ(stats.records, 0);
+  std::vector<ManifestEntry> segments;
+  ASSERT_FALSE(readSegments(tempDir().path() + "/empty", segments));
+}
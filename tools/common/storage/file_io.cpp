@@ -18,9 +18,11 @@
 
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <system_error>
 
 namespace inspector {
@@ -35,21 +37,41 @@ namespace {
 constexpr int kNullFileDescriptor = -1;
 
 /**
- * @brief Open a file having given name and path.
+ * @brief Create the directory at the given path along with any missing parent
+ * directories.
  *
- * @param name Constant reference to the file name.
- * @param path Constant reference to the path to the file excluding file name.
- * @returns File descriptor.
+ * @param path Constant reference to the path of the directory.
  */
-int openFile(const std::string& name, const std::string& path) {
+void makeDirectories(const std::string& path) {
+  const auto separator = path.find_last_of('/');
+  if (separator != std::string::npos && separator != 0) {
+    struct stat buffer;
+    const auto parent = path.substr(0, separator);
+    if (::stat(parent.c_str(), &buffer) == -1) {
+      makeDirectories(parent);
+    }
+  }
   auto status = ::mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-  if (!status && status != EEXIST) {
+  if (status == -1 && errno != EEXIST) {
     throw std::system_error(
         errno, std::generic_category(),
         "Error calling 'mkdir' for directory '" + path + "': ");
   }
+}
+
+/**
+ * @brief Open a file having given name and path.
+ *
+ * @param name Constant reference to the file name.
+ * @param path Constant reference to the path to the file excluding file name.
+ * @param direct Flag to open the file for direct IO.
+ * @returns File descriptor.
+ */
+int openFile(const std::string& name, const std::string& path,
+             const bool direct) {
+  makeDirectories(path);
   const auto file = path + "/" + name;
-  auto fd = ::open(file.c_str(), O_CREAT | O_RDWR,
+  auto fd = ::open(file.c_str(), O_CREAT | O_RDWR | (direct ? O_DIRECT : 0),
                    S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
   if (fd < 0) {
     throw std::system_error(errno, std::generic_category(),
@@ -58,8 +80,32 @@ int openFile(const std::string& name, const std::string& path) {
   return fd;
 }
 
+/**
+ * @brief Get the `madvise` flag of the given advice.
+ *
+ */
+int adviceFlag(const MappedFile::Advice advice) {
+  switch (advice) {
+    case MappedFile::Advice::kNormal:
+      return MADV_NORMAL;
+    case MappedFile::Advice::kSequential:
+      return MADV_SEQUENTIAL;
+    case MappedFile::Advice::kRandom:
+      return MADV_RANDOM;
+    case MappedFile::Advice::kWillNeed:
+      return MADV_WILLNEED;
+    case MappedFile::Advice::kDontNeed:
+      return MADV_DONTNEED;
+  }
+  return MADV_NORMAL;
+}
+
 }  // namespace
 
+// ----------------------------------------------------------------
+// File
+// ----------------------------------------------------------------
+
 // static
 bool File::exists(const std::string& name, const std::string& path) {
   const std::string file = path + "/" + name;
@@ -68,8 +114,30 @@ bool File::exists(const std::string& name, const std::string& path) {
   return ::stat(file.c_str(), &buffer) == 0;
 }
 
-File::File(const std::string& name, const std::string& path)
-    : path_(path + "/" + name), fd_(openFile(name, path)) {}
+// static
+bool File::syncIfExists(const std::string& name, const std::string& path) {
+  const auto file = path + "/" + name;
+  const auto fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    throw std::system_error(errno, std::generic_category(),
+                            "Error calling 'open' for file '" + file + "': ");
+  }
+  const auto status = ::fsync(fd);
+  const auto error = errno;
+  ::close(fd);
+  if (status == -1) {
+    throw std::system_error(error, std::generic_category(),
+                            "Error calling 'fsync' for file '" + file + "': ");
+  }
+  return true;
+}
+
+File::File(const std::string& name, const std::string& path,
+           const bool direct)
+    : path_(path + "/" + name), fd_(openFile(name, path, direct)) {}
 
 File::~File() {
   if (fd_ != kNullFileDescriptor) {
@@ -139,6 +207,67 @@ void File::remove() const {
 
 const std::string& File::path() const { return path_; }
 
+// ----------------------------------------------------------------
+// MappedFile
+// ----------------------------------------------------------------
+
+MappedFile::MappedFile(const File& file) : data_(nullptr), size_(file.size()) {
+  if (size_ == 0) {
+    return;
+  }
+  auto* address = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, file.fd_, 0);
+  if (address == MAP_FAILED) {
+    throw std::system_error(
+        errno, std::generic_category(),
+        "Error calling 'mmap' for file '" + file.path() + "': ");
+  }
+  data_ = static_cast<uint8_t*>(address);
+}
+
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  if (this != &other) {
+    unmap();
+    data_ = other.data_;
+    size_ = other.size_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
+const uint8_t* MappedFile::data() const { return data_; }
+
+std::size_t MappedFile::size() const { return size_; }
+
+void MappedFile::advise(const Advice advice, const std::size_t offset,
+                        const std::size_t size) const {
+  if (data_ == nullptr || offset >= size_) {
+    return;
+  }
+  static const auto page_size =
+      static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const auto begin = offset / page_size * page_size;
+  const auto end = std::min(offset + size, size_);
+  ::madvise(data_ + begin, end - begin, adviceFlag(advice));
+}
+
+// private
+void MappedFile::unmap() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
 }  // namespace storage
 }  // namespace tools
 }  // namespace inspector
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include "tools/common/storage/common.hpp"
@@ -33,6 +34,9 @@ namespace storage {
  *
  */
 class File final {
+  friend class AsyncWriter;
+  friend class MappedFile;
+
  public:
   NO_COPY(File);
 
@@ -45,6 +49,17 @@ class File final {
    */
   static bool exists(const std::string& name, const std::string& path = ".");
 
+  /**
+   * @brief Sync the file with given name and path to disk if it exists. Unlike
+   * constructing a `File`, neither the file nor its directory are created.
+   *
+   * @param name Constant reference to the file name.
+   * @param path Constant reference to the path to the file excluding file name.
+   * @returns `true` if the file was synced else `false` if it does not exist.
+   */
+  static bool syncIfExists(const std::string& name,
+                           const std::string& path = ".");
+
   /**
    * @brief Construct a new File object.
    *
@@ -52,8 +67,12 @@ class File final {
    *
    * @param name Constant reference to the file name.
    * @param path Constant reference to the path to the file excluding file name.
+   * @param direct Flag to open the file for direct IO, bypassing the page
+   * cache. Data written must then be aligned to `kBlockAlignment` in both
+   * memory and size.
    */
-  File(const std::string& name, const std::string& path = ".");
+  File(const std::string& name, const std::string& path = ".",
+       const bool direct = false);
 
   /**
    * @brief Destroy the File object.
@@ -137,6 +156,87 @@ class File final {
   int fd_;
 };
 
+/**
+ * @brief The class `MappedFile` maps the contents of a file read-only into
+ * memory. Pages are loaded on first access, so mapping a file is constant time
+ * and the resident memory only covers the parts actually read.
+ *
+ */
+class MappedFile final {
+ public:
+  NO_COPY(MappedFile);
+
+  /**
+   * @brief Expected access pattern of a range of the mapping.
+   *
+   */
+  enum class Advice : uint8_t {
+    kNormal,
+    kSequential,
+    kRandom,
+    kWillNeed,
+    kDontNeed,
+  };
+
+  /**
+   * @brief Construct a new MappedFile object mapping the entire given file.
+   *
+   * @param file Constant reference to the file.
+   */
+  explicit MappedFile(const File& file);
+
+  /**
+   * @brief Destroy the MappedFile object.
+   *
+   * The file is unmapped as part of the DTOR.
+   *
+   */
+  ~MappedFile();
+
+  /**
+   * @brief Construct a new MappedFile object. Move CTOR.
+   *
+   */
+  MappedFile(MappedFile&& other);
+
+  /**
+   * @brief Move assignment operator.
+   *
+   */
+  MappedFile& operator=(MappedFile&& other);
+
+  /**
+   * @brief Get pointer to the start of the mapping. The pointer is null for
+   * empty files.
+   *
+   */
+  const uint8_t* data() const;
+
+  /**
+   * @brief Get the size of the mapping in bytes.
+   *
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Advise the kernel on the expected access pattern of the given range
+   * of the mapping. The range is expanded to page boundaries. Advice is only a
+   * hint and failures are ignored.
+   *
+   * @param advice Expected access pattern.
+   * @param offset Offset in bytes of the range from the start of the mapping.
+   * @param size Size in bytes of the range.
+   */
+  void advise(const Advice advice, const std::size_t offset,
+              const std::size_t size) const;
+
+ private:
+  void unmap();
+
+  uint8_t* data_;
+  std::size_t size_;
+};
+
 }  // namespace storage
 }  // namespace tools
 }  // namespace inspector
\ No newline at end of file
@@ -18,6 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <utility>
+
 #include "tools/common/storage/testing.hpp"
 
 using namespace inspector::tools::storage;
@@ -41,6 +44,15 @@ TEST_F(FileIOTestFixture, TestExists) {
   ASSERT_TRUE(File::exists(kTestFile, tempDir().path()));
 }
 
+TEST_F(FileIOTestFixture, TestSyncIfExists) {
+  ASSERT_TRUE(File::syncIfExists(kTestFile, tempDir().path()));
+  // Missing files and directories are not created.
+  ASSERT_FALSE(File::syncIfExists("no_exist.data", tempDir().path()));
+  ASSERT_FALSE(tempDir().fileExists("no_exist.data"));
+  ASSERT_FALSE(File::syncIfExists(kTestFile, tempDir().path() + "/missing"));
+  ASSERT_FALSE(tempDir().fileExists("missing"));
+}
+
 TEST_F(FileIOTestFixture, TestCtorAndRemove) {
   auto file = File("temp_test.data", tempDir().path());
   // Asserts that file exists
@@ -72,4 +84,30 @@ TEST_F(FileIOTestFixture, TestResize) {
   ASSERT_EQ(file.size(), kTestDataFileSize);
   file.resize(10);
   ASSERT_EQ(file.size(), 10);
-}
\ No newline at end of file
+}
+
+TEST_F(FileIOTestFixture, TestMappedFile) {
+  auto file = File(kTestFile, tempDir().path());
+
+  MappedFile mapping(file);
+  ASSERT_EQ(mapping.size(), kTestDataFileSize);
+  ASSERT_EQ(std::string(reinterpret_cast<const char*>(mapping.data()),
+                        mapping.size()),
+            "testing");
+  mapping.advise(MappedFile::Advice::kSequential, 0, mapping.size());
+  mapping.advise(MappedFile::Advice::kWillNeed, 2, 100);
+
+  // Writes to the file are visible through the mapping
+  file.write("T", 1, 0);
+  ASSERT_EQ(mapping.data()[0], 'T');
+
+  auto moved = std::move(mapping);
+  ASSERT_EQ(moved.size(), kTestDataFileSize);
+  ASSERT_EQ(mapping.data(), nullptr);
+  ASSERT_EQ(mapping.size(), 0);
+
+  auto empty_file = File("empty.data", tempDir().path());
+  MappedFile empty(empty_file);
+  ASSERT_EQ(empty.data(), nullptr);
+  ASSERT_EQ(empty.size(), 0);
+}
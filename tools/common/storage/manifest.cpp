@@ -0,0 +1,175 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/manifest.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tools/common/storage/common.hpp"
+
+namespace inspector {
+namespace tools {
+namespace storage {
+namespace {
+
+/**
+ * @brief Data structure representing the frame of a manifest entry. It
+ * contains the size in bytes and checksum of the serialized entry following
+ * the frame.
+ */
+struct PACKED EntryFrame {
+  uint32_t size;
+  ChecksumType checksum;
+};
+
+/**
+ * @brief Data structure representing the fixed size fields of a serialized
+ * manifest entry. It is followed by the block name and summary.
+ */
+struct PACKED EntryFields {
+  uint64_t index;
+  uint64_t size;
+  CodecType codec;
+  ChecksumType checksum;
+  uint16_t name_size;
+};
+
+/**
+ * @brief Serialize the given entry along with its frame into the buffer.
+ *
+ */
+void serialize(const ManifestEntry& entry, std::vector<uint8_t>& buffer) {
+  EntryFields fields;
+  fields.index = entry.index;
+  fields.size = entry.size;
+  fields.codec = entry.codec;
+  fields.checksum = entry.checksum;
+  fields.name_size = static_cast<uint16_t>(entry.name.size());
+  buffer.resize(sizeof(EntryFrame) + sizeof(fields));
+  std::memcpy(buffer.data() + sizeof(EntryFrame), &fields, sizeof(fields));
+  buffer.insert(buffer.end(), entry.name.begin(), entry.name.end());
+  entry.summary.serialize(buffer);
+
+  EntryFrame frame;
+  frame.size = static_cast<uint32_t>(buffer.size() - sizeof(frame));
+  frame.checksum = checksum(buffer.data() + sizeof(frame), frame.size);
+  std::memcpy(buffer.data(), &frame, sizeof(frame));
+}
+
+/**
+ * @brief Parse the entries serialized in the given data, stopping at the first
+ * torn or corrupt entry.
+ *
+ * @returns Number of bytes of the parsed entries.
+ */
+std::size_t parse(const std::vector<uint8_t>& data,
+                  std::vector<ManifestEntry>& entries) {
+  std::size_t offset = 0;
+  while (data.size() - offset >= sizeof(EntryFrame)) {
+    EntryFrame frame;
+    std::memcpy(&frame, data.data() + offset, sizeof(frame));
+    const auto* const payload = data.data() + offset + sizeof(frame);
+    if (frame.size < sizeof(EntryFields) ||
+        frame.size > data.size() - offset - sizeof(frame) ||
+        checksum(payload, frame.size) != frame.checksum) {
+      break;
+    }
+    EntryFields fields;
+    std::memcpy(&fields, payload, sizeof(fields));
+    if (sizeof(fields) + fields.name_size > frame.size) {
+      break;
+    }
+    ManifestEntry entry;
+    entry.index = fields.index;
+    entry.name.assign(
+        reinterpret_cast<const char*>(payload + sizeof(fields)),
+        fields.name_size);
+    entry.size = fields.size;
+    entry.codec = fields.codec;
+    entry.checksum = fields.checksum;
+    const auto summary_offset = sizeof(fields) + fields.name_size;
+    if (entry.summary.deserialize(payload + summary_offset,
+                                  frame.size - summary_offset) == 0) {
+      break;
+    }
+    entries.push_back(std::move(entry));
+    offset += sizeof(frame) + frame.size;
+  }
+  return offset;
+}
+
+/**
+ * @brief Read all the bytes of the manifest with given name at the given path.
+ *
+ * @returns `true` if the manifest exists else `false`.
+ */
+bool readManifestFile(const std::string& path, const std::string& name,
+                      std::vector<uint8_t>& data) {
+  if (!File::exists(name, path)) {
+    return false;
+  }
+  File file(name, path);
+  data.resize(file.size());
+  data.resize(file.read(data.data(), data.size(), 0));
+  return true;
+}
+
+}  // namespace
+
+const char kManifestName[] = "manifest.inspector";
+
+bool readManifest(const std::string& path, std::vector<ManifestEntry>& entries,
+                  const std::string& name) {
+  entries.clear();
+  std::vector<uint8_t> data;
+  if (!readManifestFile(path, name, data)) {
+    return false;
+  }
+  parse(data, entries);
+  // Blocks written concurrently complete out of order.
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const ManifestEntry& lhs, const ManifestEntry& rhs) {
+                     return lhs.index < rhs.index;
+                   });
+  return true;
+}
+
+// ----------------------------------------------------------------
+// ManifestWriter
+// ----------------------------------------------------------------
+
+ManifestWriter::ManifestWriter(const std::string& path,
+                               const std::string& name)
+    : path_(path), name_(name), size_(0) {
+  if (File::exists(name_, path_)) {
+    File{name_, path_}.resize(0);
+  }
+}
+
+void ManifestWriter::append(const ManifestEntry& entry, const bool sync) {
+  serialize(entry, buffer_);
+  File file(name_, path_);
+  file.write(buffer_.data(), buffer_.size(), size_);
+  if (sync) {
+    file.sync();
+  }
+  size_ += buffer_.size();
+}
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
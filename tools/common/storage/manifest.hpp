@@ -0,0 +1,103 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/block.hpp"
+#include "tools/common/storage/checksum.hpp"
+#include "tools/common/storage/codec.hpp"
+#include "tools/common/storage/file_io.hpp"
+
+namespace inspector {
+namespace tools {
+namespace storage {
+
+/**
+ * @brief Name of the manifest file in a storage directory.
+ *
+ */
+extern const char kManifestName[];
+
+/**
+ * @brief Data structure describing a block listed in a manifest.
+ *
+ */
+struct ManifestEntry {
+  std::size_t index = 0;               //<- Index of the block in write order.
+  std::string name;                    //<- Name of the block file.
+  std::size_t size = 0;                //<- Size in bytes of the block file.
+  CodecType codec = CodecType::kNone;  //<- Codec compressing the block.
+  ChecksumType checksum = 0;           //<- Checksum stored in the header.
+  BlockSummary summary;                //<- Summary of the block records.
+};
+
+/**
+ * @brief Read the manifest of the storage directory at the given path in one
+ * read. Entries of a torn or corrupt tail, e.g. left by a crashed writer, are
+ * ignored.
+ *
+ * @param path Path of the storage directory.
+ * @param entries Reference to store the entries sorted by block index.
+ * @param name Name of the manifest file.
+ * @returns `true` if the directory has a manifest else `false`.
+ */
+bool readManifest(const std::string& path, std::vector<ManifestEntry>& entries,
+                  const std::string& name = kManifestName);
+
+/**
+ * @brief The class `ManifestWriter` appends entries to the manifest of a
+ * storage directory.
+ *
+ * The manifest is append only. Each entry is framed with its size and checksum
+ * and written with a single write at the end of the manifest, so that readers
+ * see either the whole entry or none of it. The manifest file is created with
+ * the first appended entry.
+ *
+ */
+class ManifestWriter {
+ public:
+  /**
+   * @brief Construct a new ManifestWriter object starting a new manifest in
+   * the directory at the given path. Any existing manifest is emptied, as the
+   * blocks it lists are overwritten by the new ones.
+   *
+   * @param path Path of the storage directory.
+   * @param name Name of the manifest file.
+   */
+  explicit ManifestWriter(const std::string& path,
+                          const std::string& name = kManifestName);
+
+  /**
+   * @brief Append the given entry to the manifest.
+   *
+   * @param entry Constant reference to the entry.
+   * @param sync Flag to sync the manifest to disk once written.
+   */
+  void append(const ManifestEntry& entry, const bool sync);
+
+ private:
+  std::string path_;
+  std::string name_;
+  std::size_t size_;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace storage
+}  // namespace tools
+}  // namespace inspector
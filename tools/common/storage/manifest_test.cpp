@@ -0,0 +1,104 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/common/storage/manifest.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/testing.hpp"
+
+using namespace inspector::tools::storage;
+
+namespace {
+
+ManifestEntry makeEntry(const std::size_t index) {
+  ManifestEntry entry;
+  entry.index = index;
+  entry.name = std::to_string(index) + ".inspector";
+  entry.size = 4096 * (index + 1);
+  entry.codec = CodecType::kLz4;
+  entry.checksum = static_cast<ChecksumType>(index * 31);
+  entry.summary.count = index + 1;
+  entry.summary.min_timestamp = static_cast<timestamp_t>(10 * index);
+  entry.summary.max_timestamp = static_cast<timestamp_t>(10 * index + 9);
+  return entry;
+}
+
+}  // namespace
+
+class ManifestTestFixture : public TestHarness, public ::testing::Test {};
+
+TEST_F(ManifestTestFixture, TestReadMissingManifest) {
+  std::vector<ManifestEntry> entries;
+  ASSERT_FALSE(readManifest(tempDir().path(), entries));
+  ASSERT_TRUE(entries.empty());
+  ManifestWriter writer(tempDir().path());
+  ASSERT_FALSE(tempDir().fileExists(kManifestName));
+}
+
+TEST_F(ManifestTestFixture, TestAppendAndRead) {
+  {
+    // Entries appended out of order are read back in block order.
+    ManifestWriter writer(tempDir().path());
+    for (const std::size_t index : {1, 0, 2}) {
+      writer.append(makeEntry(index), false);
+    }
+  }
+
+  std::vector<ManifestEntry> entries;
+  ASSERT_TRUE(readManifest(tempDir().path(), entries));
+  ASSERT_EQ(entries.size(), 3);
+  for (std::size_t index = 0; index < entries.size(); ++index) {
+    const auto expected = makeEntry(index);
+    ASSERT_EQ(entries[index].index, expected.index);
+    ASSERT_EQ(entries[index].name, expected.name);
+    ASSERT_EQ(entries[index].size, expected.size);
+    ASSERT_EQ(entries[index].codec, expected.codec);
+    ASSERT_EQ(entries[index].checksum, expected.checksum);
+    ASSERT_EQ(entries[index].summary.count, expected.summary.count);
+    ASSERT_EQ(entries[index].summary.min_timestamp,
+              expected.summary.min_timestamp);
+    ASSERT_EQ(entries[index].summary.max_timestamp,
+              expected.summary.max_timestamp);
+  }
+}
+
+TEST_F(ManifestTestFixture, TestTornTailIsIgnored) {
+  {
+    ManifestWriter writer(tempDir().path());
+    writer.append(makeEntry(0), false);
+    writer.append(makeEntry(1), false);
+  }
+  // Tear the last entry as if the writer crashed while appending it.
+  const auto size = tempDir().readFile(kManifestName).size();
+  File{kManifestName, tempDir().path()}.resize(size - 3);
+
+  std::vector<ManifestEntry> entries;
+  ASSERT_TRUE(readManifest(tempDir().path(), entries));
+  ASSERT_EQ(entries.size(), 1);
+
+  // A new writer starts a new manifest.
+  ManifestWriter writer(tempDir().path());
+  ASSERT_TRUE(readManifest(tempDir().path(), entries));
+  ASSERT_TRUE(entries.empty());
+  writer.append(makeEntry(0), false);
+  ASSERT_TRUE(readManifest(tempDir().path(), entries));
+  ASSERT_EQ(entries.size(), 1);
+  ASSERT_EQ(entries.back().name, "0.inspector");
+}
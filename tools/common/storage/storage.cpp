@@ -16,109 +16,1338 @@
 
 #include "tools/common/storage/storage.hpp"
 
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include "tools/common/storage/async_io.hpp"
 
 namespace inspector {
 namespace tools {
 namespace storage {
 
+namespace {
+
+/**
+ * @brief Prefix of the directory names of shards.
+ *
+ */
+constexpr char kShardPrefix[] = "shard-";
+
+/**
+ * @brief Prefix of the directory names of segments.
+ *
+ */
+constexpr char kSegmentPrefix[] = "segment-";
+
+/**
+ * @brief Parse the index in the given directory name having the given prefix.
+ *
+ * @param name Name of the directory.
+ * @param prefix Prefix of the name followed by the index.
+ * @param index Reference to store the index.
+ * @returns `true` if the name has the prefix and an index else `false`.
+ */
+bool parseIndexedName(const std::string& name, const std::string& prefix,
+                      std::size_t& index) {
+  if (name.size() <= prefix.size() ||
+      name.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  index = 0;
+  for (auto i = prefix.size(); i < name.size(); ++i) {
+    if (name[i] < '0' || name[i] > '9') {
+      return false;
+    }
+    index = index * 10 + (name[i] - '0');
+  }
+  return true;
+}
+
+/**
+ * @brief Parse the index of the shard with the given directory name.
+ *
+ * @param name Name of the directory.
+ * @param shard Reference to store the shard index.
+ * @returns `true` if the directory is a shard else `false`.
+ */
+bool parseShardName(const std::string& name, std::size_t& shard) {
+  return parseIndexedName(name, kShardPrefix, shard);
+}
+
+/**
+ * @brief Check if the given path is a directory.
+ *
+ */
+bool isDirectory(const std::string& path) {
+  struct stat buffer;
+  return ::stat(path.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode);
+}
+
+/**
+ * @brief Data structure identifying a block file along with the time range of
+ * its records, which is unbounded if unknown. Reads of the block start at the
+ * first record at or after the given timestamp.
+ *
+ */
+struct BlockFile {
+  std::string name;
+  std::string path;
+  timestamp_t begin = std::numeric_limits<timestamp_t>::min();
+  timestamp_t min_timestamp = std::numeric_limits<timestamp_t>::min();
+  timestamp_t max_timestamp = std::numeric_limits<timestamp_t>::max();
+};
+
+/**
+ * @brief List the blocks stored at the given path in the order written. Blocks
+ * are listed from the manifest of the directory, or else by probing the blocks
+ * in order up to the first missing one, with their time range read from their
+ * footer.
+ *
+ */
+std::vector<BlockFile> listBlocks(const std::string& path) {
+  std::vector<BlockFile> blocks;
+  std::vector<ManifestEntry> entries;
+  if (readManifest(path, entries)) {
+    for (auto& entry : entries) {
+      blocks.push_back({std::move(entry.name), path});
+      blocks.back().min_timestamp = entry.summary.min_timestamp;
+      blocks.back().max_timestamp = entry.summary.max_timestamp;
+    }
+    return blocks;
+  }
+  while (true) {
+    auto name = std::to_string(blocks.size()) + kFileExtension;
+    if (!File::exists(name, path)) {
+      return blocks;
+    }
+    blocks.push_back({std::move(name), path});
+    BlockSummary summary;
+    if (readSummary(File{blocks.back().name, path}, summary)) {
+      blocks.back().min_timestamp = summary.min_timestamp;
+      blocks.back().max_timestamp = summary.max_timestamp;
+    }
+  }
+}
+
+}  // namespace
+
+// ------------------------------------------------
+// Topics
+// ------------------------------------------------
+
+std::string topicPath(const std::string& path, const std::string& topic) {
+  return path + "/" + topic;
+}
+
+std::vector<std::string> listTopics(const std::string& path) {
+  std::vector<std::string> topics;
+  auto* dir = ::opendir(path.c_str());
+  if (dir == nullptr) {
+    return topics;
+  }
+  const auto first_block = std::to_string(0) + kFileExtension;
+  while (const auto* entry = ::readdir(dir)) {
+    const std::string name = entry->d_name;
+    std::size_t index;
+    if (name == "." || name == ".." || parseShardName(name, index) ||
+        parseIndexedName(name, kSegmentPrefix, index)) {
+      continue;
+    }
+    const auto topic_path = topicPath(path, name);
+    if (isDirectory(topic_path) &&
+        (File::exists(kManifestName, topic_path) ||
+         File::exists(first_block, topic_path))) {
+      topics.emplace_back(name);
+    }
+  }
+  ::closedir(dir);
+  std::sort(topics.begin(), topics.end());
+  return topics;
+}
+
+// ------------------------------------------------
+// Shards
+// ------------------------------------------------
+
+std::string shardPath(const std::string& path, const std::size_t shard) {
+  return path + "/" + kShardPrefix + std::to_string(shard);
+}
+
+std::vector<std::string> listShards(const std::string& path) {
+  std::vector<std::pair<std::size_t, std::string>> shards;
+  auto* dir = ::opendir(path.c_str());
+  if (dir == nullptr) {
+    return {};
+  }
+  while (const auto* entry = ::readdir(dir)) {
+    std::size_t shard;
+    if (parseShardName(entry->d_name, shard) &&
+        isDirectory(shardPath(path, shard))) {
+      shards.emplace_back(shard, shardPath(path, shard));
+    }
+  }
+  ::closedir(dir);
+  std::sort(shards.begin(), shards.end());
+  std::vector<std::string> paths;
+  for (auto& shard : shards) {
+    paths.emplace_back(std::move(shard.second));
+  }
+  return paths;
+}
+
+// ------------------------------------------------
+// Segments
+// ------------------------------------------------
+
+const char kSegmentIndexName[] = "segments.inspector";
+
+std::string segmentPath(const std::string& path, const std::size_t segment) {
+  return path + "/" + kSegmentPrefix + std::to_string(segment);
+}
+
+bool readSegments(const std::string& path,
+                  std::vector<ManifestEntry>& segments) {
+  return readManifest(path, segments, kSegmentIndexName);
+}
+
+// ------------------------------------------------
+// Index
+// ------------------------------------------------
+
+DirectoryIndex readIndex(const std::string& path) {
+  DirectoryIndex index;
+  if (!readManifest(path, index.blocks)) {
+    for (auto& block : listBlocks(path)) {
+      ManifestEntry entry;
+      entry.index = index.blocks.size();
+      entry.name = std::move(block.name);
+      File file(entry.name, path);
+      entry.size = file.size();
+      if (!readSummary(file, entry.summary)) {
+        entry.summary = BlockSummary::unknown();
+      }
+      index.blocks.push_back(std::move(entry));
+    }
+  }
+  for (const auto& block : index.blocks) {
+    index.summary.merge(block.summary);
+  }
+  return index;
+}
+
+bool ReadFilter::empty() const {
+  return begin == std::numeric_limits<timestamp_t>::min() &&
+         end == std::numeric_limits<timestamp_t>::max() && types.empty() &&
+         pids.empty() && tids.empty();
+}
+
+bool ReadFilter::matches(const BlockSummary& summary) const {
+  if (!summary.overlaps(begin, end)) {
+    return false;
+  }
+  if (!summary.tagged) {
+    return true;
+  }
+  const auto intersects = [](const std::vector<int32_t>& ids,
+                             const std::vector<int32_t>& sorted_ids) {
+    return ids.empty() ||
+           std::any_of(ids.begin(), ids.end(), [&sorted_ids](const auto id) {
+             return std::binary_search(sorted_ids.begin(), sorted_ids.end(),
+                                       id);
+           });
+  };
+  return (types.empty() ||
+          std::any_of(types.begin(), types.end(),
+                      [&summary](const auto type) {
+                        return summary.type_counts.count(type) != 0;
+                      })) &&
+         intersects(pids, summary.pids) && intersects(tids, summary.tids);
+}
+
+bool ReadFilter::matches(const Record& record) const {
+  if (record.timestamp < begin || record.timestamp > end) {
+    return false;
+  }
+  if (!classifier || (types.empty() && pids.empty() && tids.empty())) {
+    return true;
+  }
+  const auto contains = [](const auto& values, const auto value) {
+    return values.empty() ||
+           std::find(values.begin(), values.end(), value) != values.end();
+  };
+  const auto tags = classifier(record);
+  return contains(types, tags.type) && contains(pids, tags.pid) &&
+         contains(tids, tags.tid);
+}
+
 // ------------------------------------------------
 // Writer
 // ------------------------------------------------
 
-Writer::Writer(const std::string& path, const std::size_t block_size)
-    : path_(path), builder_(block_size), num_blocks_(0) {}
+namespace {
+
+/**
+ * @brief Create the manifest entry of the written block with given index.
+ *
+ */
+ManifestEntry manifestEntry(const std::size_t index, const BlockInfo& info,
+                            BlockSummary&& summary) {
+  ManifestEntry entry;
+  entry.index = index;
+  entry.name = std::to_string(index) + kFileExtension;
+  entry.size = info.size;
+  entry.codec = info.codec;
+  entry.checksum = info.checksum;
+  entry.summary = std::move(summary);
+  return entry;
+}
+
+}  // namespace
+
+/**
+ * @brief The data structure `SyncState` tracks the blocks written but not yet
+ * synced to disk, and syncs them at the points set by the durability policy.
+ * A block is synced by reopening its file, as syncing applies to the file and
+ * not to the descriptor it was written through. Files are reopened without
+ * being created, so that blocks removed since being written are skipped. The
+ * state is shared between the write stage thread and the thread flushing the
+ * writer.
+ *
+ */
+struct Writer::SyncState {
+  using Clock = std::chrono::steady_clock;
+
+  SyncState(const std::string& path, const DurabilityPolicy& policy)
+      : path(path), policy(policy), last_sync(Clock::now()) {}
+
+  /**
+   * @brief Check if every block is synced as part of its write, in which case
+   * no block is tracked.
+   *
+   */
+  bool syncsEachBlock() const {
+    return policy.sync == DurabilityPolicy::Sync::kBlocks &&
+           policy.blocks <= 1;
+  }
+
+  /**
+   * @brief Track the written block with given index, syncing the tracked
+   * blocks if due.
+   *
+   */
+  void written(const std::size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    unsynced.push_back(index);
+    if (isDue()) {
+      syncLocked();
+    }
+  }
+
+  /**
+   * @brief Sync the tracked blocks if the sync interval has elapsed.
+   *
+   */
+  void poll() {
+    if (policy.sync != DurabilityPolicy::Sync::kInterval) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!unsynced.empty() && isDue()) {
+      syncLocked();
+    }
+  }
+
+  /**
+   * @brief Sync all the tracked blocks unless syncs are left to the kernel.
+   *
+   */
+  void syncAll() {
+    if (policy.sync == DurabilityPolicy::Sync::kNone) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    syncLocked();
+  }
+
+  /**
+   * @brief Get the time at which the tracked blocks are next due for an
+   * interval sync, or the maximum time point if none is.
+   *
+   */
+  Clock::time_point nextSync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (policy.sync != DurabilityPolicy::Sync::kInterval || unsynced.empty()) {
+      return Clock::time_point::max();
+    }
+    return last_sync + policy.interval;
+  }
+
+  bool isDue() const {
+    switch (policy.sync) {
+      case DurabilityPolicy::Sync::kBlocks:
+        return unsynced.size() >= policy.blocks;
+      case DurabilityPolicy::Sync::kInterval:
+        return Clock::now() - last_sync >= policy.interval;
+      default:
+        return false;
+    }
+  }
+
+  void syncLocked() {
+    // Blocks failing to sync are kept and retried by the next sync. The
+    // manifest listing the blocks is synced after them.
+    while (!unsynced.empty()) {
+      File::syncIfExists(std::to_string(unsynced.back()) + kFileExtension,
+                         path);
+      unsynced.pop_back();
+      manifest_unsynced = true;
+    }
+    if (manifest_unsynced) {
+      File::syncIfExists(kManifestName, path);
+      manifest_unsynced = false;
+    }
+    last_sync = Clock::now();
+  }
+
+  const std::string path;
+  const DurabilityPolicy policy;
+  std::mutex mutex;
+  std::vector<std::size_t> unsynced;
+  bool manifest_unsynced = false;
+  Clock::time_point last_sync;
+};
+
+/**
+ * @brief The data structure `WriteStage` owns the thread writing full blocks to
+ * disk. Sealed blocks are queued to the thread, which submits them to an
+ * asynchronous writer so that multiple blocks are written and synced at once.
+ * Buffers of written blocks are returned to the builder for reuse. Blocks are
+ * compressed by the thread before being submitted, in which case the buffers
+ * of compressed blocks are kept by the thread for reuse instead. Written blocks
+ * are appended to the manifest by the thread as they complete.
+ *
+ * The thread never polls. It blocks reaping the writes in flight when there
+ * are any, or else on the queue of sealed blocks until the next interval sync
+ * is due.
+ *
+ */
+struct Writer::WriteStage {
+  struct Block {
+    std::size_t index = 0;
+    BlockBuffer buffer;
+    BlockSummary summary;
+  };
+
+  WriteStage(const std::string& path, const std::size_t max_pending_blocks,
+             SyncState& sync, ManifestWriter& manifest, const CodecType codec)
+      : path(path),
+        sync(sync),
+        manifest(manifest),
+        codec(codec),
+        pending(max_pending_blocks),
+        free(2 * max_pending_blocks + 1),
+        io(max_pending_blocks),
+        written(0),
+        thread(&WriteStage::run, this) {}
 
-Writer::~Writer() { flush(); }
+  ~WriteStage() {
+    pending.close();
+    thread.join();
+  }
+
+  void run() {
+    Block block;
+    std::vector<AsyncWriter::Completion> completions;
+    while (true) {
+      while (!io.full() && pending.tryPop(block)) {
+        submit(block);
+      }
+      if (io.inFlight()) {
+        io.reap(completions, true);
+        for (auto& completion : completions) {
+          complete(completion.tag, std::move(completion.buffer),
+                   completion.error);
+        }
+        completions.clear();
+      }
+      try {
+        sync.poll();
+      } catch (...) {
+        setError(std::current_exception());
+      }
+      if (io.inFlight()) {
+        continue;
+      }
+      if (pending.closed() && pending.empty()) {
+        return;
+      }
+      const auto deadline = sync.nextSync();
+      if (deadline == SyncState::Clock::time_point::max()
+              ? pending.pop(block)
+              : pending.popUntil(block, deadline)) {
+        submit(block);
+      }
+    }
+  }
+
+  void submit(Block& block) {
+    try {
+      summaries[block.index] = std::move(block.summary);
+      encode(block);
+      File file(std::to_string(block.index) + kFileExtension, path,
+                sync.policy.direct);
+      io.submit(std::move(file), std::move(block.buffer),
+                sync.syncsEachBlock(), block.index);
+    } catch (...) {
+      complete(block.index, std::move(block.buffer), std::current_exception());
+    }
+  }
+
+  void encode(Block& block) {
+    if (codec == CodecType::kNone) {
+      return;
+    }
+    BlockBuffer encoded;
+    if (!spares.empty()) {
+      encoded = std::move(spares.back());
+      spares.pop_back();
+    }
+    encodeBlock(block.buffer, codec, encoded);
+    std::swap(block.buffer, encoded);
+    free.tryPush(std::move(encoded));
+  }
+
+  void recycle(BlockBuffer&& buffer) {
+    if (codec == CodecType::kNone) {
+      free.tryPush(std::move(buffer));
+    } else {
+      spares.push_back(std::move(buffer));
+    }
+  }
+
+  void complete(const std::size_t index, BlockBuffer&& buffer,
+                const std::exception_ptr& write_error) {
+    auto summary = std::move(summaries[index]);
+    summaries.erase(index);
+    if (write_error) {
+      setError(write_error);
+    } else {
+      try {
+        manifest.append(
+            manifestEntry(index, blockInfo(buffer), std::move(summary)),
+            sync.syncsEachBlock());
+        if (!sync.syncsEachBlock()) {
+          sync.written(index);
+        }
+      } catch (...) {
+        setError(std::current_exception());
+      }
+    }
+    recycle(std::move(buffer));
+    {
+      std::lock_guard<std::mutex> lock(written_mutex);
+      ++written;
+    }
+    written_condition.notify_all();
+  }
+
+  /**
+   * @brief Wait until the given number of blocks have been written.
+   *
+   */
+  void waitWritten(const std::size_t count) {
+    std::unique_lock<std::mutex> lock(written_mutex);
+    written_condition.wait(lock, [this, count]() { return written == count; });
+  }
+
+  void setError(const std::exception_ptr& stage_error) {
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (!error) {
+      error = stage_error;
+    }
+  }
+
+  void rethrowError() {
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (error) {
+      auto current = error;
+      error = nullptr;
+      std::rethrow_exception(current);
+    }
+  }
+
+  const std::string path;
+  SyncState& sync;
+  ManifestWriter& manifest;
+  const CodecType codec;
+  BoundedQueue<Block> pending;      //<- Builder to write stage.
+  BoundedQueue<BlockBuffer> free;   //<- Write stage to builder.
+  std::vector<BlockBuffer> spares;  //<- Buffers of compressed blocks.
+  std::unordered_map<std::size_t, BlockSummary> summaries;  //<- In flight.
+  AsyncWriter io;
+  std::size_t written;  //<- Guarded by the written mutex.
+  std::mutex written_mutex;
+  std::condition_variable written_condition;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  std::thread thread;
+};
+
+DurabilityPolicy::Sync parseSync(const std::string& name) {
+  if (name == "none") {
+    return DurabilityPolicy::Sync::kNone;
+  }
+  if (name == "blocks") {
+    return DurabilityPolicy::Sync::kBlocks;
+  }
+  if (name == "interval") {
+    return DurabilityPolicy::Sync::kInterval;
+  }
+  if (name == "close") {
+    return DurabilityPolicy::Sync::kOnClose;
+  }
+  throw std::invalid_argument("Unknown sync point '" + name + "'.");
+}
+
+Writer::Writer(const std::string& path, const std::size_t block_size,
+               const std::size_t max_pending_blocks,
+               const DurabilityPolicy& durability, const CodecType codec,
+               const RecordClassifier classifier)
+    : path_(path),
+      builder_(durability.direct ? (block_size + kBlockAlignment - 1) /
+                                       kBlockAlignment * kBlockAlignment
+                                 : block_size,
+               codec, classifier),
+      manifest_(path),
+      num_blocks_(0),
+      sync_(std::make_unique<SyncState>(path, durability)),
+      stage_(max_pending_blocks
+                 ? std::make_unique<WriteStage>(path, max_pending_blocks,
+                                                *sync_, manifest_, codec)
+                 : nullptr) {}
+
+Writer::~Writer() {
+  try {
+    flush();
+  } catch (const std::exception&) {
+    // Errors are reported by explicit calls to flush.
+  }
+}
 
 void Writer::write(const Record& record) {
   if (!builder_.add(record)) {
-    flush();
+    seal();
     assert(builder_.count() == 0);
     builder_.add(record);
   }
 }
 
+void Writer::write(const Record* const records, const std::size_t count) {
+  std::size_t index = 0;
+  while (index < count) {
+    const auto added = builder_.add(records + index, count - index);
+    index += added;
+    if (index == count) {
+      break;
+    }
+    if (builder_.count() == 0) {
+      // Records larger than the block are dropped, as for single writes.
+      ++index;
+      continue;
+    }
+    seal();
+  }
+}
+
 void Writer::flush() {
-  if (builder_.count() != 0) {
-    File file(std::to_string(num_blocks_) + kFileExtension, path_);
-    builder_.flush(file);
-    ++num_blocks_;
+  seal();
+  if (stage_) {
+    stage_->waitWritten(num_blocks_);
+    stage_->rethrowError();
+  }
+  sync_->syncAll();
+}
+
+BackpressureMetrics Writer::metrics() const {
+  return stage_ ? stage_->pending.metrics() : BackpressureMetrics{};
+}
+
+// private
+void Writer::seal() {
+  if (builder_.count() == 0) {
+    return;
+  }
+  auto summary = builder_.summary();
+  if (!stage_) {
+    const auto index = num_blocks_++;
+    File file(std::to_string(index) + kFileExtension, path_,
+              sync_->policy.direct);
+    const auto info = builder_.flush(file, sync_->syncsEachBlock());
+    manifest_.append(manifestEntry(index, info, std::move(summary)),
+                     sync_->syncsEachBlock());
+    if (!sync_->syncsEachBlock()) {
+      sync_->written(index);
+    }
+    return;
   }
+  stage_->rethrowError();
+  WriteStage::Block block;
+  block.index = num_blocks_++;
+  block.summary = std::move(summary);
+  // Buffers of written blocks are reused, a new one is allocated only while
+  // the write stage has not returned any yet.
+  stage_->free.tryPop(block.buffer);
+  builder_.seal(block.buffer);
+  stage_->pending.push(std::move(block));
 }
 
 // ------------------------------------------------
 // Reader
 // ------------------------------------------------
 
-Reader::Iterator::BlockReaderWrapper::BlockReaderWrapper(BlockReader&& _reader)
-    : reader(std::move(_reader)), it(reader.begin()) {}
+namespace {
+
+/**
+ * @brief Minimum number of bytes of a block held in memory at a time while
+ * merging. Bounds the number of blocks merged at once for a memory budget.
+ *
+ */
+constexpr std::size_t kMinChunkSize = 64 * 1024;  // 64KB
+
+/**
+ * @brief Maximum number of bytes of a block held in memory at a time while
+ * merging. Records are consumed in order, thus larger chunks only add to the
+ * memory touched by the merge.
+ *
+ */
+constexpr std::size_t kMaxChunkSize = 256 * 1024;  // 256KB
+
+/**
+ * @brief Minimum number of runs merged at once for blocks to be prefetched.
+ * Merges of fewer runs spend little time opening blocks, and are slowed down
+ * by handing the blocks over between threads.
+ *
+ */
+constexpr std::size_t kMinPrefetchRuns = 32;
+
+/**
+ * @brief Bounds on the size of the blocks of temporary runs.
+ *
+ */
+constexpr std::size_t kMinRunBlockSize = 1024 * 1024;       // 1MB
+constexpr std::size_t kMaxRunBlockSize = 64 * 1024 * 1024;  // 64MB
+
+/**
+ * @brief Sequence of blocks whose records are in chronological order across
+ * the blocks, e.g. a temporary run or consecutive blocks of a source which do
+ * not overlap in time.
+ *
+ */
+using Run = std::vector<BlockFile>;
 
-bool Reader::Iterator::BlockReaderWrapperPtrCompare::operator()(
-    const BlockReaderWrapperPtr& lhs, const BlockReaderWrapperPtr& rhs) const {
-  return lhs->it->timestamp >= rhs->it->timestamp;
+/**
+ * @brief List the blocks stored at the given path matching the given filter,
+ * in the order written. Reads of the listed blocks start at the beginning of
+ * the time range of the filter.
+ *
+ */
+std::vector<BlockFile> listBlocks(const std::string& path,
+                                  const ReadFilter& filter) {
+  if (filter.empty()) {
+    return listBlocks(path);
+  }
+  const auto index = readIndex(path);
+  std::vector<BlockFile> blocks;
+  if (!filter.matches(index.summary)) {
+    return blocks;
+  }
+  for (const auto& block : index.blocks) {
+    if (filter.matches(block.summary)) {
+      blocks.push_back({block.name, path});
+      blocks.back().min_timestamp = block.summary.min_timestamp;
+      blocks.back().max_timestamp = block.summary.max_timestamp;
+      if (block.summary.min_timestamp < filter.begin) {
+        blocks.back().begin = filter.begin;
+      }
+    }
+  }
+  return blocks;
+}
+
+/**
+ * @brief List the blocks of the given segments of the compacted storage at the
+ * given path matching the given filter. The segments are in time order and do
+ * not overlap, so that the first segment in the time range of the filter is
+ * found by binary search and the listed blocks form a single run.
+ *
+ */
+Run listSegmentBlocks(const std::string& path,
+                      const std::vector<ManifestEntry>& segments,
+                      const ReadFilter& filter) {
+  Run run;
+  auto segment = std::partition_point(
+      segments.begin(), segments.end(), [&filter](const ManifestEntry& entry) {
+        return entry.summary.max_timestamp < filter.begin;
+      });
+  for (; segment != segments.end() &&
+         segment->summary.min_timestamp <= filter.end;
+       ++segment) {
+    if (!filter.matches(segment->summary)) {
+      continue;
+    }
+    auto blocks = listBlocks(path + "/" + segment->name, filter);
+    run.insert(run.end(), std::make_move_iterator(blocks.begin()),
+               std::make_move_iterator(blocks.end()));
+  }
+  return run;
 }
 
+/**
+ * @brief Chain the given blocks of a source, in the order written, into runs.
+ * Consecutive blocks are chained into the same run while each starts no
+ * earlier than the previous one ends, so that only the blocks overlapping in
+ * time are merged. Blocks of unknown time range are runs of their own.
+ *
+ */
+std::vector<Run> chainBlocks(std::vector<BlockFile>&& blocks) {
+  std::vector<Run> runs;
+  for (auto& block : blocks) {
+    if (runs.empty() ||
+        block.min_timestamp < runs.back().back().max_timestamp) {
+      runs.emplace_back();
+    }
+    runs.back().push_back(std::move(block));
+  }
+  return runs;
+}
+
+/**
+ * @brief Create a new temporary directory for the runs of a merge.
+ *
+ */
+std::string makeTempDirectory() {
+  const auto* const tmp = std::getenv("TMPDIR");
+  std::string path = std::string(tmp && *tmp ? tmp : "/tmp") +
+                     "/inspector-merge-XXXXXX";
+  if (::mkdtemp(&path[0]) == nullptr) {
+    throw std::system_error(
+        errno, std::generic_category(),
+        "Error creating temporary directory '" + path + "': ");
+  }
+  return path;
+}
+
+/**
+ * @brief Remove the directory at the given path along with its contents.
+ *
+ */
+void removeDirectory(const std::string& path) {
+  auto* const dir = ::opendir(path.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  while (const auto* const entry = ::readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    const auto child = path + "/" + name;
+    if (isDirectory(child)) {
+      removeDirectory(child);
+    } else {
+      ::unlink(child.c_str());
+    }
+  }
+  ::closedir(dir);
+  ::rmdir(path.c_str());
+}
+
+/**
+ * @brief Open a cursor over the records of the given block. Opening reads and
+ * verifies the metadata of the block, then reads the first chunk of the block
+ * a frame at a time. No cursor is opened for blocks missing from disk, e.g.
+ * deleted after being listed in the manifest.
+ *
+ */
+std::unique_ptr<BlockCursor> openBlock(const BlockFile& block,
+                                       const std::size_t chunk_size) {
+  if (!File::exists(block.name, block.path)) {
+    return nullptr;
+  }
+  return std::make_unique<BlockCursor>(File{block.name, block.path},
+                                       chunk_size, block.begin);
+}
+
+/**
+ * @brief The class `BlockPrefetcher` opens blocks on a pool of background
+ * threads, so that the next block of a run is ready by the time the merge
+ * exhausts the current one.
+ *
+ */
+class BlockPrefetcher {
+ public:
+  using Future = std::future<std::unique_ptr<BlockCursor>>;
+
+  explicit BlockPrefetcher(const std::size_t threads) : stop_(false) {
+    for (std::size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this]() { run(); });
+    }
+  }
+
+  ~BlockPrefetcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  /**
+   * @brief Schedule opening the given block. Errors opening the block are
+   * rethrown when getting the cursor from the returned future.
+   *
+   */
+  Future prefetch(const BlockFile& block, const std::size_t chunk_size) {
+    Task task([block, chunk_size]() { return openBlock(block, chunk_size); });
+    auto future = task.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+ private:
+  using Task = std::packaged_task<std::unique_ptr<BlockCursor>()>;
+
+  void run() {
+    while (true) {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+        if (stop_) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Task> tasks_;
+  bool stop_;
+  std::vector<std::thread> threads_;
+};
+
+/**
+ * @brief The class `RunCursor` streams the records of a run, reading one block
+ * at a time. The next block of the run is opened in the background when a
+ * prefetcher is given. Blocks failing checksum verification are skipped and
+ * counted in the given counter, including blocks ended early by a corrupt
+ * frame.
+ *
+ */
+class RunCursor {
+ public:
+  RunCursor(Run run, const std::size_t chunk_size,
+            BlockPrefetcher* const prefetcher,
+            std::atomic<std::size_t>* const corrupt_blocks)
+      : run_(std::move(run)),
+        chunk_size_(chunk_size),
+        prefetcher_(prefetcher),
+        corrupt_blocks_(corrupt_blocks),
+        next_block_(0) {
+    prefetch();
+  }
+
+  /**
+   * @brief Open the first non-empty block of the run, skipping missing ones.
+   *
+   */
+  void open() {
+    cursor_.reset();
+    while (pending_.valid() || next_block_ < run_.size()) {
+      cursor_ = pending_.valid() ? pending_.get()
+                                 : openBlock(run_[next_block_++], chunk_size_);
+      prefetch();
+      if (cursor_ && cursor_->isCorrupt()) {
+        corrupt_blocks_->fetch_add(1, std::memory_order_relaxed);
+      }
+      if (cursor_ && cursor_->valid()) {
+        return;
+      }
+    }
+    cursor_.reset();
+  }
+
+  bool valid() const { return cursor_ && cursor_->valid(); }
+
+  const Record& record() const { return cursor_->record(); }
+
+  void next() {
+    cursor_->next();
+    if (!cursor_->valid()) {
+      if (cursor_->isCorrupt()) {
+        corrupt_blocks_->fetch_add(1, std::memory_order_relaxed);
+      }
+      open();
+    }
+  }
+
+ private:
+  void prefetch() {
+    if (prefetcher_ && next_block_ < run_.size()) {
+      pending_ = prefetcher_->prefetch(run_[next_block_++], chunk_size_);
+    }
+  }
+
+  Run run_;
+  std::size_t chunk_size_;
+  BlockPrefetcher* prefetcher_;
+  std::atomic<std::size_t>* corrupt_blocks_;
+  std::size_t next_block_;
+  std::unique_ptr<BlockCursor> cursor_;
+  BlockPrefetcher::Future pending_;
+};
+
+/**
+ * @brief The class `RunMerger` merges the records of multiple runs into a
+ * single chronologically ordered stream.
+ *
+ * The runs are merged using a tournament tree of losers. Leaves of the tree
+ * are the runs while each internal node holds the run losing the match played
+ * at the node, and the overall winner is kept at the root. Advancing the
+ * winner replays only the matches on the path from its leaf to the root, i.e.
+ * one comparison per level and no reordering of a heap.
+ *
+ */
+class RunMerger {
+ public:
+  RunMerger(std::vector<Run>&& runs, const std::size_t chunk_size,
+            BlockPrefetcher* const prefetcher,
+            std::atomic<std::size_t>* const corrupt_blocks)
+      : keys_(runs.size()),
+        tree_(std::max<std::size_t>(runs.size(), 1), kNone) {
+    cursors_.reserve(runs.size());
+    for (auto& run : runs) {
+      cursors_.emplace_back(std::move(run), chunk_size, prefetcher,
+                            corrupt_blocks);
+    }
+    // First blocks of all the runs are prefetched before any is waited on.
+    for (std::size_t run = 0; run < cursors_.size(); ++run) {
+      cursors_[run].open();
+      updateKey(run);
+    }
+    for (std::size_t run = 0; run < cursors_.size(); ++run) {
+      replay(run);
+    }
+  }
+
+  bool valid() const { return !cursors_.empty() && keys_[tree_[0]].valid; }
+
+  const Record& record() const { return cursors_[tree_[0]].record(); }
+
+  void next() {
+    const auto winner = tree_[0];
+    cursors_[winner].next();
+    updateKey(winner);
+    replay(winner);
+  }
+
+ private:
+  static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+  /**
+   * @brief Key of the current record of a run, copied out of the cursor so
+   * that the matches do not chase pointers into the blocks.
+   *
+   */
+  struct Key {
+    timestamp_t timestamp = 0;
+    bool valid = false;
+  };
+
+  void updateKey(const std::size_t run) {
+    auto& key = keys_[run];
+    key.valid = cursors_[run].valid();
+    if (key.valid) {
+      key.timestamp = cursors_[run].record().timestamp;
+    }
+  }
+
+  /**
+   * @brief Check if the given run wins against the other. Exhausted runs lose
+   * against all others, and ties are won by the run listed first so that
+   * records with equal timestamps keep the order of the runs.
+   *
+   */
+  bool wins(const std::size_t run, const std::size_t other) const {
+    const auto& lhs = keys_[run];
+    const auto& rhs = keys_[other];
+    if (!lhs.valid || !rhs.valid) {
+      return lhs.valid;
+    }
+    return lhs.timestamp < rhs.timestamp ||
+           (lhs.timestamp == rhs.timestamp && run < other);
+  }
+
+  /**
+   * @brief Replay the matches from the leaf of the given run up to the root.
+   * While the tree is being built, the first run reaching an internal node
+   * waits there for its opponent.
+   *
+   */
+  void replay(std::size_t winner) {
+    const auto leaves = cursors_.size();
+    for (auto node = (winner + leaves) / 2; node > 0; node /= 2) {
+      if (tree_[node] == kNone) {
+        tree_[node] = winner;
+        return;
+      }
+      if (wins(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+  std::vector<RunCursor> cursors_;
+  std::vector<Key> keys_;
+  std::vector<std::size_t> tree_;
+};
+
+/**
+ * @brief Write the records merged by the given merger into a new run at the
+ * given path.
+ *
+ */
+Run writeRun(RunMerger& merger, const std::string& path,
+             const std::size_t block_size) {
+  {
+    // Temporary runs are not synced, as they do not outlive the reader.
+    DurabilityPolicy durability;
+    durability.sync = DurabilityPolicy::Sync::kNone;
+    Writer writer(path, block_size, 0, durability);
+    for (; merger.valid(); merger.next()) {
+      writer.write(merger.record());
+    }
+    writer.flush();
+  }
+  return listBlocks(path);
+}
+
+}  // namespace
+
+/**
+ * @brief The data structure `MergeState` holds the merge of the runs read by
+ * an iterator, along with the threads prefetching blocks and the temporary
+ * directory of the runs created by the passes of a multi-pass merge.
+ *
+ */
+struct Reader::Iterator::MergeState {
+  ReadFilter filter;
+  std::string temp_dir;
+  std::unique_ptr<BlockPrefetcher> prefetcher;
+  std::unique_ptr<RunMerger> merger;
+
+  ~MergeState() {
+    merger.reset();
+    if (!temp_dir.empty()) {
+      removeDirectory(temp_dir);
+    }
+  }
+};
+
 // private
 Reader::Iterator::Iterator(const Reader& reader, bool end)
-    : path_(reader.path_),
-      mode_(reader.mode_),
-      max_blocks_(reader.max_blocks_),
-      num_blocks_(0) {
-  if (!end) {
-    updateQueue();
-    updateRecord();
+    : path_(reader.path_), mode_(reader.mode_) {
+  if (end) {
+    return;
+  }
+
+  // Consecutive blocks of a source not overlapping in time are chained into
+  // runs, so that only overlapping blocks need merging. Runs are listed round
+  // robin across the sources so that the runs of different shards and topics
+  // covering the same time range are merged together. The blocks of a
+  // compacted storage are already sorted and are read as a single run.
+  std::vector<std::vector<Run>> sources;
+  std::vector<Run> runs;
+  auto roots = listShards(path_);
+  roots.insert(roots.begin(), path_);
+  for (const auto& root : roots) {
+    std::vector<ManifestEntry> segments;
+    if (readSegments(root, segments)) {
+      auto run = listSegmentBlocks(root, segments, reader.filter_);
+      if (!run.empty()) {
+        runs.push_back(std::move(run));
+      }
+      continue;
+    }
+    sources.push_back(chainBlocks(listBlocks(root, reader.filter_)));
+    for (const auto& topic : listTopics(root)) {
+      sources.push_back(
+          chainBlocks(listBlocks(topicPath(root, topic), reader.filter_)));
+    }
+  }
+  for (std::size_t index = 0, listed = 1; listed; ++index) {
+    listed = 0;
+    for (auto& source : sources) {
+      if (index < source.size()) {
+        runs.push_back(std::move(source[index]));
+        ++listed;
+      }
+    }
+  }
+
+  // The number of runs merged at once is bounded such that each run gets at
+  // least the minimum chunk of the memory budget. Runs beyond that are merged
+  // in multiple passes, with each pass merging groups of runs into temporary
+  // runs. The blocks of the temporary runs use part of the budget. A prefetched
+  // block is held along with the current one of each run, when enough runs are
+  // merged for prefetching to pay off.
+  merge_ = std::make_shared<MergeState>();
+  merge_->filter = reader.filter_;
+  if (reader.prefetch_threads_ && runs.size() >= kMinPrefetchRuns) {
+    merge_->prefetcher =
+        std::make_unique<BlockPrefetcher>(reader.prefetch_threads_);
+  }
+  const std::size_t blocks_per_run = merge_->prefetcher ? 2 : 1;
+  const auto budget = std::max(reader.memory_budget_,
+                               2 * blocks_per_run * kMinChunkSize);
+  const auto fan_in = std::max<std::size_t>(
+      2, std::min(reader.max_blocks_,
+                  budget / (blocks_per_run * kMinChunkSize)));
+  if (runs.size() > fan_in) {
+    merge_->temp_dir = makeTempDirectory();
+    const auto block_size =
+        std::min(std::max(budget / 4, kMinRunBlockSize), kMaxRunBlockSize);
+    const auto merge_budget = budget > 2 * block_size ? budget - block_size
+                                                      : budget / 2;
+    for (std::size_t pass = 0; runs.size() > fan_in; ++pass) {
+      std::vector<Run> next_runs;
+      for (std::size_t begin = 0; begin < runs.size(); begin += fan_in) {
+        const auto end = std::min(begin + fan_in, runs.size());
+        if (end - begin == 1) {
+          next_runs.push_back(std::move(runs[begin]));
+          continue;
+        }
+        std::vector<Run> group(std::make_move_iterator(runs.begin() + begin),
+                               std::make_move_iterator(runs.begin() + end));
+        // Temporary runs of previous passes are removed once merged. Blocks
+        // of the storage can be carried over to later passes as runs of their
+        // own, and are left untouched.
+        std::vector<std::string> merged_paths;
+        for (const auto& run : group) {
+          if (run.empty()) {
+            continue;
+          }
+          const auto& run_path = run.front().path;
+          if (run_path.compare(0, merge_->temp_dir.size(),
+                               merge_->temp_dir) == 0) {
+            merged_paths.push_back(run_path);
+          }
+        }
+        const auto chunk_size = std::min(
+            std::max(merge_budget / (blocks_per_run * group.size()),
+                     kMinChunkSize / 2),
+            kMaxChunkSize);
+        RunMerger merger(std::move(group), chunk_size,
+                         merge_->prefetcher.get(),
+                         reader.corrupt_blocks_.get());
+        next_runs.push_back(writeRun(merger,
+                                     merge_->temp_dir + "/run-" +
+                                         std::to_string(pass) + "-" +
+                                         std::to_string(next_runs.size()),
+                                     block_size));
+        for (const auto& path : merged_paths) {
+          removeDirectory(path);
+        }
+      }
+      runs = std::move(next_runs);
+    }
+  }
+  const auto chunk_size = std::min(
+      budget / (blocks_per_run * std::max<std::size_t>(runs.size(), 1)),
+      kMaxChunkSize);
+  merge_->merger = std::make_unique<RunMerger>(
+      std::move(runs), chunk_size, merge_->prefetcher.get(),
+      reader.corrupt_blocks_.get());
+  if (!updateRecord()) {
+    next();
   }
 }
 
 // private
 void Reader::Iterator::next() {
-  if (queue_.empty()) {
+  if (isEnd()) {
     record_ = {};
     return;
   }
 
   do {
-    BlockReaderWrapperPtr block_reader = queue_.top();
-    queue_.pop();
-    ++(block_reader->it);
-    if (block_reader->it == block_reader->reader.end()) {
-      updateQueue();
-    } else {
-      queue_.emplace(std::move(block_reader));
-    }
+    merge_->merger->next();
   } while (!updateRecord());
 }
 
 // private
-void Reader::Iterator::updateQueue() {
-  while (queue_.size() < max_blocks_) {
-    const auto file_name = std::to_string(num_blocks_) + kFileExtension;
-    if (!File::exists(file_name, path_)) {
-      return;
-    }
-    BlockReader block_reader{File{file_name, path_}};
-    if (block_reader.count()) {
-      queue_.emplace(
-          std::make_shared<BlockReaderWrapper>(std::move(block_reader)));
-    }
-    ++num_blocks_;
-  }
-}
-
 bool Reader::Iterator::updateRecord() {
-  if (queue_.empty()) {
+  if (isEnd()) {
     record_ = {};
     return true;
   }
 
+  const auto& record = merge_->merger->record();
+  if (mode_ == ReadMode::kAlwaysChronological &&
+      record.timestamp > merge_->filter.end) {
+    // No later record can be in the time range of the filter.
+    merge_->merger.reset();
+    record_ = {};
+    return true;
+  }
+  if (!merge_->filter.matches(record)) {
+    return false;
+  }
   const auto timestamp = record_.timestamp;
-  record_ = *(queue_.top()->it);
+  record_ = record;
   return mode_ == ReadMode::kAlwaysChronological
              ? record_.timestamp >= timestamp
              : true;
 }
 
+// private
+bool Reader::Iterator::isEnd() const {
+  return !merge_ || !merge_->merger || !merge_->merger->valid();
+}
+
 Reader::Iterator& Reader::Iterator::operator++() {
   next();
   return *this;
@@ -126,8 +1355,7 @@ Reader::Iterator& Reader::Iterator::operator++() {
 
 bool Reader::Iterator::operator==(const Iterator& other) const {
   return path_ == other.path_ && mode_ == other.mode_ &&
-         queue_.size() == other.queue_.size() &&
-         (queue_.empty() ? true : queue_.top()->it == other.queue_.top()->it);
+         isEnd() == other.isEnd() && (isEnd() || merge_ == other.merge_);
 }
 
 bool Reader::Iterator::operator!=(const Iterator& other) const {
@@ -141,13 +1369,24 @@ const Record* Reader::Iterator::operator->() const {
 const Record& Reader::Iterator::operator*() const { return record_; }
 
 Reader::Reader(const std::string& path, const std::size_t max_blocks,
-               const ReadMode mode)
-    : path_(path), max_blocks_(max_blocks), mode_(mode) {}
+               const ReadMode mode, const std::size_t memory_budget,
+               const std::size_t prefetch_threads, const ReadFilter& filter)
+    : path_(path),
+      max_blocks_(max_blocks),
+      mode_(mode),
+      memory_budget_(memory_budget),
+      prefetch_threads_(prefetch_threads),
+      filter_(filter),
+      corrupt_blocks_(std::make_shared<std::atomic<std::size_t>>(0)) {}
 
 Reader::Iterator Reader::begin() const { return Iterator{*this, false}; }
 
 Reader::Iterator Reader::end() const { return Iterator{*this, true}; }
 
+std::size_t Reader::corruptBlocks() const {
+  return corrupt_blocks_->load(std::memory_order_relaxed);
+}
+
 }  // namespace storage
 }  // namespace tools
 }  // namespace inspector
\ No newline at end of file
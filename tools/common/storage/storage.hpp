@@ -16,21 +16,208 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <memory>
-#include <queue>
 #include <string>
+#include <vector>
 
 #include "tools/common/storage/block.hpp"
+#include "tools/common/storage/bounded_queue.hpp"
 #include "tools/common/storage/common.hpp"
+#include "tools/common/storage/manifest.hpp"
 
 namespace inspector {
 namespace tools {
 namespace storage {
 
+/**
+ * @brief Get the path of a topic in the storage located at the given path.
+ * Records of different topics are written by separate writers into their own
+ * sub-directory, and read back merged by a `Reader` of the storage path.
+ *
+ * @param path Path where storage is located.
+ * @param topic Name of the topic.
+ * @returns Path of the topic.
+ */
+std::string topicPath(const std::string& path, const std::string& topic);
+
+/**
+ * @brief List the names of the topics in the storage located at the given
+ * path. Only topics containing at least one block are listed. Shards and
+ * segments are not listed as topics.
+ *
+ * @param path Path where storage is located.
+ * @returns Sorted list of topic names.
+ */
+std::vector<std::string> listTopics(const std::string& path);
+
+/**
+ * @brief Get the path of a shard in the storage located at the given path.
+ * Shards are written concurrently by independent writers, e.g. one per
+ * recorder thread, and can contain topics of their own. A `Reader` of the
+ * storage path merges the records of all the shards.
+ *
+ * @param path Path where storage is located.
+ * @param shard Index of the shard.
+ * @returns Path of the shard.
+ */
+std::string shardPath(const std::string& path, const std::size_t shard);
+
+/**
+ * @brief List the paths of the shards in the storage located at the given
+ * path.
+ *
+ * @param path Path where storage is located.
+ * @returns List of shard paths ordered by shard index.
+ */
+std::vector<std::string> listShards(const std::string& path);
+
+/**
+ * @brief Name of the segment index of a compacted storage. The index is a
+ * manifest listing the segments in time order, each with the total size and
+ * the summary of its blocks.
+ *
+ */
+extern const char kSegmentIndexName[];
+
+/**
+ * @brief Get the path of a segment in the compacted storage located at the
+ * given path. Segments partition the records of the storage by time, and the
+ * blocks of each segment are sorted and do not overlap in time.
+ *
+ * @param path Path where storage is located.
+ * @param segment Index of the segment.
+ * @returns Path of the segment.
+ */
+std::string segmentPath(const std::string& path, const std::size_t segment);
+
+/**
+ * @brief Read the segment index of the compacted storage located at the given
+ * path.
+ *
+ * @param path Path where storage is located.
+ * @param segments Reference to store the segments in time order.
+ * @returns `true` if the storage is compacted else `false`.
+ */
+bool readSegments(const std::string& path,
+                  std::vector<ManifestEntry>& segments);
+
+/**
+ * @brief Data structure indexing the blocks stored in a directory, along with
+ * the summary of all the blocks.
+ *
+ */
+struct DirectoryIndex {
+  BlockSummary summary;               //<- Summary of all the blocks.
+  std::vector<ManifestEntry> blocks;  //<- Blocks in the order written.
+};
+
+/**
+ * @brief Read the index of the blocks stored directly under the given path
+ * from the manifest of the directory. Directories written without a manifest
+ * are indexed by probing the blocks in order, with each block summarized from
+ * its footer or else with `BlockSummary::unknown()`.
+ *
+ * @param path Path where the blocks are located.
+ * @returns Index of the blocks.
+ */
+DirectoryIndex readIndex(const std::string& path);
+
+/**
+ * @brief Data structure describing the records read by a `Reader`. Blocks
+ * whose summaries do not match the filter are skipped without being read, and
+ * reads of the other blocks start at the first record in the time range.
+ *
+ * Records of the read blocks are filtered by time range, and by the tagged
+ * types, process and thread ids only when a classifier is set.
+ *
+ */
+struct ReadFilter {
+  timestamp_t begin = std::numeric_limits<timestamp_t>::min();
+  timestamp_t end = std::numeric_limits<timestamp_t>::max();  //<- Inclusive.
+  std::vector<uint8_t> types;  //<- Record types, all if empty.
+  std::vector<int32_t> pids;   //<- Process ids, all if empty.
+  std::vector<int32_t> tids;   //<- Thread ids, all if empty.
+  RecordClassifier classifier = nullptr;
+
+  /**
+   * @brief Check if all the records match the filter.
+   *
+   */
+  bool empty() const;
+
+  /**
+   * @brief Check if the summarized records may match the filter.
+   *
+   */
+  bool matches(const BlockSummary& summary) const;
+
+  /**
+   * @brief Check if the given record matches the filter.
+   *
+   */
+  bool matches(const Record& record) const;
+};
+
+/**
+ * @brief Data structure describing how durably blocks are written to disk.
+ *
+ */
+struct DurabilityPolicy {
+  /**
+   * @brief Points at which written blocks are synced to disk.
+   *
+   */
+  enum class Sync : uint8_t {
+    kNone,      //<- Never synced, left to the kernel.
+    kBlocks,    //<- Synced once `blocks` blocks have been written.
+    kInterval,  //<- Synced once `interval` has elapsed since the last sync.
+    kOnClose,   //<- Synced when the writer is flushed.
+  };
+
+  Sync sync = Sync::kBlocks;
+  std::size_t blocks = 1;
+  std::chrono::milliseconds interval{1000};
+  bool direct = false;  //<- Write blocks with direct IO.
+};
+
+/**
+ * @brief Parse the sync point of a durability policy from its name: one of
+ * `none`, `blocks`, `interval` or `close`.
+ *
+ * @param name Constant reference to the name.
+ * @returns Sync point.
+ * @throws `std::invalid_argument` if the name is unknown.
+ */
+DurabilityPolicy::Sync parseSync(const std::string& name);
+
 /**
  * @brief The class `Writer` exposes API to write records in chronological order
  * to disk.
  *
+ * Full blocks are written to disk either synchronously by the calling thread,
+ * or by a dedicated write stage thread when pending blocks are allowed. In the
+ * latter case filling the next block overlaps with writing the previous ones,
+ * and the block buffers are recycled between the two threads. The write stage
+ * keeps up to as many blocks in flight as it allows pending blocks, submitted
+ * through io_uring when available or else to a pool of writing threads.
+ *
+ * Written blocks are synced to disk as set by a durability policy. Syncing
+ * every block is the most durable, while leaving syncs to the kernel gives the
+ * most write bandwidth. With direct IO blocks bypass the page cache, in which
+ * case the block size is rounded up to a multiple of `kBlockAlignment`.
+ *
+ * Blocks are compressed with the given codec before being written, by the
+ * write stage thread when there is one so that compression does not slow down
+ * the threads writing records.
+ *
+ * Each written block is listed in the manifest of the output directory along
+ * with its size, codec, checksum and the summary of its records. The summaries
+ * let readers skip the blocks outside a time range or of other processes and
+ * threads.
+ *
  */
 class Writer final {
  public:
@@ -39,9 +226,20 @@ class Writer final {
    *
    * @param path Path to output directory.
    * @param block_size Maximum size of each file stored in the output directory.
-   *
+   * @param max_pending_blocks Maximum number of full blocks waiting to be
+   * written by the write stage thread. Blocks are written synchronously if 0.
+   * @param durability Constant reference to the durability policy.
+   * @param codec Codec used to compress blocks.
+   * @param classifier Function tagging the records for the block summaries.
+   * Summaries only cover the time range of the records if null.
+   * @throws `std::invalid_argument` if the block size is less than
+   * `kMinBlockSize`.
    */
-  Writer(const std::string& path, const std::size_t block_size);
+  Writer(const std::string& path, const std::size_t block_size,
+         const std::size_t max_pending_blocks = 0,
+         const DurabilityPolicy& durability = {},
+         const CodecType codec = CodecType::kNone,
+         const RecordClassifier classifier = nullptr);
 
   /**
    * @brief Destory writer object.
@@ -58,23 +256,92 @@ class Writer final {
   void write(const Record& record);
 
   /**
-   * @brief Flush all contents to disk.
+   * @brief Write the given records in one pass.
    *
+   * @param records Pointer to the first record to write.
+   * @param count Number of records to write.
+   */
+  void write(const Record* const records, const std::size_t count);
+
+  /**
+   * @brief Flush all contents to disk. Blocks until all the pending blocks
+   * have been written, and syncs the blocks not synced yet unless the
+   * durability policy leaves syncs to the kernel.
+   *
+   * @throws `std::system_error` if the write stage thread failed writing a
+   * block.
    */
   void flush();
 
+  /**
+   * @brief Get the backpressure experienced while handing full blocks to the
+   * write stage thread. All zeros when blocks are written synchronously.
+   *
+   */
+  BackpressureMetrics metrics() const;
+
  private:
+  struct SyncState;
+  struct WriteStage;
+
+  void seal();
+
   std::string path_;
   BlockBuilder builder_;
+  ManifestWriter manifest_;
   std::size_t num_blocks_;
+  std::unique_ptr<SyncState> sync_;
+  std::unique_ptr<WriteStage> stage_;
 };
 
 /**
  * @brief The class Reader exposes API to read records from storage.
  *
+ * Records are read by merging the blocks in storage. Consecutive blocks of a
+ * shard or topic which do not overlap in time are chained into sorted runs,
+ * and only the runs are merged. Blocks are streamed in chunks so that the
+ * memory used by the merge stays within a budget. The number of runs merged at
+ * once is adapted to the budget and when the storage has more runs than can be
+ * merged at once, the runs are first merged in groups into temporary sorted
+ * runs which are then merged in turn. When enough runs are merged at once,
+ * the next block of each run is opened by background threads while the current
+ * one is merged.
+ *
+ * Blocks are listed from the manifests of the storage directories in a single
+ * read each. Blocks listed but missing from disk are skipped, as are blocks
+ * failing checksum verification, which are counted. Frames of a block are
+ * verified as they are read, thus the records of a block preceding a corrupt
+ * frame are still read.
+ *
+ * Only the records matching a filter are read. The blocks not matching it are
+ * skipped using the index of their directory, so that reading a short time
+ * range of a large storage seeks to the blocks of the range.
+ *
+ * The blocks of a compacted storage are sorted and partitioned by time into
+ * segments, and are read as a single run without merging. Reads of a time
+ * range binary search the segment index and the records of the first block.
+ *
  */
 class Reader {
  public:
+  /**
+   * @brief Default maximum number of blocks merged at once.
+   *
+   */
+  static constexpr std::size_t kDefaultMaxBlocks = 1024;
+
+  /**
+   * @brief Default number of bytes of memory used for reading records.
+   *
+   */
+  static constexpr std::size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+
+  /**
+   * @brief Default number of threads prefetching blocks.
+   *
+   */
+  static constexpr std::size_t kDefaultPrefetchThreads = 2;
+
   /**
    * @brief Different modes of reading records.
    *
@@ -103,52 +370,58 @@ class Reader {
     Iterator(const Reader& reader, bool end);
 
     void next();
-    void updateQueue();
     bool updateRecord();
+    bool isEnd() const;
 
-    struct BlockReaderWrapper {
-      BlockReader reader;
-      BlockReader::Iterator it;
-
-      NO_COPY(BlockReaderWrapper);
-      explicit BlockReaderWrapper(BlockReader&& _reader);
-    };
-    using BlockReaderWrapperPtr = std::shared_ptr<BlockReaderWrapper>;
-
-    struct BlockReaderWrapperPtrCompare {
-      bool operator()(const BlockReaderWrapperPtr& lhs,
-                      const BlockReaderWrapperPtr& rhs) const;
-    };
-    using BlockReaderQueue =
-        std::priority_queue<BlockReaderWrapperPtr,
-                            std::vector<BlockReaderWrapperPtr>,
-                            BlockReaderWrapperPtrCompare>;
+    struct MergeState;
 
     std::string path_;
     Reader::ReadMode mode_;
-    std::size_t max_blocks_;
-    std::size_t num_blocks_;
-    BlockReaderQueue queue_;
+    std::shared_ptr<MergeState> merge_;
     Record record_;
   };
 
   /**
-   * @brief Construct a Reader object.
+   * @brief Construct a Reader object. Records stored in the shards and topics
+   * of the storage are merged with the records stored directly under the
+   * path.
    *
    * @param path Path where storage is located.
-   * @param max_blocks Maximum number of blocks to load at once.
+   * @param max_blocks Maximum number of blocks to merge at once.
    * @param mode Mode of reading records.
+   * @param memory_budget Number of bytes of memory to use for reading records.
+   * Temporary runs are written to the directory set by the `TMPDIR`
+   * environment variable, or `/tmp`, when the budget is exceeded.
+   * @param prefetch_threads Number of threads prefetching blocks. Blocks are
+   * opened by the iterating thread if 0, or if too few runs of blocks are
+   * merged at once for prefetching to pay off.
+   * @param filter Constant reference to the filter of the records to read.
    */
-  Reader(const std::string& path, const std::size_t max_blocks = 1024,
-         const ReadMode mode = ReadMode::kAlwaysChronological);
+  Reader(const std::string& path,
+         const std::size_t max_blocks = kDefaultMaxBlocks,
+         const ReadMode mode = ReadMode::kAlwaysChronological,
+         const std::size_t memory_budget = kDefaultMemoryBudget,
+         const std::size_t prefetch_threads = kDefaultPrefetchThreads,
+         const ReadFilter& filter = {});
 
   Iterator begin() const;
   Iterator end() const;
 
+  /**
+   * @brief Get the number of corrupt blocks skipped by the iterators of the
+   * reader so far.
+   *
+   */
+  std::size_t corruptBlocks() const;
+
  private:
   const std::string path_;
   const std::size_t max_blocks_;
   const ReadMode mode_;
+  const std::size_t memory_budget_;
+  const std::size_t prefetch_threads_;
+  const ReadFilter filter_;
+  const std::shared_ptr<std::atomic<std::size_t>> corrupt_blocks_;
 };
 
 }  // namespace storage
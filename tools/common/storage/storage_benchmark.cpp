@@ -0,0 +1,174 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The `storage_benchmark` utility measures the throughput of reading records
+ * merged across the blocks of shards, comparing the reader against a merge
+ * keeping every block mapped in a priority queue of shared block iterators:
+ *
+ *   bazel run -c opt //tools/common/storage:storage_benchmark -- --shards=8
+ *
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "tools/common/storage/block.hpp"
+#include "tools/common/storage/storage.hpp"
+#include "utils/tempdir.hpp"
+
+DEFINE_uint64(records, 4000000, "Number of records written to storage.");
+DEFINE_uint64(record_size, 32, "Size in bytes of each record.");
+DEFINE_uint64(block_size, 4 * 1024 * 1024, "Size in bytes of each block.");
+DEFINE_uint64(shards, 4, "Number of shards the records are written to.");
+DEFINE_uint64(prefetch_threads, 2, "Number of threads prefetching blocks.");
+DEFINE_string(dir, "/tmp/storage_benchmark", "Directory to write storage.");
+
+namespace inspector {
+namespace tools {
+namespace {
+
+/**
+ * @brief Block iterator shared through the priority queue of the baseline
+ * merge.
+ *
+ */
+struct BlockReaderWrapper {
+  storage::BlockReader reader;
+  storage::BlockReader::Iterator it;
+
+  explicit BlockReaderWrapper(storage::BlockReader&& _reader)
+      : reader(std::move(_reader)), it(reader.begin()) {}
+};
+using BlockReaderWrapperPtr = std::shared_ptr<BlockReaderWrapper>;
+
+struct BlockReaderWrapperPtrCompare {
+  bool operator()(const BlockReaderWrapperPtr& lhs,
+                  const BlockReaderWrapperPtr& rhs) const {
+    return lhs->it->timestamp >= rhs->it->timestamp;
+  }
+};
+
+/**
+ * @brief Merge the records of all the blocks in the given shards by popping
+ * and pushing the shared iterator of a block for each record.
+ *
+ */
+std::size_t baselineMerge(const std::vector<std::string>& shards,
+                          uint64_t& checksum) {
+  std::priority_queue<BlockReaderWrapperPtr,
+                      std::vector<BlockReaderWrapperPtr>,
+                      BlockReaderWrapperPtrCompare>
+      queue;
+  for (const auto& shard : shards) {
+    for (std::size_t block = 0;; ++block) {
+      const auto name = std::to_string(block) + storage::kFileExtension;
+      if (!storage::File::exists(name, shard)) {
+        break;
+      }
+      storage::BlockReader reader{storage::File{name, shard}};
+      if (reader.count()) {
+        queue.emplace(std::make_shared<BlockReaderWrapper>(std::move(reader)));
+      }
+    }
+  }
+
+  std::size_t count = 0;
+  while (!queue.empty()) {
+    auto wrapper = queue.top();
+    queue.pop();
+    checksum += wrapper->it->timestamp;
+    ++count;
+    ++(wrapper->it);
+    if (wrapper->it != wrapper->reader.end()) {
+      queue.emplace(std::move(wrapper));
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Run the given merge, logging its throughput.
+ *
+ */
+template <class Merge>
+void run(const std::string& name, Merge&& merge) {
+  uint64_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  const std::size_t count = merge(checksum);
+  const auto end = std::chrono::steady_clock::now();
+  const auto elapsed_s = std::chrono::duration<double>(end - start).count();
+  LOG(INFO) << name << ": merged " << count << " records in " << elapsed_s
+            << "s (" << count / elapsed_s << " records/s, checksum "
+            << checksum << ")";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  FLAGS_logtostderr = 1;
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  const utils::TempDir dir(FLAGS_dir);
+  std::vector<std::string> shards;
+  {
+    // Shards overlap in time so that the blocks of every shard are merged.
+    const std::vector<uint8_t> data(FLAGS_record_size, 0);
+    std::vector<std::unique_ptr<storage::Writer>> writers;
+    for (std::size_t shard = 0; shard < FLAGS_shards; ++shard) {
+      shards.push_back(storage::shardPath(dir.path(), shard));
+      writers.emplace_back(
+          std::make_unique<storage::Writer>(shards.back(), FLAGS_block_size));
+    }
+    for (std::size_t i = 0; i < FLAGS_records; ++i) {
+      writers[i % writers.size()]->write(
+          {static_cast<storage::timestamp_t>(i), data.data(), data.size()});
+    }
+  }
+
+  run("Priority queue", [&](uint64_t& checksum) {
+    return baselineMerge(shards, checksum);
+  });
+  for (const std::size_t threads : {std::size_t{0}, FLAGS_prefetch_threads}) {
+    run("Loser tree, " + std::to_string(threads) + " prefetch threads",
+        [&](uint64_t& checksum) {
+          const storage::Reader reader(
+              dir.path(), storage::Reader::kDefaultMaxBlocks,
+              storage::Reader::ReadMode::kAlwaysChronological,
+              storage::Reader::kDefaultMemoryBudget, threads);
+          std::size_t count = 0;
+          for (const auto& record : reader) {
+            checksum += record.timestamp;
+            ++count;
+          }
+          return count;
+        });
+  }
+
+  return 0;
+}
+
+}  // namespace tools
+}  // namespace inspector
+
+int main(int argc, char* argv[]) { return inspector::tools::main(argc, argv); }
@@ -18,8 +18,14 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <queue>
+#include <stdexcept>
+#include <string>
+#include <system_error>
 #include <unordered_map>
 #include <vector>
 
@@ -31,6 +37,13 @@ using namespace inspector::tools::storage;
 
 namespace {
 constexpr auto kBlockSize = 1024;
+
+// Records of the filter tests store their process id as text.
+RecordTags parsePid(const Record& record) {
+  return {0, std::stoi(std::string(static_cast<const char*>(record.src),
+                                   record.size)),
+          0};
+}
 }
 
 class StorageTestFixture : public TestHarness, public ::testing::Test {
@@ -83,4 +96,448 @@ TEST_F(StorageTestFixture, TestWriteAndRead) {
     ++i;
   }
   ASSERT_EQ(i, kRecordCount);
-}
\ No newline at end of file
+}
+
+TEST_F(StorageTestFixture, TestWriteAndReadTopics) {
+  constexpr auto kRecordCount = 1000;
+  const std::vector<std::string> topics = {"counter", "scope"};
+
+  {
+    Writer counter_writer(topicPath(tempDir().path(), topics[0]), kBlockSize);
+    Writer scope_writer(topicPath(tempDir().path(), topics[1]), kBlockSize);
+    for (auto i = 0; i < kRecordCount; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      auto& writer = i % 2 ? counter_writer : scope_writer;
+      writer.write({static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+
+  ASSERT_EQ(listTopics(tempDir().path()), topics);
+
+  // Records of all the topics are merged in chronological order
+  Reader reader{tempDir().path()};
+  timestamp_t timestamp = 0;
+  for (const auto& entry : reader) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    const auto record = "test-data-" + std::to_string(timestamp);
+    ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+              record);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+
+  // Records of a single topic
+  std::size_t count = 0;
+  for (const auto& entry : Reader{topicPath(tempDir().path(), topics[0])}) {
+    ASSERT_EQ(entry.timestamp % 2, 1);
+    ++count;
+  }
+  ASSERT_EQ(count, kRecordCount / 2);
+}
+
+TEST_F(StorageTestFixture, TestWriteAndReadShards) {
+  constexpr auto kRecordCount = 1000;
+  constexpr auto kShardCount = 3;
+
+  {
+    // Shards are written concurrently and can contain topics of their own
+    std::vector<std::unique_ptr<Writer>> writers;
+    for (auto shard = 0; shard < kShardCount; ++shard) {
+      const auto path = shardPath(tempDir().path(), shard);
+      writers.emplace_back(std::make_unique<Writer>(
+          shard ? path : topicPath(path, "scope"), kBlockSize));
+    }
+    for (auto i = 0; i < kRecordCount; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      writers[i % kShardCount]->write(
+          {static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+
+  ASSERT_EQ(listShards(tempDir().path()).size(), kShardCount);
+  ASSERT_TRUE(listTopics(tempDir().path()).empty());
+
+  // Records of all the shards are merged in chronological order
+  Reader reader{tempDir().path()};
+  timestamp_t timestamp = 0;
+  for (const auto& entry : reader) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+}
+
+TEST_F(StorageTestFixture, TestWriteAndReadWithWriteStage) {
+  constexpr auto kRecordCount = 1000;
+  constexpr auto kMaxPendingBlocks = 2;
+
+  {
+    Writer writer(tempDir().path(), kBlockSize, kMaxPendingBlocks);
+    for (auto i = 0; i < kRecordCount; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      writer.write({static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+    writer.flush();
+    ASSERT_GT(writer.metrics().items, 1);
+    ASSERT_LE(writer.metrics().max_depth, kMaxPendingBlocks);
+  }
+
+  Reader reader{tempDir().path()};
+  timestamp_t timestamp = 0;
+  for (const auto& entry : reader) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    const auto record = "test-data-" + std::to_string(timestamp);
+    ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+              record);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+}
+
+TEST_F(StorageTestFixture, TestWriteBatchesAndReadWithWriteStage) {
+  constexpr auto kRecordCount = 1000;
+  constexpr auto kMaxPendingBlocks = 2;
+
+  {
+    // Records are written in batches
+    std::vector<std::string> data;
+    std::vector<Record> records;
+    for (auto i = 0; i < kRecordCount; ++i) {
+      data.emplace_back("test-data-" + std::to_string(i));
+    }
+    for (auto i = 0; i < kRecordCount; ++i) {
+      records.emplace_back(i, data[i].data(), data[i].size());
+    }
+    Writer writer(tempDir().path(), kBlockSize, kMaxPendingBlocks);
+    for (auto i = 0; i < kRecordCount; i += 100) {
+      writer.write(records.data() + i, 100);
+    }
+    writer.flush();
+    ASSERT_GT(writer.metrics().items, 1);
+    ASSERT_LE(writer.metrics().max_depth, kMaxPendingBlocks);
+  }
+
+  Reader reader{tempDir().path()};
+  timestamp_t timestamp = 0;
+  for (const auto& entry : reader) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    const auto record = "test-data-" + std::to_string(timestamp);
+    ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+              record);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+}
+
+TEST_F(StorageTestFixture, TestReadWithMultiPassMerge) {
+  constexpr auto kRecordCount = 2000;
+  constexpr auto kShardCount = 4;
+  constexpr std::size_t kMaxBlocks = 3;
+  constexpr std::size_t kMemoryBudget = 256 * 1024;
+
+  {
+    // Shards overlap in time so that every block needs to be merged
+    std::vector<std::unique_ptr<Writer>> writers;
+    for (auto shard = 0; shard < kShardCount; ++shard) {
+      writers.emplace_back(std::make_unique<Writer>(
+          shardPath(tempDir().path(), shard), kBlockSize));
+    }
+    for (auto i = 0; i < kRecordCount; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      writers[i % kShardCount]->write(
+          {static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+
+  // More blocks than can be merged at once are merged in multiple passes
+  // through temporary runs, leaving the storage untouched.
+  const auto files = tempDir().listFiles(true);
+  ASSERT_GT(files.size(), kMaxBlocks * kMaxBlocks);
+  for (const std::size_t prefetch_threads : {0, 2}) {
+    Reader reader{tempDir().path(), kMaxBlocks,
+                  Reader::ReadMode::kAlwaysChronological, kMemoryBudget,
+                  prefetch_threads};
+    timestamp_t timestamp = 0;
+    for (const auto& entry : reader) {
+      ASSERT_EQ(entry.timestamp, timestamp);
+      const auto record = "test-data-" + std::to_string(timestamp);
+      ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+                record);
+      ++timestamp;
+    }
+    ASSERT_EQ(timestamp, kRecordCount);
+    ASSERT_EQ(tempDir().listFiles(true), files);
+  }
+}
+
+TEST_F(StorageTestFixture, TestReadManyRunsWithPrefetch) {
+  constexpr auto kRecordCount = 3200;
+  constexpr auto kShardCount = 32;
+
+  {
+    // Enough shards are merged at once for the next block of each shard to be
+    // prefetched.
+    std::vector<std::unique_ptr<Writer>> writers;
+    for (auto shard = 0; shard < kShardCount; ++shard) {
+      writers.emplace_back(std::make_unique<Writer>(
+          shardPath(tempDir().path(), shard), kBlockSize));
+    }
+    for (auto i = 0; i < kRecordCount; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      writers[i % kShardCount]->write(
+          {static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+
+  for (const std::size_t prefetch_threads : {0, 2}) {
+    Reader reader{tempDir().path(), Reader::kDefaultMaxBlocks,
+                  Reader::ReadMode::kAlwaysChronological,
+                  Reader::kDefaultMemoryBudget, prefetch_threads};
+    timestamp_t timestamp = 0;
+    for (const auto& entry : reader) {
+      ASSERT_EQ(entry.timestamp, timestamp);
+      const auto record = "test-data-" + std::to_string(timestamp);
+      ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+                record);
+      ++timestamp;
+    }
+    ASSERT_EQ(timestamp, kRecordCount);
+  }
+}
+
+TEST_F(StorageTestFixture, TestReadChainsSortedBlocks) {
+  constexpr auto kRecordCount = 2000;
+  constexpr std::size_t kMaxBlocks = 2;
+  const auto path = tempDir().path() + "/storage";
+  {
+    // Records of each shard are written in order so that their blocks do
+    // not overlap in time.
+    Writer first(shardPath(path, 0), kBlockSize);
+    Writer second(shardPath(path, 1), kBlockSize);
+    for (auto i = 0; i < kRecordCount; ++i) {
+      std::string record = "test-data-" + std::to_string(i);
+      auto& writer = i % 2 ? second : first;
+      writer.write({static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+  ASSERT_GT(readIndex(shardPath(path, 0)).blocks.size(), kMaxBlocks);
+
+  // The blocks of each shard are read as a single run, so that the two shards
+  // are merged at once without spilling temporary runs.
+  const utils::TempDir tmp(tempDir().path() + "/tmp");
+  const auto* const previous = std::getenv("TMPDIR");
+  const std::string saved = previous ? previous : "";
+  ::setenv("TMPDIR", tmp.path().c_str(), 1);
+  std::size_t spilled = 0;
+  timestamp_t timestamp = 0;
+  for (const auto& entry : Reader{path, kMaxBlocks}) {
+    if (timestamp == 0) {
+      spilled = tmp.listFiles(true).size();
+    }
+    ASSERT_EQ(entry.timestamp, timestamp);
+    ++timestamp;
+  }
+  if (previous) {
+    ::setenv("TMPDIR", saved.c_str(), 1);
+  } else {
+    ::unsetenv("TMPDIR");
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+  ASSERT_EQ(spilled, 0);
+}
+
+TEST_F(StorageTestFixture, TestWriterRejectsSmallBlocks) {
+  ASSERT_THROW(Writer(tempDir().path(), 0), std::invalid_argument);
+  ASSERT_THROW(Writer(tempDir().path(), 16, 2), std::invalid_argument);
+  DurabilityPolicy durability;
+  durability.direct = true;
+  ASSERT_THROW(Writer(tempDir().path(), 0, 0, durability),
+               std::invalid_argument);
+}
+
+TEST_F(StorageTestFixture, TestWriteWithDurabilityPolicies) {
+  constexpr auto kRecordCount = 1000;
+
+  std::vector<DurabilityPolicy> policies(5);
+  policies[0].sync = parseSync("none");
+  policies[1].sync = parseSync("blocks");
+  policies[1].blocks = 3;
+  policies[2].sync = parseSync("interval");
+  policies[2].interval = std::chrono::milliseconds{1};
+  policies[3].sync = parseSync("close");
+  policies[4].direct = true;
+  ASSERT_THROW(parseSync("never"), std::invalid_argument);
+
+  for (std::size_t index = 0; index < policies.size(); ++index) {
+    const auto path = topicPath(tempDir().path(), std::to_string(index));
+    if (policies[index].direct) {
+      // Direct IO is not supported by every file system, e.g. tmpfs.
+      try {
+        File{"probe", path, true}.remove();
+      } catch (const std::system_error&) {
+        continue;
+      }
+    }
+    for (const std::size_t max_pending_blocks : {0, 2}) {
+      {
+        Writer writer(path, kBlockSize, max_pending_blocks, policies[index]);
+        for (auto i = 0; i < kRecordCount; ++i) {
+          std::string record = "test-data-" + std::to_string(i);
+          writer.write(
+              {static_cast<timestamp_t>(i), record.data(), record.size()});
+        }
+      }
+
+      timestamp_t timestamp = 0;
+      for (const auto& entry : Reader{path}) {
+        ASSERT_EQ(entry.timestamp, timestamp);
+        const auto record = "test-data-" + std::to_string(timestamp);
+        ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+                  record);
+        ++timestamp;
+      }
+      ASSERT_EQ(timestamp, kRecordCount);
+    }
+  }
+}
+
+TEST_F(StorageTestFixture, TestWriteAndReadCompressed) {
+  constexpr auto kRecordCount = 1000;
+
+  for (const auto codec : {CodecType::kLz4, CodecType::kZlib}) {
+    for (const std::size_t max_pending_blocks : {0, 2}) {
+      const auto path =
+          topicPath(tempDir().path(), std::to_string(static_cast<int>(codec)) +
+                                          "-" +
+                                          std::to_string(max_pending_blocks));
+      {
+        Writer writer(path, kBlockSize, max_pending_blocks, {}, codec);
+        for (auto i = 0; i < kRecordCount; ++i) {
+          std::string record = "test-data-" + std::to_string(i);
+          writer.write(
+              {static_cast<timestamp_t>(i), record.data(), record.size()});
+        }
+      }
+
+      timestamp_t timestamp = 0;
+      for (const auto& entry : Reader{path}) {
+        ASSERT_EQ(entry.timestamp, timestamp);
+        const auto record = "test-data-" + std::to_string(timestamp);
+        ASSERT_EQ(std::string(static_cast<const char*>(entry.src), entry.size),
+                  record);
+        ++timestamp;
+      }
+      ASSERT_EQ(timestamp, kRecordCount);
+    }
+  }
+}
+
+TEST_F(StorageTestFixture, TestReadWithFilter) {
+  constexpr auto kRecordCount = 1000;
+  constexpr auto kPidCount = 4;
+
+  {
+    Writer writer(tempDir().path(), kBlockSize, 0, {}, CodecType::kNone,
+                  parsePid);
+    // Process 3 only writes in the second half of the records.
+    for (auto i = 0; i < kRecordCount; ++i) {
+      const auto pid = i < kRecordCount / 2 ? i % (kPidCount - 1) : 3;
+      const auto record = std::to_string(pid);
+      writer.write({static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+
+  const auto index = readIndex(tempDir().path());
+  ASSERT_GT(index.blocks.size(), 2);
+  ASSERT_EQ(index.summary.count, kRecordCount);
+  ASSERT_EQ(index.summary.min_timestamp, 0);
+  ASSERT_EQ(index.summary.max_timestamp, kRecordCount - 1);
+  ASSERT_EQ(index.summary.pids, (std::vector<int32_t>{0, 1, 2, 3}));
+
+  ReadFilter filter;
+  filter.begin = 100;
+  filter.end = 199;
+  timestamp_t timestamp = filter.begin;
+  for (const auto& entry : Reader{tempDir().path(), Reader::kDefaultMaxBlocks,
+                                  Reader::ReadMode::kAlwaysChronological,
+                                  Reader::kDefaultMemoryBudget,
+                                  Reader::kDefaultPrefetchThreads, filter}) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, filter.end + 1);
+
+  filter = {};
+  filter.pids = {3};
+  filter.classifier = parsePid;
+  std::size_t count = 0;
+  for (const auto& entry : Reader{tempDir().path(), Reader::kDefaultMaxBlocks,
+                                  Reader::ReadMode::kAlmostChronological,
+                                  Reader::kDefaultMemoryBudget,
+                                  Reader::kDefaultPrefetchThreads, filter}) {
+    ASSERT_EQ(parsePid(entry).pid, 3);
+    ++count;
+  }
+  ASSERT_EQ(count, kRecordCount / 2);
+
+  // Blocks of the first half only hold records of the other processes, while
+  // blocks without a summary can not be skipped.
+  ASSERT_FALSE(filter.matches(index.blocks.front().summary));
+  ASSERT_TRUE(filter.matches(index.blocks.back().summary));
+  ASSERT_TRUE(filter.matches(BlockSummary::unknown()));
+}
+
+TEST_F(StorageTestFixture, TestReadWithManifest) {
+  constexpr auto kRecordCount = 1000;
+
+  // A previous recording with more blocks is replaced as a whole.
+  for (const auto record_count : {2 * kRecordCount, kRecordCount}) {
+    Writer writer(tempDir().path(), kBlockSize, 2);
+    for (auto i = 0; i < record_count; ++i) {
+      const auto record = "test-data-" + std::to_string(i);
+      writer.write({static_cast<timestamp_t>(i), record.data(), record.size()});
+    }
+  }
+
+  std::vector<ManifestEntry> entries;
+  ASSERT_TRUE(readManifest(tempDir().path(), entries));
+  ASSERT_GT(entries.size(), 2);
+  std::size_t count = 0;
+  for (std::size_t index = 0; index < entries.size(); ++index) {
+    ASSERT_EQ(entries[index].index, index);
+    ASSERT_EQ(tempDir().readFile(entries[index].name).size(),
+              entries[index].size);
+    count += entries[index].summary.count;
+  }
+  ASSERT_EQ(count, kRecordCount);
+
+  timestamp_t timestamp = 0;
+  for (const auto& entry : Reader{tempDir().path()}) {
+    ASSERT_EQ(entry.timestamp, timestamp);
+    ++timestamp;
+  }
+  ASSERT_EQ(timestamp, kRecordCount);
+
+  // Blocks deleted after being listed in the manifest are skipped.
+  File{entries.front().name, tempDir().path()}.remove();
+  count = 0;
+  for (const auto& entry : Reader{tempDir().path()}) {
+    ASSERT_GE(entry.timestamp, entries.front().summary.max_timestamp);
+    ++count;
+  }
+  ASSERT_EQ(count, kRecordCount - entries.front().summary.count);
+
+  // Corrupt blocks are skipped and counted.
+  const auto& corrupt = entries.back();
+  ASSERT_NE(corrupt.checksum, 0);
+  File{corrupt.name, tempDir().path()}.write("x", 1, corrupt.size - 1);
+  Reader reader{tempDir().path()};
+  count = 0;
+  for (const auto& entry : reader) {
+    ASSERT_LT(entry.timestamp, corrupt.summary.min_timestamp);
+    ++count;
+  }
+  ASSERT_EQ(count, kRecordCount - entries.front().summary.count -
+                       corrupt.summary.count);
+  ASSERT_EQ(reader.corruptBlocks(), 1);
+}
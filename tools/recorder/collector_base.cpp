@@ -19,7 +19,15 @@
 namespace inspector {
 namespace tools {
 
+void CollectorBase::process(const TraceEventBatch& batch) {
+  for (const auto trace_event : batch) {
+    process(trace_event);
+  }
+}
+
 void CollectorBase::flush() {}
 
+storage::BackpressureMetrics CollectorBase::metrics() const { return {}; }
+
 }  // namespace tools
 }  // namespace inspector
\ No newline at end of file
@@ -18,6 +18,8 @@
 
 #include <inspector/trace_event.hpp>
 
+#include "tools/common/storage/bounded_queue.hpp"
+
 namespace inspector {
 namespace tools {
 
@@ -28,11 +30,21 @@ namespace tools {
 class CollectorBase {
  public:
   /**
-   * @brief Process the given trace event.
+   * @brief Process the given trace event. The view is only valid for the
+   * duration of the call.
+   *
+   * @param trace_event Constant reference to a view into the trace event.
+   */
+  virtual void process(const TraceEventView& trace_event) = 0;
+
+  /**
+   * @brief Process the given batch of trace events in one call. The views
+   * into the batch are only valid for the duration of the call. Default
+   * implementation processes the trace events one at a time.
    *
-   * @param trace_event Constant reference to trace event.
+   * @param batch Constant reference to the batch of trace events.
    */
-  virtual void process(const TraceEvent& trace_event) = 0;
+  virtual void process(const TraceEventBatch& batch);
 
   /**
    * @brief Flush any events buffered. Not all collectors need to implement this
@@ -40,6 +52,14 @@ class CollectorBase {
    *
    */
   virtual void flush();
+
+  /**
+   * @brief Get the backpressure experienced by the collector when handing
+   * processed events over to its downstream stage, e.g. a storage write
+   * stage. Default implementation returns all zeros.
+   *
+   */
+  virtual storage::BackpressureMetrics metrics() const;
 };
 
 }  // namespace tools
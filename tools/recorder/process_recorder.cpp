@@ -0,0 +1,114 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tools/recorder/process_recorder.hpp"
+
+#include <glog/logging.h>
+
+#include "tools/recorder/storage_collector.hpp"
+
+namespace inspector {
+namespace tools {
+namespace {
+
+/**
+ * @brief Name of recorder.
+ *
+ */
+const auto kRecorderName = "ProcessRecorder";
+
+/**
+ * @brief Prefix of the storage topic of each traced process.
+ *
+ */
+const auto kTopicPrefix = "pid-";
+
+}  // namespace
+
+ProcessRecorder::ProcessRecorder(const std::string& out_dir,
+                                 const std::vector<int32_t>& pids,
+                                 const std::chrono::microseconds interval,
+                                 const StorageOptions& options)
+    : RecorderBase(kRecorderName),
+      out_dir_(out_dir),
+      pids_(pids.begin(), pids.end()),
+      interval_(interval),
+      options_(options) {}
+
+ProcessRecorder::~ProcessRecorder() {
+  for (auto& process : processes_) {
+    detach(process.second, false);
+  }
+}
+
+void ProcessRecorder::record() {
+  // The last record operation after stopping drains and detaches all the
+  // processes still being recorded.
+  if (!isAlive()) {
+    for (auto& process : processes_) {
+      detach(process.second, false);
+    }
+    processes_.clear();
+    return;
+  }
+
+  for (const auto pid : listTracedProcesses()) {
+    if (processes_.count(pid) == 0 && (pids_.empty() || pids_.count(pid))) {
+      attach(pid);
+    }
+  }
+  for (auto it = processes_.begin(); it != processes_.end();) {
+    if (it->second.reader->isProcessAlive()) {
+      ++it;
+      continue;
+    }
+    detach(it->second, true);
+    it = processes_.erase(it);
+  }
+}
+
+// private
+void ProcessRecorder::attach(const int32_t pid) {
+  LOG(INFO) << "[" << name() << "]: Attaching to process " << pid;
+  auto& process = processes_[pid];
+  process.reader = std::make_shared<ProcessTraceReader>(pid);
+  process.collector = std::make_shared<StorageCollector>(
+      out_dir_, kTopicPrefix + std::to_string(pid), options_);
+  process.recorder =
+      std::make_shared<TraceRecorder>(process.collector, process.reader);
+  process.thread = std::thread(&RecorderBase::start, process.recorder.get(),
+                               interval_);
+}
+
+// private
+void ProcessRecorder::detach(ProcessEntry& process, const bool release) {
+  if (!process.thread.joinable()) {
+    return;
+  }
+  LOG(INFO) << "[" << name() << "]: Detaching from process "
+            << process.reader->pid();
+  // Stopping the recorder performs a last record operation draining the
+  // queues of the process.
+  process.recorder->stop();
+  process.thread.join();
+  process.collector->flush();
+  if (release) {
+    process.reader->release();
+  }
+}
+
+}  // namespace tools
+}  // namespace inspector
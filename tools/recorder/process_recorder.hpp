@@ -0,0 +1,84 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <inspector/trace_reader.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "tools/recorder/collector_base.hpp"
+#include "tools/recorder/recorder_base.hpp"
+#include "tools/recorder/storage_collector.hpp"
+#include "tools/recorder/trace_recorder.hpp"
+
+namespace inspector {
+namespace tools {
+
+/**
+ * @brief The class `ProcessRecorder` records trace events published by traced
+ * processes to their own event queues. On every tick it discovers newly
+ * registered processes and starts a `TraceRecorder` thread draining the queues
+ * of each, so that the processes are drained in parallel. The trace events of
+ * each process are written to their own storage topic. Once a process exits
+ * its queues are drained, removed and the process is unregistered.
+ *
+ */
+class ProcessRecorder final : public RecorderBase {
+ public:
+  /**
+   * @brief Construct a new ProcessRecorder object.
+   *
+   * @param out_dir Path to output directory.
+   * @param pids Identifiers of the processes to record. All the registered
+   * processes are recorded if empty.
+   * @param interval Tick interval of the per process recorders.
+   * @param options Constant reference to the storage options.
+   */
+  ProcessRecorder(const std::string& out_dir, const std::vector<int32_t>& pids,
+                  const std::chrono::microseconds interval,
+                  const StorageOptions& options = {});
+
+  ~ProcessRecorder() override;
+
+  void record() override;
+
+ private:
+  struct ProcessEntry {
+    std::shared_ptr<ProcessTraceReader> reader;
+    std::shared_ptr<CollectorBase> collector;
+    std::shared_ptr<TraceRecorder> recorder;
+    std::thread thread;
+  };
+
+  void attach(const int32_t pid);
+  void detach(ProcessEntry& process, const bool release);
+
+  const std::string out_dir_;
+  const std::unordered_set<int32_t> pids_;
+  const std::chrono::microseconds interval_;
+  const StorageOptions options_;
+  std::map<int32_t, ProcessEntry> processes_;
+};
+
+}  // namespace tools
+}  // namespace inspector
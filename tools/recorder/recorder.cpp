@@ -16,11 +16,17 @@
 
 #include "tools/recorder/recorder.hpp"
 
+#include <glog/logging.h>
+
 #include <chrono>
+#include <inspector/config.hpp>
 #include <memory>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
+#include "tools/common/storage/storage.hpp"
+#include "tools/recorder/process_recorder.hpp"
 #include "tools/recorder/storage_collector.hpp"
 #include "tools/recorder/trace_recorder.hpp"
 
@@ -29,7 +35,9 @@ namespace tools {
 namespace {
 
 /**
- * @brief Tick interval of the monitor.
+ * @brief Tick interval of the monitor. Trace recorders are woken up by the
+ * producers once the event queues fill up, so the interval only bounds the
+ * latency of recording trace events when the producers are idle.
  *
  */
 constexpr std::chrono::microseconds kTickIntervalUs{99'000};  // 99ms
@@ -41,14 +49,42 @@ class Manager {
     return mng;
   }
 
-  void start(const std::string& out, const bool block) {
+  void start(const std::string& out, const bool block,
+             const std::vector<int32_t>& pids, const std::size_t consumers,
+             const StorageOptions& options) {
     if (!recorders_.empty()) {
       return;
     }
-    collector_ = std::make_shared<StorageCollector>(out);
-    recorders_.emplace_back(std::make_shared<TraceRecorder>(collector_));
-    threads_.emplace_back(&RecorderBase::start, recorders_.back().get(),
-                          kTickIntervalUs);
+    try {
+      Config::verifyEventQueueGeometry();
+    } catch (const std::runtime_error& error) {
+      LOG(ERROR) << error.what()
+                 << ". Recorded events may be incomplete. Set the "
+                    "INSPECTOR_EVENT_QUEUE_* environment variables "
+                    "consistently for the recorder and the traced processes.";
+    }
+    if (Config::isPerProcessEventQueueEnabled()) {
+      recorders_.emplace_back(std::make_shared<ProcessRecorder>(
+          out, pids, kTickIntervalUs, options));
+    } else if (consumers <= 1) {
+      collectors_.emplace_back(
+          std::make_shared<StorageCollector>(out, "", options));
+      recorders_.emplace_back(
+          std::make_shared<TraceRecorder>(collectors_.back()));
+    } else {
+      // Each consumer drains the shared event queues concurrently into its own
+      // storage shard, which readers of the output directory merge back.
+      for (std::size_t shard = 0; shard < consumers; ++shard) {
+        collectors_.emplace_back(std::make_shared<StorageCollector>(
+            storage::shardPath(out, shard), "", options));
+        recorders_.emplace_back(
+            std::make_shared<TraceRecorder>(collectors_.back()));
+      }
+    }
+    for (auto& recorder : recorders_) {
+      threads_.emplace_back(&RecorderBase::start, recorder.get(),
+                            kTickIntervalUs);
+    }
     if (block) {
       wait();
     }
@@ -61,7 +97,9 @@ class Manager {
     if (block) {
       wait();
     }
-    collector_->flush();
+    for (auto& collector : collectors_) {
+      collector->flush();
+    }
   }
 
  private:
@@ -73,15 +111,17 @@ class Manager {
     }
   }
 
-  std::shared_ptr<CollectorBase> collector_;
+  std::vector<std::shared_ptr<CollectorBase>> collectors_;
   std::vector<std::shared_ptr<RecorderBase>> recorders_;
   std::vector<std::thread> threads_;
 };
 
 }  // namespace
 
-void startRecorder(const std::string& out, const bool block) {
-  Manager::instance().start(out, block);
+void startRecorder(const std::string& out, const bool block,
+                   const std::vector<int32_t>& pids,
+                   const std::size_t consumers, const StorageOptions& options) {
+  Manager::instance().start(out, block, pids, consumers, options);
 }
 
 void stopRecorder(const bool block) { Manager::instance().stop(block); }
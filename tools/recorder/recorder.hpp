@@ -16,7 +16,12 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include "tools/recorder/storage_collector.hpp"
 
 namespace inspector {
 namespace tools {
@@ -26,8 +31,18 @@ namespace tools {
  *
  * @param out Path to output directory to store trace and metric records.
  * @param block Invoke a blocking call.
+ * @param pids Identifiers of the processes to record when per process event
+ * queues are enabled. All the traced processes are recorded if empty.
+ * @param consumers Number of threads draining the event queues concurrently.
+ * When more than one, each thread writes to its own storage shard. Ignored
+ * when per process event queues are enabled, as every traced process is then
+ * drained by its own thread.
+ * @param options Constant reference to the options of writing to storage.
  */
-void startRecorder(const std::string& out, const bool block = false);
+void startRecorder(const std::string& out, const bool block = false,
+                   const std::vector<int32_t>& pids = {},
+                   const std::size_t consumers = 1,
+                   const StorageOptions& options = {});
 
 /**
  * @brief Stop recorder.
@@ -38,11 +38,13 @@ void RecorderBase::start(const std::chrono::microseconds duration) {
                    << " took long: " << record_duration.count() << " > "
                    << duration.count();
     } else {
-      std::this_thread::sleep_for(duration - record_duration);
+      this->wait(std::chrono::duration_cast<std::chrono::microseconds>(
+          duration - record_duration));
     }
   }
   // Performing last record operation to ensure all traces are recorded.
   this->record();
+  this->finish();
   LOG(INFO) << "[" << this->name_ << "]: Stopped";
 }
 
@@ -53,6 +55,14 @@ void RecorderBase::stop() {
   stop_ = true;
 }
 
+// protected
+void RecorderBase::wait(const std::chrono::microseconds duration) {
+  std::this_thread::sleep_for(duration);
+}
+
+// protected
+void RecorderBase::finish() {}
+
 const std::string& RecorderBase::name() const { return name_; }
 
 uint64_t RecorderBase::recordCount() const { return count_; }
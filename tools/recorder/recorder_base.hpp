@@ -25,8 +25,9 @@ namespace tools {
 
 /**
  * @brief The class `RecorderBase` is an abstract base class for implementing a
- * recorder. Its designed to perform unit of recording work periodically at a
- * fixed cadance.
+ * recorder. Its designed to perform unit of recording work periodically. By
+ * default the work is performed at a fixed cadance, while recorders can
+ * override `wait` to be woken up earlier when there is work to do.
  *
  */
 class RecorderBase {
@@ -44,6 +45,7 @@ class RecorderBase {
   /**
    * @brief Method to start the recorder. Note that this is a blocking call.
    *
+   * @param duration Maximum time between two consecutive recording tasks.
    */
   void start(const std::chrono::microseconds duration);
 
@@ -72,6 +74,22 @@ class RecorderBase {
   uint64_t recordCount() const;
 
  protected:
+  /**
+   * @brief Wait between two consecutive recording tasks. The default
+   * implementation sleeps for the given duration.
+   *
+   * @param duration Maximum time to wait.
+   */
+  virtual void wait(const std::chrono::microseconds duration);
+
+  /**
+   * @brief Complete any recording work still in flight once the recorder has
+   * been stopped. Called after the last recording task. The default
+   * implementation is a NOP.
+   *
+   */
+  virtual void finish();
+
   std::chrono::steady_clock clock_;
 
  private:
@@ -19,18 +19,57 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
 #include "tools/recorder/recorder.hpp"
 
 namespace py = pybind11;
 
+namespace inspector {
+namespace tools {
+namespace {
+
+void pyStartRecorder(const std::string& out, const bool block,
+                     const std::vector<int32_t>& pids,
+                     const std::size_t consumers, const std::size_t block_size,
+                     const std::string& sync, const std::size_t sync_blocks,
+                     const std::size_t sync_interval_ms,
+                     const bool direct_io, const std::string& compression) {
+  if (block_size < storage::kMinBlockSize) {
+    throw std::invalid_argument("Block size must be at least " +
+                                std::to_string(storage::kMinBlockSize) +
+                                " bytes.");
+  }
+  StorageOptions options;
+  options.block_size = block_size;
+  options.durability.sync = storage::parseSync(sync);
+  options.durability.blocks = sync_blocks;
+  options.durability.interval = std::chrono::milliseconds{sync_interval_ms};
+  options.durability.direct = direct_io;
+  options.codec = storage::parseCodec(compression);
+  startRecorder(out, block, pids, consumers, options);
+}
+
+}  // namespace
+}  // namespace tools
+}  // namespace inspector
+
 PYBIND11_MODULE(INSPECTOR_PYTHON_MODULE, m) {
   FLAGS_logtostderr = 0;
   google::InitGoogleLogging("recorder_py");
 
   m.doc() = "Recording tool to capture real time application traces.";
 
-  m.def("start_recorder", &inspector::tools::startRecorder, "Start recorder.",
-        py::arg("out"), py::arg("block") = false);
+  m.def("start_recorder", &inspector::tools::pyStartRecorder,
+        "Start recorder.", py::arg("out"), py::arg("block") = false,
+        py::arg("pids") = std::vector<int32_t>{}, py::arg("consumers") = 1,
+        py::arg("block_size") =
+            inspector::tools::StorageOptions::kDefaultBlockSize,
+        py::arg("sync") = "blocks", py::arg("sync_blocks") = 1,
+        py::arg("sync_interval_ms") = 1000, py::arg("direct_io") = false,
+        py::arg("compression") = "lz4");
   m.def("stop_recorder", &inspector::tools::stopRecorder, "Stop recorder.",
         py::arg("block") = false);
 }
\ No newline at end of file
@@ -18,11 +18,40 @@
 #include <glog/logging.h>
 #include <stdio.h>
 
+#include <cerrno>
+#include <chrono>
 #include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "tools/recorder/recorder.hpp"
+#include "utils/strings.hpp"
 
 DEFINE_string(out, "", "Path to storage directory.");
+DEFINE_string(pids, "",
+              "Comma separated identifiers of the processes to record when "
+              "per process event queues are enabled. All the traced "
+              "processes are recorded if empty.");
+DEFINE_uint32(consumers, 1,
+              "Number of threads draining the event queues concurrently. "
+              "Each thread writes to its own storage shard.");
+DEFINE_uint64(block_size, inspector::tools::StorageOptions::kDefaultBlockSize,
+              "Size in bytes of the storage blocks.");
+DEFINE_string(sync, "blocks",
+              "When written blocks are synced to disk: 'none' leaves it to "
+              "the kernel, 'blocks' syncs every --sync_blocks blocks, "
+              "'interval' every --sync_interval_ms and 'close' once recording "
+              "stops.");
+DEFINE_uint64(sync_blocks, 1, "Number of blocks written between syncs.");
+DEFINE_uint64(sync_interval_ms, 1000, "Interval in ms between syncs.");
+DEFINE_bool(direct_io, false,
+            "Write blocks with direct IO, bypassing the page cache.");
+DEFINE_string(compression, "lz4",
+              "Codec compressing the storage blocks: 'none', 'lz4' for "
+              "speed or 'zlib' for a higher ratio.");
 
 namespace inspector {
 namespace tools {
@@ -39,11 +68,44 @@ int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
   LOG_IF(FATAL, FLAGS_out.empty()) << "No output file provided.";
+  LOG_IF(FATAL, FLAGS_block_size < storage::kMinBlockSize)
+      << "Block size must be at least " << storage::kMinBlockSize
+      << " bytes.";
 
   std::signal(SIGINT, signalHandler);
   std::signal(SIGTERM, signalHandler);
 
-  startRecorder(FLAGS_out, true);
+  std::vector<int32_t> pids;
+  if (!FLAGS_pids.empty()) {
+    for (const auto& pid : utils::Split(FLAGS_pids, ",")) {
+      char* end = nullptr;
+      errno = 0;
+      const auto value = std::strtol(pid.c_str(), &end, 10);
+      LOG_IF(FATAL, pid.empty() || *end != '\0' || errno == ERANGE ||
+                        value <= 0 || value > INT32_MAX)
+          << "Invalid process identifier '" << pid << "' in --pids.";
+      pids.push_back(static_cast<int32_t>(value));
+    }
+  }
+
+  StorageOptions options;
+  options.block_size = FLAGS_block_size;
+  try {
+    options.durability.sync = storage::parseSync(FLAGS_sync);
+  } catch (const std::invalid_argument& error) {
+    LOG(FATAL) << error.what() << " Check --sync.";
+  }
+  options.durability.blocks = FLAGS_sync_blocks;
+  options.durability.interval =
+      std::chrono::milliseconds{FLAGS_sync_interval_ms};
+  options.durability.direct = FLAGS_direct_io;
+  try {
+    options.codec = storage::parseCodec(FLAGS_compression);
+  } catch (const std::invalid_argument& error) {
+    LOG(FATAL) << error.what() << " Check --compression.";
+  }
+
+  startRecorder(FLAGS_out, true, pids, FLAGS_consumers, options);
 
   ::printf("Output: %s\n", FLAGS_out.c_str());
   ::fflush(stdout);
@@ -16,27 +16,96 @@
 
 #include "tools/recorder/storage_collector.hpp"
 
+#include <algorithm>
+#include <inspector/channel.hpp>
+#include <inspector/config.hpp>
+
+#include "tools/common/events/event_columns.hpp"
+
 namespace inspector {
 namespace tools {
 namespace {
 
 /**
- * @brief Block size in bytes to use for storage.
+ * @brief Maximum number of full blocks waiting to be written to disk per
+ * storage topic.
  *
  */
-constexpr auto kBlockSize = 1024UL * 1024UL * 100UL;  // 100MB
+constexpr std::size_t kMaxPendingBlocks = 1;
 
 }  // namespace
 
-StorageCollector::StorageCollector(const std::string& out_dir)
-    : writer_(out_dir, kBlockSize) {}
+StorageCollector::StorageCollector(const std::string& out_dir,
+                                   const std::string& topic,
+                                   const StorageOptions& options) {
+  if (!Config::isMultiChannelEnabled()) {
+    const auto path =
+        topic.empty() ? out_dir : storage::topicPath(out_dir, topic);
+    writers_.emplace_back(std::make_unique<storage::Writer>(
+        path, options.block_size, kMaxPendingBlocks, options.durability,
+        options.codec, eventTags));
+    records_.resize(writers_.size());
+    return;
+  }
+  for (std::size_t index = 0; index < kChannelCount; ++index) {
+    const std::string channel = channelName(static_cast<Channel>(index));
+    const auto path = storage::topicPath(
+        out_dir, topic.empty() ? channel : topic + "-" + channel);
+    writers_.emplace_back(std::make_unique<storage::Writer>(
+        path, options.block_size, kMaxPendingBlocks, options.durability,
+        options.codec, eventTags));
+  }
+  records_.resize(writers_.size());
+}
 
-void StorageCollector::process(const TraceEvent& trace_event) {
+void StorageCollector::process(const TraceEventView& trace_event) {
   const auto span = trace_event.span();
-  writer_.write({trace_event.timestampNs(), span.first, span.second});
+  writers_[writerIndex(trace_event)]->write(
+      {trace_event.timestampNs(), span.first, span.second});
+}
+
+void StorageCollector::process(const TraceEventBatch& batch) {
+  // Records are gathered per writer and appended to their blocks in one pass.
+  // The record buffers are kept across batches to avoid reallocations.
+  for (const auto trace_event : batch) {
+    const auto span = trace_event.span();
+    records_[writerIndex(trace_event)].emplace_back(
+        trace_event.timestampNs(), span.first, span.second);
+  }
+  for (std::size_t index = 0; index < writers_.size(); ++index) {
+    auto& records = records_[index];
+    if (!records.empty()) {
+      writers_[index]->write(records.data(), records.size());
+      records.clear();
+    }
+  }
 }
 
-void StorageCollector::flush() { writer_.flush(); }
+void StorageCollector::flush() {
+  for (auto& writer : writers_) {
+    writer->flush();
+  }
+}
+
+storage::BackpressureMetrics StorageCollector::metrics() const {
+  storage::BackpressureMetrics metrics;
+  for (const auto& writer : writers_) {
+    const auto writer_metrics = writer->metrics();
+    metrics.items += writer_metrics.items;
+    metrics.stalls += writer_metrics.stalls;
+    metrics.stall_ns += writer_metrics.stall_ns;
+    metrics.max_depth = std::max(metrics.max_depth, writer_metrics.max_depth);
+  }
+  return metrics;
+}
+
+// private
+std::size_t StorageCollector::writerIndex(
+    const TraceEventView& trace_event) const {
+  return writers_.size() == 1
+             ? 0
+             : static_cast<std::size_t>(eventChannel(trace_event.type()));
+}
 
 }  // namespace tools
 }  // namespace inspector
\ No newline at end of file
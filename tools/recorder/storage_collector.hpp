@@ -16,21 +16,61 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "tools/common/storage/storage.hpp"
 #include "tools/recorder/collector_base.hpp"
 
 namespace inspector {
 namespace tools {
 
+/**
+ * @brief Data structure describing how trace events are written to storage.
+ *
+ */
+struct StorageOptions {
+  static constexpr std::size_t kDefaultBlockSize =
+      1024UL * 1024UL * 100UL;  // 100MB
+
+  std::size_t block_size = kDefaultBlockSize;  //<- Block size in bytes.
+  storage::DurabilityPolicy durability;
+  storage::CodecType codec = storage::CodecType::kLz4;  //<- Block codec.
+};
+
+/**
+ * @brief The class `StorageCollector` writes trace events to storage. When
+ * multi-channel event queues are enabled, the trace events of each channel are
+ * written to a storage topic named after the channel. Full blocks are written
+ * to disk by a write stage thread per topic, so that a slow disk does not
+ * stall the processing of trace events.
+ *
+ */
 class StorageCollector final : public CollectorBase {
  public:
-  explicit StorageCollector(const std::string& out_dir);
+  /**
+   * @brief Construct a new StorageCollector object.
+   *
+   * @param out_dir Path to output directory.
+   * @param topic Storage topic to write trace events to. The trace events are
+   * written directly to the output directory if empty. When multi-channel
+   * event queues are enabled, the channel name is appended to the topic.
+   * @param options Constant reference to the storage options.
+   */
+  explicit StorageCollector(const std::string& out_dir,
+                            const std::string& topic = "",
+                            const StorageOptions& options = {});
 
-  void process(const TraceEvent& trace_event) override;
+  void process(const TraceEventView& trace_event) override;
+  void process(const TraceEventBatch& batch) override;
   void flush() override;
+  storage::BackpressureMetrics metrics() const override;
 
  private:
-  tools::storage::Writer writer_;
+  std::size_t writerIndex(const TraceEventView& trace_event) const;
+
+  std::vector<std::unique_ptr<tools::storage::Writer>> writers_;
+  std::vector<std::vector<storage::Record>> records_;
 };
 
 }  // namespace tools
@@ -16,7 +16,14 @@
 
 #include "tools/recorder/trace_recorder.hpp"
 
-#include <inspector/trace_reader.hpp>
+#include <glog/logging.h>
+
+#include <condition_variable>
+#include <inspector/channel.hpp>
+#include <inspector/config.hpp>
+#include <mutex>
+#include <string>
+#include <thread>
 
 namespace inspector {
 namespace tools {
@@ -28,20 +35,176 @@ namespace {
  */
 const auto kRecorderName = "TraceRecorder";
 
+/**
+ * @brief Number of trace events read per batch for a channel of priority 1.
+ *
+ */
+constexpr std::size_t kBatchEvents = 1024;
+
+/**
+ * @brief Maximum number of bytes read per batch.
+ *
+ */
+constexpr std::size_t kBatchBytes = 1024 * 1024;  // 1MB
+
+/**
+ * @brief Maximum number of drained batches waiting for the encode stage.
+ *
+ */
+constexpr std::size_t kPipelineDepth = 4;
+
 }  // namespace
 
+/**
+ * @brief The data structure `EncodeStage` owns the thread handing the drained
+ * batches of trace events to the collector. Processed batches are returned to
+ * the drain stage through a free list so that their arenas are reused.
+ *
+ * With `kPipelineDepth + 2` batches in circulation, i.e. one being filled by
+ * the drain stage and one being processed by the encode stage, a free batch is
+ * always available to the drain stage once it has queued the previous one.
+ * Backpressure thus only shows up as stalls queueing drained batches.
+ *
+ * The stage thread blocks on the queue of drained batches while there is none,
+ * so that an idle recorder does not wake up the thread.
+ *
+ */
+struct TraceRecorder::EncodeStage {
+  explicit EncodeStage(const std::shared_ptr<CollectorBase>& collector)
+      : collector(collector),
+        drained(kPipelineDepth),
+        free(kPipelineDepth + 1),
+        queued(0),
+        processed(0) {
+    for (std::size_t i = 0; i < free.capacity(); ++i) {
+      free.tryPush(std::make_unique<TraceEventBatch>());
+    }
+    thread = std::thread(&EncodeStage::run, this);
+  }
+
+  ~EncodeStage() {
+    drained.close();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  void run() {
+    std::unique_ptr<TraceEventBatch> batch;
+    while (drained.pop(batch)) {
+      collector->process(*batch);
+      free.tryPush(std::move(batch));
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++processed;
+      }
+      idle.notify_all();
+    }
+  }
+
+  void push(std::unique_ptr<TraceEventBatch>&& batch) {
+    drained.push(std::move(batch));
+    ++queued;
+  }
+
+  std::unique_ptr<TraceEventBatch> acquire() {
+    std::unique_ptr<TraceEventBatch> batch;
+    free.pop(batch);
+    return batch;
+  }
+
+  void waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return processed == queued; });
+  }
+
+  std::shared_ptr<CollectorBase> collector;
+  storage::BoundedQueue<std::unique_ptr<TraceEventBatch>> drained;
+  storage::BoundedQueue<std::unique_ptr<TraceEventBatch>> free;
+  uint64_t queued;
+  uint64_t processed;  //<- Guarded by the mutex.
+  std::mutex mutex;
+  std::condition_variable idle;
+  std::thread thread;
+};
+
 TraceRecorder::TraceRecorder(const std::shared_ptr<CollectorBase>& collector)
-    : RecorderBase(kRecorderName), collector_(collector) {}
+    : RecorderBase(kRecorderName),
+      collector_(collector),
+      stage_(std::make_unique<EncodeStage>(collector)),
+      batch_(std::make_unique<TraceEventBatch>()),
+      wait_token_(0) {}
+
+TraceRecorder::TraceRecorder(const std::shared_ptr<CollectorBase>& collector,
+                             const std::shared_ptr<ProcessTraceReader>& reader)
+    : RecorderBase(std::string(kRecorderName) + "[" +
+                   std::to_string(reader->pid()) + "]"),
+      collector_(collector),
+      reader_(reader),
+      stage_(std::make_unique<EncodeStage>(collector)),
+      batch_(std::make_unique<TraceEventBatch>()),
+      wait_token_(0) {}
+
+TraceRecorder::~TraceRecorder() = default;
 
 void TraceRecorder::record() {
-  while (true) {
-    auto event = readTraceEvent();
-    if (event.isEmpty()) {
-      break;
+  // Channels are drained in weighted round robin order. Each round reads a
+  // batch of up to `priority` times `kBatchEvents` trace events from every
+  // channel until all the channels are empty, so that a busy low priority
+  // channel cannot starve the others.
+  //
+  // The wait token is taken before draining, so that trace events published
+  // while draining wake up the next wait.
+  wait_token_ = reader_ ? reader_->prepareWait() : prepareWaitForTraceEvents();
+  bool drained = false;
+  while (!drained) {
+    drained = true;
+    for (std::size_t index = 0; index < kChannelCount; ++index) {
+      const auto channel = static_cast<Channel>(index);
+      const auto max_events =
+          kBatchEvents * Config::eventChannelPriority(channel);
+      if (read(channel, max_events) == 0) {
+        continue;
+      }
+      drained = false;
+      stage_->push(std::move(batch_));
+      batch_ = stage_->acquire();
     }
-    collector_->process(event);
   }
 }
 
+storage::BackpressureMetrics TraceRecorder::metrics() const {
+  return stage_->drained.metrics();
+}
+
+// protected
+void TraceRecorder::wait(const std::chrono::microseconds duration) {
+  if (reader_) {
+    reader_->wait(wait_token_, duration);
+  } else {
+    waitForTraceEvents(wait_token_, duration);
+  }
+}
+
+// protected
+void TraceRecorder::finish() {
+  stage_->waitIdle();
+  const auto drain = metrics();
+  const auto write = collector_->metrics();
+  LOG(INFO) << "[" << name() << "]: Drain stage queued " << drain.items
+            << " batches, stalled " << drain.stalls << " times for "
+            << drain.stall_ns / 1000 << "us, max depth " << drain.max_depth
+            << ". Write stage queued " << write.items << " blocks, stalled "
+            << write.stalls << " times for " << write.stall_ns / 1000
+            << "us, max depth " << write.max_depth << ".";
+}
+
+// private
+std::size_t TraceRecorder::read(const Channel channel,
+                                const std::size_t max_events) {
+  return reader_ ? reader_->read(*batch_, channel, max_events, kBatchBytes)
+                 : readTraceEvents(*batch_, channel, max_events, kBatchBytes);
+}
+
 }  // namespace tools
-}  // namespace inspector
\ No newline at end of file
+}  // namespace inspector
@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <inspector/trace_reader.hpp>
 #include <memory>
 
+#include "tools/common/storage/bounded_queue.hpp"
 #include "tools/recorder/collector_base.hpp"
 #include "tools/recorder/recorder_base.hpp"
 
@@ -26,17 +30,63 @@ namespace tools {
 
 /**
  * @brief The class `TraceRecorder` records captured traces and metrics through
- * the inspector library.
+ * the inspector library. Between recordings the recorder blocks until the
+ * producers fill the event queues up to the configured wakeup threshold, with
+ * the tick interval acting as an idle timeout.
+ *
+ * Recording is split into pipeline stages connected by bounded lock-free
+ * queues. The recorder thread drains batches of trace events from the event
+ * queues, while an encode stage thread hands them to the collector. Collectors
+ * can in turn write their output from a stage of their own, e.g. the write
+ * stage of `StorageCollector`. A slow stage only stalls the draining of the
+ * event queues once the queue in front of it is full.
  *
  */
 class TraceRecorder final : public RecorderBase {
  public:
+  /**
+   * @brief Construct a recorder draining the event queues of the calling
+   * process.
+   *
+   * @param collector Collector to process the recorded trace events.
+   */
   explicit TraceRecorder(const std::shared_ptr<CollectorBase>& collector);
 
+  /**
+   * @brief Construct a recorder draining the event queues of a single traced
+   * process when per process event queues are enabled.
+   *
+   * @param collector Collector to process the recorded trace events.
+   * @param reader Reader of the event queues of the traced process.
+   */
+  TraceRecorder(const std::shared_ptr<CollectorBase>& collector,
+                const std::shared_ptr<ProcessTraceReader>& reader);
+
+  ~TraceRecorder() override;
+
   void record() override;
 
+  /**
+   * @brief Get the backpressure experienced by the drain stage when handing
+   * batches of trace events to the encode stage.
+   *
+   */
+  storage::BackpressureMetrics metrics() const;
+
+ protected:
+  void wait(const std::chrono::microseconds duration) override;
+  void finish() override;
+
  private:
+  struct EncodeStage;
+
+  std::size_t read(const Channel channel, const std::size_t max_events);
+
   std::shared_ptr<CollectorBase> collector_;
+  std::shared_ptr<ProcessTraceReader> reader_;
+  std::unique_ptr<EncodeStage> stage_;
+  std::unique_ptr<TraceEventBatch> batch_;
+  uint32_t wait_token_;
 };
 
 }  // namespace tools
@@ -37,9 +37,28 @@ class Recorder:
     Class to record captured trace and metric events.
     """
 
-    def __init__(self, out_dir: Path) -> None:
+    def __init__(
+        self,
+        out_dir: Path,
+        consumers: int = 1,
+        block_size: int = 100 * 1024 * 1024,
+        sync: str = "blocks",
+        sync_blocks: int = 1,
+        sync_interval_ms: int = 1000,
+        direct_io: bool = False,
+        compression: str = "lz4",
+    ) -> None:
         self._started = False
         self._out_dir = out_dir
+        self._consumers = consumers
+        self._storage_options = dict(
+            block_size=block_size,
+            sync=sync,
+            sync_blocks=sync_blocks,
+            sync_interval_ms=sync_interval_ms,
+            direct_io=direct_io,
+            compression=compression,
+        )
         if not self._out_dir.exists():
             self._out_dir.mkdir(parents=True)
 
@@ -60,7 +79,9 @@ class Recorder:
             return
 
         LOG.info(f"Starting trace recorder. Data will be stored in {self._out_dir}")
-        recorder_py.start_recorder(str(self._out_dir))
+        recorder_py.start_recorder(
+            str(self._out_dir), consumers=self._consumers, **self._storage_options
+        )
         self._started = True
 
     def stop(self) -> None:
@@ -95,6 +116,47 @@ def parse_args() -> Tuple[argparse.Namespace, List[str]]:
         type=Path,
         default=tempfile.mkdtemp("__inspector"),
     )
+    sub_parser.add_argument(
+        "--consumers",
+        type=int,
+        default=1,
+        help="Number of threads draining the event queues concurrently.",
+    )
+    sub_parser.add_argument(
+        "--block-size",
+        type=int,
+        default=100 * 1024 * 1024,
+        help="Size in bytes of the storage blocks.",
+    )
+    sub_parser.add_argument(
+        "--sync",
+        choices=["none", "blocks", "interval", "close"],
+        default="blocks",
+        help="When written blocks are synced to disk.",
+    )
+    sub_parser.add_argument(
+        "--sync-blocks",
+        type=int,
+        default=1,
+        help="Number of blocks written between syncs.",
+    )
+    sub_parser.add_argument(
+        "--sync-interval-ms",
+        type=int,
+        default=1000,
+        help="Interval in ms between syncs.",
+    )
+    sub_parser.add_argument(
+        "--direct-io",
+        action="store_true",
+        help="Write blocks with direct IO, bypassing the page cache.",
+    )
+    sub_parser.add_argument(
+        "--compression",
+        choices=["none", "lz4", "zlib"],
+        default="lz4",
+        help="Codec compressing the storage blocks.",
+    )
     sub_parser.add_argument(
         "--perfetto",
         action="store_true",
@@ -122,7 +184,16 @@ def main() -> None:
     logging.basicConfig(level=logging.INFO)
 
     recorder_args, target_args = parse_args()
-    recorder = Recorder(out_dir=recorder_args.out)
+    recorder = Recorder(
+        out_dir=recorder_args.out,
+        consumers=recorder_args.consumers,
+        block_size=recorder_args.block_size,
+        sync=recorder_args.sync,
+        sync_blocks=recorder_args.sync_blocks,
+        sync_interval_ms=recorder_args.sync_interval_ms,
+        direct_io=recorder_args.direct_io,
+        compression=recorder_args.compression,
+    )
     with recorder:
         try:
             LOG.info("Running target...")
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2023 Ketan Goyal
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * The `trace_compact` utility is a CLI script to compact a recorded storage
+ * into time partitioned segments of sorted blocks. Compacted storage is read
+ * as a single sorted run, without merging the blocks again on every read.
+ *
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "tools/common/events/event_columns.hpp"
+#include "tools/common/storage/compaction.hpp"
+
+DEFINE_string(in, "", "Input path of the storage to compact.");
+DEFINE_string(out, "", "Output path of the compacted storage.");
+DEFINE_uint64(segment_ms, 60 * 1000,
+              "Duration in ms of the time partition of each segment.");
+DEFINE_uint64(
+    block_size,
+    inspector::tools::storage::CompactionOptions::kDefaultBlockSize,
+    "Size in bytes of the blocks of the compacted storage.");
+DEFINE_string(compression, "lz4",
+              "Codec compressing the blocks of the compacted storage: 'none', "
+              "'lz4' for speed or 'zlib' for a higher ratio.");
+DEFINE_uint64(memory_budget,
+              inspector::tools::storage::Reader::kDefaultMemoryBudget,
+              "Number of bytes of memory used for sorting the records.");
+
+namespace inspector {
+namespace tools {
+
+int main(int argc, char* argv[]) {
+  FLAGS_logtostderr = 1;
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  LOG_IF(FATAL, FLAGS_in.empty()) << "No input path provided.";
+  LOG_IF(FATAL, FLAGS_out.empty()) << "No output path provided.";
+  constexpr auto kMaxSegmentMs =
+      std::numeric_limits<storage::timestamp_t>::max() / 1000 / 1000;
+  LOG_IF(FATAL, FLAGS_segment_ms == 0 || FLAGS_segment_ms > kMaxSegmentMs)
+      << "Segment duration must be between 1 and " << kMaxSegmentMs << " ms.";
+  LOG_IF(FATAL, FLAGS_block_size < storage::kMinBlockSize)
+      << "Block size must be at least " << storage::kMinBlockSize
+      << " bytes.";
+
+  // Blocks are summarized by event types, processes and threads so that
+  // filtered reads of the compacted storage skip blocks.
+  storage::CompactionOptions options;
+  options.segment_duration =
+      static_cast<storage::timestamp_t>(FLAGS_segment_ms) * 1000 * 1000;
+  options.block_size = FLAGS_block_size;
+  try {
+    options.codec = storage::parseCodec(FLAGS_compression);
+  } catch (const std::invalid_argument& error) {
+    LOG(FATAL) << error.what() << " Check --compression.";
+  }
+  options.classifier = eventTags;
+  options.memory_budget = FLAGS_memory_budget;
+
+  LOG(INFO) << "Compacting storage...";
+  const auto stats = storage::compact(FLAGS_in, FLAGS_out, options);
+  LOG(INFO) << "Wrote " << stats.records << " trace events in "
+            << stats.segments << " segments.";
+  LOG_IF(WARNING, stats.corrupt_blocks)
+      << "Skipped " << stats.corrupt_blocks << " corrupt blocks.";
+
+  return 0;
+}
+
+}  // namespace tools
+}  // namespace inspector
+
+int main(int argc, char* argv[]) { return inspector::tools::main(argc, argv); }
@@ -23,13 +23,19 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
-#include <cstring>
+#include <cerrno>
+#include <cstdlib>
 #include <fstream>
 #include <inspector/trace.hpp>
 #include <inspector/trace_event.hpp>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
 
+#include "tools/common/events/event_columns.hpp"
 #include "tools/common/storage/storage.hpp"
+#include "utils/strings.hpp"
 
 DEFINE_string(in, "", "Input path from which to load events.");
 DEFINE_string(
@@ -37,9 +43,85 @@ DEFINE_string(
     "Path to the output file for storing captured events. When set to 'stdout' "
     "then the events will be printed to standard output. Default set to "
     "'stdout'.");
+DEFINE_int64(start_ns, std::numeric_limits<int64_t>::min(),
+             "Only list events with timestamps in nanoseconds at or after the "
+             "given value.");
+DEFINE_int64(end_ns, std::numeric_limits<int64_t>::max(),
+             "Only list events with timestamps in nanoseconds at or before the "
+             "given value.");
+DEFINE_string(types, "",
+              "Comma separated event types to list. All types are listed if "
+              "empty.");
+DEFINE_string(pids, "",
+              "Comma separated process identifiers to list. All processes are "
+              "listed if empty.");
+DEFINE_string(tids, "",
+              "Comma separated thread identifiers to list. All threads are "
+              "listed if empty.");
+DEFINE_string(names, "",
+              "Comma separated event names to list. All names are listed if "
+              "empty.");
 
 namespace inspector {
 namespace tools {
+namespace {
+
+/**
+ * @brief Number of bytes of formatted trace events to buffer before writing
+ * them to the output stream.
+ *
+ */
+constexpr std::size_t kOutputChunkSize = 1024 * 1024;  // 1MB
+
+/**
+ * @brief Number of trace events decoded into columns at a time for filtering.
+ *
+ */
+constexpr std::size_t kFilterBatchSize = 4096;
+
+/**
+ * @brief Parse a comma separated list of integers. Exits with an error naming
+ * the offending value if a value is not an integer within the range of `T`.
+ *
+ */
+template <class T>
+std::vector<T> parseList(const std::string& list) {
+  std::vector<T> values;
+  if (!list.empty()) {
+    for (const auto& value : utils::Split(list, ",")) {
+      char* end = nullptr;
+      errno = 0;
+      const auto parsed = std::strtoll(value.c_str(), &end, 10);
+      LOG_IF(FATAL,
+             value.empty() || *end != '\0' || errno == ERANGE ||
+                 parsed < static_cast<long long>(
+                              std::numeric_limits<T>::min()) ||
+                 parsed > static_cast<long long>(
+                              std::numeric_limits<T>::max()))
+          << "Invalid value '" << value << "' in list '" << list << "'.";
+      values.push_back(static_cast<T>(parsed));
+    }
+  }
+  return values;
+}
+
+/**
+ * @brief Create the event filter set using command line flags.
+ *
+ */
+EventFilter createFilter() {
+  EventFilter filter;
+  filter.setTimeRange(FLAGS_start_ns, FLAGS_end_ns)
+      .setTypes(parseList<event_type_t>(FLAGS_types))
+      .setPids(parseList<int32_t>(FLAGS_pids))
+      .setTids(parseList<int32_t>(FLAGS_tids));
+  if (!FLAGS_names.empty()) {
+    filter.setNames(utils::Split(FLAGS_names, ","));
+  }
+  return filter;
+}
+
+}  // namespace
 
 int main(int argc, char* argv[]) {
   FLAGS_logtostderr = 1;
@@ -58,13 +140,69 @@ int main(int argc, char* argv[]) {
 
   LOG(INFO) << "Loading trace events...";
 
-  storage::Reader reader(FLAGS_in);
+  // Trace events are formatted into a reusable buffer which is written out in
+  // large chunks.
+  std::string buffer;
+  buffer.reserve(2 * kOutputChunkSize);
+  const auto format = [&buffer, &out](const TraceEventView& event) {
+    event.toJson(buffer);
+    buffer.push_back('\n');
+    if (buffer.size() >= kOutputChunkSize) {
+      out.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  };
+
+  // When filtering, trace events are copied into a batch which is decoded into
+  // columns. The filter then scans the columns and only the selected events
+  // are formatted.
+  const auto filter = createFilter();
+  TraceEventBatch batch;
+  EventColumns columns;
+  std::vector<uint32_t> selection;
+  const auto flush = [&]() {
+    columns.clear();
+    columns.decode(batch);
+    filter.apply(columns, selection);
+    for (const auto index : selection) {
+      format(columns.event(index));
+    }
+    batch.clear();
+  };
+
+  // Blocks without events in the time range, or of the selected types,
+  // processes and threads, are skipped by the reader. Records of the read
+  // blocks are then filtered by the event filter.
+  storage::ReadFilter read_filter;
+  read_filter.begin = FLAGS_start_ns;
+  read_filter.end = FLAGS_end_ns;
+  read_filter.types = parseList<event_type_t>(FLAGS_types);
+  read_filter.pids = parseList<int32_t>(FLAGS_pids);
+  read_filter.tids = parseList<int32_t>(FLAGS_tids);
+  storage::Reader reader(FLAGS_in, storage::Reader::kDefaultMaxBlocks,
+                         storage::Reader::ReadMode::kAlwaysChronological,
+                         storage::Reader::kDefaultMemoryBudget,
+                         storage::Reader::kDefaultPrefetchThreads,
+                         read_filter);
   for (auto& record : reader) {
-    std::vector<uint8_t> buffer(record.size);
-    std::memcpy(buffer.data(), record.src, record.size);
-    TraceEvent event(std::move(buffer));
-    out << event.toJson() << "\n";
+    if (filter.empty()) {
+      format(TraceEventView(record.src, record.size));
+      continue;
+    }
+    // Records are read in chronological order so no later record can be in
+    // the selected time range.
+    if (record.timestamp > filter.maxTimestamp()) {
+      break;
+    }
+    batch.append(static_cast<const uint8_t*>(record.src), record.size);
+    if (batch.size() >= kFilterBatchSize) {
+      flush();
+    }
   }
+  flush();
+  out.write(buffer.data(), buffer.size());
+  LOG_IF(WARNING, reader.corruptBlocks())
+      << "Skipped " << reader.corruptBlocks() << " corrupt blocks.";
 
   return 0;
 }
@@ -19,6 +19,8 @@
 #include "tools/viewers/perfetto/generator.hpp"
 
 #include <fstream>
+#include <string>
+#include <type_traits>
 #include <inspector/trace.hpp>
 #include <inspector/trace_event.hpp>
 
@@ -34,69 +36,24 @@ namespace {
 
 void createDebugAnnotation(perfetto::protos::DebugAnnotation& debug_annotation,
                            const DebugArg& arg) {
-  switch (arg.type()) {
-    case DebugArg::Type::TYPE_STRING:
-    case DebugArg::Type::TYPE_CHAR: {
-      debug_annotation.set_string_value(arg.value<std::string>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_INT16: {
-      debug_annotation.set_int_value(arg.value<int16_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_INT32: {
-      debug_annotation.set_int_value(arg.value<int32_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_INT64: {
-      debug_annotation.set_int_value(arg.value<int64_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_UINT8: {
-      debug_annotation.set_uint_value(arg.value<uint8_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_UINT16: {
-      debug_annotation.set_uint_value(arg.value<uint16_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_UINT32: {
-      debug_annotation.set_uint_value(arg.value<uint32_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_UINT64: {
-      debug_annotation.set_uint_value(arg.value<uint64_t>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_FLOAT: {
-      debug_annotation.set_double_value(arg.value<float>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_DOUBLE: {
-      debug_annotation.set_double_value(arg.value<double>());
-      break;
-    }
-
-    case DebugArg::Type::TYPE_KWARG: {
-      const auto kwarg = arg.value<KeywordArg>();
+  visit(arg, [&debug_annotation](const auto value) {
+    using T = std::decay_t<decltype(value)>;
+    if constexpr (std::is_same<T, char>::value) {
+      debug_annotation.set_string_value(std::string(1, value));
+    } else if constexpr (std::is_same<T, const char*>::value) {
+      debug_annotation.set_string_value(value);
+    } else if constexpr (std::is_same<T, KeywordArg>::value) {
       auto* debug_annotation_ptr = debug_annotation.add_dict_entries();
-      debug_annotation_ptr->set_name(kwarg.name());
-      createDebugAnnotation(*debug_annotation_ptr, kwarg);
-      break;
+      debug_annotation_ptr->set_name(value.name());
+      createDebugAnnotation(*debug_annotation_ptr, value);
+    } else if constexpr (std::is_floating_point<T>::value) {
+      debug_annotation.set_double_value(value);
+    } else if constexpr (std::is_signed<T>::value) {
+      debug_annotation.set_int_value(value);
+    } else {
+      debug_annotation.set_uint_value(value);
     }
-
-    default:
-      break;
-  }
+  });
 }
 
 /**
@@ -104,7 +61,7 @@ void createDebugAnnotation(perfetto::protos::DebugAnnotation& debug_annotation,
  *
  */
 void createDebugAnnotations(perfetto::protos::TrackEvent& track_event,
-                            const TraceEvent& trace_event) {
+                            const TraceEventView& trace_event) {
   const auto debug_args = trace_event.debugArgs();
   auto* debug_annotation_ptr = track_event.add_debug_annotations();
   debug_annotation_ptr->set_name("args");
@@ -130,9 +87,7 @@ void generatePerfetto(const std::string& input_dir,
   PerfettoEventManager event_manager(trace_packets);
   storage::Reader reader(input_dir);
   for (auto& record : reader) {
-    std::vector<uint8_t> buffer(record.size);
-    std::memcpy(buffer.data(), record.src, record.size);
-    TraceEvent event(std::move(buffer));
+    const TraceEventView event(record.src, record.size);
     switch (static_cast<EventType>(event.type())) {
       case EventType::kSyncBeginTag: {
         const auto track_uuid =
@@ -157,8 +112,8 @@ void generatePerfetto(const std::string& input_dir,
         }
         const auto parent_track_uuid =
             track_manager.getOrCreateThreadTrack(event.pid(), event.tid());
-        size_t count = 0;
-        for (const auto& arg : debug_args) {
+        for (size_t count = 0; count < debug_args.size(); ++count) {
+          const auto arg = debug_args[count];
           const std::string suffix =
               debug_args.size() > 1 ? " [" + std::to_string(count) + "]" : "";
           const auto track_name =
@@ -167,61 +122,17 @@ void generatePerfetto(const std::string& input_dir,
               track_name, parent_track_uuid);
           auto* track_event_ptr =
               event_manager.createCounterEvent(track_uuid, event.timestampNs());
-          switch (arg.type()) {
-            case DebugArg::Type::TYPE_STRING:
-            case DebugArg::Type::TYPE_CHAR: {
+          visit(arg, [track_event_ptr](const auto value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same<T, char>::value ||
+                          std::is_same<T, const char*>::value) {
               LOG(INFO) << "String counter value not supported.";
-              break;
-            }
-
-            case DebugArg::Type::TYPE_INT16: {
-              track_event_ptr->set_counter_value(arg.value<int16_t>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_INT32: {
-              track_event_ptr->set_counter_value(arg.value<int32_t>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_INT64: {
-              track_event_ptr->set_counter_value(arg.value<int64_t>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_UINT8: {
-              track_event_ptr->set_counter_value(arg.value<uint8_t>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_UINT16: {
-              track_event_ptr->set_counter_value(arg.value<uint16_t>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_UINT32: {
-              track_event_ptr->set_counter_value(arg.value<uint32_t>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_UINT64: {
-              track_event_ptr->set_counter_value(arg.value<uint64_t>());
-              break;
+            } else if constexpr (std::is_floating_point<T>::value) {
+              track_event_ptr->set_double_counter_value(value);
+            } else if constexpr (std::is_integral<T>::value) {
+              track_event_ptr->set_counter_value(value);
             }
-
-            case DebugArg::Type::TYPE_FLOAT: {
-              track_event_ptr->set_double_counter_value(arg.value<float>());
-              break;
-            }
-
-            case DebugArg::Type::TYPE_DOUBLE: {
-              track_event_ptr->set_double_counter_value(arg.value<double>());
-              break;
-            }
-
-            default:
-              break;
-          }
+          });
         }
 
         break;
@@ -233,6 +144,8 @@ void generatePerfetto(const std::string& input_dir,
       }
     }
   }
+  LOG_IF(WARNING, reader.corruptBlocks())
+      << "Skipped " << reader.corruptBlocks() << " corrupt blocks.";
 
   if (trace_packets.packet().size() == 0) {
     LOG(ERROR) << "No events found.";